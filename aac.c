@@ -0,0 +1,343 @@
+#include "aac.h"
+#include "canonical.h"
+#include "result_cache.h"
+#include "mem_track.h"
+#include "trace.h"
+#include "utils.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+struct AacContext {
+    AacOptions opts;
+    int n_h;
+    const int *adj_h;
+    const SparseGraph *sparse_h;
+    const HIndex *h_index;
+    int *owned_adj_h;           // Target expanded from sparse_h, owned by the context
+    HIndex *owned_index;        // share_target: index built for a target that came without one
+    CandidateCache *candidates; // share_target: candidate sets shared by all solves
+    CanonicalForm target_form;  // cache_dir: canonical form of the target, computed once
+    bool has_target_form;
+};
+
+static const char *engine_names[] = {
+    [AAC_ISO_EXACT] = "iso_exact",
+    [AAC_ISO_APPROX] = "iso_approx",
+    [AAC_EXT_EXACT] = "ext_exact",
+    [AAC_EXT_APPROX] = "ext_approx",
+    [AAC_EXT_JOINT] = "ext_joint",
+};
+
+#define NUM_ENGINES ((int) (sizeof(engine_names) / sizeof(engine_names[0])))
+
+// ============================================================================
+// Options
+// ============================================================================
+
+AacOptions aac_default_options(AacEngine engine) {
+    AacOptions opts = {
+        .engine = engine,
+        .n = 1,
+        .interactive = false,
+        .joint_budget = {0, 0},
+        .approx = ext_approx_default_options(),
+        .share_target = false,
+        .cache_dir = NULL,
+    };
+    return opts;
+}
+
+bool aac_parse_engine(const char *name, AacEngine *engine) {
+    for (int k = 0; k < NUM_ENGINES; k++) {
+        if (strcmp(name, engine_names[k]) == 0) {
+            *engine = (AacEngine) k;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char *aac_engine_name(AacEngine engine) {
+    return (int) engine >= 0 && (int) engine < NUM_ENGINES ? engine_names[engine] : "unknown";
+}
+
+bool aac_engine_runs_on_sparse(AacEngine engine) {
+    return engine == AAC_ISO_APPROX || engine == AAC_EXT_APPROX;
+}
+
+// ============================================================================
+// Context
+// ============================================================================
+
+AacContext *aac_create(const AacOptions *opts) {
+    AacContext *ctx = (AacContext *) calloc(1, sizeof(AacContext));
+    if (!ctx) {
+        fprintf(stderr, "Error: out of memory\n");
+        return NULL;
+    }
+    ctx->opts = *opts;
+    return ctx;
+}
+
+// Drop everything derived from the previous target
+static void release_target(AacContext *ctx) {
+    candidate_cache_destroy(ctx->candidates);
+    free_canonical_form(&ctx->target_form);
+    ctx->has_target_form = false;
+    free_h_index(ctx->owned_index);
+    mem_free(ctx->owned_adj_h);
+    ctx->candidates = NULL;
+    ctx->owned_index = NULL;
+    ctx->owned_adj_h = NULL;
+}
+
+void aac_destroy(AacContext *ctx) {
+    if (!ctx) return;
+    release_target(ctx);
+    free(ctx);
+}
+
+static bool engine_uses_cache(AacEngine engine) {
+    return engine == AAC_ISO_EXACT || engine == AAC_EXT_EXACT;
+}
+
+// Index the target once for the many solves that will share it
+static int share_target(AacContext *ctx) {
+    if (!ctx->h_index) {
+        ctx->owned_index = ctx->adj_h ? h_index_build(ctx->n_h, ctx->adj_h) : h_index_build_sparse(ctx->sparse_h);
+        ctx->h_index = ctx->owned_index;
+    }
+    if (ctx->h_index && ctx->opts.engine == AAC_ISO_EXACT) {
+        ctx->candidates = candidate_cache_create(ctx->h_index);
+        if (!ctx->candidates) return -1;
+    }
+    return ctx->h_index ? 0 : -1;
+}
+
+int aac_set_target(AacContext *ctx, int n_h, const int *adj_h, const SparseGraph *sparse_h, const HIndex *h_index) {
+    release_target(ctx);
+    ctx->n_h = n_h;
+    ctx->adj_h = adj_h;
+    ctx->sparse_h = sparse_h;
+    ctx->h_index = h_index;
+
+    if (sparse_h && !adj_h && !aac_engine_runs_on_sparse(ctx->opts.engine)) {
+        ctx->owned_adj_h = sparse_graph_to_dense(sparse_h);
+        if (!ctx->owned_adj_h) {
+            fprintf(stderr, "Graph H (%d vertices) is too large for a dense matrix\n", n_h);
+            return -1;
+        }
+        ctx->adj_h = ctx->owned_adj_h;
+        ctx->sparse_h = NULL;
+    }
+    if (ctx->opts.share_target && share_target(ctx) != 0) {
+        fprintf(stderr, "Error: out of memory indexing H\n");
+        return -1;
+    }
+    // Without a form (too symmetric), solves on this target skip the cache
+    if (ctx->opts.cache_dir && engine_uses_cache(ctx->opts.engine) && ctx->adj_h) {
+        ctx->has_target_form = canonical_form(n_h, ctx->adj_h, &ctx->target_form) == 0;
+    }
+    return 0;
+}
+
+// ============================================================================
+// Result Cache
+// ============================================================================
+
+// Turn cached mappings (taken over) into the engine's result, reporting each as
+// the engine would have; ext_exact rounds are replayed on a copy of H
+static bool answer_from_cache(AacResult *result, int n_g, const int *adj_g, int n_h, const int *adj_h,
+                              int **mappings, int count, const Reporter *rep) {
+    if (result->engine == AAC_ISO_EXACT) {
+        IsomorphismResult *iso = (IsomorphismResult *) mem_alloc(MEM_RESULTS, sizeof(IsomorphismResult));
+        if (!iso) return false;
+        *iso = (IsomorphismResult) {.mappings = mappings, .num_found = count, .n_g = n_g, .is_subgraph = count > 0};
+        result->iso = iso;
+        for (int k = 0; k < count; k++) {
+            MappingReport m = {.kind = REPORT_ISOMORPHISM, .index = k + 1, .mapping = mappings[k],
+                               .n_g = n_g, .n_h = n_h, .adj_g = adj_g, .adj_h = adj_h};
+            report_mapping(rep, &m);
+        }
+        return true;
+    }
+
+    size_t cells = (size_t) n_h * n_h;
+    ExtensionResult *ext = (ExtensionResult *) mem_calloc(MEM_RESULTS, 1, sizeof(ExtensionResult));
+    int *h = (int *) mem_alloc(MEM_RESULTS, (cells > 0 ? cells : 1) * sizeof(int));
+    int *prev = (int *) mem_alloc(MEM_EXTENSION, (cells > 0 ? cells : 1) * sizeof(int));
+    if (!ext || !h || !prev) {
+        mem_free(ext);
+        mem_free(h);
+        mem_free(prev);
+        return false;
+    }
+    memcpy(h, adj_h, cells * sizeof(int));
+    *ext = (ExtensionResult) {.mappings = mappings, .num_mappings = count, .extended_adj_h = h,
+                              .n_h = n_h, .n_g = n_g};
+    result->ext = ext;
+    for (int k = 0; k < count; k++) {
+        memcpy(prev, h, cells * sizeof(int));
+        int added = 0;
+        for (int i = 0; i < n_g; i++) {
+            for (int j = 0; j < n_g; j++) {
+                int *cell = &h[(size_t) mappings[k][i] * n_h + mappings[k][j]];
+                int g_mult = adj_g[(size_t) i * n_g + j];
+                if (*cell < g_mult) {
+                    added += g_mult - *cell;
+                    *cell = g_mult;
+                }
+            }
+        }
+        ext->total_edges_added += added;
+        MappingReport m = {.kind = REPORT_EXTENSION, .index = k + 1, .mapping = mappings[k], .n_g = n_g,
+                           .n_h = n_h, .adj_g = adj_g, .adj_h = h, .prev_adj_h = prev, .deficit = added,
+                           .edges_added = added};
+        report_mapping(rep, &m);
+    }
+    mem_free(prev);
+    return true;
+}
+
+// ============================================================================
+// Solving
+// ============================================================================
+
+AacResult *aac_solve(const AacContext *ctx, const AacInstance *instance) {
+    return aac_solve_reported(ctx, instance, &ctx->opts.reporter);
+}
+
+AacResult *aac_solve_reported(const AacContext *ctx, const AacInstance *instance, const Reporter *rep) {
+    const AacOptions *opts = &ctx->opts;
+    int n_g = instance->n_g;
+    const int *adj_g = instance->adj_g;
+    int n = instance->n > 0 ? instance->n : opts->n;
+
+    int n_h = ctx->n_h;
+    const int *adj_h = ctx->adj_h;
+    const SparseGraph *sparse_h = ctx->sparse_h;
+    const HIndex *h_index = ctx->h_index;
+    CandidateCache *candidates = ctx->candidates;
+    if (instance->adj_h || instance->sparse_h) {
+        n_h = instance->n_h;
+        adj_h = instance->adj_h;
+        sparse_h = instance->sparse_h;
+        h_index = instance->h_index;
+        candidates = NULL;
+    }
+    if (!adj_h && !sparse_h) {
+        fprintf(stderr, "Error: no graph H given\n");
+        return NULL;
+    }
+
+    // Only the heuristics run on a sparse H; the other engines get a dense copy
+    int *dense_h = NULL;
+    if (!aac_engine_runs_on_sparse(opts->engine)) {
+        if (!adj_h) {
+            dense_h = sparse_graph_to_dense(sparse_h);
+            if (!dense_h) {
+                fprintf(stderr, "Graph H (%d vertices) is too large for a dense matrix\n", n_h);
+                return NULL;
+            }
+            adj_h = dense_h;
+        }
+        sparse_h = NULL;
+    }
+
+    AacResult *result = (AacResult *) calloc(1, sizeof(AacResult));
+    if (!result) {
+        fprintf(stderr, "Error: out of memory\n");
+        mem_free(dense_h);
+        return NULL;
+    }
+    result->engine = opts->engine;
+
+    double start = now_ms();
+    trace_begin(engine_names[opts->engine]);
+    CanonicalForm g_form = {0}, own_h_form = {0};
+    const CanonicalForm *h_form = NULL;
+    // A run that could prompt has no fixed answer to cache
+    if (opts->cache_dir && engine_uses_cache(opts->engine) && (!opts->interactive || !rep || !rep->confirm) &&
+        canonical_form(n_g, adj_g, &g_form) == 0) {
+        if (adj_h != ctx->adj_h) {
+            if (canonical_form(n_h, adj_h, &own_h_form) == 0) h_form = &own_h_form;
+        } else if (ctx->has_target_form) {
+            h_form = &ctx->target_form;
+        }
+    }
+    int **cached;
+    int num_cached;
+    bool hit = h_form && result_cache_lookup(opts->cache_dir, engine_names[opts->engine], n, &g_form, h_form,
+                                             &cached, &num_cached);
+    if (hit) {
+        report_note(rep, "Answered from the result cache (%s)\n", opts->cache_dir);
+        if (!answer_from_cache(result, n_g, adj_g, n_h, adj_h, cached, num_cached, rep)) {
+            for (int k = 0; k < num_cached; k++) mem_free(cached[k]);
+            mem_free(cached);
+            fprintf(stderr, "Error: out of memory\n");
+        }
+        h_form = NULL; // Nothing new to store
+    } else {
+        switch (opts->engine) {
+            case AAC_ISO_EXACT:
+                result->iso = find_isomorphisms_exact(n_g, adj_g, n_h, adj_h, h_index, candidates, n,
+                                                      opts->interactive, rep);
+                break;
+            case AAC_ISO_APPROX:
+                result->iso = sparse_h
+                              ? find_isomorphisms_greedy_sparse(n_g, adj_g, sparse_h, h_index, n, opts->interactive,
+                                                                rep)
+                              : find_isomorphisms_greedy(n_g, adj_g, n_h, adj_h, h_index, n, opts->interactive,
+                                                         rep);
+                break;
+            case AAC_EXT_EXACT:
+                result->ext = find_minimal_extension_exact(n_g, adj_g, n_h, adj_h, n, opts->interactive, rep);
+                break;
+            case AAC_EXT_APPROX:
+                result->ext = sparse_h
+                              ? find_minimal_extension_greedy_sparse(n_g, adj_g, sparse_h, h_index, n,
+                                                                     opts->interactive, &opts->approx, rep)
+                              : find_minimal_extension_greedy(n_g, adj_g, n_h, adj_h, h_index, n,
+                                                              opts->interactive, &opts->approx, rep);
+                break;
+            case AAC_EXT_JOINT:
+                result->ext = find_minimal_extension_joint(n_g, adj_g, n_h, adj_h, n, &opts->joint_budget,
+                                                           &result->joint, rep);
+                break;
+        }
+    }
+    result->time_ms = now_ms() - start;
+    trace_end(engine_names[opts->engine]);
+
+    // ext_exact finds nothing only when it refuses the sizes; that is not an answer to keep
+    int found = result->iso ? result->iso->num_found : result->ext ? result->ext->num_mappings : 0;
+    if (h_form && (result->iso || found > 0)) {
+        result_cache_store(opts->cache_dir, engine_names[opts->engine], n, &g_form, h_form,
+                           result->iso ? result->iso->mappings : result->ext->mappings, found);
+    }
+    free_canonical_form(&g_form);
+    free_canonical_form(&own_h_form);
+    mem_free(dense_h);
+
+    if (result->iso) {
+        result->num_mappings = result->iso->num_found;
+        result->mappings = result->iso->mappings;
+        result->stats = result->iso->stats;
+    } else if (result->ext) {
+        result->num_mappings = result->ext->num_mappings;
+        result->mappings = result->ext->mappings;
+        result->stats = result->ext->stats;
+    } else {
+        free(result);
+        return NULL;
+    }
+    return result;
+}
+
+void aac_free_result(AacResult *result) {
+    if (!result) return;
+    if (result->iso) free_isomorphism_result(result->iso);
+    if (result->ext) free_extension_result(result->ext);
+    free(result);
+}
@@ -0,0 +1,131 @@
+#ifndef AAC_AAC_H
+#define AAC_AAC_H
+
+#include <stdbool.h>
+#include "algorithms.h"
+#include "report.h"
+
+/**
+ * Public entry point of libaac: run any engine in-process through a context.
+ *
+ * The library never reads stdin or writes stdout; everything the engines
+ * would show goes to the Reporter in AacOptions (all callbacks NULL = silent).
+ * Errors such as running out of memory are described on stderr and reported
+ * by a NULL result.
+ */
+
+typedef enum {
+    AAC_ISO_EXACT,  // Subgraph isomorphisms, Bron-Kerbosch on the product graph
+    AAC_ISO_APPROX, // Subgraph isomorphisms, greedy clique heuristic
+    AAC_EXT_EXACT,  // Minimal extension, exact backtracking per round
+    AAC_EXT_APPROX, // Minimal extension, greedy heuristic per round
+    AAC_EXT_JOINT   // Jointly minimal extension, branch-and-bound over all mappings
+} AacEngine;
+
+/**
+ * Engine choice and limits for a context
+ */
+typedef struct {
+    AacEngine engine;
+    int n;                    // Isomorphisms / mappings to find
+    bool interactive;         // Ask reporter.confirm whether to go on once n are found
+    JointBudget joint_budget; // AAC_EXT_JOINT search limits
+    ExtApproxOptions approx;  // AAC_EXT_APPROX tuning, including the portfolio thread count
+    Reporter reporter;        // Progress and mapping callbacks
+    bool share_target;        // Many instances will use the target: index it once and share candidate sets
+    const char *cache_dir;    // Result cache directory for AAC_ISO_EXACT and AAC_EXT_EXACT, or NULL (see below)
+} AacOptions;
+
+/**
+ * One problem: G, and optionally H (dense or sparse). An instance without H
+ * uses the context's target.
+ */
+typedef struct {
+    int n_g;
+    const int *adj_g;
+    int n_h;
+    const int *adj_h;            // H as a matrix, or NULL
+    const SparseGraph *sparse_h; // H as CSR, or NULL (expanded for engines that need a matrix)
+    const HIndex *h_index;       // Precomputed tables for this H, or NULL
+    int n;                       // Isomorphisms / mappings to find, 0 = the context's opts.n
+} AacInstance;
+
+/**
+ * Outcome of one solve. Exactly one of iso / ext is set, depending on the engine.
+ */
+typedef struct {
+    AacEngine engine;
+    IsomorphismResult *iso;
+    ExtensionResult *ext;
+    JointStats joint;  // AAC_EXT_JOINT only
+    SearchStats stats; // Search counters, all zero unless built with AAC_STATS (see search_stats.h)
+    int num_mappings;  // Mappings found (iso->num_found or ext->num_mappings)
+    int **mappings;    // The mappings themselves, owned by iso / ext
+    double time_ms;    // Wall-clock time spent in the engine
+} AacResult;
+
+typedef struct AacContext AacContext;
+
+/**
+ * Options with n = 1, non-interactive, unlimited joint search, default
+ * heuristic options and no reporter
+ */
+AacOptions aac_default_options(AacEngine engine);
+
+/**
+ * Engine for a command name (iso_exact, iso_approx, ext_exact, ext_approx, ext_joint)
+ */
+bool aac_parse_engine(const char *name, AacEngine *engine);
+
+const char *aac_engine_name(AacEngine engine);
+
+/**
+ * True if the engine works on a sparse H directly (the others expand it to a matrix)
+ */
+bool aac_engine_runs_on_sparse(AacEngine engine);
+
+/**
+ * Create a context holding a copy of opts (NULL on allocation failure)
+ */
+AacContext *aac_create(const AacOptions *opts);
+
+void aac_destroy(AacContext *ctx);
+
+/**
+ * Set the H used by instances that bring none. The graphs and the optional
+ * index (see h_index.h; NULL = the engines compute what they need per solve)
+ * are borrowed and must outlive the context; a sparse H is expanded once here
+ * if the engine needs a matrix. With opts.share_target, a missing index is
+ * built here and AAC_ISO_EXACT solves share H-side candidate sets. Returns 0,
+ * or -1 if that expansion or indexing fails.
+ */
+int aac_set_target(AacContext *ctx, int n_h, const int *adj_h, const SparseGraph *sparse_h, const HIndex *h_index);
+
+/**
+ * With opts.cache_dir, AAC_ISO_EXACT and AAC_EXT_EXACT solves that cannot
+ * prompt (not interactive, or a reporter without confirm) first look up the
+ * canonical forms of G and H in that directory (see result_cache.h). A hit is
+ * translated to the instance's vertex numbers and replayed to the reporter
+ * instead of searching; a miss is solved and stored. The answer to a
+ * relabelled query is a valid one, though not necessarily the mappings a
+ * fresh search would pick first. Graphs too symmetric to canonicalize within
+ * budget are solved without the cache.
+ */
+
+/**
+ * Solve one instance, reporting to the context's reporter
+ *
+ * @return AacResult (caller must free with aac_free_result), or NULL on failure
+ */
+AacResult *aac_solve(const AacContext *ctx, const AacInstance *instance);
+
+/**
+ * Solve one instance, reporting to rep instead of the context's reporter
+ * (NULL = silent). The context is not modified, so several threads may solve
+ * on one context at once, each with its own reporter.
+ */
+AacResult *aac_solve_reported(const AacContext *ctx, const AacInstance *instance, const Reporter *rep);
+
+void aac_free_result(AacResult *result);
+
+#endif //AAC_AAC_H
@@ -5,5 +5,7 @@
 #include "algorithms/isomorphism.h"
 #include "algorithms/minimal_extension.h"
 #include "algorithms/minimal_extension_approximation.h"
+#include "algorithms/minimal_extension_joint.h"
+#include "algorithms/incremental_isomorphism.h"
 
 #endif //AAC_ALGORITHMS_H
\ No newline at end of file
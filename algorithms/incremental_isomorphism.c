@@ -0,0 +1,487 @@
+#include "incremental_isomorphism.h"
+#include "../mem_track.h"
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// ============================================================================
+// Types
+// ============================================================================
+
+// H vertices joined to one vertex by an edge in either direction (loops excluded)
+typedef struct {
+    int *ids;
+    int count, cap;
+} NeighborList;
+
+struct IncrementalIso {
+    int n_g;
+    int *adj_g;
+    int *out_deg_g, *in_deg_g;
+    // Search plan per anchor a (rows of n_g): order[a][k] is the k-th G vertex placed,
+    // parent[a][k] an already placed neighbour whose image's H neighbours are its
+    // candidates (-1 = first vertex of a component, tried on all of H)
+    int *order;
+    int *parent;
+
+    int n_h;
+    int *adj_h;
+    int *out_deg_h, *in_deg_h;
+    NeighborList *nbrs;
+
+    // Search state
+    int *mapping;  // G vertex -> H vertex, -1 = unplaced
+    bool *used;    // H vertices in the image
+    bool *touched; // H vertices changed by the current update
+    int anchor;    // G vertices below it may not use touched vertices
+    EmbeddingSet *found;
+    int found_cap;
+    long long nodes;
+    bool failed;
+};
+
+static inline int cell(const int *adj, int n, int i, int j) {
+    return adj[(size_t) i * n + j];
+}
+
+// ============================================================================
+// Embedding Sets
+// ============================================================================
+
+static int compare_mappings(const int *a, const int *b, int n_g) {
+    for (int v = 0; v < n_g; v++) {
+        if (a[v] != b[v]) return a[v] < b[v] ? -1 : 1;
+    }
+    return 0;
+}
+
+// Stable merge sort (qsort has no way to pass n_g to the comparison)
+static void sort_mappings(int **items, int **tmp, int count, int n_g) {
+    if (count < 2) return;
+    int half = count / 2;
+    sort_mappings(items, tmp, half, n_g);
+    sort_mappings(items + half, tmp, count - half, n_g);
+    int i = 0, j = half, k = 0;
+    while (i < half && j < count) {
+        tmp[k++] = compare_mappings(items[j], items[i], n_g) < 0 ? items[j++] : items[i++];
+    }
+    while (i < half) tmp[k++] = items[i++];
+    while (j < count) tmp[k++] = items[j++];
+    memcpy(items, tmp, (size_t) count * sizeof(int *));
+}
+
+static int sort_set(EmbeddingSet *set) {
+    if (set->count < 2) return 0;
+    int **tmp = (int **) mem_alloc(MEM_RESULTS, (size_t) set->count * sizeof(int *));
+    if (!tmp) return -1;
+    sort_mappings(set->mappings, tmp, set->count, set->n_g);
+    mem_free(tmp);
+    return 0;
+}
+
+void free_embedding_set(EmbeddingSet *set) {
+    for (int k = 0; k < set->count; k++) mem_free(set->mappings[k]);
+    mem_free(set->mappings);
+    set->mappings = NULL;
+    set->count = 0;
+}
+
+void free_embedding_delta(EmbeddingDelta *delta) {
+    free_embedding_set(&delta->gained);
+    free_embedding_set(&delta->lost);
+}
+
+// Record the current (complete) mapping
+static void record(IncrementalIso *inc) {
+    EmbeddingSet *set = inc->found;
+    if (set->count == inc->found_cap) {
+        int cap = inc->found_cap ? inc->found_cap * 2 : 16;
+        int **grown = (int **) mem_realloc(MEM_RESULTS, set->mappings, (size_t) cap * sizeof(int *));
+        if (!grown) {
+            inc->failed = true;
+            return;
+        }
+        set->mappings = grown;
+        inc->found_cap = cap;
+    }
+    int *copy = (int *) mem_alloc(MEM_RESULTS, (inc->n_g > 0 ? (size_t) inc->n_g : 1) * sizeof(int));
+    if (!copy) {
+        inc->failed = true;
+        return;
+    }
+    memcpy(copy, inc->mapping, (size_t) inc->n_g * sizeof(int));
+    set->mappings[set->count++] = copy;
+}
+
+// ============================================================================
+// Search
+// ============================================================================
+
+static bool fits(const IncrementalIso *inc, int w, int x) {
+    if (inc->used[x]) return false;
+    if (w < inc->anchor && inc->touched[x]) return false; // Found from a lower anchor
+    if (inc->out_deg_g[w] > inc->out_deg_h[x] || inc->in_deg_g[w] > inc->in_deg_h[x]) return false;
+
+    int n_g = inc->n_g, n_h = inc->n_h;
+    if (cell(inc->adj_g, n_g, w, w) > cell(inc->adj_h, n_h, x, x)) return false;
+    for (int w2 = 0; w2 < n_g; w2++) {
+        int x2 = inc->mapping[w2];
+        if (x2 < 0) continue;
+        if (cell(inc->adj_g, n_g, w, w2) > cell(inc->adj_h, n_h, x, x2)) return false;
+        if (cell(inc->adj_g, n_g, w2, w) > cell(inc->adj_h, n_h, x2, x)) return false;
+    }
+    return true;
+}
+
+static void extend(IncrementalIso *inc, const int *order, const int *parent, int depth);
+
+static void place(IncrementalIso *inc, const int *order, const int *parent, int depth, int x) {
+    int w = order[depth];
+    inc->nodes++;
+    if (!fits(inc, w, x)) return;
+    inc->mapping[w] = x;
+    inc->used[x] = true;
+    extend(inc, order, parent, depth + 1);
+    inc->used[x] = false;
+    inc->mapping[w] = -1;
+}
+
+static void extend(IncrementalIso *inc, const int *order, const int *parent, int depth) {
+    if (inc->failed) return;
+    if (depth == inc->n_g) {
+        record(inc);
+        return;
+    }
+
+    int p = parent[depth];
+    if (p < 0) {
+        for (int x = 0; x < inc->n_h && !inc->failed; x++) place(inc, order, parent, depth, x);
+        return;
+    }
+    // Joined to p in G, so its image is joined to p's image in H
+    const NeighborList *nl = &inc->nbrs[inc->mapping[p]];
+    for (int k = 0; k < nl->count && !inc->failed; k++) place(inc, order, parent, depth, nl->ids[k]);
+}
+
+// Every embedding that maps some G vertex onto one of the marked H vertices, each
+// found once: from the lowest G vertex that lands on a marked vertex
+static int search_touched(IncrementalIso *inc, const int *touched, int num_touched, EmbeddingSet *out) {
+    memset(out, 0, sizeof(*out));
+    out->n_g = inc->n_g;
+    inc->found = out;
+    inc->found_cap = 0;
+    inc->failed = false;
+
+    for (int a = 0; a < inc->n_g && !inc->failed; a++) {
+        inc->anchor = a;
+        const int *order = inc->order + (size_t) a * inc->n_g;
+        const int *parent = inc->parent + (size_t) a * inc->n_g;
+        for (int k = 0; k < num_touched && !inc->failed; k++) place(inc, order, parent, 0, touched[k]);
+    }
+    inc->anchor = 0;
+    inc->found = NULL;
+
+    if (inc->failed || sort_set(out) != 0) {
+        free_embedding_set(out);
+        return -1;
+    }
+    return 0;
+}
+
+// ============================================================================
+// H Updates
+// ============================================================================
+
+static bool joined(const IncrementalIso *inc, int a, int b) {
+    return cell(inc->adj_h, inc->n_h, a, b) > 0 || cell(inc->adj_h, inc->n_h, b, a) > 0;
+}
+
+static int neighbor_add(NeighborList *nl, int id) {
+    if (nl->count == nl->cap) {
+        int cap = nl->cap ? nl->cap * 2 : 4;
+        int *grown = (int *) mem_realloc(MEM_GRAPH, nl->ids, (size_t) cap * sizeof(int));
+        if (!grown) return -1;
+        nl->ids = grown;
+        nl->cap = cap;
+    }
+    nl->ids[nl->count++] = id;
+    return 0;
+}
+
+static void neighbor_remove(NeighborList *nl, int id) {
+    for (int k = 0; k < nl->count; k++) {
+        if (nl->ids[k] == id) {
+            nl->ids[k] = nl->ids[--nl->count];
+            return;
+        }
+    }
+}
+
+// Add delta to src -> dst. Only fails (leaving H unchanged) when a neighbour list
+// cannot grow; undoing an applied change never needs to grow one.
+static int apply_cell(IncrementalIso *inc, int src, int dst, int delta) {
+    bool was = joined(inc, src, dst);
+    inc->adj_h[(size_t) src * inc->n_h + dst] += delta;
+    bool now = joined(inc, src, dst);
+
+    if (src != dst && was != now) {
+        if (now) {
+            if (neighbor_add(&inc->nbrs[src], dst) != 0) {
+                inc->adj_h[(size_t) src * inc->n_h + dst] -= delta;
+                return -1;
+            }
+            if (neighbor_add(&inc->nbrs[dst], src) != 0) {
+                neighbor_remove(&inc->nbrs[src], dst);
+                inc->adj_h[(size_t) src * inc->n_h + dst] -= delta;
+                return -1;
+            }
+        } else {
+            neighbor_remove(&inc->nbrs[src], dst);
+            neighbor_remove(&inc->nbrs[dst], src);
+        }
+    }
+    inc->out_deg_h[src] += delta;
+    inc->in_deg_h[dst] += delta;
+    return 0;
+}
+
+static int apply_updates(IncrementalIso *inc, const EdgeUpdate *updates, int count) {
+    for (int k = 0; k < count; k++) {
+        if (apply_cell(inc, updates[k].src, updates[k].dst, updates[k].delta) == 0) continue;
+        while (--k >= 0) apply_cell(inc, updates[k].src, updates[k].dst, -updates[k].delta);
+        return -1;
+    }
+    return 0;
+}
+
+static bool updates_valid(const IncrementalIso *inc, const EdgeUpdate *updates, int count) {
+    for (int k = 0; k < count; k++) {
+        const EdgeUpdate *u = &updates[k];
+        if (u->src < 0 || u->src >= inc->n_h || u->dst < 0 || u->dst >= inc->n_h) {
+            fprintf(stderr, "Error: update %d names a vertex outside H (%d -> %d)\n", k + 1, u->src, u->dst);
+            return false;
+        }
+        // Multiplicity after all updates of this cell up to this one
+        long long mult = cell(inc->adj_h, inc->n_h, u->src, u->dst);
+        for (int j = 0; j <= k; j++) {
+            if (updates[j].src == u->src && updates[j].dst == u->dst) mult += updates[j].delta;
+        }
+        if (mult < 0) {
+            fprintf(stderr, "Error: update %d makes H_%d -> H_%d negative\n", k + 1, u->src + 1, u->dst + 1);
+            return false;
+        }
+    }
+    return true;
+}
+
+// Move what is only in a into only_a, what is only in b into only_b, and free the rest.
+// Both sets must be sorted; they are emptied.
+static void split_sets(EmbeddingSet *a, EmbeddingSet *b, EmbeddingSet *only_a, EmbeddingSet *only_b) {
+    only_a->n_g = only_b->n_g = a->n_g;
+    only_a->mappings = a->mappings;
+    only_b->mappings = b->mappings;
+    only_a->count = only_b->count = 0;
+    int i = 0, j = 0;
+    while (i < a->count || j < b->count) {
+        int c = i == a->count ? 1 : j == b->count ? -1 : compare_mappings(a->mappings[i], b->mappings[j], a->n_g);
+        if (c < 0) {
+            only_a->mappings[only_a->count++] = a->mappings[i++];
+        } else if (c > 0) {
+            only_b->mappings[only_b->count++] = b->mappings[j++];
+        } else {
+            mem_free(a->mappings[i++]);
+            mem_free(b->mappings[j++]);
+        }
+    }
+    a->mappings = b->mappings = NULL;
+    a->count = b->count = 0;
+}
+
+// ============================================================================
+// Public API
+// ============================================================================
+
+// Breadth-first over G (edges taken in both directions) from each anchor
+static int plan_searches(IncrementalIso *inc) {
+    int n_g = inc->n_g;
+    bool *placed = (bool *) mem_alloc(MEM_RESULTS, (n_g > 0 ? (size_t) n_g : 1) * sizeof(bool));
+    if (!placed) return -1;
+    for (int a = 0; a < n_g; a++) {
+        int *order = inc->order + (size_t) a * n_g;
+        int *parent = inc->parent + (size_t) a * n_g;
+        memset(placed, 0, (size_t) n_g * sizeof(bool));
+        int head = 0, tail = 0, next_root = 0;
+        order[tail] = a;
+        parent[tail++] = -1;
+        placed[a] = true;
+        while (tail < n_g) {
+            if (head == tail) {
+                while (placed[next_root]) next_root++;
+                order[tail] = next_root;
+                parent[tail++] = -1;
+                placed[next_root] = true;
+            }
+            int x = order[head++];
+            for (int y = 0; y < n_g; y++) {
+                if (placed[y] || (cell(inc->adj_g, n_g, x, y) == 0 && cell(inc->adj_g, n_g, y, x) == 0)) continue;
+                order[tail] = y;
+                parent[tail++] = x;
+                placed[y] = true;
+            }
+        }
+    }
+    mem_free(placed);
+    return 0;
+}
+
+IncrementalIso *incremental_iso_create(int n_g, const int *adj_g, int n_h, const int *adj_h) {
+    IncrementalIso *inc = (IncrementalIso *) mem_calloc(MEM_GRAPH, 1, sizeof(IncrementalIso));
+    if (!inc) return NULL;
+    inc->n_g = n_g;
+    inc->n_h = n_h;
+
+    size_t g_count = n_g > 0 ? (size_t) n_g : 1;
+    size_t h_count = n_h > 0 ? (size_t) n_h : 1;
+    inc->adj_g = (int *) mem_alloc(MEM_GRAPH, g_count * g_count * sizeof(int));
+    inc->out_deg_g = (int *) mem_calloc(MEM_GRAPH, g_count, sizeof(int));
+    inc->in_deg_g = (int *) mem_calloc(MEM_GRAPH, g_count, sizeof(int));
+    inc->order = (int *) mem_alloc(MEM_RESULTS, g_count * g_count * sizeof(int));
+    inc->parent = (int *) mem_alloc(MEM_RESULTS, g_count * g_count * sizeof(int));
+    inc->mapping = (int *) mem_alloc(MEM_RESULTS, g_count * sizeof(int));
+    inc->adj_h = (int *) mem_alloc(MEM_GRAPH, h_count * h_count * sizeof(int));
+    inc->out_deg_h = (int *) mem_calloc(MEM_GRAPH, h_count, sizeof(int));
+    inc->in_deg_h = (int *) mem_calloc(MEM_GRAPH, h_count, sizeof(int));
+    inc->nbrs = (NeighborList *) mem_calloc(MEM_GRAPH, h_count, sizeof(NeighborList));
+    inc->used = (bool *) mem_calloc(MEM_RESULTS, h_count, sizeof(bool));
+    inc->touched = (bool *) mem_calloc(MEM_RESULTS, h_count, sizeof(bool));
+    if (!inc->adj_g || !inc->out_deg_g || !inc->in_deg_g || !inc->order || !inc->parent || !inc->mapping ||
+        !inc->adj_h || !inc->out_deg_h || !inc->in_deg_h || !inc->nbrs || !inc->used || !inc->touched) {
+        incremental_iso_destroy(inc);
+        return NULL;
+    }
+
+    memcpy(inc->adj_g, adj_g, (size_t) n_g * n_g * sizeof(int));
+    memcpy(inc->adj_h, adj_h, (size_t) n_h * n_h * sizeof(int));
+    for (int v = 0; v < n_g; v++) {
+        inc->mapping[v] = -1;
+        for (int w = 0; w < n_g; w++) {
+            inc->out_deg_g[v] += cell(adj_g, n_g, v, w);
+            inc->in_deg_g[w] += cell(adj_g, n_g, v, w);
+        }
+    }
+    for (int u = 0; u < n_h; u++) {
+        for (int x = 0; x < n_h; x++) {
+            inc->out_deg_h[u] += cell(adj_h, n_h, u, x);
+            inc->in_deg_h[x] += cell(adj_h, n_h, u, x);
+            if (x != u && joined(inc, u, x) && neighbor_add(&inc->nbrs[u], x) != 0) {
+                incremental_iso_destroy(inc);
+                return NULL;
+            }
+        }
+    }
+    if (plan_searches(inc) != 0) {
+        incremental_iso_destroy(inc);
+        return NULL;
+    }
+    return inc;
+}
+
+void incremental_iso_destroy(IncrementalIso *inc) {
+    if (!inc) return;
+    if (inc->nbrs) {
+        for (int u = 0; u < inc->n_h; u++) mem_free(inc->nbrs[u].ids);
+    }
+    mem_free(inc->adj_g);
+    mem_free(inc->out_deg_g);
+    mem_free(inc->in_deg_g);
+    mem_free(inc->order);
+    mem_free(inc->parent);
+    mem_free(inc->mapping);
+    mem_free(inc->adj_h);
+    mem_free(inc->out_deg_h);
+    mem_free(inc->in_deg_h);
+    mem_free(inc->nbrs);
+    mem_free(inc->used);
+    mem_free(inc->touched);
+    mem_free(inc);
+}
+
+const int *incremental_iso_target(const IncrementalIso *inc) {
+    return inc->adj_h;
+}
+
+int incremental_iso_embeddings(IncrementalIso *inc, EmbeddingSet *out) {
+    memset(out, 0, sizeof(*out));
+    out->n_g = inc->n_g;
+    if (inc->n_g == 0) {
+        // The empty mapping
+        out->mappings = (int **) mem_alloc(MEM_RESULTS, sizeof(int *));
+        if (!out->mappings || !(out->mappings[0] = (int *) mem_calloc(MEM_RESULTS, 1, sizeof(int)))) {
+            mem_free(out->mappings);
+            out->mappings = NULL;
+            return -1;
+        }
+        out->count = 1;
+        return 0;
+    }
+
+    // Anchored on G_0 over all of H, with nothing marked touched
+    inc->found = out;
+    inc->found_cap = 0;
+    inc->failed = false;
+    inc->anchor = 0;
+    for (int u = 0; u < inc->n_h && !inc->failed; u++) place(inc, inc->order, inc->parent, 0, u);
+    inc->found = NULL;
+
+    if (inc->failed || sort_set(out) != 0) {
+        free_embedding_set(out);
+        return -1;
+    }
+    return 0;
+}
+
+int incremental_iso_update(IncrementalIso *inc, const EdgeUpdate *updates, int count, EmbeddingDelta *delta) {
+    memset(delta, 0, sizeof(*delta));
+    delta->gained.n_g = delta->lost.n_g = inc->n_g;
+    if (!updates_valid(inc, updates, count)) return -1;
+
+    // Only embeddings through an endpoint of a changed cell can change
+    int *touched = (int *) mem_calloc(MEM_RESULTS, (size_t) (2 * count + 1), sizeof(int));
+    if (!touched) return -1;
+    int num_touched = 0;
+    for (int k = 0; k < count; k++) {
+        if (updates[k].delta == 0) continue;
+        int ends[2] = {updates[k].src, updates[k].dst};
+        for (int e = 0; e < 2; e++) {
+            if (inc->touched[ends[e]]) continue;
+            inc->touched[ends[e]] = true;
+            touched[num_touched++] = ends[e];
+        }
+    }
+
+    inc->nodes = 0;
+    EmbeddingSet before, after;
+    int rc = search_touched(inc, touched, num_touched, &before);
+    if (rc == 0 && apply_updates(inc, updates, count) != 0) {
+        free_embedding_set(&before);
+        rc = -1;
+    }
+    if (rc == 0 && search_touched(inc, touched, num_touched, &after) != 0) {
+        // Keep H and the reported state consistent: undo the step
+        for (int k = count - 1; k >= 0; k--) apply_cell(inc, updates[k].src, updates[k].dst, -updates[k].delta);
+        free_embedding_set(&before);
+        rc = -1;
+    }
+
+    for (int k = 0; k < num_touched; k++) inc->touched[touched[k]] = false;
+    mem_free(touched);
+    if (rc != 0) {
+        fprintf(stderr, "Error: out of memory updating embeddings\n");
+        return -1;
+    }
+
+    split_sets(&before, &after, &delta->lost, &delta->gained);
+    delta->nodes = inc->nodes;
+    return 0;
+}
@@ -0,0 +1,82 @@
+#ifndef AAC_INCREMENTAL_ISOMORPHISM_H
+#define AAC_INCREMENTAL_ISOMORPHISM_H
+
+/**
+ * Subgraph isomorphisms of a fixed G kept up to date while H changes
+ *
+ * An embedding is an injective mapping G -> H under which every G cell, loops
+ * included, lands on an H cell with at least its multiplicity, and every G
+ * vertex on an H vertex with at least its in- and out-degree.
+ *
+ * Only embeddings that use an H vertex touched by an update can appear or
+ * disappear, so an update re-searches just those: each search is anchored on
+ * a touched vertex and grows along G's edges through the H neighbourhood of
+ * vertices already mapped. For a connected G the work is bounded by the part
+ * of H within G's diameter of the touched vertices, not by |H|. A G with
+ * several components still places the later ones anywhere in H.
+ */
+
+/**
+ * Change of one H cell
+ */
+typedef struct {
+    int src, dst; // H vertices (0-based)
+    int delta;    // Added to the multiplicity of src -> dst (negative to remove); must not go below 0
+} EdgeUpdate;
+
+/**
+ * Embeddings in ascending lexicographic order; mappings[k][v] = H vertex of G_v
+ */
+typedef struct {
+    int **mappings;
+    int count;
+    int n_g;
+} EmbeddingSet;
+
+/**
+ * What one update changed
+ */
+typedef struct {
+    EmbeddingSet gained; // Embeddings of the updated H that were not embeddings before
+    EmbeddingSet lost;   // Embeddings of the previous H that no longer are
+    long long nodes;     // Partial mappings tried by the two anchored searches
+} EmbeddingDelta;
+
+typedef struct IncrementalIso IncrementalIso;
+
+/**
+ * Register G against H. Both are copied; H is then only changed through
+ * incremental_iso_update. Not thread-safe: one call at a time per instance.
+ *
+ * @return The instance, or NULL on allocation failure
+ */
+IncrementalIso *incremental_iso_create(int n_g, const int *adj_g, int n_h, const int *adj_h);
+
+void incremental_iso_destroy(IncrementalIso *inc);
+
+/**
+ * Current H (n_h x n_h, row-major), valid until the next update
+ */
+const int *incremental_iso_target(const IncrementalIso *inc);
+
+/**
+ * Every embedding of G in the current H (a full search)
+ *
+ * @return 0 on success, -1 on allocation failure
+ */
+int incremental_iso_embeddings(IncrementalIso *inc, EmbeddingSet *out);
+
+/**
+ * Apply updates to H as one step and report the embeddings gained and lost.
+ * Several updates of the same cell add up. If any update names a vertex
+ * outside H or would make a multiplicity negative, H is left unchanged.
+ *
+ * @return 0 on success, -1 on an invalid update or allocation failure
+ */
+int incremental_iso_update(IncrementalIso *inc, const EdgeUpdate *updates, int count, EmbeddingDelta *delta);
+
+void free_embedding_set(EmbeddingSet *set);
+
+void free_embedding_delta(EmbeddingDelta *delta);
+
+#endif //AAC_INCREMENTAL_ISOMORPHISM_H
@@ -1,6 +1,9 @@
 #include "isomorphism.h"
 #include "product_graph.h"
-#include "../console.h"
+#include "../multiplicity.h"
+#include "../report.h"
+#include "../mem_track.h"
+#include "../trace.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -46,23 +49,49 @@ static bool mapping_exists(const IsomorphismResult *result, const int *mapping)
     return false;
 }
 
-// Add mapping to result
-static void add_mapping(IsomorphismResult *result, int *mapping) {
-    if (result->num_found >= MAX_ISOMORPHISMS) {
-        free(mapping);
-        return;
+// Add a copy of mapping to result (dropped once MAX_ISOMORPHISMS are stored).
+// Returns false if the copy cannot be allocated.
+static bool add_mapping(IsomorphismResult *result, const int *mapping) {
+    if (result->num_found >= MAX_ISOMORPHISMS) return true;
+    int n_g = result->n_g;
+    int *stored = (int *) mem_alloc(MEM_RESULTS, (n_g > 0 ? n_g : 1) * sizeof(int));
+    if (!stored) {
+        fprintf(stderr, "Error: out of memory storing isomorphism %d.\n", result->num_found + 1);
+        return false;
     }
-    result->mappings[result->num_found++] = mapping;
+    memcpy(stored, mapping, n_g * sizeof(int));
+    result->mappings[result->num_found++] = stored;
+    return true;
 }
 
-static void print_single_mapping(int idx, const int *mapping, int n_g,
-                                 int n_h, const int *adj_g, const int *adj_h) {
-    printf("\nMapping %d:\n", idx);
-    for (int v = 0; v < n_g; v++) {
-        printf("    G_%d -> H_%d\n", v + 1, mapping[v] + 1);
+// Empty result for G with n_g vertices, or NULL if it cannot be allocated
+static IsomorphismResult *new_isomorphism_result(int n_g) {
+    IsomorphismResult *result = (IsomorphismResult *) mem_alloc(MEM_RESULTS, sizeof(IsomorphismResult));
+    int **mappings = (int **) mem_alloc(MEM_RESULTS, MAX_ISOMORPHISMS * sizeof(int *));
+    if (!result || !mappings) {
+        fprintf(stderr, "Error: out of memory.\n");
+        mem_free(result);
+        mem_free(mappings);
+        return NULL;
     }
-    printf("\nH with mapped edges highlighted:\n");
-    print_matrix_with_mapping(n_h, adj_h, NULL, n_g, adj_g, mapping);
+    *result = (IsomorphismResult) {.mappings = mappings, .n_g = n_g};
+    return result;
+}
+
+// Hand a new isomorphism to the reporter (adj_h is NULL for a sparse H)
+static void report_isomorphism(const Reporter *rep, int idx, const int *mapping, int n_g,
+                               int n_h, const int *adj_g, const int *adj_h) {
+    if (!report_wants_mappings(rep)) return;
+    MappingReport m = {
+        .kind = REPORT_ISOMORPHISM,
+        .index = idx,
+        .mapping = mapping,
+        .n_g = n_g,
+        .n_h = n_h,
+        .adj_g = adj_g,
+        .adj_h = adj_h
+    };
+    report_mapping(rep, &m);
 }
 
 // ============================================================================
@@ -80,6 +109,7 @@ typedef struct {
     bool stop_requested;
     const int *adj_g;
     const int *adj_h;
+    const Reporter *rep;
 } BKContext;
 
 // Check if vertex v is compatible with all vertices in clique R
@@ -113,27 +143,35 @@ static void find_cliques_recursive(BKContext *ctx,
     if (ctx->max_to_find > 0 && ctx->result->num_found >= ctx->max_to_find) {
         return;
     }
+    STATS_INC(&ctx->result->stats, nodes);
 
 
     // Found a clique of target size
     if (r_size == ctx->target_size) {
+        STATS_INC(&ctx->result->stats, leaves);
         int *mapping = extract_mapping(ctx->pg, R, r_size);
         if (!mapping_exists(ctx->result, mapping)) {
-            add_mapping(ctx->result, mapping);
+            if (!add_mapping(ctx->result, mapping)) {
+                ctx->stop_requested = true;
+                free(mapping);
+                return;
+            }
             ctx->result->is_subgraph = true;
 
-            print_single_mapping(ctx->result->num_found, mapping, ctx->result->n_g, ctx->pg->n_h, ctx->adj_g,
-                                 ctx->adj_h);
+            report_isomorphism(ctx->rep, ctx->result->num_found, mapping, ctx->result->n_g, ctx->pg->n_h,
+                               ctx->adj_g, ctx->adj_h);
+            free(mapping);
 
             // After reaching initial target, prompt for more
             if (ctx->result->num_found >= ctx->initial_target) {
                 if (!ctx->interactive) {
                     ctx->stop_requested = true;
-                } else if (!prompt_continue("Continue searching for more isomorphisms?")) {
+                } else if (!report_confirm(ctx->rep, "Continue searching for more isomorphisms?")) {
                     ctx->stop_requested = true;
                 }
             }
         } else {
+            STATS_INC(&ctx->result->stats, duplicates);
             free(mapping);
         }
         return;
@@ -141,6 +179,7 @@ static void find_cliques_recursive(BKContext *ctx,
 
     // Pruning: can't reach target size
     if (r_size + num_candidates < ctx->target_size) {
+        STATS_INC(&ctx->result->stats, pruned);
         return;
     }
 
@@ -155,6 +194,7 @@ static void find_cliques_recursive(BKContext *ctx,
 
         // Check if v is compatible with current clique
         if (!is_compatible_with_clique(ctx->pg, v, R, r_size)) {
+            STATS_INC(&ctx->result->stats, pruned);
             continue;
         }
 
@@ -188,43 +228,46 @@ static void find_cliques_recursive(BKContext *ctx,
 }
 
 IsomorphismResult *find_isomorphisms_exact(int n_g, const int *adj_g,
-                                           int n_h, const int *adj_h,
-                                           int n, bool interactive) {
-    IsomorphismResult *result = (IsomorphismResult *) malloc(sizeof(IsomorphismResult));
-    result->mappings = (int **) malloc(MAX_ISOMORPHISMS * sizeof(int *));
-    result->num_found = 0;
-    result->n_g = n_g;
-    result->is_subgraph = false;
+                                           int n_h, const int *adj_h, const HIndex *h_index,
+                                           CandidateCache *h_candidates,
+                                           int n, bool interactive, const Reporter *rep) {
+    IsomorphismResult *result = new_isomorphism_result(n_g);
+    if (!result) return NULL;
 
 
     // Edge case
     if (n_g > n_h) {
-        printf("G has more vertices than H. No isomorphism possible.\n");
+        report_note(rep, "G has more vertices than H. No isomorphism possible.\n");
         return result;
     }
 
     if (n_g == 0) {
         // Empty G is subgraph of any H
         result->is_subgraph = true;
-        int *empty_mapping = (int *) calloc(1, sizeof(int));
-        add_mapping(result, empty_mapping);
+        int empty_mapping = 0;
+        add_mapping(result, &empty_mapping);
         return result;
     }
 
     // Build product graph
-    ProductGraph *pg = build_product_graph(n_g, adj_g, n_h, adj_h);
-    if (!pg) {
-        printf("Failed to build product graph.\n");
-        return result;
-    }
+    trace_begin("product_graph");
+    ProductGraph *pg = build_product_graph(n_g, adj_g, n_h, adj_h, h_index, h_candidates);
+    trace_end("product_graph");
+    if (!pg) return result;
 
     if (pg->num_vertices == 0) {
-        printf("Product graph is empty. No isomorphism possible.\n");
+        report_note(rep, "Product graph is empty. No isomorphism possible.\n");
         free_product_graph(pg);
         return result;
     }
 
-    printf("Product graph has %d vertices\n", pg->num_vertices);
+    report_note(rep, "Product graph has %d vertices%s\n", pg->num_vertices,
+                pg->adj_matrix ? "" : " (adjacency as a bitset to stay under the memory limit)");
+#ifdef AAC_STATS
+    result->stats.product_vertices = pg->num_vertices;
+    for (int i = 0; i < pg->num_vertices; i++) result->stats.product_edges += pg->degree[i];
+    result->stats.product_edges /= 2;
+#endif
 
     // Initialize context
     BKContext ctx = {
@@ -237,7 +280,8 @@ IsomorphismResult *find_isomorphisms_exact(int n_g, const int *adj_g,
         .interactive = interactive,
         .stop_requested = false,
         .adj_g = adj_g,
-        .adj_h = adj_h
+        .adj_h = adj_h,
+        .rep = rep
     };
     // Allocate working arrays
     int *R = (int *) malloc(pg->num_vertices * sizeof(int));
@@ -249,7 +293,9 @@ IsomorphismResult *find_isomorphisms_exact(int n_g, const int *adj_g,
     }
 
     // Find cliques
+    trace_begin("clique_search");
     find_cliques_recursive(&ctx, R, 0, candidates, pg->num_vertices);
+    trace_end("clique_search");
 
     free(R);
     free(candidates);
@@ -299,8 +345,10 @@ static void calc_total_degrees(int n, const int *adj, GreedyVertexInfo *infos) {
 // Returns true if all edges between v and already-mapped vertices are preserved
 static bool is_valid_assignment(int v, int u,
                                 int n_g, const int *adj_g,
-                                int n_h, const int *adj_h,
+                                const MultMatrix *h,
                                 const int *mapping) {
+    int n_h = h->n;
+
     // Check degree constraints
     int out_deg_g = 0, in_deg_g = 0;
     int out_deg_h = 0, in_deg_h = 0;
@@ -310,36 +358,36 @@ static bool is_valid_assignment(int v, int u,
         out_deg_g += get_adj_val(adj_g, n_g, v, j);
         in_deg_g += get_adj_val(adj_g, n_g, j, v);
     }
-    for (int j = 0; j < n_h; j++) {
-        out_deg_h += get_adj_val(adj_h, n_h, u, j);
-        in_deg_h += get_adj_val(adj_h, n_h, j, u);
-    }
 
-    if (out_deg_g > out_deg_h || in_deg_g > in_deg_h) {
-        return false;
-    }
+    MULT_DISPATCH(h, cell_t,
+        const cell_t *h_cells = (const cell_t *) h->cells;
+        const cell_t *row_u = h_cells + (size_t) u * n_h;
 
-    // Check edge preservation with already-mapped vertices
-    for (int v2 = 0; v2 < n_g; v2++) {
-        if (mapping[v2] == -1) continue; // Not yet mapped
+        for (int j = 0; j < n_h; j++) {
+            out_deg_h += row_u[j];
+            in_deg_h += h_cells[(size_t) j * n_h + u];
+        }
 
-        int u2 = mapping[v2];
+        if (out_deg_g > out_deg_h || in_deg_g > in_deg_h) {
+            return false;
+        }
 
-        // Edge v -> v2 must be preserved as u -> u2
-        int g_mult = get_adj_val(adj_g, n_g, v, v2);
-        int h_mult = get_adj_val(adj_h, n_h, u, u2);
-        if (g_mult > h_mult) return false;
+        // Check edge preservation with already-mapped vertices
+        for (int v2 = 0; v2 < n_g; v2++) {
+            if (mapping[v2] == -1) continue; // Not yet mapped
 
-        // Edge v2 -> v must be preserved as u2 -> u
-        g_mult = get_adj_val(adj_g, n_g, v2, v);
-        h_mult = get_adj_val(adj_h, n_h, u2, u);
-        if (g_mult > h_mult) return false;
-    }
+            int u2 = mapping[v2];
+
+            // Edge v -> v2 must be preserved as u -> u2
+            if (get_adj_val(adj_g, n_g, v, v2) > row_u[u2]) return false;
 
-    // Check self-loop
-    int g_loop = get_adj_val(adj_g, n_g, v, v);
-    int h_loop = get_adj_val(adj_h, n_h, u, u);
-    if (g_loop > h_loop) return false;
+            // Edge v2 -> v must be preserved as u2 -> u
+            if (get_adj_val(adj_g, n_g, v2, v) > h_cells[(size_t) u2 * n_h + u]) return false;
+        }
+
+        // Check self-loop
+        if (get_adj_val(adj_g, n_g, v, v) > row_u[u]) return false;
+    )
 
     return true;
 }
@@ -347,7 +395,6 @@ static bool is_valid_assignment(int v, int u,
 // Score an assignment (higher = more edges preserved = better)
 static int score_assignment(int v, int u,
                             int n_g, const int *adj_g,
-                            int n_h, const int *adj_h,
                             const int *mapping) {
     int score = 0;
 
@@ -370,9 +417,10 @@ static int score_assignment(int v, int u,
 
 // Try to build a valid isomorphism starting with first_v -> first_u
 static int *try_greedy_from_start(int n_g, const int *adj_g,
-                                  int n_h, const int *adj_h,
+                                  const MultMatrix *h,
                                   const GreedyVertexInfo *sorted_g,
                                   int first_v, int first_u) {
+    int n_h = h->n;
     int *mapping = (int *) malloc(n_g * sizeof(int));
     for (int i = 0; i < n_g; i++) mapping[i] = -1;
 
@@ -394,11 +442,11 @@ static int *try_greedy_from_start(int n_g, const int *adj_g,
         for (int u = 0; u < n_h; u++) {
             if (used_h[u]) continue;
 
-            if (!is_valid_assignment(v, u, n_g, adj_g, n_h, adj_h, mapping)) {
+            if (!is_valid_assignment(v, u, n_g, adj_g, h, mapping)) {
                 continue;
             }
 
-            int score = score_assignment(v, u, n_g, adj_g, n_h, adj_h, mapping);
+            int score = score_assignment(v, u, n_g, adj_g, mapping);
 
             if (score > best_score) {
                 best_score = score;
@@ -423,38 +471,37 @@ static int *try_greedy_from_start(int n_g, const int *adj_g,
 
 // Verify that a mapping is a valid subgraph isomorphism
 static bool verify_isomorphism(int n_g, const int *adj_g,
-                               int n_h, const int *adj_h,
+                               const MultMatrix *h,
                                const int *mapping) {
-    for (int i = 0; i < n_g; i++) {
-        for (int j = 0; j < n_g; j++) {
-            int g_mult = get_adj_val(adj_g, n_g, i, j);
-            int h_mult = get_adj_val(adj_h, n_h, mapping[i], mapping[j]);
-            if (g_mult > h_mult) return false;
+    MULT_DISPATCH(h, cell_t,
+        const cell_t *h_cells = (const cell_t *) h->cells;
+        for (int i = 0; i < n_g; i++) {
+            const cell_t *row = h_cells + (size_t) mapping[i] * h->n;
+            for (int j = 0; j < n_g; j++) {
+                if (get_adj_val(adj_g, n_g, i, j) > row[mapping[j]]) return false;
+            }
         }
-    }
+    )
     return true;
 }
 
 IsomorphismResult *find_isomorphisms_greedy(int n_g, const int *adj_g,
-                                            int n_h, const int *adj_h,
-                                            int n, bool interactive) {
-    IsomorphismResult *result = (IsomorphismResult *) malloc(sizeof(IsomorphismResult));
-    result->mappings = (int **) malloc(MAX_ISOMORPHISMS * sizeof(int *));
-    result->num_found = 0;
-    result->n_g = n_g;
-    result->is_subgraph = false;
+                                            int n_h, const int *adj_h, const HIndex *h_index,
+                                            int n, bool interactive, const Reporter *rep) {
+    IsomorphismResult *result = new_isomorphism_result(n_g);
+    if (!result) return NULL;
 
 
     // Edge cases
     if (n_g > n_h) {
-        printf("G has more vertices than H. No isomorphism possible.\n");
+        report_note(rep, "G has more vertices than H. No isomorphism possible.\n");
         return result;
     }
 
     if (n_g == 0) {
         result->is_subgraph = true;
-        int *empty_mapping = (int *) calloc(1, sizeof(int));
-        add_mapping(result, empty_mapping);
+        int empty_mapping = 0;
+        add_mapping(result, &empty_mapping);
         return result;
     }
 
@@ -463,42 +510,72 @@ IsomorphismResult *find_isomorphisms_greedy(int n_g, const int *adj_g,
     calc_total_degrees(n_g, adj_g, sorted_g);
     qsort(sorted_g, n_g, sizeof(GreedyVertexInfo), compare_by_degree_desc);
 
-    // Also sort H vertices by degree for smarter iteration
-    GreedyVertexInfo *sorted_h = (GreedyVertexInfo *) malloc(n_h * sizeof(GreedyVertexInfo));
-    calc_total_degrees(n_h, adj_h, sorted_h);
-    qsort(sorted_h, n_h, sizeof(GreedyVertexInfo), compare_by_degree_desc);
+    // Also sort H vertices by degree for smarter iteration (same order as the index's)
+    int *own_order = NULL;
+    if (!h_index) {
+        GreedyVertexInfo *sorted_h = (GreedyVertexInfo *) malloc(n_h * sizeof(GreedyVertexInfo));
+        calc_total_degrees(n_h, adj_h, sorted_h);
+        qsort(sorted_h, n_h, sizeof(GreedyVertexInfo), compare_by_degree_desc);
+        own_order = (int *) malloc(n_h * sizeof(int));
+        for (int k = 0; k < n_h; k++) own_order[k] = sorted_h[k].id;
+        free(sorted_h);
+    }
+    const int *h_order = h_index ? h_index->order : own_order;
+
+    // Narrow copy of H for the validity checks
+    MultMatrix h;
+    int rc;
+    bool own_cells = !(h_index && h_index->cells.cells);
+    if (!own_cells) {
+        h = h_index->cells;
+    } else if ((rc = mult_matrix_init(&h, n_h, adj_h, 0)) != 0) {
+        fprintf(stderr, rc == MULT_NEGATIVE ? "Error: negative multiplicity in H.\n"
+                                            : "Error: out of memory copying H.\n");
+        free(sorted_g);
+        free(own_order);
+        return result;
+    }
 
     // The anchor vertex: highest degree in G
     int anchor_v = sorted_g[0].id;
 
     bool stop = false;
+    trace_begin("greedy_search");
 
     /// Try each possible starting assignment for anchor vertex
     for (int h_idx = 0; h_idx < n_h && !stop; h_idx++) {
-        int start_u = sorted_h[h_idx].id;
+        int start_u = h_order[h_idx];
 
-        int *mapping = try_greedy_from_start(n_g, adj_g, n_h, adj_h,
+        int *mapping = try_greedy_from_start(n_g, adj_g, &h,
                                              sorted_g, anchor_v, start_u);
+        STATS_INC(&result->stats, starts);
 
-        if (mapping == NULL) continue;
-        if (!verify_isomorphism(n_g, adj_g, n_h, adj_h, mapping)) {
+        if (mapping == NULL) {
+            STATS_INC(&result->stats, failed_starts);
+            continue;
+        }
+        if (!verify_isomorphism(n_g, adj_g, &h, mapping)) {
+            STATS_INC(&result->stats, failed_starts);
             free(mapping);
             continue;
         }
         if (mapping_exists(result, mapping)) {
+            STATS_INC(&result->stats, duplicates);
             free(mapping);
             continue;
         }
 
-        add_mapping(result, mapping);
+        bool stored = add_mapping(result, mapping);
+        free(mapping);
+        if (!stored) break;
         result->is_subgraph = true;
 
-        printf("Found isomorphism %d (anchor G_%d -> H_%d)\n",
-               result->num_found, anchor_v + 1, start_u + 1);
-        print_single_mapping(result->num_found, result->mappings[result->num_found - 1], n_g, n_h, adj_g, adj_h);
+        report_note(rep, "Found isomorphism %d (anchor G_%d -> H_%d)\n",
+                    result->num_found, anchor_v + 1, start_u + 1);
+        report_isomorphism(rep, result->num_found, result->mappings[result->num_found - 1], n_g, n_h, adj_g, adj_h);
 
         if (result->num_found >= n) {
-            if (!interactive) { stop = true; } else if (!prompt_continue("Continue searching for more isomorphisms?")) {
+            if (!interactive) { stop = true; } else if (!report_confirm(rep, "Continue searching for more isomorphisms?")) {
                 stop = true;
             }
         }
@@ -509,64 +586,275 @@ IsomorphismResult *find_isomorphisms_greedy(int n_g, const int *adj_g,
         int alt_anchor = sorted_g[g_idx].id;
 
         for (int h_idx = 0; h_idx < n_h && !stop; h_idx++) {
-            int start_u = sorted_h[h_idx].id;
+            int start_u = h_order[h_idx];
 
-            int *mapping = try_greedy_from_start(n_g, adj_g, n_h, adj_h,
+            int *mapping = try_greedy_from_start(n_g, adj_g, &h,
                                                  sorted_g, alt_anchor, start_u);
+            STATS_INC(&result->stats, starts);
 
-            if (mapping == NULL) continue;
-            if (!verify_isomorphism(n_g, adj_g, n_h, adj_h, mapping)) {
+            if (mapping == NULL) {
+                STATS_INC(&result->stats, failed_starts);
+                continue;
+            }
+            if (!verify_isomorphism(n_g, adj_g, &h, mapping)) {
+                STATS_INC(&result->stats, failed_starts);
                 free(mapping);
                 continue;
             }
             if (mapping_exists(result, mapping)) {
+                STATS_INC(&result->stats, duplicates);
                 free(mapping);
                 continue;
             }
 
-            add_mapping(result, mapping);
+            bool stored = add_mapping(result, mapping);
+            free(mapping);
+            if (!stored) {
+                stop = true;
+                continue;
+            }
             result->is_subgraph = true;
 
-            printf("Found isomorphism %d (alt anchor G_%d -> H_%d)\n",
-                   result->num_found, alt_anchor + 1, start_u + 1);
-            print_single_mapping(result->num_found, result->mappings[result->num_found - 1], n_g, n_h, adj_g, adj_h);
+            report_note(rep, "Found isomorphism %d (alt anchor G_%d -> H_%d)\n",
+                        result->num_found, alt_anchor + 1, start_u + 1);
+            report_isomorphism(rep, result->num_found, result->mappings[result->num_found - 1], n_g, n_h, adj_g, adj_h);
 
             if (result->num_found >= n) {
-                if (!interactive) { stop = true; } else if (!prompt_continue(
+                if (!interactive) { stop = true; } else if (!report_confirm(rep, 
                     "Continue searching for more isomorphisms?")) { stop = true; }
             }
         }
     }
 
+    trace_end("greedy_search");
+
+    if (own_cells) mult_matrix_free(&h);
     free(sorted_g);
-    free(sorted_h);
+    free(own_order);
     return result;
 }
 
 // ============================================================================
-// Utility Functions
+// Heuristic Algorithm on Sparse H (CSR)
 // ============================================================================
 
-void free_isomorphism_result(IsomorphismResult *result) {
-    if (result) {
-        for (int i = 0; i < result->num_found; i++) {
-            free(result->mappings[i]);
+// Same greedy as above, but H is only touched through its edges: candidates for
+// v come from the H neighbours of an already-mapped G neighbour, and edge checks
+// use hash lookups. Every G vertex has a constant score, so the dense version
+// picks the lowest-id valid u; scanning sorted neighbour lists finds the same u.
+
+typedef struct {
+    int n_g;
+    const int *adj_g;
+    const SparseGraph *h;
+    int *g_out_deg, *g_in_deg;
+    const int *h_out_deg, *h_in_deg;
+} SparseGreedyContext;
+
+static bool is_valid_assignment_sparse(const SparseGreedyContext *ctx, int v, int u, const int *mapping) {
+    int n_g = ctx->n_g;
+
+    if (ctx->g_out_deg[v] > ctx->h_out_deg[u] || ctx->g_in_deg[v] > ctx->h_in_deg[u]) {
+        return false;
+    }
+
+    for (int v2 = 0; v2 < n_g; v2++) {
+        if (mapping[v2] == -1) continue;
+        int u2 = mapping[v2];
+
+        int g_mult = get_adj_val(ctx->adj_g, n_g, v, v2);
+        if (g_mult > 0 && g_mult > sparse_graph_mult(ctx->h, u, u2)) return false;
+        g_mult = get_adj_val(ctx->adj_g, n_g, v2, v);
+        if (g_mult > 0 && g_mult > sparse_graph_mult(ctx->h, u2, u)) return false;
+    }
+
+    int g_loop = get_adj_val(ctx->adj_g, n_g, v, v);
+    return g_loop == 0 || g_loop <= sparse_graph_mult(ctx->h, u, u);
+}
+
+// Lowest-id unused H vertex that v can be mapped to, or -1
+static int first_valid_candidate(const SparseGreedyContext *ctx, int v,
+                                 const int *mapping, const bool *used_h) {
+    const SparseGraph *h = ctx->h;
+
+    // A mapped neighbour restricts u to the H neighbours of its image
+    for (int j = 0; j < ctx->n_g; j++) {
+        if (j == v || mapping[j] == -1) continue;
+        int x = mapping[j];
+        if (get_adj_val(ctx->adj_g, ctx->n_g, j, v) > 0) {
+            for (int k = h->out_start[x]; k < h->out_start[x + 1]; k++) {
+                int u = h->out_dst[k];
+                if (!used_h[u] && is_valid_assignment_sparse(ctx, v, u, mapping)) return u;
+            }
+            return -1;
+        }
+        if (get_adj_val(ctx->adj_g, ctx->n_g, v, j) > 0) {
+            for (int k = h->in_start[x]; k < h->in_start[x + 1]; k++) {
+                int u = h->in_src[k];
+                if (!used_h[u] && is_valid_assignment_sparse(ctx, v, u, mapping)) return u;
+            }
+            return -1;
         }
-        free(result->mappings);
-        free(result);
     }
+
+    for (int u = 0; u < h->n; u++) {
+        if (!used_h[u] && is_valid_assignment_sparse(ctx, v, u, mapping)) return u;
+    }
+    return -1;
 }
 
-void print_isomorphism_result(const IsomorphismResult *result) {
-    printf("\n--- Isomorphism Result ---\n");
-    printf("Subgraph isomorphism exists: %s\n", result->is_subgraph ? "YES" : "NO");
-    printf("Number of isomorphisms found: %d\n", result->num_found);
+static int *try_greedy_from_start_sparse(const SparseGreedyContext *ctx,
+                                         const GreedyVertexInfo *sorted_g,
+                                         bool *used_h, int first_v, int first_u) {
+    int n_g = ctx->n_g;
+    int *mapping = (int *) malloc(n_g * sizeof(int));
+    for (int i = 0; i < n_g; i++) mapping[i] = -1;
 
+    mapping[first_v] = first_u;
+    used_h[first_u] = true;
 
-    for (int i = 0; i < result->num_found; i++) {
-        printf("\nMapping %d:\n", i + 1);
-        for (int v = 0; v < result->n_g; v++) {
-            printf("    G_%d -> H_%d\n", v + 1, result->mappings[i][v] + 1);
+    bool ok = true;
+    for (int i = 0; i < n_g && ok; i++) {
+        int v = sorted_g[i].id;
+        if (mapping[v] != -1) continue;
+
+        int u = first_valid_candidate(ctx, v, mapping, used_h);
+        if (u == -1) {
+            ok = false;
+        } else {
+            mapping[v] = u;
+            used_h[u] = true;
+        }
+    }
+
+    // used_h is shared across starts: clear only what this start set
+    for (int v = 0; v < n_g; v++) {
+        if (mapping[v] != -1) used_h[mapping[v]] = false;
+    }
+    if (!ok) {
+        free(mapping);
+        return NULL;
+    }
+    return mapping;
+}
+
+static bool verify_isomorphism_sparse(int n_g, const int *adj_g, const SparseGraph *h, const int *mapping) {
+    for (int i = 0; i < n_g; i++) {
+        for (int j = 0; j < n_g; j++) {
+            int g_mult = get_adj_val(adj_g, n_g, i, j);
+            if (g_mult > 0 && g_mult > sparse_graph_mult(h, mapping[i], mapping[j])) return false;
+        }
+    }
+    return true;
+}
+
+IsomorphismResult *find_isomorphisms_greedy_sparse(int n_g, const int *adj_g,
+                                                   const SparseGraph *h, const HIndex *h_index,
+                                                   int n, bool interactive, const Reporter *rep) {
+    int n_h = h->n;
+    IsomorphismResult *result = new_isomorphism_result(n_g);
+    if (!result) return NULL;
+
+    if (n_g > n_h) {
+        report_note(rep, "G has more vertices than H. No isomorphism possible.\n");
+        return result;
+    }
+
+    // H degrees and vertex order are the index's; without one, index H here
+    HIndex *own_index = h_index ? NULL : h_index_build_sparse(h);
+    if (!h_index) h_index = own_index;
+    if (!h_index) {
+        fprintf(stderr, "Error: out of memory indexing H.\n");
+        return result;
+    }
+
+    SparseGreedyContext ctx = {
+        .n_g = n_g,
+        .adj_g = adj_g,
+        .h = h,
+        .g_out_deg = (int *) calloc(n_g, sizeof(int)),
+        .g_in_deg = (int *) calloc(n_g, sizeof(int)),
+        .h_out_deg = h_index->out_deg,
+        .h_in_deg = h_index->in_deg
+    };
+    for (int i = 0; i < n_g; i++) {
+        for (int j = 0; j < n_g; j++) {
+            ctx.g_out_deg[i] += get_adj_val(adj_g, n_g, i, j);
+            ctx.g_in_deg[j] += get_adj_val(adj_g, n_g, i, j);
+        }
+    }
+
+    GreedyVertexInfo *sorted_g = (GreedyVertexInfo *) malloc(n_g * sizeof(GreedyVertexInfo));
+    calc_total_degrees(n_g, adj_g, sorted_g);
+    qsort(sorted_g, n_g, sizeof(GreedyVertexInfo), compare_by_degree_desc);
+
+    bool *used_h = (bool *) calloc(n_h, sizeof(bool));
+    bool stop = false;
+
+    // Anchor each G vertex in turn (highest degree first) on every H vertex
+    trace_begin("greedy_search");
+    for (int g_idx = 0; g_idx < n_g && !stop; g_idx++) {
+        int anchor = sorted_g[g_idx].id;
+
+        for (int h_idx = 0; h_idx < n_h && !stop; h_idx++) {
+            int start_u = h_index->order[h_idx];
+
+            int *mapping = try_greedy_from_start_sparse(&ctx, sorted_g, used_h, anchor, start_u);
+            STATS_INC(&result->stats, starts);
+            if (mapping == NULL) {
+                STATS_INC(&result->stats, failed_starts);
+                continue;
+            }
+            if (!verify_isomorphism_sparse(n_g, adj_g, h, mapping)) {
+                STATS_INC(&result->stats, failed_starts);
+                free(mapping);
+                continue;
+            }
+            if (mapping_exists(result, mapping)) {
+                STATS_INC(&result->stats, duplicates);
+                free(mapping);
+                continue;
+            }
+
+            bool stored = add_mapping(result, mapping);
+            free(mapping);
+            if (!stored) {
+                stop = true;
+                continue;
+            }
+            result->is_subgraph = true;
+
+            report_note(rep, "Found isomorphism %d (%sanchor G_%d -> H_%d)\n",
+                        result->num_found, g_idx == 0 ? "" : "alt ", anchor + 1, start_u + 1);
+            report_isomorphism(rep, result->num_found, result->mappings[result->num_found - 1], n_g, n_h, adj_g,
+                               NULL);
+
+            if (result->num_found >= n) {
+                if (!interactive) { stop = true; } else if (!report_confirm(rep, 
+                    "Continue searching for more isomorphisms?")) { stop = true; }
+            }
+        }
+    }
+    trace_end("greedy_search");
+
+    free(used_h);
+    free(sorted_g);
+    free(ctx.g_out_deg);
+    free(ctx.g_in_deg);
+    free_h_index(own_index);
+    return result;
+}
+
+// ============================================================================
+// Utility Functions
+// ============================================================================
+
+void free_isomorphism_result(IsomorphismResult *result) {
+    if (result) {
+        for (int i = 0; i < result->num_found; i++) {
+            mem_free(result->mappings[i]);
         }
+        mem_free(result->mappings);
+        mem_free(result);
     }
 }
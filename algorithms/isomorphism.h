@@ -2,6 +2,11 @@
 #define AAC_ISOMORPHISM_H
 
 #include <stdbool.h>
+#include "../sparse_graph.h"
+#include "../h_index.h"
+#include "../candidate_cache.h"
+#include "../report.h"
+#include "../search_stats.h"
 
 /**
  * Result structure for isomorphism finding
@@ -11,6 +16,7 @@ typedef struct {
     int num_found; // Number of isomorphisms found
     int n_g; // Size of G (for interpreting mappings)
     bool is_subgraph; // True if at least one isomorphism exists (G is subgraph of H)
+    SearchStats stats; // Search counters (AAC_STATS builds only)
 } IsomorphismResult;
 
 /**
@@ -20,12 +26,17 @@ typedef struct {
  * @param adj_g Adjacency matrix of G (flattened)
  * @param n_h Number of vertices in H
  * @param adj_h Adjacency matrix of H (flattened)
+ * @param h_index Precomputed tables for H, or NULL
+ * @param h_candidates H-side candidate sets shared with other patterns (over h_index), or NULL
  * @param n Maximum number of isomorphisms to find (0 = find all)
- * @return IsomorphismResult (caller must free with free_isomorphism_result)
+ * @param interactive Ask rep whether to go on once n isomorphisms are found
+ * @param rep Receives progress notes and each isomorphism (NULL = silent)
+ * @return IsomorphismResult (caller must free with free_isomorphism_result), or NULL if out of memory
  */
 IsomorphismResult *find_isomorphisms_exact(int n_g, const int *adj_g,
-                                           int n_h, const int *adj_h,
-                                           int n, bool interactive);
+                                           int n_h, const int *adj_h, const HIndex *h_index,
+                                           CandidateCache *h_candidates,
+                                           int n, bool interactive, const Reporter *rep);
 
 /**
  * Find up to n distinct subgraph isomorphisms using heuristic (greedy clique)
@@ -34,22 +45,41 @@ IsomorphismResult *find_isomorphisms_exact(int n_g, const int *adj_g,
  * @param adj_g Adjacency matrix of G (flattened)
  * @param n_h Number of vertices in H
  * @param adj_h Adjacency matrix of H (flattened)
+ * @param h_index Precomputed tables for H, or NULL
  * @param n Maximum number of isomorphisms to find
- * @return IsomorphismResult (caller must free with free_isomorphism_result)
+ * @param interactive Ask rep whether to go on once n isomorphisms are found
+ * @param rep Receives progress notes and each isomorphism (NULL = silent)
+ * @return IsomorphismResult (caller must free with free_isomorphism_result), or NULL if out of memory
  */
 IsomorphismResult *find_isomorphisms_greedy(int n_g, const int *adj_g,
-                                            int n_h, const int *adj_h,
-                                            int n, bool interactive);
+                                            int n_h, const int *adj_h, const HIndex *h_index,
+                                            int n, bool interactive, const Reporter *rep);
 
 /**
- * Free memory allocated for isomorphism result
+ * Heuristic isomorphism search on a sparse H (CSR)
+ *
+ * Same mappings as find_isomorphisms_greedy on the equivalent dense matrix, but
+ * H is only accessed through its edge lists and hash index, so memory and time
+ * scale with the number of edges instead of n_h^2. Mappings are reported
+ * without the H matrix (adj_h is NULL).
+ *
+ * @param n_g Number of vertices in G
+ * @param adj_g Adjacency matrix of G (flattened)
+ * @param h Sparse graph H
+ * @param h_index Precomputed tables for H, or NULL
+ * @param n Maximum number of isomorphisms to find
+ * @param interactive Ask rep whether to go on once n isomorphisms are found
+ * @param rep Receives progress notes and each isomorphism (NULL = silent)
+ * @return IsomorphismResult (caller must free with free_isomorphism_result), or NULL if out of memory
  */
-void free_isomorphism_result(IsomorphismResult *result);
+IsomorphismResult *find_isomorphisms_greedy_sparse(int n_g, const int *adj_g,
+                                                   const SparseGraph *h, const HIndex *h_index,
+                                                   int n, bool interactive, const Reporter *rep);
 
 /**
- * Print isomorphism results
+ * Free memory allocated for isomorphism result
  */
-void print_isomorphism_result(const IsomorphismResult *result);
+void free_isomorphism_result(IsomorphismResult *result);
 
 /**
  * Check if two mappings are identical
@@ -1,27 +1,36 @@
 #include "minimal_extension.h"
-#include "../console.h"
+#include "../report.h"
+#include "../multiplicity.h"
+#include "../mem_track.h"
+#include "../trace.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdbool.h>
 #include <limits.h>
 
-#define MAX_VERTICES 20
+#define MAX_VERTICES EXT_EXACT_MAX_VERTICES
 #define MAX_MAPPINGS 4096
 
 // ============================================================================
 // Internal State for Backtracking (single mapping)
 // ============================================================================
 
-static int g_min_deficit;
-static int g_best_mapping[MAX_VERTICES];
-static int g_n_g, g_n_h;
-static const int *g_adj_g;
-static int *g_adj_h_working; // Working copy of H that we modify
+// Per-call search state, so concurrent calls (batch mode) do not share anything
+typedef struct {
+    int min_deficit;
+    int best_mapping[MAX_VERTICES];
+    int n_g, n_h;
+    const int *adj_g;
+    int *adj_h_working; // Working copy of H that we modify
+    MultMatrix h_cells;  // Narrow mirror of adj_h_working, read by the search
 
-// Already found mappings (to ensure distinctness)
-static int g_found_mappings[MAX_MAPPINGS][MAX_VERTICES];
-static int g_num_found;
+    // Already found mappings (to ensure distinctness)
+    int found_mappings[MAX_MAPPINGS][MAX_VERTICES];
+    int num_found;
+
+    SearchStats *stats; // The result's counters
+} ExactSearch;
 
 // ============================================================================
 // Helper Functions
@@ -36,11 +45,11 @@ static inline void set_adj(int *adj, int n, int i, int j, int val) {
 }
 
 // Check if mapping is distinct from all previously found
-static bool is_distinct_mapping(const int *mapping) {
-    for (int i = 0; i < g_num_found; i++) {
+static bool is_distinct_mapping(const ExactSearch *s, const int *mapping) {
+    for (int i = 0; i < s->num_found; i++) {
         bool same = true;
-        for (int v = 0; v < g_n_g && same; v++) {
-            if (g_found_mappings[i][v] != mapping[v]) {
+        for (int v = 0; v < s->n_g && same; v++) {
+            if (s->found_mappings[i][v] != mapping[v]) {
                 same = false;
             }
         }
@@ -50,56 +59,57 @@ static bool is_distinct_mapping(const int *mapping) {
 }
 
 // Calculate deficit for a complete mapping against working H'
-static int calculate_deficit(const int *mapping) {
+static int calculate_deficit(const ExactSearch *s, const int *mapping) {
     int deficit = 0;
-    for (int i = 0; i < g_n_g; i++) {
-        for (int j = 0; j < g_n_g; j++) {
-            int g_mult = get_adj(g_adj_g, g_n_g, i, j);
-            if (g_mult > 0) {
-                int h_mult = get_adj(g_adj_h_working, g_n_h, mapping[i], mapping[j]);
-                if (h_mult < g_mult) {
-                    deficit += (g_mult - h_mult);
+    MULT_DISPATCH(&s->h_cells, cell_t,
+        const cell_t *h_cells = (const cell_t *) s->h_cells.cells;
+        for (int i = 0; i < s->n_g; i++) {
+            const cell_t *row = h_cells + (size_t) mapping[i] * s->n_h;
+            for (int j = 0; j < s->n_g; j++) {
+                int g_mult = get_adj(s->adj_g, s->n_g, i, j);
+                if (g_mult > 0) {
+                    int h_mult = row[mapping[j]];
+                    if (h_mult < g_mult) {
+                        deficit += (g_mult - h_mult);
+                    }
                 }
             }
         }
-    }
+    )
     return deficit;
 }
 
-static void print_mapping_inline(const int *mapping, int n_g) {
-    printf("  Mapping: ");
-    for (int v = 0; v < n_g; v++)
-        printf("G_%d->H_%d ", v + 1, mapping[v] + 1);
-    printf("\n");
-}
-
 // ============================================================================
 // Backtracking to Find Single Best Mapping
 // ============================================================================
 
-static void backtrack_single(int v_idx, int *mapping, bool *used_h) {
+static void backtrack_single(ExactSearch *s, int v_idx, int *mapping, bool *used_h) {
+    STATS_INC(s->stats, nodes);
+
     // Base case: all vertices mapped
-    if (v_idx == g_n_g) {
+    if (v_idx == s->n_g) {
+        STATS_INC(s->stats, leaves);
         // Check distinctness
-        if (!is_distinct_mapping(mapping)) {
+        if (!is_distinct_mapping(s, mapping)) {
+            STATS_INC(s->stats, duplicates);
             return;
         }
 
-        int deficit = calculate_deficit(mapping);
-        if (deficit < g_min_deficit) {
-            g_min_deficit = deficit;
-            memcpy(g_best_mapping, mapping, g_n_g * sizeof(int));
+        int deficit = calculate_deficit(s, mapping);
+        if (deficit < s->min_deficit) {
+            s->min_deficit = deficit;
+            memcpy(s->best_mapping, mapping, s->n_g * sizeof(int));
         }
         return;
     }
 
     // Try mapping v_idx to each unused vertex in H
-    for (int u = 0; u < g_n_h; u++) {
+    for (int u = 0; u < s->n_h; u++) {
         if (!used_h[u]) {
             mapping[v_idx] = u;
             used_h[u] = true;
 
-            backtrack_single(v_idx + 1, mapping, used_h);
+            backtrack_single(s, v_idx + 1, mapping, used_h);
 
             used_h[u] = false;
         }
@@ -107,40 +117,44 @@ static void backtrack_single(int v_idx, int *mapping, bool *used_h) {
 }
 
 // Find the best single mapping for current state of H'
-static bool find_best_mapping(int *out_mapping, int *out_deficit) {
-    g_min_deficit = INT_MAX;
+static bool find_best_mapping(ExactSearch *s, int *out_mapping, int *out_deficit) {
+    s->min_deficit = INT_MAX;
 
-    int *mapping = (int *) malloc(g_n_g * sizeof(int));
-    bool *used_h = (bool *) calloc(g_n_h, sizeof(bool));
-
-    backtrack_single(0, mapping, used_h);
+    int *mapping = (int *) mem_alloc(MEM_EXTENSION, s->n_g * sizeof(int));
+    bool *used_h = (bool *) mem_calloc(MEM_EXTENSION, s->n_h, sizeof(bool));
+    if (mapping && used_h) {
+        backtrack_single(s, 0, mapping, used_h);
+    } else {
+        fprintf(stderr, "Error: out of memory.\n");
+    }
 
-    free(mapping);
-    free(used_h);
+    mem_free(mapping);
+    mem_free(used_h);
 
-    if (g_min_deficit == INT_MAX) {
+    if (s->min_deficit == INT_MAX) {
         return false; // No valid distinct mapping found
     }
 
-    memcpy(out_mapping, g_best_mapping, g_n_g * sizeof(int));
-    *out_deficit = g_min_deficit;
+    memcpy(out_mapping, s->best_mapping, s->n_g * sizeof(int));
+    *out_deficit = s->min_deficit;
     return true;
 }
 
 // Apply mapping: add edges to working H' to satisfy this mapping
-static int apply_mapping_edges(const int *mapping) {
+static int apply_mapping_edges(ExactSearch *s, const int *mapping) {
     int edges_added = 0;
 
-    for (int i = 0; i < g_n_g; i++) {
-        for (int j = 0; j < g_n_g; j++) {
-            int g_mult = get_adj(g_adj_g, g_n_g, i, j);
+    for (int i = 0; i < s->n_g; i++) {
+        for (int j = 0; j < s->n_g; j++) {
+            int g_mult = get_adj(s->adj_g, s->n_g, i, j);
             int u_i = mapping[i];
             int u_j = mapping[j];
-            int h_mult = get_adj(g_adj_h_working, g_n_h, u_i, u_j);
+            int h_mult = get_adj(s->adj_h_working, s->n_h, u_i, u_j);
 
             if (h_mult < g_mult) {
                 int to_add = g_mult - h_mult;
-                set_adj(g_adj_h_working, g_n_h, u_i, u_j, g_mult);
+                set_adj(s->adj_h_working, s->n_h, u_i, u_j, g_mult);
+                mult_set(&s->h_cells, u_i, u_j, g_mult);
                 edges_added += to_add;
             }
         }
@@ -155,15 +169,9 @@ static int apply_mapping_edges(const int *mapping) {
 
 ExtensionResult *find_minimal_extension_exact(int n_g, const int *adj_g,
                                               int n_h, const int *adj_h,
-                                              int n, bool interactive) {
-    ExtensionResult *result = (ExtensionResult *) malloc(sizeof(ExtensionResult));
-    result->mappings = (int **) malloc(MAX_MAPPINGS * sizeof(int *));
-    result->num_mappings = 0;
-    result->n_g = n_g;
-    result->n_h = n_h;
-    result->total_edges_added = 0;
-    result->extended_adj_h = (int *) malloc((size_t) n_h * n_h * sizeof(int));
-    memcpy(result->extended_adj_h, adj_h, (size_t) n_h * n_h * sizeof(int));
+                                              int n, bool interactive, const Reporter *rep) {
+    ExtensionResult *result = new_extension_result(n_g, n_h, adj_h, MAX_MAPPINGS);
+    if (!result) return NULL;
 
     if (n_g > n_h) {
         fprintf(stderr, "Error: G has more vertices than H.\n");
@@ -174,60 +182,92 @@ ExtensionResult *find_minimal_extension_exact(int n_g, const int *adj_g,
         return result;
     }
 
-    g_n_g = n_g;
-    g_n_h = n_h;
-    g_adj_g = adj_g;
-    g_adj_h_working = result->extended_adj_h;
-    g_num_found = 0;
-
-    int *prev_adj_h = (int *) malloc((size_t) n_h * n_h * sizeof(int));
+    ExactSearch *s = (ExactSearch *) mem_alloc(MEM_EXTENSION, sizeof(ExactSearch));
+    int *prev_adj_h = (int *) mem_alloc(MEM_EXTENSION, (size_t) n_h * n_h * sizeof(int));
+    if (!s || !prev_adj_h) {
+        mem_free(s);
+        mem_free(prev_adj_h);
+        fprintf(stderr, "Error: out of memory.\n");
+        return result;
+    }
+    s->n_g = n_g;
+    s->n_h = n_h;
+    s->adj_g = adj_g;
+    s->adj_h_working = result->extended_adj_h;
+    s->num_found = 0;
+    s->stats = &result->stats;
+
+    // H' cells never exceed the largest multiplicity of G or H
+    int rc = mult_matrix_init(&s->h_cells, n_h, adj_h, mult_max_value(adj_g, (size_t) n_g * n_g));
+    if (rc != 0) {
+        fprintf(stderr, rc == MULT_NEGATIVE ? "Error: negative multiplicity in H.\n"
+                                            : "Error: out of memory copying H.\n");
+        mem_free(s);
+        mem_free(prev_adj_h);
+        return result;
+    }
     memcpy(prev_adj_h, adj_h, (size_t) n_h * n_h * sizeof(int));
 
     int target = n;
     while (1) {
-        int *new_mapping = (int *) malloc(n_g * sizeof(int));
+        int *new_mapping = (int *) mem_alloc(MEM_RESULTS, n_g * sizeof(int));
         int deficit;
+        if (!new_mapping) {
+            fprintf(stderr, "Error: out of memory storing mapping %d.\n", result->num_mappings + 1);
+            break;
+        }
 
-        if (!find_best_mapping(new_mapping, &deficit)) {
-            free(new_mapping);
-            printf("No more distinct mappings possible. Found %d total.\n", result->num_mappings);
+        // Trace slices carry the round (the mapping's 1-based index)
+        trace_begin_index("mapping_search", result->num_mappings + 1);
+        bool found = find_best_mapping(s, new_mapping, &deficit);
+        trace_end("mapping_search");
+        if (!found) {
+            mem_free(new_mapping);
+            report_note(rep, "No more distinct mappings possible. Found %d total.\n", result->num_mappings);
             break;
         }
 
-        memcpy(prev_adj_h, g_adj_h_working, (size_t) n_h * n_h * sizeof(int));
+        // The previous H' is only needed to show what this round changed
+        if (report_wants_mappings(rep)) memcpy(prev_adj_h, s->adj_h_working, (size_t) n_h * n_h * sizeof(int));
 
         result->mappings[result->num_mappings] = new_mapping;
-        memcpy(g_found_mappings[g_num_found], new_mapping, n_g * sizeof(int));
-        g_num_found++;
+        memcpy(s->found_mappings[s->num_found], new_mapping, n_g * sizeof(int));
+        s->num_found++;
         result->num_mappings++;
 
-        int edges_this_round = apply_mapping_edges(new_mapping);
+        trace_begin_index("apply_mapping_edges", result->num_mappings);
+        int edges_this_round = apply_mapping_edges(s, new_mapping);
+        trace_end("apply_mapping_edges");
         result->total_edges_added += edges_this_round;
 
-        printf("\nMapping %d: deficit = %d, edges added this round = %d\n",
-               result->num_mappings, deficit, edges_this_round);
-        print_mapping_inline(new_mapping, n_g);
-
-        if (edges_this_round > 0) {
-            printf("\nUpdated H' (new edges highlighted in green):\n");
-            print_matrix_highlighted(n_h, g_adj_h_working, prev_adj_h);
-        }
-
-        printf("\nUpdated H' (mapping edges highlighted in red):\n");
-        print_matrix_with_mapping(n_h, g_adj_h_working, prev_adj_h, n_g, adj_g, new_mapping);
+        MappingReport m = {
+            .kind = REPORT_EXTENSION,
+            .index = result->num_mappings,
+            .mapping = new_mapping,
+            .n_g = n_g,
+            .n_h = n_h,
+            .adj_g = adj_g,
+            .adj_h = s->adj_h_working,
+            .prev_adj_h = prev_adj_h,
+            .deficit = deficit,
+            .edges_added = edges_this_round
+        };
+        report_mapping(rep, &m);
 
         if (result->num_mappings >= target) {
             if (!interactive) break;
-            if (!prompt_continue("Continue searching for more mappings?")) break;
+            if (!report_confirm(rep, "Continue searching for more mappings?")) break;
         }
 
         if (result->num_mappings >= MAX_MAPPINGS) {
-            printf("Reached maximum mappings limit (%d).\n", MAX_MAPPINGS);
+            report_note(rep, "Reached maximum mappings limit (%d).\n", MAX_MAPPINGS);
             break;
         }
     }
 
-    free(prev_adj_h);
+    mem_free(prev_adj_h);
+    mult_matrix_free(&s->h_cells);
+    mem_free(s);
     return result;
 }
 
@@ -235,47 +275,31 @@ ExtensionResult *find_minimal_extension_exact(int n_g, const int *adj_g,
 // Utility Functions
 // ============================================================================
 
-void free_extension_result(ExtensionResult *result) {
-    if (result) {
-        for (int i = 0; i < result->num_mappings; i++) {
-            free(result->mappings[i]);
-        }
-        free(result->mappings);
-        free(result->extended_adj_h);
-        free(result);
+ExtensionResult *new_extension_result(int n_g, int n_h, const int *adj_h, int capacity) {
+    size_t cells = (size_t) n_h * n_h;
+    ExtensionResult *result = (ExtensionResult *) mem_calloc(MEM_RESULTS, 1, sizeof(ExtensionResult));
+    int **mappings = (int **) mem_calloc(MEM_RESULTS, capacity > 0 ? capacity : 1, sizeof(int *));
+    int *extended = adj_h ? (int *) mem_alloc(MEM_RESULTS, (cells > 0 ? cells : 1) * sizeof(int)) : NULL;
+    if (!result || !mappings || (adj_h && !extended)) {
+        fprintf(stderr, "Error: out of memory.\n");
+        mem_free(result);
+        mem_free(mappings);
+        mem_free(extended);
+        return NULL;
     }
+    if (adj_h) memcpy(extended, adj_h, cells * sizeof(int));
+    *result = (ExtensionResult) {.mappings = mappings, .extended_adj_h = extended, .n_h = n_h, .n_g = n_g};
+    return result;
 }
 
-void print_extension_result(const ExtensionResult *result, const int *adj_g) {
-    printf("\n--- Minimal Extension Result ---\n");
-    printf("Total edges added: %d\n", result->total_edges_added);
-    printf("Mappings found: %d\n", result->num_mappings);
-
-    for (int k = 0; k < result->num_mappings; k++) {
-        printf("\nMapping %d (G -> H):\n", k + 1);
-        for (int v = 0; v < result->n_g; v++) {
-            printf("    G_%d -> H_%d\n", v + 1, result->mappings[k][v] + 1);
-        }
-    }
-
-    printf("\nEdges added to H:\n");
-    if (result->total_edges_added == 0) {
-        printf("    None. G is already embeddable in H.\n");
-    } else {
-        // Compare original H (we need to reconstruct it) with extended H'
-        // Actually, we don't have original H here. We'll print based on what mappings needed.
-        printf("    (See extended adjacency matrix)\n");
-    }
-
-    printf("\nExtended H' adjacency matrix:\n");
-    printf("    ");
-    for (int c = 0; c < result->n_h; c++) printf("%4d", c + 1);
-    printf("\n");
-    for (int r = 0; r < result->n_h; r++) {
-        printf("%4d", r + 1);
-        for (int c = 0; c < result->n_h; c++) {
-            printf("%4d", get_adj(result->extended_adj_h, result->n_h, r, c));
+void free_extension_result(ExtensionResult *result) {
+    if (result) {
+        for (int i = 0; i < result->num_mappings; i++) {
+            mem_free(result->mappings[i]);
         }
-        printf("\n");
+        mem_free(result->mappings);
+        mem_free(result->extended_adj_h);
+        free_sparse_graph(result->extended_sparse_h);
+        mem_free(result);
     }
 }
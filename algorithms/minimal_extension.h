@@ -1,6 +1,12 @@
 #ifndef AAC_MINIMAL_EXTENSION_H
 #define AAC_MINIMAL_EXTENSION_H
 #include <stdbool.h>
+#include "../sparse_graph.h"
+#include "../report.h"
+#include "../search_stats.h"
+
+// Largest G and H the exact search accepts (its state is sized for this)
+#define EXT_EXACT_MAX_VERTICES 20
 
 /**
  * Result structure for minimal extension
@@ -9,9 +15,11 @@ typedef struct {
     int **mappings;           // Array of n mappings
     int num_mappings;         // Number of mappings found
     int *extended_adj_h;      // Extended adjacency matrix H' (flattened)
+    SparseGraph *extended_sparse_h; // Extended H' for sparse inputs (extended_adj_h is NULL then)
     int n_h;                  // Size of H (for interpreting extended_adj_h)
     int n_g;                  // Size of G (for interpreting mappings)
     int total_edges_added;    // Total number of edges added to H
+    SearchStats stats;        // Search counters (AAC_STATS builds only)
 } ExtensionResult;
 
 /**
@@ -23,27 +31,34 @@ typedef struct {
  * - Repeat n times
  *
  * This is NOT globally optimal for n > 1, but is tractable.
+ * See find_minimal_extension_joint for the jointly optimal search.
  *
  * @param n_g Number of vertices in G
  * @param adj_g Adjacency matrix of G (flattened)
  * @param n_h Number of vertices in H
  * @param adj_h Adjacency matrix of H (flattened)
  * @param n Number of distinct isomorphisms required
- * @return ExtensionResult (caller must free with free_extension_result)
+ * @param interactive Ask rep whether to go on once n mappings are found
+ * @param rep Receives progress notes and each round's mapping (NULL = silent)
+ * @return ExtensionResult (caller must free with free_extension_result), or NULL if out of memory
  */
 ExtensionResult *find_minimal_extension_exact(int n_g, const int *adj_g,
                                                int n_h, const int *adj_h,
-                                               int n, bool interactive);
+                                               int n, bool interactive, const Reporter *rep);
 
 /**
- * Free memory allocated for extension result
+ * Empty result for the extension engines, with room for capacity mappings
+ * (allocated with mem_alloc, see mem_track.h). H' starts as a copy of adj_h;
+ * with adj_h NULL (a sparse H) extended_adj_h is left NULL.
+ *
+ * @return New result, or NULL if out of memory (message printed to stderr)
  */
-void free_extension_result(ExtensionResult *result);
+ExtensionResult *new_extension_result(int n_g, int n_h, const int *adj_h, int capacity);
 
 /**
- * Print extension results
+ * Free memory allocated for extension result
  */
-void print_extension_result(const ExtensionResult *result, const int *adj_g);
+void free_extension_result(ExtensionResult *result);
 
 /**
  * Legacy function for backwards compatibility
@@ -1,5 +1,9 @@
 #include "minimal_extension_approximation.h"
-#include "../console.h"
+#include "../report.h"
+#include "../thread_pool.h"
+#include "../multiplicity.h"
+#include "../mem_track.h"
+#include "../trace.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -16,6 +20,39 @@ typedef struct {
     int total_degree; // in_degree + out_degree
 } VertexInfo;
 
+// State shared by every greedy start of a run; G-side data is built once,
+// H'-side data is kept in sync by apply_edges
+typedef struct {
+    VertexInfo *sorted_g;  // G vertices by degree (descending)
+    VertexInfo *h_info;    // Current H' degrees, indexed by vertex id
+    int *g_nbr_start;      // G neighbours (in or out edge, no self) of v: g_nbr[g_nbr_start[v] .. g_nbr_start[v+1])
+    int *g_nbr;
+    int *g_out_start;      // G out-edges (incl. self-loops) of v: g_out[g_out_start[v] .. g_out_start[v+1])
+    int *g_out;
+    int *h_owner;          // Local search: G vertex mapped to each H vertex, or -1
+} GreedyWorkspace;
+
+// Buffers for one greedy start; one per thread in portfolio mode
+typedef struct {
+    int *score;            // score[v * n_h + u]: preserved multiplicity if v -> u, for the start in progress
+    bool *used_h;
+    bool out_of_memory;    // A start could not allocate its mapping
+    SearchStats stats;     // This worker's counters, added to the result's at the end
+} GreedyScratch;
+
+// How a greedy start breaks ties between H vertices with the same score
+typedef enum {
+    TIE_HIGH_DEGREE, // Prefer the H vertex with the highest degree (default)
+    TIE_LOW_DEGREE,  // Prefer the H vertex with the lowest degree
+    TIE_RANDOM       // Pick uniformly among equal scores
+} TieBreak;
+
+typedef struct {
+    int anchor_v;          // G vertex whose assignment is fixed first
+    TieBreak tie_break;
+    unsigned int seed;     // TIE_RANDOM only
+} GreedyStrategy;
+
 // ============================================================================
 // Helper Functions
 // ============================================================================
@@ -71,70 +108,203 @@ static bool mapping_exists(int **existing, int num_existing, const int *mapping,
     return false;
 }
 
-static void print_mapping_inline(const int *mapping, int n_g) {
-    printf("  Mapping: ");
-    for (int v = 0; v < n_g; v++)
-        printf("G_%d->H_%d ", v + 1, mapping[v] + 1);
-    printf("\n");
+// ============================================================================
+// Workspace
+// ============================================================================
+
+// G never changes: sort its vertices by degree (descending) and build its
+// adjacency lists once for all rounds. Returns false if out of memory.
+static bool init_g_workspace(GreedyWorkspace *ws, int n_g, const int *adj_g) {
+    ws->sorted_g = (VertexInfo *) mem_alloc(MEM_EXTENSION, (n_g > 0 ? n_g : 1) * sizeof(VertexInfo));
+    ws->g_nbr_start = (int *) mem_alloc(MEM_EXTENSION, (n_g + 1) * sizeof(int));
+    ws->g_out_start = (int *) mem_alloc(MEM_EXTENSION, (n_g + 1) * sizeof(int));
+    if (!ws->sorted_g || !ws->g_nbr_start || !ws->g_out_start) return false;
+    calc_degrees(n_g, adj_g, ws->sorted_g);
+    qsort(ws->sorted_g, n_g, sizeof(VertexInfo), compare_vertices);
+
+    // Adjacency lists of G, so each step only touches actual edges
+    int num_nbr = 0, num_out = 0;
+    for (int v = 0; v < n_g; v++) {
+        for (int j = 0; j < n_g; j++) {
+            if (get_adj(adj_g, n_g, v, j) > 0) num_out++;
+            if (j != v && (get_adj(adj_g, n_g, v, j) > 0 || get_adj(adj_g, n_g, j, v) > 0)) num_nbr++;
+        }
+    }
+    ws->g_nbr = (int *) mem_alloc(MEM_EXTENSION, (num_nbr > 0 ? num_nbr : 1) * sizeof(int));
+    ws->g_out = (int *) mem_alloc(MEM_EXTENSION, (num_out > 0 ? num_out : 1) * sizeof(int));
+    if (!ws->g_nbr || !ws->g_out) return false;
+    num_nbr = num_out = 0;
+    for (int v = 0; v < n_g; v++) {
+        ws->g_nbr_start[v] = num_nbr;
+        ws->g_out_start[v] = num_out;
+        for (int j = 0; j < n_g; j++) {
+            if (get_adj(adj_g, n_g, v, j) > 0) ws->g_out[num_out++] = j;
+            if (j != v && (get_adj(adj_g, n_g, v, j) > 0 || get_adj(adj_g, n_g, j, v) > 0)) {
+                ws->g_nbr[num_nbr++] = j;
+            }
+        }
+    }
+    ws->g_nbr_start[n_g] = num_nbr;
+    ws->g_out_start[n_g] = num_out;
+    return true;
+}
+
+// Initial H' degrees, from the index if there is one
+static void init_h_info(VertexInfo *h_info, int n_h, const HIndex *h_index) {
+    for (int u = 0; u < n_h; u++) {
+        h_info[u].id = u;
+        h_info[u].total_degree = h_index_total_degree(h_index, u);
+    }
+}
+
+// Returns false if out of memory (free_workspace releases what was allocated)
+static bool init_workspace(GreedyWorkspace *ws, int n_g, const int *adj_g, int n_h, const int *adj_h,
+                           const HIndex *h_index) {
+    memset(ws, 0, sizeof(*ws));
+    if (!init_g_workspace(ws, n_g, adj_g)) return false;
+
+    // H' degrees are computed once here and then updated by apply_edges
+    ws->h_info = (VertexInfo *) mem_alloc(MEM_EXTENSION, n_h * sizeof(VertexInfo));
+    ws->h_owner = (int *) mem_alloc(MEM_EXTENSION, n_h * sizeof(int));
+    if (!ws->h_info || !ws->h_owner) return false;
+    if (h_index) {
+        init_h_info(ws->h_info, n_h, h_index);
+    } else {
+        calc_degrees(n_h, adj_h, ws->h_info);
+    }
+    return true;
+}
+
+static void free_workspace(GreedyWorkspace *ws) {
+    mem_free(ws->sorted_g);
+    mem_free(ws->h_info);
+    mem_free(ws->g_nbr_start);
+    mem_free(ws->g_nbr);
+    mem_free(ws->g_out_start);
+    mem_free(ws->g_out);
+    mem_free(ws->h_owner);
+}
+
+// Returns false if out of memory (free_scratch releases what was allocated)
+static bool init_scratch(GreedyScratch *sc, int n_g, int n_h) {
+    sc->score = (int *) mem_alloc(MEM_EXTENSION, (size_t) n_g * n_h * sizeof(int));
+    sc->used_h = (bool *) mem_alloc(MEM_EXTENSION, n_h * sizeof(bool));
+    sc->out_of_memory = false;
+    sc->stats = (SearchStats) {0};
+    return sc->score && sc->used_h;
+}
+
+static void free_scratch(GreedyScratch *sc) {
+    mem_free(sc->score);
+    mem_free(sc->used_h);
+}
+
+static const char *tie_break_name(TieBreak tie_break) {
+    switch (tie_break) {
+        case TIE_LOW_DEGREE: return "low-degree";
+        case TIE_RANDOM: return "random";
+        default: return "high-degree";
+    }
+}
+
+static unsigned int xorshift32(unsigned int *state) {
+    unsigned int x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
 }
 
 // ============================================================================
 // Greedy Single Mapping Finder
 // ============================================================================
 
-// Run greedy from a fixed first assignment (first_v -> first_u)
+// Fix j -> x: every unplaced G neighbour v of j gains, for each H vertex u, the
+// multiplicity that the edges between v and j would keep if v -> u
+static void fix_vertex(const GreedyWorkspace *ws, GreedyScratch *sc, int n_g, const int *adj_g,
+                       const MultMatrix *h_cur,
+                       const int *mapping, int j, int x) {
+    int n_h = h_cur->n;
+    MULT_DISPATCH(h_cur, cell_t,
+        const cell_t *h_cells = (const cell_t *) h_cur->cells;
+        const cell_t *row_x = h_cells + (size_t) x * n_h; // H'(x, u)
+        for (int k = ws->g_nbr_start[j]; k < ws->g_nbr_start[j + 1]; k++) {
+            int v = ws->g_nbr[k];
+            if (mapping[v] != -1) continue;
+
+            int g_in = get_adj(adj_g, n_g, j, v);  // j -> v, kept by x -> u
+            int g_out = get_adj(adj_g, n_g, v, j); // v -> j, kept by u -> x
+            int *score_v = sc->score + (size_t) v * n_h;
+            for (int u = 0; u < n_h; u++) {
+                score_v[u] += min(g_in, row_x[u]) + min(g_out, h_cells[(size_t) u * n_h + x]);
+            }
+        }
+    )
+}
+
+// Run greedy from a fixed first assignment (strategy->anchor_v -> first_u)
 static int *greedy_from_start(int n_g, const int *adj_g,
-                              int n_h, const int *adj_h_current,
-                              const VertexInfo *sorted_g,
-                              const VertexInfo *h_info,
-                              int first_v, int first_u,
+                              const MultMatrix *h_cur,
+                              const GreedyWorkspace *ws, GreedyScratch *sc,
+                              const GreedyStrategy *strategy, int first_u,
                               int *out_deficit) {
-    int *mapping = (int *) malloc(n_g * sizeof(int));
+    int n_h = h_cur->n;
+    int first_v = strategy->anchor_v;
+    int *mapping = (int *) mem_alloc(MEM_RESULTS, n_g * sizeof(int));
+    if (!mapping) {
+        sc->out_of_memory = true;
+        *out_deficit = -1;
+        return NULL;
+    }
     for (int i = 0; i < n_g; i++) mapping[i] = -1;
 
-    bool *used_h = (bool *) calloc(n_h, sizeof(bool));
+    bool *used_h = sc->used_h;
+    memset(used_h, 0, n_h * sizeof(bool));
+    memset(sc->score, 0, (size_t) n_g * n_h * sizeof(int));
+
+    unsigned int rng = (strategy->seed ^ ((unsigned int) first_u * 2654435761u)) | 1u;
+    STATS_INC(&sc->stats, starts);
 
     // Fix the first assignment
     mapping[first_v] = first_u;
     used_h[first_u] = true;
+    fix_vertex(ws, sc, n_g, adj_g, h_cur, mapping, first_v, first_u);
 
     // Greedy matching for remaining vertices
     for (int i = 0; i < n_g; i++) {
-        int v = sorted_g[i].id;
+        int v = ws->sorted_g[i].id;
 
         if (mapping[v] != -1) continue; // Already assigned (first vertex)
 
         int best_u = -1;
         int best_score = -1;
         int best_h_degree = -1;
+        int num_ties = 0;
+
+        const int *score_v = sc->score + (size_t) v * n_h;
+        int g_loop = get_adj(adj_g, n_g, v, v);
 
         for (int u = 0; u < n_h; u++) {
             if (used_h[u]) continue;
 
-            int score = 0;
+            int h_loop = mult_at(h_cur, u, u);
+            int score = score_v[u] + min(g_loop, h_loop);
+            int u_deg = ws->h_info[u].total_degree;
 
-            for (int j = 0; j < n_g; j++) {
-                if (mapping[j] != -1) {
-                    int mapped_u = mapping[j];
-
-                    int g_mult_in = get_adj(adj_g, n_g, j, v);
-                    int h_mult_in = get_adj(adj_h_current, n_h, mapped_u, u);
-                    score += min(g_mult_in, h_mult_in);
-
-                    int g_mult_out = get_adj(adj_g, n_g, v, j);
-                    int h_mult_out = get_adj(adj_h_current, n_h, u, mapped_u);
-                    score += min(g_mult_out, h_mult_out);
-                }
+            bool take;
+            if (score != best_score) {
+                take = score > best_score;
+                if (take) num_ties = 1;
+            } else if (strategy->tie_break == TIE_LOW_DEGREE) {
+                take = u_deg < best_h_degree;
+            } else if (strategy->tie_break == TIE_RANDOM) {
+                take = (xorshift32(&rng) % (unsigned int) ++num_ties) == 0;
+            } else {
+                take = u_deg > best_h_degree;
             }
 
-            int g_loop = get_adj(adj_g, n_g, v, v);
-            int h_loop = get_adj(adj_h_current, n_h, u, u);
-            score += min(g_loop, h_loop);
-
-            int u_deg = h_info[u].total_degree;
-            if (score > best_score ||
-                (score == best_score && u_deg > best_h_degree) ||
-                (score == best_score && u_deg == best_h_degree && (best_u == -1 || u < best_u))) {
+            if (take) {
                 best_score = score;
                 best_u = u;
                 best_h_degree = u_deg;
@@ -142,29 +312,33 @@ static int *greedy_from_start(int n_g, const int *adj_g,
         }
 
         if (best_u == -1) {
-            free(mapping);
-            free(used_h);
+            STATS_INC(&sc->stats, failed_starts);
+            mem_free(mapping);
             *out_deficit = -1;
             return NULL;
         }
 
         mapping[v] = best_u;
         used_h[best_u] = true;
+        fix_vertex(ws, sc, n_g, adj_g, h_cur, mapping, v, best_u);
     }
 
-    free(used_h);
-
-    // Calculate deficit
+    // Calculate deficit over the edges of G
     int deficit = 0;
-    for (int i = 0; i < n_g; i++) {
-        for (int j = 0; j < n_g; j++) {
-            int g_mult = get_adj(adj_g, n_g, i, j);
-            int h_mult = get_adj(adj_h_current, n_h, mapping[i], mapping[j]);
-            if (h_mult < g_mult) {
-                deficit += (g_mult - h_mult);
+    MULT_DISPATCH(h_cur, cell_t,
+        const cell_t *h_cells = (const cell_t *) h_cur->cells;
+        for (int i = 0; i < n_g; i++) {
+            const cell_t *row = h_cells + (size_t) mapping[i] * n_h;
+            for (int k = ws->g_out_start[i]; k < ws->g_out_start[i + 1]; k++) {
+                int j = ws->g_out[k];
+                int g_mult = get_adj(adj_g, n_g, i, j);
+                int h_mult = row[mapping[j]];
+                if (h_mult < g_mult) {
+                    deficit += (g_mult - h_mult);
+                }
             }
         }
-    }
+    )
 
     *out_deficit = deficit;
     return mapping;
@@ -172,57 +346,290 @@ static int *greedy_from_start(int n_g, const int *adj_g,
 
 // Find best greedy mapping by trying all possible first-vertex assignments
 static int *find_greedy_mapping(int n_g, const int *adj_g,
-                                int n_h, const int *adj_h_current,
+                                const MultMatrix *h_cur,
+                                const GreedyWorkspace *ws, GreedyScratch *sc,
                                 int **existing_mappings, int num_existing,
                                 int *out_deficit) {
-    // Sort G vertices by degree (descending)
-    VertexInfo *sorted_g = (VertexInfo *) malloc(n_g * sizeof(VertexInfo));
-    calc_degrees(n_g, adj_g, sorted_g);
-    qsort(sorted_g, n_g, sizeof(VertexInfo), compare_vertices);
-
-    // Pre-calculate H vertex degrees
-    VertexInfo *h_info = (VertexInfo *) malloc(n_h * sizeof(VertexInfo));
-    calc_degrees(n_h, adj_h_current, h_info);
-
     int *best_mapping = NULL;
     int best_deficit = -1;
 
     // Try each possible first-vertex assignment
     // Use the highest-degree vertex in G as the "anchor"
-    int anchor_v = sorted_g[0].id;
+    GreedyStrategy strategy = {ws->sorted_g[0].id, TIE_HIGH_DEGREE, 0};
 
-    for (int u = 0; u < n_h; u++) {
+    for (int u = 0; u < h_cur->n; u++) {
         int deficit;
-        int *mapping = greedy_from_start(n_g, adj_g, n_h, adj_h_current,
-                                         sorted_g, h_info, anchor_v, u, &deficit);
+        int *mapping = greedy_from_start(n_g, adj_g, h_cur,
+                                         ws, sc, &strategy, u, &deficit);
 
         if (mapping == NULL) continue;
 
         // Check distinctness
         if (mapping_exists(existing_mappings, num_existing, mapping, n_g)) {
-            free(mapping);
+            STATS_INC(&sc->stats, duplicates);
+            mem_free(mapping);
             continue;
         }
 
         // Keep if better
         if (best_mapping == NULL || deficit < best_deficit) {
-            free(best_mapping);
+            mem_free(best_mapping);
             best_mapping = mapping;
             best_deficit = deficit;
         } else {
-            free(mapping);
+            mem_free(mapping);
         }
     }
 
-    free(sorted_g);
-    free(h_info);
-
     *out_deficit = best_deficit;
     return best_mapping;
 }
 
-// Apply mapping edges to H'
-static int apply_edges(int n_g, const int *adj_g, int n_h, int *adj_h, const int *mapping) {
+// ============================================================================
+// Portfolio: Several Greedy Strategies in Parallel
+// ============================================================================
+
+// Best candidate seen by one worker
+typedef struct {
+    int *mapping;
+    int deficit;
+    int task;
+} PortfolioBest;
+
+typedef struct {
+    int n_g, n_h;
+    const int *adj_g;
+    const MultMatrix *h_cur;
+    const GreedyWorkspace *ws;
+    GreedyScratch *scratch;      // One per worker
+    const GreedyStrategy *strategies;
+    int **existing;
+    int num_existing;
+    PortfolioBest *best;         // One per worker
+} PortfolioJob;
+
+// Strategy 0 is the plain greedy, so the portfolio never does worse than it on the same H'
+static GreedyStrategy *build_strategies(const GreedyWorkspace *ws, int n_g,
+                                        const ExtApproxOptions *opts, int *out_count) {
+    int anchors = opts->portfolio_anchors;
+    if (anchors < 1) anchors = 1;
+    if (anchors > n_g) anchors = n_g;
+    int num_random = opts->portfolio_random > 0 ? opts->portfolio_random : 0;
+
+    GreedyStrategy *strategies = (GreedyStrategy *) mem_alloc(MEM_EXTENSION,
+                                                              (2 * anchors + num_random) * sizeof(GreedyStrategy));
+    int count = 0;
+    if (!strategies) {
+        *out_count = 0;
+        return NULL;
+    }
+    for (int a = 0; a < anchors; a++) {
+        strategies[count++] = (GreedyStrategy) {ws->sorted_g[a].id, TIE_HIGH_DEGREE, 0};
+        strategies[count++] = (GreedyStrategy) {ws->sorted_g[a].id, TIE_LOW_DEGREE, 0};
+    }
+    for (int r = 0; r < num_random; r++) {
+        unsigned int seed = opts->seed * 2246822519u + (unsigned int) r * 3266489917u + 1u;
+        strategies[count++] = (GreedyStrategy) {ws->sorted_g[r % anchors].id, TIE_RANDOM, seed};
+    }
+
+    *out_count = count;
+    return strategies;
+}
+
+// Task = (strategy, first H vertex); ties between workers go to the lowest task index,
+// so the result does not depend on scheduling
+static void portfolio_task(void *arg, int task, int worker) {
+    PortfolioJob *job = (PortfolioJob *) arg;
+    const GreedyStrategy *strategy = &job->strategies[task / job->n_h];
+    int first_u = task % job->n_h;
+
+    int deficit;
+    int *mapping = greedy_from_start(job->n_g, job->adj_g, job->h_cur,
+                                     job->ws, &job->scratch[worker], strategy, first_u, &deficit);
+    if (mapping == NULL) return;
+    if (mapping_exists(job->existing, job->num_existing, mapping, job->n_g)) {
+        STATS_INC(&job->scratch[worker].stats, duplicates);
+        mem_free(mapping);
+        return;
+    }
+
+    PortfolioBest *best = &job->best[worker];
+    if (best->mapping == NULL || deficit < best->deficit ||
+        (deficit == best->deficit && task < best->task)) {
+        mem_free(best->mapping);
+        best->mapping = mapping;
+        best->deficit = deficit;
+        best->task = task;
+    } else {
+        mem_free(mapping);
+    }
+}
+
+static int *find_portfolio_mapping(int n_g, const int *adj_g,
+                                   const MultMatrix *h_cur,
+                                   const GreedyWorkspace *ws, ThreadPool *pool,
+                                   GreedyScratch *scratch,
+                                   const GreedyStrategy *strategies, int num_strategies,
+                                   int **existing_mappings, int num_existing,
+                                   int *out_deficit, int *out_strategy) {
+    int n_h = h_cur->n;
+    int workers = thread_pool_size(pool);
+    PortfolioBest *best = (PortfolioBest *) mem_calloc(MEM_EXTENSION, workers, sizeof(PortfolioBest));
+    if (!best) {
+        scratch[0].out_of_memory = true;
+        *out_deficit = -1;
+        return NULL;
+    }
+
+    PortfolioJob job = {
+        .n_g = n_g,
+        .n_h = n_h,
+        .adj_g = adj_g,
+        .h_cur = h_cur,
+        .ws = ws,
+        .scratch = scratch,
+        .strategies = strategies,
+        .existing = existing_mappings,
+        .num_existing = num_existing,
+        .best = best
+    };
+    thread_pool_run(pool, num_strategies * n_h, portfolio_task, &job);
+
+    // Reduce the per-worker winners
+    PortfolioBest *winner = NULL;
+    for (int w = 0; w < workers; w++) {
+        if (best[w].mapping == NULL) continue;
+        if (winner == NULL || best[w].deficit < winner->deficit ||
+            (best[w].deficit == winner->deficit && best[w].task < winner->task)) {
+            winner = &best[w];
+        }
+    }
+
+    int *mapping = NULL;
+    *out_deficit = -1;
+    if (winner) {
+        mapping = winner->mapping;
+        winner->mapping = NULL;
+        *out_deficit = winner->deficit;
+        *out_strategy = winner->task / n_h;
+    }
+    for (int w = 0; w < workers; w++) mem_free(best[w].mapping);
+    mem_free(best);
+    return mapping;
+}
+
+// ============================================================================
+// Local Search Refinement
+// ============================================================================
+
+static inline int missing(int g_mult, int h_mult) {
+    return (h_mult < g_mult) ? g_mult - h_mult : 0;
+}
+
+// Deficit of the edges incident to v if v sits at pos (other vertices as in mapping)
+static int incident_deficit(const GreedyWorkspace *ws, int n_g, const int *adj_g,
+                            const MultMatrix *h, const int *mapping, int v, int pos) {
+    int deficit = missing(get_adj(adj_g, n_g, v, v), mult_at(h, pos, pos));
+    for (int k = ws->g_nbr_start[v]; k < ws->g_nbr_start[v + 1]; k++) {
+        int j = ws->g_nbr[k];
+        deficit += missing(get_adj(adj_g, n_g, v, j), mult_at(h, pos, mapping[j]));
+        deficit += missing(get_adj(adj_g, n_g, j, v), mult_at(h, mapping[j], pos));
+    }
+    return deficit;
+}
+
+// Deficit of the edges between v1 and v2 (both directions) under mapping
+static int pair_deficit(int n_g, const int *adj_g, const MultMatrix *h,
+                        const int *mapping, int v1, int v2) {
+    return missing(get_adj(adj_g, n_g, v1, v2), mult_at(h, mapping[v1], mapping[v2])) +
+           missing(get_adj(adj_g, n_g, v2, v1), mult_at(h, mapping[v2], mapping[v1]));
+}
+
+// Improve mapping in place by relocations to unused H vertices and pairwise swaps,
+// accepting any move that lowers the deficit against h. Moves that would
+// reproduce an existing mapping are skipped. Returns the deficit reduction.
+static int refine_mapping(GreedyWorkspace *ws, int n_g, const int *adj_g,
+                          const MultMatrix *h, int *mapping,
+                          int **existing, int num_existing,
+                          int max_passes, int *out_moves) {
+    int n_h = h->n;
+    int *owner = ws->h_owner;
+    for (int u = 0; u < n_h; u++) owner[u] = -1;
+    for (int v = 0; v < n_g; v++) owner[mapping[v]] = v;
+
+    int saved = 0;
+    int moves = 0;
+    bool improved = true;
+
+    for (int pass = 0; improved && (max_passes <= 0 || pass < max_passes); pass++) {
+        improved = false;
+
+        for (int v = 0; v < n_g; v++) {
+            int from = mapping[v];
+            int current = incident_deficit(ws, n_g, adj_g, h, mapping, v, from);
+            if (current == 0) continue; // Nothing to gain for v
+
+            // Relocation: v -> unused u
+            for (int u = 0; u < n_h; u++) {
+                if (owner[u] != -1) continue;
+                int delta = incident_deficit(ws, n_g, adj_g, h, mapping, v, u) - current;
+                if (delta >= 0) continue;
+
+                mapping[v] = u;
+                if (mapping_exists(existing, num_existing, mapping, n_g)) {
+                    mapping[v] = from;
+                    continue;
+                }
+                owner[from] = -1;
+                owner[u] = v;
+                from = u;
+                current += delta;
+                saved -= delta;
+                moves++;
+                improved = true;
+                if (current == 0) break;
+            }
+            if (current == 0) continue;
+
+            // Swap: v <-> w
+            for (int w = 0; w < n_g; w++) {
+                if (w == v) continue;
+                int a = mapping[v], b = mapping[w];
+
+                int before = incident_deficit(ws, n_g, adj_g, h, mapping, v, a) +
+                             incident_deficit(ws, n_g, adj_g, h, mapping, w, b) -
+                             pair_deficit(n_g, adj_g, h, mapping, v, w);
+                mapping[v] = b;
+                mapping[w] = a;
+                int after = incident_deficit(ws, n_g, adj_g, h, mapping, v, b) +
+                            incident_deficit(ws, n_g, adj_g, h, mapping, w, a) -
+                            pair_deficit(n_g, adj_g, h, mapping, v, w);
+
+                if (after >= before || mapping_exists(existing, num_existing, mapping, n_g)) {
+                    mapping[v] = a;
+                    mapping[w] = b;
+                    continue;
+                }
+                owner[a] = w;
+                owner[b] = v;
+                saved += before - after;
+                moves++;
+                improved = true;
+                current = incident_deficit(ws, n_g, adj_g, h, mapping, v, b);
+                if (current == 0) break;
+            }
+        }
+    }
+
+    *out_moves = moves;
+    return saved;
+}
+
+// Apply mapping edges to H' (the narrow search copy h_cur and the int matrix
+// adj_h), keeping h_info degrees in sync with the raised cells
+static int apply_edges(int n_g, const int *adj_g, MultMatrix *h_cur, int *adj_h, const int *mapping,
+                       VertexInfo *h_info) {
+    int n_h = h_cur->n;
     int added = 0;
 
     for (int i = 0; i < n_g; i++) {
@@ -230,11 +637,14 @@ static int apply_edges(int n_g, const int *adj_g, int n_h, int *adj_h, const int
             int g_mult = get_adj(adj_g, n_g, i, j);
             int u_i = mapping[i];
             int u_j = mapping[j];
-            int h_mult = get_adj(adj_h, n_h, u_i, u_j);
+            int h_mult = mult_at(h_cur, u_i, u_j);
 
             if (h_mult < g_mult) {
                 int to_add = g_mult - h_mult;
+                mult_set(h_cur, u_i, u_j, g_mult);
                 set_adj(adj_h, n_h, u_i, u_j, g_mult);
+                h_info[u_i].total_degree += to_add; // out-degree of u_i
+                h_info[u_j].total_degree += to_add; // in-degree of u_j
                 added += to_add;
             }
         }
@@ -247,68 +657,537 @@ static int apply_edges(int n_g, const int *adj_g, int n_h, int *adj_h, const int
 // Main Algorithm
 // ============================================================================
 
+ExtApproxOptions ext_approx_default_options(void) {
+    ExtApproxOptions opts = {
+        .refine = false,
+        .refine_max_passes = 100,
+        .portfolio = false,
+        .threads = 0,
+        .portfolio_anchors = 3,
+        .portfolio_random = 0,
+        .seed = 1
+    };
+    return opts;
+}
+
 ExtensionResult *find_minimal_extension_greedy(int n_g, const int *adj_g,
-                                               int n_h, const int *adj_h,
-                                               int n, bool interactive) {
-    ExtensionResult *result = (ExtensionResult *) malloc(sizeof(ExtensionResult));
-    result->mappings = (int **) malloc(MAX_MAPPINGS * sizeof(int *));
-    result->num_mappings = 0;
-    result->n_g = n_g;
-    result->n_h = n_h;
-    result->total_edges_added = 0;
-    result->extended_adj_h = (int *) malloc((size_t) n_h * n_h * sizeof(int));
-    memcpy(result->extended_adj_h, adj_h, (size_t) n_h * n_h * sizeof(int));
+                                               int n_h, const int *adj_h, const HIndex *h_index,
+                                               int n, bool interactive,
+                                               const ExtApproxOptions *opts, const Reporter *rep) {
+    ExtApproxOptions defaults = ext_approx_default_options();
+    if (!opts) opts = &defaults;
+
+    ExtensionResult *result = new_extension_result(n_g, n_h, adj_h, MAX_MAPPINGS);
+    if (!result) return NULL;
 
     if (n_g > n_h) {
         fprintf(stderr, "Error: G has more vertices than H.\n");
         return result;
     }
 
-    int *prev_adj_h = (int *) malloc((size_t) n_h * n_h * sizeof(int));
-    memcpy(prev_adj_h, adj_h, (size_t) n_h * n_h * sizeof(int));
+    // Only needed to show what each round changed
+    int *prev_adj_h = NULL;
+    if (report_wants_mappings(rep)) {
+        prev_adj_h = (int *) mem_alloc(MEM_EXTENSION, (size_t) n_h * n_h * sizeof(int));
+        if (!prev_adj_h) {
+            fprintf(stderr, "Error: out of memory copying H.\n");
+            return result;
+        }
+    }
+
+    // The search reads H' through a narrow copy; its cells never exceed the
+    // largest multiplicity of G or H
+    MultMatrix h_cur;
+    int rc = mult_matrix_init(&h_cur, n_h, adj_h, mult_max_value(adj_g, (size_t) n_g * n_g));
+    if (rc != 0) {
+        fprintf(stderr, rc == MULT_NEGATIVE ? "Error: negative multiplicity in H.\n"
+                                            : "Error: out of memory copying H.\n");
+        mem_free(prev_adj_h);
+        return result;
+    }
+
+    GreedyWorkspace ws;
+    if (!init_workspace(&ws, n_g, adj_g, n_h, result->extended_adj_h, h_index)) {
+        fprintf(stderr, "Error: out of memory.\n");
+        free_workspace(&ws);
+        mult_matrix_free(&h_cur);
+        mem_free(prev_adj_h);
+        return result;
+    }
+
+    ThreadPool *pool = NULL;
+    GreedyStrategy *strategies = NULL;
+    int num_strategies = 0;
+    int num_scratch = 1;
+    if (opts->portfolio) {
+        strategies = build_strategies(&ws, n_g, opts, &num_strategies);
+        pool = strategies ? thread_pool_create(opts->threads) : NULL;
+        if (pool) {
+            num_scratch = thread_pool_size(pool);
+            report_note(rep, "Portfolio: %d strategies on %d threads\n", num_strategies, num_scratch);
+        } else {
+            fprintf(stderr, "Warning: could not start worker threads, running plain greedy.\n");
+        }
+    }
+    GreedyScratch *scratch = (GreedyScratch *) mem_calloc(MEM_EXTENSION, num_scratch, sizeof(GreedyScratch));
+    bool scratch_ok = scratch != NULL;
+    for (int i = 0; scratch_ok && i < num_scratch; i++) scratch_ok = init_scratch(&scratch[i], n_g, n_h);
 
     int target = n;
-    while (1) {
+    int total_saved = 0;
+    while (scratch_ok) {
         int deficit;
-        int *new_mapping = find_greedy_mapping(n_g, adj_g, n_h, result->extended_adj_h,
-                                               result->mappings, result->num_mappings,
-                                               &deficit);
+        int strategy = 0;
+        int *new_mapping;
+        // Trace slices carry the round (the mapping's 1-based index)
+        trace_begin_index("mapping_search", result->num_mappings + 1);
+        if (pool) {
+            new_mapping = find_portfolio_mapping(n_g, adj_g, &h_cur,
+                                                 &ws, pool, scratch, strategies, num_strategies,
+                                                 result->mappings, result->num_mappings,
+                                                 &deficit, &strategy);
+        } else {
+            new_mapping = find_greedy_mapping(n_g, adj_g, &h_cur,
+                                              &ws, scratch,
+                                              result->mappings, result->num_mappings,
+                                              &deficit);
+        }
+        trace_end("mapping_search");
 
+        bool out_of_memory = false;
+        for (int i = 0; i < num_scratch; i++) out_of_memory |= scratch[i].out_of_memory;
+        if (out_of_memory) {
+            // A start that could not run may have been the best one
+            fprintf(stderr, "Error: out of memory in round %d.\n", result->num_mappings + 1);
+            mem_free(new_mapping);
+            break;
+        }
         if (new_mapping == NULL) {
-            printf("No more distinct mappings possible. Found %d total.\n", result->num_mappings);
+            report_note(rep, "No more distinct mappings possible. Found %d total.\n", result->num_mappings);
             break;
         }
 
-        memcpy(prev_adj_h, result->extended_adj_h, (size_t) n_h * n_h * sizeof(int));
+        if (opts->refine) {
+            trace_begin_index("refine", result->num_mappings + 1);
+            int moves;
+            int saved = refine_mapping(&ws, n_g, adj_g, &h_cur, new_mapping,
+                                       result->mappings, result->num_mappings,
+                                       opts->refine_max_passes, &moves);
+            trace_end("refine");
+            report_note(rep, "\nLocal search: deficit %d -> %d (saved %d edges, %d moves)\n",
+                        deficit, deficit - saved, saved, moves);
+            deficit -= saved;
+            total_saved += saved;
+        }
+
+        // The previous H' is only needed to show what this round changed
+        bool reporting = report_wants_mappings(rep);
+        if (reporting) memcpy(prev_adj_h, result->extended_adj_h, (size_t) n_h * n_h * sizeof(int));
 
         result->mappings[result->num_mappings++] = new_mapping;
 
-        int edges_this_round = apply_edges(n_g, adj_g, n_h, result->extended_adj_h, new_mapping);
+        trace_begin_index("apply_mapping_edges", result->num_mappings);
+        int edges_this_round = apply_edges(n_g, adj_g, &h_cur, result->extended_adj_h, new_mapping, ws.h_info);
+        trace_end("apply_mapping_edges");
         result->total_edges_added += edges_this_round;
 
-        printf("\nMapping %d: deficit = %d, edges added = %d\n",
-               result->num_mappings, deficit, edges_this_round);
-        print_mapping_inline(new_mapping, n_g);
+        if (reporting) {
+            char strategy_desc[64];
+            if (pool) {
+                snprintf(strategy_desc, sizeof(strategy_desc), "anchor G_%d, %s tie-break",
+                         strategies[strategy].anchor_v + 1, tie_break_name(strategies[strategy].tie_break));
+            }
+            MappingReport m = {
+                .kind = REPORT_EXTENSION,
+                .index = result->num_mappings,
+                .mapping = new_mapping,
+                .n_g = n_g,
+                .n_h = n_h,
+                .adj_g = adj_g,
+                .adj_h = result->extended_adj_h,
+                .prev_adj_h = prev_adj_h,
+                .deficit = deficit,
+                .edges_added = edges_this_round,
+                .strategy = pool ? strategy_desc : NULL
+            };
+            report_mapping(rep, &m);
+        }
 
-        if (edges_this_round > 0) {
-            printf("\nUpdated H' (new edges highlighted in green):\n");
-            print_matrix_highlighted(n_h, result->extended_adj_h, prev_adj_h);
+        if (result->num_mappings >= target) {
+            if (!interactive) break;
+            if (!report_confirm(rep, "Continue searching for more mappings?")) break;
+        }
+
+        if (result->num_mappings >= MAX_MAPPINGS) {
+            report_note(rep, "Reached maximum mappings limit (%d).\n", MAX_MAPPINGS);
+            break;
         }
+    }
+
+    if (opts->refine) {
+        report_note(rep, "\nLocal search saved %d edges in total.\n", total_saved);
+    }
+
+    if (!scratch_ok) fprintf(stderr, "Error: out of memory.\n");
+    for (int i = 0; scratch && i < num_scratch; i++) {
+        search_stats_merge(&result->stats, &scratch[i].stats);
+        free_scratch(&scratch[i]);
+    }
+    mem_free(scratch);
+    thread_pool_destroy(pool);
+    mem_free(strategies);
+    free_workspace(&ws);
+    mult_matrix_free(&h_cur);
+    mem_free(prev_adj_h);
+    return result;
+}
+
+// ============================================================================
+// Greedy on Sparse H' (CSR)
+// ============================================================================
+
+// Same rounds and starts as the dense greedy (default strategy), but a G vertex
+// is scored only against H vertices adjacent to the images of its placed
+// neighbours. Every other H vertex scores 0 (plus a possible self-loop), so the
+// highest-degree unused vertex stands in for all of them and the chosen vertex
+// matches the dense search.
+
+typedef struct {
+    int *score;           // score[u] for the G vertex being placed (0 outside touched)
+    int *touched;         // H vertices with a score entry
+    bool *in_touched;
+    bool *used_h;
+    int *h_order;         // H vertex ids by current degree (descending), then id
+    VertexInfo *order_buf;
+    int *h_loops;         // H vertices with a self-loop
+    int num_loops;
+    SearchStats *stats;   // The result's counters
+    bool out_of_memory;   // A start could not allocate its mapping
+} SparseScratch;
 
-        printf("\nUpdated H' (mapping edges highlighted in red):\n");
-        print_matrix_with_mapping(n_h, result->extended_adj_h, prev_adj_h, n_g, adj_g, new_mapping);
+// Refresh the per-round H' views: degree order and self-loop list
+static void refresh_sparse_scratch(SparseScratch *sc, const SparseGraph *h, const VertexInfo *h_info) {
+    memcpy(sc->order_buf, h_info, h->n * sizeof(VertexInfo));
+    qsort(sc->order_buf, h->n, sizeof(VertexInfo), compare_vertices);
+    for (int o = 0; o < h->n; o++) sc->h_order[o] = sc->order_buf[o].id;
+
+    sc->num_loops = 0;
+    for (int u = 0; u < h->n; u++) {
+        if (sparse_graph_mult(h, u, u) > 0) sc->h_loops[sc->num_loops++] = u;
+    }
+}
+
+static inline void add_score(SparseScratch *sc, int *num_touched, int u, int value) {
+    if (!sc->in_touched[u]) {
+        sc->in_touched[u] = true;
+        sc->touched[(*num_touched)++] = u;
+    }
+    sc->score[u] += value;
+}
+
+static int *greedy_from_start_sparse(int n_g, const int *adj_g, const SparseGraph *h,
+                                     const GreedyWorkspace *ws, SparseScratch *sc,
+                                     int first_v, int first_u, int *out_deficit) {
+    int *mapping = (int *) mem_alloc(MEM_RESULTS, n_g * sizeof(int));
+    if (!mapping) {
+        sc->out_of_memory = true;
+        *out_deficit = -1;
+        return NULL;
+    }
+    for (int i = 0; i < n_g; i++) mapping[i] = -1;
+
+    mapping[first_v] = first_u;
+    sc->used_h[first_u] = true;
+    STATS_INC(sc->stats, starts);
+
+    for (int i = 0; i < n_g; i++) {
+        int v = ws->sorted_g[i].id;
+        if (mapping[v] != -1) continue;
+
+        // Accumulate the multiplicity kept with each placed neighbour
+        int num_touched = 0;
+        for (int k = ws->g_nbr_start[v]; k < ws->g_nbr_start[v + 1]; k++) {
+            int j = ws->g_nbr[k];
+            int x = mapping[j];
+            if (x == -1) continue;
+
+            int g_in = get_adj(adj_g, n_g, j, v);  // j -> v, kept by x -> u
+            int g_out = get_adj(adj_g, n_g, v, j); // v -> j, kept by u -> x
+            if (g_in > 0) {
+                for (int e = h->out_start[x]; e < h->out_start[x + 1]; e++) {
+                    add_score(sc, &num_touched, h->out_dst[e], min(g_in, h->out_mult[e]));
+                }
+            }
+            if (g_out > 0) {
+                for (int e = h->in_start[x]; e < h->in_start[x + 1]; e++) {
+                    add_score(sc, &num_touched, h->in_src[e], min(g_out, h->in_mult[e]));
+                }
+            }
+        }
+
+        int g_loop = get_adj(adj_g, n_g, v, v);
+        if (g_loop > 0) {
+            for (int l = 0; l < sc->num_loops; l++) add_score(sc, &num_touched, sc->h_loops[l], 0);
+        }
+
+        // Candidates: every scored vertex plus the best unscored one
+        int background = -1;
+        for (int o = 0; o < h->n; o++) {
+            if (!sc->used_h[sc->h_order[o]]) {
+                background = sc->h_order[o];
+                break;
+            }
+        }
+
+        int best_u = -1, best_score = -1, best_h_degree = -1;
+        for (int c = 0; c <= num_touched; c++) {
+            int u = (c < num_touched) ? sc->touched[c] : background;
+            if (u == -1 || sc->used_h[u]) continue;
+
+            int score = sc->score[u];
+            if (g_loop > 0) score += min(g_loop, sparse_graph_mult(h, u, u));
+            int u_deg = ws->h_info[u].total_degree;
+
+            if (score > best_score ||
+                (score == best_score && (u_deg > best_h_degree || (u_deg == best_h_degree && u < best_u)))) {
+                best_score = score;
+                best_u = u;
+                best_h_degree = u_deg;
+            }
+        }
+
+        for (int c = 0; c < num_touched; c++) {
+            sc->score[sc->touched[c]] = 0;
+            sc->in_touched[sc->touched[c]] = false;
+        }
+
+        if (best_u == -1) break;
+        mapping[v] = best_u;
+        sc->used_h[best_u] = true;
+    }
+
+    // used_h is shared across starts: clear only what this start set
+    bool complete = true;
+    for (int v = 0; v < n_g; v++) {
+        if (mapping[v] == -1) complete = false;
+        else sc->used_h[mapping[v]] = false;
+    }
+    if (!complete) {
+        STATS_INC(sc->stats, failed_starts);
+        mem_free(mapping);
+        *out_deficit = -1;
+        return NULL;
+    }
+
+    int deficit = 0;
+    for (int i = 0; i < n_g; i++) {
+        for (int k = ws->g_out_start[i]; k < ws->g_out_start[i + 1]; k++) {
+            int j = ws->g_out[k];
+            deficit += missing(get_adj(adj_g, n_g, i, j), sparse_graph_mult(h, mapping[i], mapping[j]));
+        }
+    }
+
+    *out_deficit = deficit;
+    return mapping;
+}
+
+static int *find_greedy_mapping_sparse(int n_g, const int *adj_g, const SparseGraph *h,
+                                       const GreedyWorkspace *ws, SparseScratch *sc,
+                                       int **existing_mappings, int num_existing,
+                                       int *out_deficit) {
+    int *best_mapping = NULL;
+    int best_deficit = -1;
+    int anchor = ws->sorted_g[0].id;
+
+    for (int u = 0; u < h->n; u++) {
+        int deficit;
+        int *mapping = greedy_from_start_sparse(n_g, adj_g, h, ws, sc, anchor, u, &deficit);
+        if (mapping == NULL) continue;
+
+        if (mapping_exists(existing_mappings, num_existing, mapping, n_g)) {
+            STATS_INC(sc->stats, duplicates);
+            mem_free(mapping);
+            continue;
+        }
+
+        if (best_mapping == NULL || deficit < best_deficit) {
+            mem_free(best_mapping);
+            best_mapping = mapping;
+            best_deficit = deficit;
+        } else {
+            mem_free(mapping);
+        }
+    }
+
+    *out_deficit = best_deficit;
+    return best_mapping;
+}
+
+// Raise the H' cells the mapping is missing, listing them in cells/cells_old (room for
+// one entry per G edge); returns the edges added or -1 on allocation failure
+static int apply_edges_sparse(int n_g, const int *adj_g, SparseGraph *h, const int *mapping,
+                              const GreedyWorkspace *ws, VertexInfo *h_info,
+                              SparseEdge *cells, int *cells_old, int *out_num_cells) {
+    int num_cells = 0;
+    int added = 0;
+
+    for (int i = 0; i < n_g; i++) {
+        for (int k = ws->g_out_start[i]; k < ws->g_out_start[i + 1]; k++) {
+            int j = ws->g_out[k];
+            int g_mult = get_adj(adj_g, n_g, i, j);
+            int u_i = mapping[i];
+            int u_j = mapping[j];
+            int h_mult = sparse_graph_mult(h, u_i, u_j);
+
+            if (h_mult < g_mult) {
+                cells_old[num_cells] = h_mult;
+                cells[num_cells++] = (SparseEdge) {u_i, u_j, g_mult};
+                h_info[u_i].total_degree += g_mult - h_mult;
+                h_info[u_j].total_degree += g_mult - h_mult;
+                added += g_mult - h_mult;
+            }
+        }
+    }
+
+    *out_num_cells = num_cells;
+    return sparse_graph_raise(h, cells, (size_t) num_cells) == 0 ? added : -1;
+}
+
+ExtensionResult *find_minimal_extension_greedy_sparse(int n_g, const int *adj_g,
+                                                      const SparseGraph *h, const HIndex *h_index,
+                                                      int n, bool interactive,
+                                                      const ExtApproxOptions *opts, const Reporter *rep) {
+    int n_h = h->n;
+    ExtensionResult *result = new_extension_result(n_g, n_h, NULL, MAX_MAPPINGS);
+    if (!result) return NULL;
+    result->extended_sparse_h = sparse_graph_copy(h);
+
+    if (!result->extended_sparse_h) {
+        fprintf(stderr, "Error: out of memory copying H.\n");
+        return result;
+    }
+    if (n_g > n_h) {
+        fprintf(stderr, "Error: G has more vertices than H.\n");
+        return result;
+    }
+    if (opts && (opts->refine || opts->portfolio)) {
+        fprintf(stderr, "Warning: --refine and --portfolio are not supported for sparse H, running plain greedy.\n");
+    }
+
+    SparseGraph *h_current = result->extended_sparse_h;
+
+    GreedyWorkspace ws;
+    memset(&ws, 0, sizeof(ws));
+    ws.h_info = (VertexInfo *) mem_alloc(MEM_EXTENSION, n_h * sizeof(VertexInfo));
+    if (!init_g_workspace(&ws, n_g, adj_g) || !ws.h_info) {
+        fprintf(stderr, "Error: out of memory.\n");
+        free_workspace(&ws);
+        return result;
+    }
+    if (h_index) {
+        init_h_info(ws.h_info, n_h, h_index);
+    } else {
+        for (int u = 0; u < n_h; u++) {
+            ws.h_info[u].id = u;
+            ws.h_info[u].total_degree = 0;
+        }
+        for (int u = 0; u < n_h; u++) {
+            for (int e = h->out_start[u]; e < h->out_start[u + 1]; e++) {
+                ws.h_info[u].total_degree += h->out_mult[e];
+                ws.h_info[h->out_dst[e]].total_degree += h->out_mult[e];
+            }
+        }
+    }
+
+    SparseScratch sc = {
+        .score = (int *) mem_calloc(MEM_EXTENSION, n_h, sizeof(int)),
+        .touched = (int *) mem_alloc(MEM_EXTENSION, n_h * sizeof(int)),
+        .in_touched = (bool *) mem_calloc(MEM_EXTENSION, n_h, sizeof(bool)),
+        .used_h = (bool *) mem_calloc(MEM_EXTENSION, n_h, sizeof(bool)),
+        .h_order = (int *) mem_alloc(MEM_EXTENSION, n_h * sizeof(int)),
+        .order_buf = (VertexInfo *) mem_alloc(MEM_EXTENSION, n_h * sizeof(VertexInfo)),
+        .h_loops = (int *) mem_alloc(MEM_EXTENSION, n_h * sizeof(int)),
+        .num_loops = 0,
+        .stats = &result->stats
+    };
+    int num_g_edges = ws.g_out_start[n_g];
+    size_t raised_cap = num_g_edges > 0 ? (size_t) num_g_edges : 1;
+    SparseEdge *raised = (SparseEdge *) mem_alloc(MEM_EXTENSION, raised_cap * sizeof(SparseEdge));
+    int *raised_old = (int *) mem_alloc(MEM_EXTENSION, raised_cap * sizeof(int));
+    bool scratch_ok = sc.score && sc.touched && sc.in_touched && sc.used_h && sc.h_order && sc.order_buf &&
+                      sc.h_loops && raised && raised_old;
+    if (!scratch_ok) fprintf(stderr, "Error: out of memory.\n");
+
+    int target = n;
+    while (scratch_ok) {
+        refresh_sparse_scratch(&sc, h_current, ws.h_info);
+
+        int deficit;
+        trace_begin_index("mapping_search", result->num_mappings + 1);
+        int *new_mapping = find_greedy_mapping_sparse(n_g, adj_g, h_current, &ws, &sc,
+                                                      result->mappings, result->num_mappings,
+                                                      &deficit);
+        trace_end("mapping_search");
+        if (sc.out_of_memory) {
+            // A start that could not run may have been the best one
+            fprintf(stderr, "Error: out of memory in round %d.\n", result->num_mappings + 1);
+            mem_free(new_mapping);
+            break;
+        }
+        if (new_mapping == NULL) {
+            report_note(rep, "No more distinct mappings possible. Found %d total.\n", result->num_mappings);
+            break;
+        }
+
+        result->mappings[result->num_mappings++] = new_mapping;
+
+        int num_raised;
+        trace_begin_index("apply_mapping_edges", result->num_mappings);
+        int edges_this_round = apply_edges_sparse(n_g, adj_g, h_current, new_mapping, &ws, ws.h_info,
+                                                  raised, raised_old, &num_raised);
+        trace_end("apply_mapping_edges");
+        if (edges_this_round < 0) {
+            fprintf(stderr, "Error: out of memory extending H'.\n");
+            break;
+        }
+        result->total_edges_added += edges_this_round;
+
+        MappingReport m = {
+            .kind = REPORT_EXTENSION,
+            .index = result->num_mappings,
+            .mapping = new_mapping,
+            .n_g = n_g,
+            .n_h = n_h,
+            .adj_g = adj_g,
+            .deficit = deficit,
+            .edges_added = edges_this_round,
+            .raised = raised,
+            .raised_old = raised_old,
+            .num_raised = num_raised
+        };
+        report_mapping(rep, &m);
 
         if (result->num_mappings >= target) {
             if (!interactive) break;
-            if (!prompt_continue("Continue searching for more mappings?")) break;
+            if (!report_confirm(rep, "Continue searching for more mappings?")) break;
         }
 
         if (result->num_mappings >= MAX_MAPPINGS) {
-            printf("Reached maximum mappings limit (%d).\n", MAX_MAPPINGS);
+            report_note(rep, "Reached maximum mappings limit (%d).\n", MAX_MAPPINGS);
             break;
         }
     }
 
-    free(prev_adj_h);
+    mem_free(raised);
+    mem_free(raised_old);
+
+    mem_free(sc.score);
+    mem_free(sc.touched);
+    mem_free(sc.in_touched);
+    mem_free(sc.used_h);
+    mem_free(sc.h_order);
+    mem_free(sc.order_buf);
+    mem_free(sc.h_loops);
+    free_workspace(&ws);
     return result;
 }
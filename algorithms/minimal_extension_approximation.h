@@ -2,6 +2,26 @@
 #define AAC_MINIMAL_EXTENSION_APPROXIMATION_H
 
 #include "minimal_extension.h"  // Reuse ExtensionResult
+#include "../h_index.h"
+
+/**
+ * Tuning options for the greedy extension heuristic
+ */
+typedef struct {
+    bool refine;           // Improve each greedy mapping by local search before applying it
+    int refine_max_passes; // Maximum local search passes per round (0 = until local optimum)
+
+    bool portfolio;        // Run several greedy strategies concurrently, keep the best mapping per round
+    int threads;           // Portfolio worker threads (0 = one per CPU)
+    int portfolio_anchors; // Highest-degree G vertices tried as anchor (each with high/low-degree tie-break)
+    int portfolio_random;  // Extra strategies with randomized tie-breaking
+    unsigned int seed;     // Seed for the randomized strategies
+} ExtApproxOptions;
+
+/**
+ * Default options: plain greedy, no refinement
+ */
+ExtApproxOptions ext_approx_default_options(void);
 
 /**
  * Find minimal extension for n isomorphisms using greedy heuristic
@@ -9,16 +29,54 @@
  * This is faster than the exact algorithm but may not find the optimal solution.
  * Uses vertex-by-vertex greedy matching, iteratively updating H' after each mapping.
  *
+ * With opts->portfolio, every round runs several anchor/tie-break strategies on a
+ * thread pool and keeps the lowest-deficit distinct mapping; the plain greedy is
+ * always one of them.
+ *
+ * With opts->refine, each greedy mapping is then improved by local search
+ * (relocating a G vertex to an unused H vertex, or swapping two G vertices)
+ * until no move lowers its deficit or the pass budget runs out.
+ *
  * @param n_g Number of vertices in G
  * @param adj_g Adjacency matrix of G (flattened)
  * @param n_h Number of vertices in H
  * @param adj_h Adjacency matrix of H (flattened)
+ * @param h_index Precomputed tables for H, or NULL
  * @param n Number of distinct isomorphisms required
- * @return ExtensionResult (caller must free with free_extension_result)
+ * @param interactive Ask rep whether to go on once n mappings are found
+ * @param opts Heuristic options (NULL = ext_approx_default_options())
+ * @param rep Receives progress notes and each round's mapping (NULL = silent)
+ * @return ExtensionResult (caller must free with free_extension_result), or NULL if out of memory
  */
 ExtensionResult *find_minimal_extension_greedy(int n_g, const int *adj_g,
-                                                int n_h, const int *adj_h,
-                                                int n, bool interactive);
+                                                int n_h, const int *adj_h, const HIndex *h_index,
+                                                int n, bool interactive,
+                                                const ExtApproxOptions *opts, const Reporter *rep);
+
+/**
+ * Greedy extension heuristic on a sparse H (CSR)
+ *
+ * Runs the default greedy strategy with the same choices as
+ * find_minimal_extension_greedy on the equivalent dense matrix, touching only
+ * the edges around each partial mapping. H' is kept sparse and returned in
+ * result->extended_sparse_h (extended_adj_h is NULL). Each round reports the
+ * raised cells instead of the H' matrix. Refinement and portfolio options are not
+ * supported here and are ignored with a warning.
+ *
+ * @param n_g Number of vertices in G
+ * @param adj_g Adjacency matrix of G (flattened)
+ * @param h Sparse graph H (not modified)
+ * @param h_index Precomputed tables for H, or NULL
+ * @param n Number of distinct isomorphisms required
+ * @param interactive Ask rep whether to go on once n mappings are found
+ * @param opts Heuristic options (may be NULL)
+ * @param rep Receives progress notes and each round's mapping (NULL = silent)
+ * @return ExtensionResult (caller must free with free_extension_result), or NULL if out of memory
+ */
+ExtensionResult *find_minimal_extension_greedy_sparse(int n_g, const int *adj_g,
+                                                      const SparseGraph *h, const HIndex *h_index,
+                                                      int n, bool interactive,
+                                                      const ExtApproxOptions *opts, const Reporter *rep);
 
 /**
  * Legacy function for backwards compatibility
@@ -0,0 +1,517 @@
+#include "minimal_extension_joint.h"
+#include "../report.h"
+#include "../utils.h"
+#include "../mem_track.h"
+#include "../trace.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <limits.h>
+
+#define TIME_CHECK_INTERVAL 1024
+
+// ============================================================================
+// Search State
+// ============================================================================
+
+typedef struct {
+    int n_g, n_h, n;
+    const int *adj_g;
+    int *work;           // H' with the requirements of all currently placed vertices
+    int *order;          // G vertices in search order (highest degree first)
+
+    int **maps;          // maps[k][v] = u for the k-th mapping being built
+    bool **used;         // used[k][u] = true if u is taken in mapping k
+    int cost;            // Edges added to reach the current work matrix
+
+    int best_cost;
+    int **best_maps;
+    bool found;
+
+    // Undo log of raised cells, so each branch can be reverted
+    int *log_cell;
+    int *log_old;
+    int log_size;
+
+    // Per-level candidate buffers (level = k * n_g + d)
+    int *cand_u;
+    int *cand_inc;
+
+    long long nodes;
+    long long max_nodes;
+    double deadline;     // Absolute now_ms() deadline (0 = none)
+    bool stop;
+    bool budget_exceeded;
+} JointContext;
+
+// ============================================================================
+// Helper Functions
+// ============================================================================
+
+static inline int get_adj(const int *adj, int n, int i, int j) {
+    return adj[i * n + j];
+}
+
+// Order G vertices by total degree (descending), ties by id - constrained vertices first.
+// Returns false if out of memory.
+static bool build_search_order(int n_g, const int *adj_g, int *order) {
+    int *deg = (int *) mem_calloc(MEM_EXTENSION, n_g, sizeof(int));
+    if (!deg) return false;
+    for (int i = 0; i < n_g; i++) {
+        for (int j = 0; j < n_g; j++) {
+            deg[i] += get_adj(adj_g, n_g, i, j);
+            deg[j] += get_adj(adj_g, n_g, i, j);
+        }
+    }
+    for (int i = 0; i < n_g; i++) order[i] = i;
+    for (int i = 1; i < n_g; i++) {
+        int v = order[i];
+        int j = i - 1;
+        while (j >= 0 && deg[order[j]] < deg[v]) {
+            order[j + 1] = order[j];
+            j--;
+        }
+        order[j + 1] = v;
+    }
+    mem_free(deg);
+    return true;
+}
+
+// Number of injective mappings G -> H, capped at limit
+static long long count_injective_mappings(int n_g, int n_h, long long limit) {
+    long long count = 1;
+    for (int i = 0; i < n_g; i++) {
+        count *= (n_h - i);
+        if (count >= limit) return limit;
+    }
+    return count;
+}
+
+// Edges needed to place v -> u in mapping k, given its vertices at order[0..d-1]
+static int placement_cost(const JointContext *ctx, int k, int d, int v, int u) {
+    const int *map = ctx->maps[k];
+    int n_g = ctx->n_g, n_h = ctx->n_h;
+    int inc = 0;
+
+    for (int i = 0; i < d; i++) {
+        int w = ctx->order[i];
+        int x = map[w];
+
+        int need_out = get_adj(ctx->adj_g, n_g, v, w);
+        int have_out = get_adj(ctx->work, n_h, u, x);
+        if (need_out > have_out) inc += need_out - have_out;
+
+        int need_in = get_adj(ctx->adj_g, n_g, w, v);
+        int have_in = get_adj(ctx->work, n_h, x, u);
+        if (need_in > have_in) inc += need_in - have_in;
+    }
+
+    int need_loop = get_adj(ctx->adj_g, n_g, v, v);
+    int have_loop = get_adj(ctx->work, n_h, u, u);
+    if (need_loop > have_loop) inc += need_loop - have_loop;
+
+    return inc;
+}
+
+static void raise_cell(JointContext *ctx, int cell, int need) {
+    if (ctx->work[cell] < need) {
+        ctx->log_cell[ctx->log_size] = cell;
+        ctx->log_old[ctx->log_size] = ctx->work[cell];
+        ctx->log_size++;
+        ctx->work[cell] = need;
+    }
+}
+
+// Raise H' cells so that v -> u is satisfied against the already placed vertices
+static void apply_placement(JointContext *ctx, int k, int d, int v, int u) {
+    const int *map = ctx->maps[k];
+    int n_g = ctx->n_g, n_h = ctx->n_h;
+
+    for (int i = 0; i < d; i++) {
+        int w = ctx->order[i];
+        int x = map[w];
+        raise_cell(ctx, u * n_h + x, get_adj(ctx->adj_g, n_g, v, w));
+        raise_cell(ctx, x * n_h + u, get_adj(ctx->adj_g, n_g, w, v));
+    }
+    raise_cell(ctx, u * n_h + u, get_adj(ctx->adj_g, n_g, v, v));
+}
+
+static void undo_to(JointContext *ctx, int log_mark) {
+    while (ctx->log_size > log_mark) {
+        ctx->log_size--;
+        ctx->work[ctx->log_cell[ctx->log_size]] = ctx->log_old[ctx->log_size];
+    }
+}
+
+static bool budget_exhausted(JointContext *ctx) {
+    if (ctx->max_nodes > 0 && ctx->nodes >= ctx->max_nodes) {
+        ctx->budget_exceeded = true;
+        return true;
+    }
+    if (ctx->deadline > 0 && ctx->nodes % TIME_CHECK_INTERVAL == 0 && now_ms() >= ctx->deadline) {
+        ctx->budget_exceeded = true;
+        return true;
+    }
+    return false;
+}
+
+static bool equals_earlier_mapping(const JointContext *ctx, int k) {
+    for (int i = 0; i < k; i++) {
+        if (memcmp(ctx->maps[i], ctx->maps[k], ctx->n_g * sizeof(int)) == 0) return true;
+    }
+    return false;
+}
+
+// Collect the free candidates for the d-th vertex of mapping k whose placement keeps the
+// total below bound, sorted by the edges they would add (cheapest first)
+static int collect_candidates(JointContext *ctx, int k, int d, int lower, int bound,
+                              int **out_u, int **out_inc) {
+    int v = ctx->order[d];
+    int level = k * ctx->n_g + d;
+    int *cand_u = ctx->cand_u + (size_t) level * ctx->n_h;
+    int *cand_inc = ctx->cand_inc + (size_t) level * ctx->n_h;
+
+    int num_cand = 0;
+    for (int u = lower; u < ctx->n_h; u++) {
+        if (ctx->used[k][u]) continue;
+
+        int inc = placement_cost(ctx, k, d, v, u);
+        if (ctx->cost + inc >= bound) continue;
+
+        int j = num_cand++;
+        while (j > 0 && cand_inc[j - 1] > inc) {
+            cand_u[j] = cand_u[j - 1];
+            cand_inc[j] = cand_inc[j - 1];
+            j--;
+        }
+        cand_u[j] = u;
+        cand_inc[j] = inc;
+    }
+
+    *out_u = cand_u;
+    *out_inc = cand_inc;
+    return num_cand;
+}
+
+static bool count_node(JointContext *ctx) {
+    ctx->nodes++;
+    if (budget_exhausted(ctx)) {
+        ctx->stop = true;
+        return false;
+    }
+    return true;
+}
+
+// Best single mapping k on top of the mappings already applied (the iterative approach).
+// Its nodes are counted but not charged to the budget, which only limits the joint search.
+static void round_search(JointContext *ctx, int k, int d, int *round_cost, int *round_map) {
+    if (d == ctx->n_g) {
+        if (equals_earlier_mapping(ctx, k)) return;
+        *round_cost = ctx->cost;
+        memcpy(round_map, ctx->maps[k], ctx->n_g * sizeof(int));
+        return;
+    }
+
+    int v = ctx->order[d];
+    int *cand_u, *cand_inc;
+    int num_cand = collect_candidates(ctx, k, d, 0, *round_cost, &cand_u, &cand_inc);
+
+    for (int c = 0; c < num_cand; c++) {
+        int u = cand_u[c];
+        int inc = cand_inc[c];
+        if (ctx->cost + inc >= *round_cost) break;
+        ctx->nodes++;
+
+        int log_mark = ctx->log_size;
+        apply_placement(ctx, k, d, v, u);
+        ctx->cost += inc;
+        ctx->maps[k][v] = u;
+        ctx->used[k][u] = true;
+
+        round_search(ctx, k, d + 1, round_cost, round_map);
+
+        ctx->used[k][u] = false;
+        ctx->maps[k][v] = -1;
+        ctx->cost -= inc;
+        undo_to(ctx, log_mark);
+    }
+}
+
+// Seed the incumbent with the iterative solution (best single mapping per round), so the
+// joint search only explores sets that beat it and a budget stop is never worse than ext_exact.
+// Runs before the budget starts, so every round is searched to its optimum.
+static void seed_incumbent(JointContext *ctx) {
+    int n_g = ctx->n_g;
+    int *round_map = (int *) mem_alloc(MEM_EXTENSION, n_g * sizeof(int));
+    bool ok = round_map != NULL;
+
+    for (int k = 0; k < ctx->n && ok; k++) {
+        int round_cost = INT_MAX;
+        round_search(ctx, k, 0, &round_cost, round_map);
+        if (round_cost == INT_MAX) {
+            ok = false;
+            break;
+        }
+
+        // Commit the round: place its vertices for real
+        for (int d = 0; d < n_g; d++) {
+            int v = ctx->order[d];
+            int u = round_map[v];
+            ctx->cost += placement_cost(ctx, k, d, v, u);
+            apply_placement(ctx, k, d, v, u);
+            ctx->maps[k][v] = u;
+            ctx->used[k][u] = true;
+        }
+    }
+
+    if (ok) {
+        ctx->best_cost = ctx->cost;
+        for (int k = 0; k < ctx->n; k++) {
+            memcpy(ctx->best_maps[k], ctx->maps[k], n_g * sizeof(int));
+        }
+        ctx->found = true;
+    }
+
+    // Reset the working state for the joint search
+    undo_to(ctx, 0);
+    ctx->cost = 0;
+    for (int k = 0; k < ctx->n; k++) {
+        for (int v = 0; v < n_g; v++) ctx->maps[k][v] = -1;
+        memset(ctx->used[k], 0, ctx->n_h * sizeof(bool));
+    }
+    mem_free(round_map);
+}
+
+// ============================================================================
+// Branch-and-Bound over Sets of Mappings
+// ============================================================================
+
+// Place the d-th vertex (in search order) of mapping k.
+// tied = mapping k agrees with mapping k-1 on order[0..d-1], so it must not go below it.
+static void search(JointContext *ctx, int k, int d, bool tied) {
+    if (ctx->stop) return;
+
+    if (d == ctx->n_g) {
+        if (tied) return; // Identical to the previous mapping, not distinct
+
+        if (k + 1 < ctx->n) {
+            search(ctx, k + 1, 0, true);
+            return;
+        }
+
+        // Complete set of n mappings, cheaper than the incumbent by construction
+        ctx->best_cost = ctx->cost;
+        for (int i = 0; i < ctx->n; i++) {
+            memcpy(ctx->best_maps[i], ctx->maps[i], ctx->n_g * sizeof(int));
+        }
+        ctx->found = true;
+        if (ctx->best_cost == 0) ctx->stop = true; // Cannot do better
+        return;
+    }
+
+    int v = ctx->order[d];
+    int lower = (tied && k > 0) ? ctx->maps[k - 1][v] : 0;
+    int *cand_u, *cand_inc;
+    int num_cand = collect_candidates(ctx, k, d, lower, ctx->best_cost, &cand_u, &cand_inc);
+
+    for (int c = 0; c < num_cand && !ctx->stop; c++) {
+        int u = cand_u[c];
+        int inc = cand_inc[c];
+
+        // Incumbent may have improved in an earlier branch
+        if (ctx->cost + inc >= ctx->best_cost) break;
+        if (!count_node(ctx)) break;
+
+        int log_mark = ctx->log_size;
+        apply_placement(ctx, k, d, v, u);
+        ctx->cost += inc;
+        ctx->maps[k][v] = u;
+        ctx->used[k][u] = true;
+
+        search(ctx, k, d + 1, tied && k > 0 && u == lower);
+
+        ctx->used[k][u] = false;
+        ctx->maps[k][v] = -1;
+        ctx->cost -= inc;
+        undo_to(ctx, log_mark);
+    }
+}
+
+// ============================================================================
+// Main Algorithm
+// ============================================================================
+
+// Allocate the search state for n mappings; returns false if out of memory
+// (free_context releases what was allocated)
+static bool init_context(JointContext *ctx, int n_g, const int *adj_g, int n_h, const int *adj_h, int n) {
+    memset(ctx, 0, sizeof(*ctx));
+    ctx->n_g = n_g;
+    ctx->n_h = n_h;
+    ctx->n = n;
+    ctx->adj_g = adj_g;
+    ctx->work = (int *) mem_alloc(MEM_EXTENSION, (size_t) n_h * n_h * sizeof(int));
+    ctx->order = (int *) mem_alloc(MEM_EXTENSION, n_g * sizeof(int));
+    ctx->maps = (int **) mem_calloc(MEM_EXTENSION, n, sizeof(int *));
+    ctx->used = (bool **) mem_calloc(MEM_EXTENSION, n, sizeof(bool *));
+    ctx->best_maps = (int **) mem_calloc(MEM_EXTENSION, n, sizeof(int *));
+    if (!ctx->work || !ctx->order || !ctx->maps || !ctx->used || !ctx->best_maps) return false;
+    memcpy(ctx->work, adj_h, (size_t) n_h * n_h * sizeof(int));
+    if (!build_search_order(n_g, adj_g, ctx->order)) return false;
+
+    // The best set becomes the result's mappings
+    for (int k = 0; k < n; k++) {
+        ctx->maps[k] = (int *) mem_alloc(MEM_EXTENSION, n_g * sizeof(int));
+        ctx->used[k] = (bool *) mem_calloc(MEM_EXTENSION, n_h, sizeof(bool));
+        ctx->best_maps[k] = (int *) mem_alloc(MEM_RESULTS, n_g * sizeof(int));
+        if (!ctx->maps[k] || !ctx->used[k] || !ctx->best_maps[k]) return false;
+        for (int v = 0; v < n_g; v++) ctx->maps[k][v] = -1;
+    }
+
+    // Each placement raises at most 2 * n_g - 1 cells
+    size_t log_cap = (size_t) n * n_g * (2 * n_g + 1);
+    ctx->log_cell = (int *) mem_alloc(MEM_EXTENSION, log_cap * sizeof(int));
+    ctx->log_old = (int *) mem_alloc(MEM_EXTENSION, log_cap * sizeof(int));
+    ctx->cand_u = (int *) mem_alloc(MEM_EXTENSION, (size_t) n * n_g * n_h * sizeof(int));
+    ctx->cand_inc = (int *) mem_alloc(MEM_EXTENSION, (size_t) n * n_g * n_h * sizeof(int));
+    return ctx->log_cell && ctx->log_old && ctx->cand_u && ctx->cand_inc;
+}
+
+static void free_context(JointContext *ctx) {
+    for (int k = 0; k < ctx->n; k++) {
+        if (ctx->maps) mem_free(ctx->maps[k]);
+        if (ctx->used) mem_free(ctx->used[k]);
+        if (ctx->best_maps) mem_free(ctx->best_maps[k]);
+    }
+    mem_free(ctx->maps);
+    mem_free(ctx->used);
+    mem_free(ctx->best_maps);
+    mem_free(ctx->log_cell);
+    mem_free(ctx->log_old);
+    mem_free(ctx->cand_u);
+    mem_free(ctx->cand_inc);
+    mem_free(ctx->order);
+    mem_free(ctx->work);
+}
+
+ExtensionResult *find_minimal_extension_joint(int n_g, const int *adj_g,
+                                              int n_h, const int *adj_h,
+                                              int n, const JointBudget *budget,
+                                              JointStats *stats, const Reporter *rep) {
+    ExtensionResult *result = new_extension_result(n_g, n_h, adj_h, n);
+    if (!result) return NULL;
+
+    if (stats) memset(stats, 0, sizeof(JointStats));
+
+    if (n_g > n_h) {
+        fprintf(stderr, "Error: G has more vertices than H.\n");
+        return result;
+    }
+    if (n < 1 || n_g == 0) {
+        return result;
+    }
+
+    long long available = count_injective_mappings(n_g, n_h, n);
+    if (available < n) {
+        report_note(rep, "Only %lld distinct mappings exist, searching for %lld.\n", available, available);
+        n = (int) available;
+    }
+
+    JointContext ctx;
+    if (!init_context(&ctx, n_g, adj_g, n_h, adj_h, n)) {
+        // The candidate tables grow with n * |V(G)| * |V(H)|: fail before searching
+        fprintf(stderr, "Error: out of memory for the joint search of %d mappings.\n", n);
+        free_context(&ctx);
+        return result;
+    }
+
+    ctx.best_cost = INT_MAX;
+    double start = now_ms();
+
+    trace_begin("seed_incumbent");
+    seed_incumbent(&ctx);
+    trace_end("seed_incumbent");
+
+    // The budget limits the joint search only, counted from the end of the seeding
+    ctx.max_nodes = (budget && budget->max_nodes > 0) ? ctx.nodes + budget->max_nodes : 0;
+    ctx.deadline = (budget && budget->time_limit_ms > 0) ? now_ms() + budget->time_limit_ms : 0;
+    if (!(ctx.found && ctx.best_cost == 0)) {
+        trace_begin("joint_search");
+        search(&ctx, 0, 0, false);
+        trace_end("joint_search");
+    }
+
+    double elapsed = now_ms() - start;
+    bool optimal = ctx.found && !ctx.budget_exceeded;
+    STATS_ADD(&result->stats, nodes, ctx.nodes);
+
+    if (stats) {
+        stats->nodes = ctx.nodes;
+        stats->elapsed_ms = elapsed;
+        stats->optimal = optimal;
+        stats->budget_exceeded = ctx.budget_exceeded;
+    }
+
+    report_note(rep, "Search expanded %lld nodes in %.0fms%s\n", ctx.nodes, elapsed,
+                ctx.budget_exceeded ? " (budget exceeded)" : "");
+
+    if (!ctx.found) {
+        report_note(rep, "No set of %d distinct mappings found within the budget.\n", n);
+    } else {
+        // Build H' from the best set: each cell rises to the largest multiplicity any mapping needs
+        int *ext = result->extended_adj_h;
+        for (int k = 0; k < n; k++) {
+            const int *map = ctx.best_maps[k];
+            for (int i = 0; i < n_g; i++) {
+                for (int j = 0; j < n_g; j++) {
+                    int g_mult = get_adj(adj_g, n_g, i, j);
+                    int cell = map[i] * n_h + map[j];
+                    if (ext[cell] < g_mult) ext[cell] = g_mult;
+                }
+            }
+            result->mappings[k] = ctx.best_maps[k];
+            ctx.best_maps[k] = NULL;
+        }
+        result->num_mappings = n;
+        result->total_edges_added = ctx.best_cost;
+
+        report_note(rep, "Best total edges added = %d (%s)\n", ctx.best_cost,
+                    optimal ? "optimal" : "best found, not proven optimal");
+        // Attribute each shared edge to the first mapping (in result order) that needs it
+        int *covered = report_wants_mappings(rep) ? (int *) mem_alloc(MEM_EXTENSION, (size_t) n_h * n_h * sizeof(int))
+                                                  : NULL;
+        if (covered) memcpy(covered, adj_h, (size_t) n_h * n_h * sizeof(int));
+        for (int k = 0; covered && k < n; k++) {
+            const int *map = result->mappings[k];
+            int deficit = 0, added = 0;
+            for (int i = 0; i < n_g; i++) {
+                for (int j = 0; j < n_g; j++) {
+                    int g_mult = get_adj(adj_g, n_g, i, j);
+                    int cell = map[i] * n_h + map[j];
+                    if (adj_h[cell] < g_mult) deficit += g_mult - adj_h[cell];
+                    if (covered[cell] < g_mult) {
+                        added += g_mult - covered[cell];
+                        covered[cell] = g_mult;
+                    }
+                }
+            }
+            MappingReport m = {
+                .kind = REPORT_JOINT,
+                .index = k + 1,
+                .mapping = map,
+                .n_g = n_g,
+                .n_h = n_h,
+                .adj_g = adj_g,
+                .adj_h = ext,
+                .prev_adj_h = adj_h,
+                .deficit = deficit,
+                .edges_added = added
+            };
+            report_mapping(rep, &m);
+        }
+        mem_free(covered);
+    }
+
+    free_context(&ctx);
+    return result;
+}
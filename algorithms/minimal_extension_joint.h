@@ -0,0 +1,52 @@
+#ifndef AAC_MINIMAL_EXTENSION_JOINT_H
+#define AAC_MINIMAL_EXTENSION_JOINT_H
+
+#include "minimal_extension.h"  // Reuse ExtensionResult
+
+/**
+ * Search limits for the joint solver (0 = unlimited)
+ */
+typedef struct {
+    long long max_nodes;  // Maximum number of search nodes to expand
+    double time_limit_ms; // Maximum wall-clock time in milliseconds
+} JointBudget;
+
+/**
+ * Search summary for the joint solver
+ */
+typedef struct {
+    long long nodes;      // Search nodes expanded
+    double elapsed_ms;    // Wall-clock time spent searching
+    bool optimal;         // True if the search space was exhausted (result is the true minimum)
+    bool budget_exceeded; // True if the node or time budget stopped the search early
+} JointStats;
+
+/**
+ * Find a jointly minimal extension for n distinct isomorphisms (branch-and-bound)
+ *
+ * Unlike find_minimal_extension_exact, all n mappings are searched at once, so
+ * an edge added for one mapping is counted only once even if later mappings
+ * reuse it. The total cost is the sum over H cells of the largest multiplicity
+ * deficit any mapping places on that cell.
+ *
+ * The search keeps the mappings in increasing lexicographic order to skip
+ * permutations of the same set. It starts from the iterative solution, found
+ * before the budget applies, so if the budget runs out the best set found so
+ * far is returned, never worse than the iterative one, and stats->optimal is false.
+ *
+ * @param n_g Number of vertices in G
+ * @param adj_g Adjacency matrix of G (flattened)
+ * @param n_h Number of vertices in H
+ * @param adj_h Adjacency matrix of H (flattened)
+ * @param n Number of distinct isomorphisms required
+ * @param budget Search limits (NULL = unlimited)
+ * @param stats Optional output for search statistics (may be NULL)
+ * @param rep Receives search notes and, once the search ends, each mapping (NULL = silent)
+ * @return ExtensionResult (caller must free with free_extension_result), or NULL if out of memory
+ */
+ExtensionResult *find_minimal_extension_joint(int n_g, const int *adj_g,
+                                              int n_h, const int *adj_h,
+                                              int n, const JointBudget *budget,
+                                              JointStats *stats, const Reporter *rep);
+
+#endif //AAC_MINIMAL_EXTENSION_JOINT_H
@@ -1,4 +1,7 @@
 #include "product_graph.h"
+#include "../multiplicity.h"
+#include "../mem_track.h"
+#include "../trace.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -26,130 +29,216 @@ static int calc_out_degree(const int *adj, int n, int v) {
     return deg;
 }
 
-ProductGraph *build_product_graph(int n_g, const int *adj_g, int n_h, const int *adj_h) {
-    ProductGraph *pg = (ProductGraph *)malloc(sizeof(ProductGraph));
-    if (!pg) return NULL;
+// Mark (i, j) and (j, i) adjacent in whichever form the graph uses
+static inline void set_adjacent(ProductGraph *pg, size_t i, size_t j) {
+    size_t count = (size_t) pg->num_vertices;
+    if (pg->adj_matrix) {
+        pg->adj_matrix[i * count + j] = true;
+        pg->adj_matrix[j * count + i] = true;
+    } else {
+        size_t a = i * count + j, b = j * count + i;
+        pg->adj_bits[a >> 6] |= (uint64_t) 1 << (a & 63);
+        pg->adj_bits[b >> 6] |= (uint64_t) 1 << (b & 63);
+    }
+}
+
+ProductGraph *build_product_graph(int n_g, const int *adj_g, int n_h, const int *adj_h, const HIndex *h_index,
+                                  CandidateCache *candidates) {
+    ProductGraph *pg = (ProductGraph *) mem_calloc(MEM_PRODUCT, 1, sizeof(ProductGraph));
+    if (!pg) {
+        fprintf(stderr, "Error: out of memory building the product graph.\n");
+        return NULL;
+    }
 
     pg->n_g = n_g;
     pg->n_h = n_h;
 
     // Phase 1: Count compatible vertices and allocate
-    // A pair (v, u) is compatible if deg+_G(v) <= deg+_H(u) and deg-_G(v) <= deg-_H(u)
-
-    // Pre-calculate degrees for all vertices
-    int *in_deg_g = (int *)malloc(n_g * sizeof(int));
-    int *out_deg_g = (int *)malloc(n_g * sizeof(int));
-    int *in_deg_h = (int *)malloc(n_h * sizeof(int));
-    int *out_deg_h = (int *)malloc(n_h * sizeof(int));
+    // A pair (v, u) is compatible if deg+_G(v) <= deg+_H(u), deg-_G(v) <= deg-_H(u)
+    // and v's distinct neighbours and heaviest edge do not exceed u's
+
+    // Pre-calculate degrees and signatures for all vertices (H's come from the index if there is one)
+    int *in_deg_g = (int *) mem_alloc(MEM_PRODUCT, n_g * sizeof(int));
+    int *out_deg_g = (int *) mem_alloc(MEM_PRODUCT, n_g * sizeof(int));
+    VertexSignature *sig_g = (VertexSignature *) mem_alloc(MEM_PRODUCT, (n_g > 0 ? n_g : 1) * sizeof(VertexSignature));
+    int *own_in_deg_h = NULL, *own_out_deg_h = NULL;
+    VertexSignature *own_sig_h = NULL;
+    if (!h_index) {
+        own_in_deg_h = (int *) mem_alloc(MEM_PRODUCT, n_h * sizeof(int));
+        own_out_deg_h = (int *) mem_alloc(MEM_PRODUCT, n_h * sizeof(int));
+        own_sig_h = (VertexSignature *) mem_alloc(MEM_PRODUCT, (n_h > 0 ? n_h : 1) * sizeof(VertexSignature));
+    }
+    // Upper bound on the compatible pairs
+    ProductVertex *temp_vertices = (ProductVertex *) mem_alloc(MEM_PRODUCT, (size_t) n_g * n_h * sizeof(ProductVertex));
+    if (!in_deg_g || !out_deg_g || !sig_g || (!h_index && (!own_in_deg_h || !own_out_deg_h || !own_sig_h)) ||
+        !temp_vertices) {
+        mem_free(in_deg_g);
+        mem_free(out_deg_g);
+        mem_free(sig_g);
+        mem_free(own_in_deg_h);
+        mem_free(own_out_deg_h);
+        mem_free(own_sig_h);
+        mem_free(temp_vertices);
+        mem_free(pg);
+        fprintf(stderr, "Error: out of memory building the product graph.\n");
+        return NULL;
+    }
 
+    trace_begin("degrees");
     for (int v = 0; v < n_g; v++) {
         in_deg_g[v] = calc_in_degree(adj_g, n_g, v);
         out_deg_g[v] = calc_out_degree(adj_g, n_g, v);
     }
-    for (int u = 0; u < n_h; u++) {
-        in_deg_h[u] = calc_in_degree(adj_h, n_h, u);
-        out_deg_h[u] = calc_out_degree(adj_h, n_h, u);
+    vertex_signatures(n_g, adj_g, sig_g);
+    if (!h_index) {
+        for (int u = 0; u < n_h; u++) {
+            own_in_deg_h[u] = calc_in_degree(adj_h, n_h, u);
+            own_out_deg_h[u] = calc_out_degree(adj_h, n_h, u);
+        }
+        vertex_signatures(n_h, adj_h, own_sig_h);
     }
+    trace_end("degrees");
+    const int *in_deg_h = h_index ? h_index->in_deg : own_in_deg_h;
+    const int *out_deg_h = h_index ? h_index->out_deg : own_out_deg_h;
+    const VertexSignature *sig_h = h_index ? h_index->signature : own_sig_h;
 
     // Count compatible pairs
-    int max_vertices = n_g * n_h;  // Upper bound
-    ProductVertex *temp_vertices = (ProductVertex *)malloc(max_vertices * sizeof(ProductVertex));
+    trace_begin("product_phase1");
     int count = 0;
 
     for (int v = 0; v < n_g; v++) {
+        // Shared candidate sets hold the same u, in the same order, as the scan below
+        int num_cand;
+        const int *cand = candidates ? candidate_cache_get(candidates, out_deg_g[v], in_deg_g[v], &sig_g[v], &num_cand) : NULL;
+        if (cand) {
+            for (int k = 0; k < num_cand; k++) {
+                temp_vertices[count].v = v;
+                temp_vertices[count].u = cand[k];
+                count++;
+            }
+            continue;
+        }
+
         for (int u = 0; u < n_h; u++) {
-            // Check degree constraints
-            if (out_deg_g[v] <= out_deg_h[u] && in_deg_g[v] <= in_deg_h[u]) {
+            if (product_compatible(out_deg_g[v], in_deg_g[v], &sig_g[v], out_deg_h[u], in_deg_h[u], &sig_h[u])) {
                 temp_vertices[count].v = v;
                 temp_vertices[count].u = u;
                 count++;
             }
         }
     }
+    mem_free(in_deg_g);
+    mem_free(out_deg_g);
+    mem_free(sig_g);
+    mem_free(own_in_deg_h);
+    mem_free(own_out_deg_h);
+    mem_free(own_sig_h);
 
     pg->num_vertices = count;
-    pg->vertices = (ProductVertex *)malloc(count * sizeof(ProductVertex));
-    memcpy(pg->vertices, temp_vertices, count * sizeof(ProductVertex));
-    free(temp_vertices);
-
-    // Phase 2: Build adjacency matrix for product graph
-    pg->adj_matrix = (bool *)calloc((size_t)count * count, sizeof(bool));
-    pg->degree = (int *)calloc(count, sizeof(int));
-
-    for (int i = 0; i < count; i++) {
-        int v1 = pg->vertices[i].v;
-        int u1 = pg->vertices[i].u;
-
-        for (int j = i + 1; j < count; j++) {
-            int v2 = pg->vertices[j].v;
-            int u2 = pg->vertices[j].u;
-
-            // Check injectivity: v1 != v2 and u1 != u2
-            if (v1 == v2 || u1 == u2) continue;
-
-            // Check edge preservation (both directions for directed graph)
-            int g_forward = get_adj(adj_g, n_g, v1, v2);
-            int h_forward = get_adj(adj_h, n_h, u1, u2);
-            int g_backward = get_adj(adj_g, n_g, v2, v1);
-            int h_backward = get_adj(adj_h, n_h, u2, u1);
-
-            if (g_forward <= h_forward && g_backward <= h_backward) {
-                // Edge exists in product graph (undirected)
-                pg->adj_matrix[i * count + j] = true;
-                pg->adj_matrix[j * count + i] = true;
-                pg->degree[i]++;
-                pg->degree[j]++;
-            }
+    pg->vertices = (ProductVertex *) mem_alloc(MEM_PRODUCT, (count > 0 ? count : 1) * sizeof(ProductVertex));
+    if (pg->vertices) memcpy(pg->vertices, temp_vertices, count * sizeof(ProductVertex));
+    mem_free(temp_vertices);
+    trace_end("product_phase1");
+
+    // Phase 2: Build adjacency matrix for product graph. Under a memory limit it
+    // may not fit as bools; a bitset takes an eighth of the space.
+    size_t cells = (size_t) count * count;
+    if (mem_fits(cells * sizeof(bool))) {
+        pg->adj_matrix = (bool *) mem_calloc(MEM_PRODUCT, cells > 0 ? cells : 1, sizeof(bool));
+    } else {
+        pg->adj_bits = (uint64_t *) mem_calloc(MEM_PRODUCT, cells / 64 + 1, sizeof(uint64_t));
+    }
+    pg->degree = (int *) mem_calloc(MEM_PRODUCT, count > 0 ? count : 1, sizeof(int));
+    if (!pg->vertices || (!pg->adj_matrix && !pg->adj_bits) || !pg->degree) {
+        free_product_graph(pg);
+        fprintf(stderr, "Error: out of memory building the product graph.\n");
+        return NULL;
+    }
+
+    // The pair loop reads H cells in random order: use the narrowest cell type
+    MultMatrix h;
+    bool own_cells = !(h_index && h_index->cells.cells);
+    if (!own_cells) {
+        h = h_index->cells;
+    } else {
+        int rc = mult_matrix_init(&h, n_h, adj_h, 0);
+        if (rc != 0) {
+            free_product_graph(pg);
+            fprintf(stderr, rc == MULT_NEGATIVE ? "Error: negative multiplicity in H.\n"
+                                                : "Error: out of memory building the product graph.\n");
+            return NULL;
         }
     }
 
-    // Cleanup
-    free(in_deg_g);
-    free(out_deg_g);
-    free(in_deg_h);
-    free(out_deg_h);
+    trace_begin("product_phase2");
+    MULT_DISPATCH(&h, cell_t,
+        const cell_t *h_cells = (const cell_t *) h.cells;
+
+        for (int i = 0; i < count; i++) {
+            int v1 = pg->vertices[i].v;
+            int u1 = pg->vertices[i].u;
+
+            for (int j = i + 1; j < count; j++) {
+                int v2 = pg->vertices[j].v;
+                int u2 = pg->vertices[j].u;
+
+                // Check injectivity: v1 != v2 and u1 != u2
+                if (v1 == v2 || u1 == u2) continue;
+
+                // Check edge preservation (both directions for directed graph)
+                int g_forward = get_adj(adj_g, n_g, v1, v2);
+                int h_forward = h_cells[(size_t)u1 * n_h + u2];
+                int g_backward = get_adj(adj_g, n_g, v2, v1);
+                int h_backward = h_cells[(size_t)u2 * n_h + u1];
+
+                if (g_forward <= h_forward && g_backward <= h_backward) {
+                    // Edge exists in product graph (undirected)
+                    set_adjacent(pg, i, j);
+                    pg->degree[i]++;
+                    pg->degree[j]++;
+                }
+            }
+        }
+    )
+    trace_end("product_phase2");
+    if (own_cells) mult_matrix_free(&h);
 
     return pg;
 }
 
-void free_product_graph(ProductGraph *pg) {
-    if (pg) {
-        free(pg->vertices);
-        free(pg->adj_matrix);
-        free(pg->degree);
-        free(pg);
+long long count_product_vertices(int n_g, const int *adj_g, const VertexSignature *sig_g, int n_h,
+                                 const int *out_deg_h, const int *in_deg_h, const VertexSignature *sig_h,
+                                 int *per_vertex) {
+    long long total = 0;
+    for (int v = 0; v < n_g; v++) {
+        int out_g = calc_out_degree(adj_g, n_g, v), in_g = calc_in_degree(adj_g, n_g, v);
+        int count = 0;
+        for (int u = 0; u < n_h; u++) {
+            count += product_compatible(out_g, in_g, &sig_g[v], out_deg_h[u], in_deg_h[u], &sig_h[u]);
+        }
+        if (per_vertex) per_vertex[v] = count;
+        total += count;
     }
+    return total;
 }
 
-void print_product_graph(const ProductGraph *pg) {
-    printf("Product Graph: %d vertices\n", pg->num_vertices);
-    printf("Vertices (v_G, u_H):\n");
-    for (int i = 0; i < pg->num_vertices; i++) {
-        printf("  [%d]: (G_%d, H_%d) degree=%d\n",
-               i, pg->vertices[i].v + 1, pg->vertices[i].u + 1, pg->degree[i]);
-    }
-
-    printf("Edges:\n");
-    int edge_count = 0;
-    for (int i = 0; i < pg->num_vertices; i++) {
-        for (int j = i + 1; j < pg->num_vertices; j++) {
-            if (pg->adj_matrix[i * pg->num_vertices + j]) {
-                printf("  [%d]-[%d]: (G_%d,H_%d)-(G_%d,H_%d)\n",
-                       i, j,
-                       pg->vertices[i].v + 1, pg->vertices[i].u + 1,
-                       pg->vertices[j].v + 1, pg->vertices[j].u + 1);
-                edge_count++;
-            }
-        }
+void free_product_graph(ProductGraph *pg) {
+    if (pg) {
+        mem_free(pg->vertices);
+        mem_free(pg->adj_matrix);
+        mem_free(pg->adj_bits);
+        mem_free(pg->degree);
+        mem_free(pg);
     }
-    printf("Total edges: %d\n", edge_count);
 }
 
 bool product_graph_adjacent(const ProductGraph *pg, int idx1, int idx2) {
     if (idx1 < 0 || idx1 >= pg->num_vertices || idx2 < 0 || idx2 >= pg->num_vertices) {
         return false;
     }
-    return pg->adj_matrix[idx1 * pg->num_vertices + idx2];
+    size_t cell = (size_t) idx1 * pg->num_vertices + idx2;
+    if (pg->adj_matrix) return pg->adj_matrix[cell];
+    return (pg->adj_bits[cell >> 6] >> (cell & 63)) & 1;
 }
 
 int product_graph_degree(const ProductGraph *pg, int idx) {
@@ -2,6 +2,9 @@
 #define AAC_PRODUCT_GRAPH_H
 
 #include <stdbool.h>
+#include <stdint.h>
+#include "../h_index.h"
+#include "../candidate_cache.h"
 
 /**
  * Modular Product Graph for Subgraph Isomorphism
@@ -21,7 +24,8 @@ typedef struct {
 typedef struct {
     ProductVertex *vertices; // Array of product graph vertices
     int num_vertices; // Number of vertices in product graph
-    bool *adj_matrix; // Adjacency matrix (flattened, num_vertices x num_vertices)
+    bool *adj_matrix; // Adjacency matrix (flattened, num_vertices x num_vertices), or NULL
+    uint64_t *adj_bits; // The same as a bitset when the matrix would pass the memory limit, else NULL
     int *degree; // Degree of each vertex in product graph
 
     // Original graph info (for reference)
@@ -36,19 +40,44 @@ typedef struct {
  * @param adj_g Adjacency matrix of G (flattened, n_g x n_g)
  * @param n_h Number of vertices in H
  * @param adj_h Adjacency matrix of H (flattened, n_h x n_h)
- * @return Pointer to ProductGraph (caller must free with free_product_graph)
+ * @param h_index Precomputed H degrees, signatures and cells, or NULL to compute them here
+ * @param candidates Shared compatible H vertices per G degree pair and signature (over h_index), or NULL
+ * @return Pointer to ProductGraph (caller must free with free_product_graph), or NULL (described
+ *         on stderr) if it does not fit in memory (or under the limit of mem_track.h, even as a
+ *         bitset) or H has a negative cell
  */
-ProductGraph *build_product_graph(int n_g, const int *adj_g, int n_h, const int *adj_h);
+ProductGraph *build_product_graph(int n_g, const int *adj_g, int n_h, const int *adj_h, const HIndex *h_index,
+                                  CandidateCache *candidates);
 
 /**
- * Free memory allocated for product graph
+ * Phase 1 filter: v can only map to u if u has at least v's out- and
+ * in-degree and its signature fits (see signature_fits)
  */
-void free_product_graph(ProductGraph *pg);
+static inline bool product_compatible(int out_g, int in_g, const VertexSignature *sig_g,
+                                      int out_h, int in_h, const VertexSignature *sig_h) {
+    return out_g <= out_h && in_g <= in_h && signature_fits(sig_g, sig_h);
+}
+
+/**
+ * Phase 1 of build_product_graph alone: the product vertices (v, u) that pass
+ * the degree and signature filter, counted without building anything. Works
+ * for any H whose degrees and signatures are known (dense, sparse or indexed).
+ *
+ * @param sig_g Signature of each G vertex
+ * @param out_deg_h Out-degree (sum of multiplicities) of each H vertex
+ * @param in_deg_h In-degree of each H vertex
+ * @param sig_h Signature of each H vertex
+ * @param per_vertex Receives the candidate count of each G vertex (n_g entries), or NULL
+ * @return Number of product graph vertices
+ */
+long long count_product_vertices(int n_g, const int *adj_g, const VertexSignature *sig_g, int n_h,
+                                 const int *out_deg_h, const int *in_deg_h, const VertexSignature *sig_h,
+                                 int *per_vertex);
 
 /**
- * Print product graph info (for debugging)
+ * Free memory allocated for product graph
  */
-void print_product_graph(const ProductGraph *pg);
+void free_product_graph(ProductGraph *pg);
 
 /**
  * Check if two product vertices are adjacent
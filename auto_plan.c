@@ -0,0 +1,395 @@
+#include "auto_plan.h"
+#include "canonical.h"
+#include "mem_track.h"
+#include "thread_pool.h"
+#include "trace.h"
+#include "algorithms/product_graph.h"
+#include "algorithms/minimal_extension.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define AUTO_STR_(x) #x
+#define AUTO_STR(x) AUTO_STR_(x)
+
+// Estimated plain greedy time below which the portfolio's thread start-up and
+// per-round synchronization cost more than the threads save
+#define AUTO_PORTFOLIO_MIN_MS 20.0
+
+// Product vertex pairs drawn to estimate the product graph's density, and
+// draws per pair end before giving up on finding a compatible H vertex
+#define AUTO_DENSITY_SAMPLES 4096
+#define AUTO_REJECTION_TRIES 64
+
+// Estimates are kept as log10 and capped here when converted (about 1e300 units)
+#define AUTO_MAX_LOG10 300.0
+
+AutoCalibration auto_default_calibration(void) {
+    // aac_benchmark --calibrate --min 4 --max 18 --step 2 --h-offset 8 --ext-limit 7 --reps 2 --seed 5
+    // (Release build). Per-instance costs spread around these by up to 6x for
+    // the clique search and 20x for the greedy, where the first mapping can turn
+    // up on any start: the estimates are orders of magnitude, not predictions.
+    AutoCalibration cal = {
+        .pair_ns = 8.14,
+        .clique_node_ns = 10.6,
+        .ext_node_ns = 2.29,
+        .iso_step_ns = 0.756,
+        .ext_step_ns = 1.69,
+    };
+    return cal;
+}
+
+// ============================================================================
+// Helper Functions
+// ============================================================================
+
+// log10(10^a + 10^b), with -INFINITY standing for 0
+static double log10_add(double a, double b) {
+    if (a == -INFINITY) return b;
+    if (b == -INFINITY) return a;
+    double hi = a > b ? a : b, lo = a > b ? b : a;
+    return hi + log10(1.0 + pow(10.0, lo - hi));
+}
+
+static double from_log10(double x) {
+    return x == -INFINITY ? 0.0 : pow(10.0, x < AUTO_MAX_LOG10 ? x : AUTO_MAX_LOG10);
+}
+
+// ============================================================================
+// Statistics
+// ============================================================================
+
+/**
+ * H degrees (sums of multiplicities), signatures and edge count
+ */
+static void measure_h(const AacInstance *inst, int *out_deg, int *in_deg, VertexSignature *sig, long long *edges) {
+    int n_h = inst->n_h;
+    memset(out_deg, 0, (size_t) n_h * sizeof(int));
+    memset(in_deg, 0, (size_t) n_h * sizeof(int));
+    *edges = 0;
+    if (inst->sparse_h) {
+        const SparseGraph *h = inst->sparse_h;
+        for (int u = 0; u < n_h; u++) {
+            for (int k = h->out_start[u]; k < h->out_start[u + 1]; k++) {
+                out_deg[u] += h->out_mult[k];
+                in_deg[h->out_dst[k]] += h->out_mult[k];
+                *edges += h->out_dst[k] != u;
+            }
+        }
+        vertex_signatures_sparse(h, sig);
+        return;
+    }
+    for (int u = 0; u < n_h; u++) {
+        const int *row = inst->adj_h + (size_t) u * n_h;
+        for (int v = 0; v < n_h; v++) {
+            out_deg[u] += row[v];
+            in_deg[v] += row[v];
+            *edges += u != v && row[v] > 0;
+        }
+    }
+    vertex_signatures(n_h, inst->adj_h, sig);
+}
+
+static inline int h_cell(const AacInstance *inst, int u, int v) {
+    return inst->sparse_h ? sparse_graph_mult(inst->sparse_h, u, v) : inst->adj_h[(size_t) u * inst->n_h + v];
+}
+
+static unsigned int xorshift32(unsigned int *state) {
+    unsigned int x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return *state = x;
+}
+
+// A random H vertex passing v's phase 1 filter (by rejection), or -1 if none turns up
+static int sample_candidate(int n_h, const int *h_out, const int *h_in, const VertexSignature *h_sig,
+                            int out_g, int in_g, const VertexSignature *sig_g, unsigned int *rng) {
+    for (int t = 0; t < AUTO_REJECTION_TRIES; t++) {
+        int u = (int) (xorshift32(rng) % (unsigned int) n_h);
+        if (product_compatible(out_g, in_g, sig_g, h_out[u], h_in[u], &h_sig[u])) return u;
+    }
+    return -1;
+}
+
+// G vertex of a random product vertex: v with probability cand[v] / total
+static int sample_g_vertex(const int *cand, long long total, unsigned int *rng) {
+    long long r = (long long) (((unsigned long long) xorshift32(rng) << 32 | xorshift32(rng)) % (unsigned long long) total);
+    int v = 0;
+    while (r >= cand[v]) r -= cand[v++];
+    return v;
+}
+
+/**
+ * Share of adjacent pairs among product vertices of distinct G vertices, by
+ * sampling pairs of product vertices: G vertices in proportion to their
+ * candidates, each on a random compatible H vertex. The filter keeps
+ * H's higher-degree vertices, whose cells are fuller than H's average, and
+ * clique counts amplify any error in the density, so it is measured on the
+ * candidates rather than derived from H's density.
+ */
+static double sample_product_density(const AacInstance *inst, const int *h_out, const int *h_in,
+                                     const VertexSignature *h_sig, const int *out_g, const int *in_g,
+                                     const VertexSignature *sig_g, const int *cand, long long total) {
+    int n_g = inst->n_g, n_h = inst->n_h;
+    if (n_g < 2 || n_h < 2 || total == 0) return 0;
+    unsigned int rng = 0x9E3779B9u; // Fixed: the same instance always gets the same plan
+    int drawn = 0, adjacent = 0;
+    for (int k = 0; k < AUTO_DENSITY_SAMPLES; k++) {
+        int i = sample_g_vertex(cand, total, &rng);
+        int j = sample_g_vertex(cand, total, &rng);
+        if (i == j) continue;
+        int u1 = sample_candidate(n_h, h_out, h_in, h_sig, out_g[i], in_g[i], &sig_g[i], &rng);
+        int u2 = sample_candidate(n_h, h_out, h_in, h_sig, out_g[j], in_g[j], &sig_g[j], &rng);
+        if (u1 < 0 || u2 < 0) continue;
+        drawn++;
+        adjacent += u1 != u2 && inst->adj_g[(size_t) i * n_g + j] <= h_cell(inst, u1, u2) &&
+                    inst->adj_g[(size_t) j * n_g + i] <= h_cell(inst, u2, u1);
+    }
+    return drawn > 0 ? (double) adjacent / drawn : 0;
+}
+
+/**
+ * Expected clique search nodes of iso_exact. Product vertices are ordered by G
+ * vertex and the size bound only cuts sets too small to finish, so the search
+ * visits the cliques on every subset of G vertices: e_k(c) candidate choices
+ * for the k-subsets, each pair of them adjacent with the product graph's
+ * density. (Sparse subsets of G dominate the sum, which is why the density is
+ * averaged over G's pairs rather than taken edge by edge.)
+ */
+static double estimate_clique_nodes(int n_g, const int *cand, double density) {
+    // e_k of the candidate counts, by the usual recurrence, in log space
+    double *e = (double *) malloc((size_t) (n_g + 1) * sizeof(double));
+    if (!e) return 0;
+    e[0] = 0;
+    for (int k = 1; k <= n_g; k++) e[k] = -INFINITY;
+    for (int v = 0; v < n_g; v++) {
+        double lc = cand[v] > 0 ? log10((double) cand[v]) : -INFINITY;
+        for (int k = v + 1; k >= 1; k--) e[k] = log10_add(e[k], e[k - 1] + lc);
+    }
+
+    double log10_density = density > 0 ? log10(density) : -INFINITY;
+    double nodes = -INFINITY;
+    for (int k = 1; k <= n_g; k++) {
+        double pairs = (double) k * (k - 1) / 2;
+        nodes = log10_add(nodes, e[k] + (k > 1 ? pairs * log10_density : 0));
+    }
+    free(e);
+    return nodes;
+}
+
+/**
+ * ext_exact per round: every injective partial mapping is a node, n_h!/(n_h-k)!
+ * at depth k, and each complete one costs a deficit over G's n_g^2 cells
+ */
+static double estimate_ext_nodes(int n_g, int n_h) {
+    double level = 0, nodes = 0;
+    for (int k = 1; k <= n_g && k <= n_h; k++) {
+        level += log10((double) (n_h - k + 1));
+        nodes = log10_add(nodes, level);
+    }
+    if (n_g > n_h) return nodes;
+    return log10_add(nodes, level + 2 * log10((double) (n_g > 0 ? n_g : 1)));
+}
+
+// ============================================================================
+// Planning
+// ============================================================================
+
+static void choose(AutoPlan *plan, int max_threads) {
+    AacEngine exact = plan->extension ? AAC_EXT_EXACT : AAC_ISO_EXACT;
+    AacEngine approx = plan->extension ? AAC_EXT_APPROX : AAC_ISO_APPROX;
+    plan->threads = 1;
+    plan->portfolio = false;
+    plan->random_strategies = 0;
+
+    if (plan->fits[exact] && plan->estimate_ms[exact] <= plan->budget_ms) {
+        plan->engine = exact;
+        plan->planned_ms = plan->estimate_ms[exact];
+        plan->reason = "the exact search is estimated to fit the budget";
+        return;
+    }
+    plan->engine = approx;
+    plan->planned_ms = plan->estimate_ms[approx];
+    plan->reason = plan->fits[exact] ? "the exact search is estimated over budget" : plan->misfit[exact];
+
+    // The portfolio runs 2 tie-breaks per anchor (plus random strategies) over
+    // the same starts as the plain greedy, spread over the threads; the sparse
+    // greedy has no portfolio
+    int threads = max_threads > 0 ? max_threads : cpu_count();
+    if (approx != AAC_EXT_APPROX || plan->sparse_h || threads < 2 || plan->planned_ms < AUTO_PORTFOLIO_MIN_MS) return;
+    int strategies = 2 * ext_approx_default_options().portfolio_anchors;
+    // A symmetric G leaves the greedy many ties: randomized tie-breaks try more of them
+    int random = plan->log10_automorphisms >= 1.0 ? strategies : 0;
+    double ms = plan->estimate_ms[approx] * (strategies + random) / threads;
+    if (random > 0 && ms > plan->budget_ms) {
+        random = 0;
+        ms = plan->estimate_ms[approx] * strategies / threads;
+    }
+    if (ms > plan->budget_ms && ms > plan->planned_ms) return;
+    plan->portfolio = true;
+    plan->threads = threads;
+    plan->random_strategies = random;
+    plan->planned_ms = ms;
+}
+
+int auto_plan(const AacInstance *instance, bool extension, double budget_ms, int max_threads,
+              const AutoCalibration *cal, AutoPlan *plan) {
+    int n_g = instance->n_g, n_h = instance->n_h;
+    const int *adj_g = instance->adj_g;
+    memset(plan, 0, sizeof(*plan));
+    plan->extension = extension;
+    plan->n = instance->n > 0 ? instance->n : 1;
+    plan->n_g = n_g;
+    plan->n_h = n_h;
+    plan->sparse_h = instance->sparse_h && !instance->adj_h;
+    plan->budget_ms = budget_ms;
+
+    trace_begin("plan");
+    size_t h_count = n_h > 0 ? (size_t) n_h : 1, g_count = n_g > 0 ? (size_t) n_g : 1;
+    int *out_deg = (int *) malloc(h_count * sizeof(int));
+    int *in_deg = (int *) malloc(h_count * sizeof(int));
+    int *cand = (int *) malloc(g_count * sizeof(int));
+    int *out_g = (int *) calloc(g_count, sizeof(int));
+    int *in_g = (int *) calloc(g_count, sizeof(int));
+    int *col = (int *) malloc(g_count * sizeof(int));
+    int *class_size = (int *) calloc(g_count, sizeof(int));
+    VertexSignature *sig_h = (VertexSignature *) malloc(h_count * sizeof(VertexSignature));
+    VertexSignature *sig_g = (VertexSignature *) malloc(g_count * sizeof(VertexSignature));
+    if (!out_deg || !in_deg || !cand || !out_g || !in_g || !col || !class_size || !sig_h || !sig_g) {
+        fprintf(stderr, "Error: out of memory planning the search\n");
+        free(out_deg);
+        free(in_deg);
+        free(sig_h);
+        free(sig_g);
+        free(cand);
+        free(out_g);
+        free(in_g);
+        free(col);
+        free(class_size);
+        trace_end("plan");
+        return -1;
+    }
+
+    // Graph statistics; H degrees and signatures from the index when there is one
+    measure_h(instance, out_deg, in_deg, sig_h, &plan->edges_h);
+    const int *h_out = instance->h_index ? instance->h_index->out_deg : out_deg;
+    const int *h_in = instance->h_index ? instance->h_index->in_deg : in_deg;
+    const VertexSignature *h_sig = instance->h_index ? instance->h_index->signature : sig_h;
+    double g_pairs = (double) n_g * (n_g - 1), h_pairs = (double) n_h * (n_h - 1);
+    for (int i = 0; i < n_g; i++) {
+        for (int j = 0; j < n_g; j++) {
+            int mult = adj_g[(size_t) i * n_g + j];
+            out_g[i] += mult;
+            in_g[j] += mult;
+            plan->edges_g += i != j && mult > 0;
+        }
+    }
+    plan->density_g = g_pairs > 0 ? (double) plan->edges_g / g_pairs : 0;
+    plan->density_h = h_pairs > 0 ? (double) plan->edges_h / h_pairs : 0;
+    vertex_signatures(n_g, adj_g, sig_g);
+    plan->product_vertices = count_product_vertices(n_g, adj_g, sig_g, n_h, h_out, h_in, h_sig, cand);
+
+    // Symmetry: |Aut(G)| is at most the product of the class sizes' factorials
+    plan->colour_classes = canonical_colour_classes(n_g, adj_g, col);
+    if (plan->colour_classes < 0) plan->colour_classes = n_g; // Out of memory: assume no symmetry
+    else {
+        for (int v = 0; v < n_g; v++) class_size[col[v]]++;
+        for (int c = 0; c < plan->colour_classes; c++) {
+            if (class_size[c] > plan->largest_class) plan->largest_class = class_size[c];
+            plan->log10_automorphisms += lgamma(class_size[c] + 1.0) / log(10.0);
+        }
+    }
+
+    plan->product_density = sample_product_density(instance, h_out, h_in, h_sig, out_g, in_g, sig_g, cand,
+                                                   plan->product_vertices);
+
+    // Work per engine
+    double p = (double) plan->product_vertices;
+    plan->product_pairs = p * (p - 1) / 2;
+    plan->clique_nodes = from_log10(estimate_clique_nodes(n_g, cand, plan->product_density));
+    plan->ext_nodes = from_log10(estimate_ext_nodes(n_g, n_h) + log10((double) plan->n));
+
+    // Greedy starts: about one pass over H for the first anchor per mapping
+    // wanted (every anchor at most). A dense candidate check reads H's row and
+    // column (n_h) and G's (n_g); a sparse greedy only tries neighbours of
+    // placed images.
+    double avg_degree = n_h > 0 ? 2.0 * (double) plan->edges_h / n_h : 0;
+    double h_checked = plan->sparse_h ? (avg_degree + 1 < n_h ? avg_degree + 1 : n_h) : n_h;
+    double check = plan->sparse_h ? n_g : (double) n_h + n_g;
+    double starts = (double) (plan->n < n_g ? plan->n : n_g) * n_h;
+    plan->iso_steps = starts * n_g * h_checked * check;
+    plan->ext_steps = (double) plan->n * n_h * h_checked * ((double) n_g + 2.0 * (double) plan->edges_g);
+
+    plan->estimate_ms[AAC_ISO_EXACT] = (plan->product_pairs * cal->pair_ns + plan->clique_nodes * cal->clique_node_ns) / 1e6;
+    plan->estimate_ms[AAC_ISO_APPROX] = plan->iso_steps * cal->iso_step_ns / 1e6;
+    plan->estimate_ms[AAC_EXT_EXACT] = plan->ext_nodes * cal->ext_node_ns / 1e6;
+    plan->estimate_ms[AAC_EXT_APPROX] = plan->ext_steps * cal->ext_step_ns / 1e6;
+
+    // The exact engines need H as a matrix and iso_exact a product graph (at least as a bitset)
+    double dense_bytes = plan->sparse_h ? (double) n_h * n_h * sizeof(int) : 0;
+    double product_bytes = p * p / 8;
+    plan->fits[AAC_ISO_EXACT] = dense_bytes + product_bytes < (double) SIZE_MAX / 2 &&
+                                mem_fits((size_t) (dense_bytes + product_bytes));
+    plan->fits[AAC_EXT_EXACT] = dense_bytes < (double) SIZE_MAX / 2 && mem_fits((size_t) dense_bytes);
+    plan->fits[AAC_ISO_APPROX] = plan->fits[AAC_EXT_APPROX] = true;
+    for (int e = 0; e < AUTO_NUM_ENGINES; e++) {
+        plan->misfit[e] = plan->fits[e] ? NULL : "the exact search does not fit in memory";
+    }
+    // ext_exact refuses larger graphs outright
+    if (n_g > EXT_EXACT_MAX_VERTICES || n_h > EXT_EXACT_MAX_VERTICES) {
+        plan->fits[AAC_EXT_EXACT] = false;
+        plan->misfit[AAC_EXT_EXACT] = "ext_exact is limited to " AUTO_STR(EXT_EXACT_MAX_VERTICES) " vertices";
+    }
+
+    choose(plan, max_threads);
+    trace_end("plan");
+
+    free(out_deg);
+    free(in_deg);
+    free(cand);
+    free(out_g);
+    free(in_g);
+    free(col);
+    free(class_size);
+    free(sig_h);
+    free(sig_g);
+    return 0;
+}
+
+void auto_plan_apply(const AutoPlan *plan, AacOptions *opts) {
+    opts->engine = plan->engine;
+    if (plan->portfolio) {
+        opts->approx.portfolio = true;
+        if (opts->approx.threads <= 0) opts->approx.threads = plan->threads;
+        if (opts->approx.portfolio_random < plan->random_strategies) {
+            opts->approx.portfolio_random = plan->random_strategies;
+        }
+    }
+}
+
+void auto_plan_print(FILE *f, const AutoPlan *plan) {
+    AacEngine exact = plan->extension ? AAC_EXT_EXACT : AAC_ISO_EXACT;
+    AacEngine approx = plan->extension ? AAC_EXT_APPROX : AAC_ISO_APPROX;
+    fprintf(f, "--- Plan ---\n");
+    fprintf(f, "G: %d vertices, %lld edges (density %.4f), %d colour class(es), largest %d, "
+               "automorphisms <= 10^%.1f\n", plan->n_g, plan->edges_g, plan->density_g, plan->colour_classes,
+            plan->largest_class, plan->log10_automorphisms);
+    fprintf(f, "H: %d vertices, %lld edges (density %.4f), %s\n", plan->n_h, plan->edges_h, plan->density_h,
+            plan->sparse_h ? "edge lists" : "matrix");
+    fprintf(f, "Product graph: %lld of %lld vertices after the degree and signature filter, expected density %.4f\n",
+            plan->product_vertices, (long long) plan->n_g * plan->n_h, plan->product_density);
+    fprintf(f, "Estimated %s: %.3g ms%s%s%s, %s: %.3g ms (budget %.0f ms)\n", aac_engine_name(exact),
+            plan->estimate_ms[exact], plan->fits[exact] ? "" : " (", plan->fits[exact] ? "" : plan->misfit[exact],
+            plan->fits[exact] ? "" : ")",
+            aac_engine_name(approx), plan->estimate_ms[approx], plan->budget_ms);
+    if (plan->portfolio) {
+        fprintf(f, "Chosen: %s, portfolio of %d strategies on %d threads, about %.3g ms (%s)\n",
+                aac_engine_name(plan->engine),
+                2 * ext_approx_default_options().portfolio_anchors + plan->random_strategies, plan->threads,
+                plan->planned_ms, plan->reason);
+    } else {
+        fprintf(f, "Chosen: %s, 1 thread, about %.3g ms (%s)\n", aac_engine_name(plan->engine), plan->planned_ms,
+                plan->reason);
+    }
+}
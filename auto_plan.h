@@ -0,0 +1,97 @@
+#ifndef AAC_AUTO_PLAN_H
+#define AAC_AUTO_PLAN_H
+
+#include <stdbool.h>
+#include <stdio.h>
+#include "aac.h"
+
+/**
+ * Engine choice from cheap statistics of an instance (the auto command).
+ *
+ * The planner measures n_g, n_h, the density and multiplicities of both
+ * graphs, the product vertices that survive the degree and signature filter
+ * (phase 1 of build_product_graph) and G's colour classes, then counts the work each
+ * engine would do: product pairs and expected clique search nodes for
+ * iso_exact, backtracking nodes for ext_exact, candidate scorings for the
+ * greedy heuristics. Per-unit costs measured by aac_benchmark --calibrate turn
+ * the counts into milliseconds. The exact engine runs when its estimate fits
+ * the time budget, the heuristic otherwise; a long ext_approx on a matrix H
+ * gets the portfolio on every CPU, with randomized strategies for a symmetric G.
+ */
+
+/**
+ * Cost of one work unit, in nanoseconds
+ */
+typedef struct {
+    double pair_ns;        // iso_exact: product vertex pair checked for adjacency (phase 2)
+    double clique_node_ns; // iso_exact: expected clique search node
+    double ext_node_ns;    // ext_exact: backtracking node (a complete mapping counts n_g^2)
+    double iso_step_ns;    // iso_approx: H candidate checked against one G vertex, per start
+    double ext_step_ns;    // ext_approx: H candidate scored for one G vertex or edge, per start
+} AutoCalibration;
+
+// Default time the exact engine may be estimated to take
+#define AUTO_DEFAULT_BUDGET_MS 1000.0
+
+// The four engines auto chooses between (AAC_ISO_EXACT .. AAC_EXT_APPROX)
+#define AUTO_NUM_ENGINES 4
+
+/**
+ * Statistics of an instance, the work and time estimates, and the choice
+ */
+typedef struct {
+    bool extension;             // Minimal extension, else isomorphisms
+    int n;                      // Mappings to find
+    int n_g, n_h;
+    long long edges_g, edges_h; // Ordered vertex pairs with an edge (loops excluded)
+    double density_g, density_h;
+    bool sparse_h;              // H is in CSR form
+    long long product_vertices; // (v, u) pairs passing phase 1 of build_product_graph
+    double product_density;     // Expected share of adjacent product vertex pairs (H's cells taken as random)
+    int colour_classes;         // G's classes after colour refinement
+    int largest_class;
+    double log10_automorphisms; // Upper bound on log10 |Aut(G)|: sum of log10(size!) over the classes
+
+    // Work units (see AutoCalibration)
+    double product_pairs, clique_nodes, ext_nodes, iso_steps, ext_steps;
+    double estimate_ms[AUTO_NUM_ENGINES]; // Single-threaded, by AacEngine
+    bool fits[AUTO_NUM_ENGINES];          // Within the engine's size limit and the memory limit (see mem_track.h)
+    const char *misfit[AUTO_NUM_ENGINES]; // Why an engine does not fit (NULL if it does)
+
+    double budget_ms;
+    AacEngine engine;
+    bool portfolio;                       // ext_approx portfolio
+    int threads;                          // Threads the engine will use
+    int random_strategies;                // Portfolio strategies with randomized tie-breaking
+    double planned_ms;                    // Estimate for the choice (wall clock)
+    const char *reason;
+} AutoPlan;
+
+/**
+ * Per-unit costs measured on the development machine (see test/benchmark.c)
+ */
+AutoCalibration auto_default_calibration(void);
+
+/**
+ * Measure instance (its n, 0 = 1) and choose an engine for it
+ *
+ * @param extension Plan a minimal extension instead of isomorphisms
+ * @param budget_ms Time the exact engine may be estimated to take
+ * @param max_threads Portfolio thread cap (0 = one per CPU)
+ * @return 0, or -1 if out of memory (described on stderr)
+ */
+int auto_plan(const AacInstance *instance, bool extension, double budget_ms, int max_threads,
+              const AutoCalibration *cal, AutoPlan *plan);
+
+/**
+ * Set the chosen engine in opts and enable the planned portfolio. Options the
+ * caller set are kept (a requested portfolio is not turned off).
+ */
+void auto_plan_apply(const AutoPlan *plan, AacOptions *opts);
+
+/**
+ * The statistics, estimates and choice, for the record
+ */
+void auto_plan_print(FILE *f, const AutoPlan *plan);
+
+#endif //AAC_AUTO_PLAN_H
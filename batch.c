@@ -0,0 +1,353 @@
+#include "batch.h"
+#include "aac.h"
+#include "graph.h"
+#include "thread_pool.h"
+#include "output.h"
+#include "fingerprint.h"
+#include "trace.h"
+#include "utils.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Instances read and solved together; bounds memory for long streams while
+// keeping every worker busy
+#define WINDOW_PER_JOB 4
+
+// ============================================================================
+// Types
+// ============================================================================
+
+typedef struct {
+    GraphPair pair;            // G, plus H when the stream holds (G, H) pairs; H alone with --pattern
+    OutWriter record;          // In-memory result, written by the worker that solved it
+    FingerprintCheck screened; // Outcome of the fingerprint check (FITS if none was made)
+} BatchInstance;
+
+typedef struct {
+    const BatchOptions *opts;
+    AacContext *ctx;              // Engine settings, plus the shared H with --target
+    bool shared_target;
+    int target_n_h;
+    GraphPair *pattern;           // Shared G with --pattern, else NULL
+    GraphFingerprint *pattern_fp; // Its fingerprint if targets are screened, else NULL
+    bool screen_loops;            // Screen loops too (only iso_approx maps them)
+    BatchInstance *window;
+    int first_number;             // 1-based instance number of window[0]
+} BatchRun;
+
+// ============================================================================
+// Helper Functions
+// ============================================================================
+
+// Mappings as 1-based H vertices per G vertex: "2,3,1;3,1,2" ("-" if none)
+static void record_mappings(OutWriter *r, int *const *mappings, int count, int n_g) {
+    out_str(r, " mappings=");
+    if (count == 0) out_char(r, '-');
+    for (int k = 0; k < count; k++) {
+        if (k > 0) out_char(r, ';');
+        for (int v = 0; v < n_g; v++) {
+            if (v > 0) out_char(r, ',');
+            out_int(r, mappings[k][v] + 1);
+        }
+    }
+}
+
+static void record_instance(OutWriter *r, const RunSummary *s) {
+    out_str(r, "instance=");
+    out_int(r, s->instance);
+    out_str(r, " n_g=");
+    out_int(r, s->n_g);
+    out_str(r, " n_h=");
+    out_int(r, s->n_h);
+}
+
+// key=value line of the text format
+static void record_text(OutWriter *r, const RunSummary *s) {
+    record_instance(r, s);
+    out_str(r, " status=ok found=");
+    out_int(r, s->num_mappings);
+    if (s->extension) {
+        out_str(r, " edges_added=");
+        out_int(r, s->edges_added);
+    } else {
+        out_str(r, " subgraph=");
+        out_str(r, s->is_subgraph ? "YES" : "NO");
+    }
+    if (s->screened) {
+        out_str(r, " screened=");
+        out_str(r, s->screened);
+    }
+    if (s->optimal >= 0) {
+        out_str(r, " optimal=");
+        out_str(r, s->optimal ? "YES" : "NO");
+    }
+    out_str(r, " time_ms=");
+    out_ms(r, s->time_ms);
+    record_mappings(r, s->mappings, s->num_mappings, s->n_g);
+    out_char(r, '\n');
+}
+
+// ============================================================================
+// Solving One Instance
+// ============================================================================
+
+static void write_record(const BatchOptions *opts, OutWriter *r, const RunSummary *summary) {
+    if (opts->format == OUTPUT_JSON) {
+        write_summary_json(r, summary);
+    } else if (opts->format == OUTPUT_CSV) {
+        write_summary_csv(r, summary);
+    } else if (opts->format == OUTPUT_TEXT) {
+        record_text(r, summary);
+    }
+}
+
+static void solve_instance(const BatchRun *run, BatchInstance *inst, int number) {
+    const BatchOptions *opts = run->opts;
+    const GraphPair *gp = &inst->pair;
+    OutWriter *r = &inst->record;
+    out_init(r, NULL);
+
+    // Only json and csv print per-mapping figures; the collector formats nothing
+    StatsCollector collector;
+    stats_collector_init(&collector);
+    const Reporter *rep = (opts->format == OUTPUT_JSON || opts->format == OUTPUT_CSV) ? &collector.reporter : NULL;
+
+    // In pair mode each instance brings its own H; with a pattern the stream graph is H
+    AacInstance instance = {.n_g = gp->n_g, .adj_g = gp->adj_g};
+    if (run->pattern) {
+        instance = (AacInstance) {
+            .n_g = run->pattern->n_g, .adj_g = run->pattern->adj_g,
+            .n_h = gp->n_g, .adj_h = gp->adj_g
+        };
+    } else if (!run->shared_target) {
+        instance.n_h = gp->n_h;
+        instance.adj_h = gp->adj_h;
+        instance.sparse_h = gp->sparse_h;
+    }
+
+    RunSummary summary = {
+        .instance = number,
+        .command = opts->command,
+        .n_g = instance.n_g,
+        .n_h = run->shared_target ? run->target_n_h : instance.n_h,
+        .optimal = -1
+    };
+
+    // Targets whose fingerprint rules the pattern out are answered without a search
+    inst->screened = FINGERPRINT_FITS;
+    if (run->pattern_fp) {
+        double start = now_ms();
+        GraphFingerprint fp;
+        if (graph_fingerprint(instance.n_h, instance.adj_h, &fp) == 0) {
+            inst->screened = fingerprint_check(run->pattern_fp, &fp, run->screen_loops);
+            free_graph_fingerprint(&fp);
+        }
+        if (inst->screened != FINGERPRINT_FITS) {
+            summary.screened = fingerprint_check_name(inst->screened);
+            summary.time_ms = now_ms() - start;
+            write_record(opts, r, &summary);
+            stats_collector_free(&collector);
+            return;
+        }
+    }
+
+    collector.start_ms = now_ms();
+    AacResult *result = aac_solve_reported(run->ctx, &instance, rep);
+    if (!result) {
+        if (opts->format == OUTPUT_TEXT) {
+            record_instance(r, &summary);
+            out_str(r, " status=error\n");
+        }
+        stats_collector_free(&collector);
+        return;
+    }
+
+    summary.time_ms = result->time_ms;
+    summary.extension = result->ext != NULL;
+    summary.is_subgraph = result->iso && result->iso->is_subgraph;
+    summary.edges_added = result->ext ? result->ext->total_edges_added : 0;
+    if (result->engine == AAC_EXT_JOINT) summary.optimal = result->joint.optimal;
+    summary.mappings = result->mappings;
+    summary.num_mappings = result->num_mappings;
+    summary.stats = collector.stats;
+    summary.num_stats = collector.count;
+    write_record(opts, r, &summary);
+
+    aac_free_result(result);
+    stats_collector_free(&collector);
+}
+
+static void solve_task(void *arg, int task, int worker) {
+    (void) worker;
+    const BatchRun *run = (const BatchRun *) arg;
+    trace_begin_index("instance", run->first_number + task);
+    solve_instance(run, &run->window[task], run->first_number + task);
+    trace_end("instance");
+}
+
+// ============================================================================
+// Main Loop
+// ============================================================================
+
+static void release_pattern(BatchRun *run) {
+    if (run->pattern_fp) free_graph_fingerprint(run->pattern_fp);
+    if (run->pattern) free_graph_pair(run->pattern);
+}
+
+int run_batch(const BatchOptions *opts) {
+    BatchRun run = {.opts = opts};
+    AacEngine engine;
+    if (!aac_parse_engine(opts->command, &engine)) {
+        fprintf(stderr, "Error: Unknown batch command '%s'\n", opts->command);
+        return 1;
+    }
+    if (opts->target_path && opts->pattern_path) {
+        fprintf(stderr, "Error: --target and --pattern cannot be combined\n");
+        return 1;
+    }
+
+    // Shared G: only isomorphisms can be ruled out (an extension always exists)
+    GraphPair pattern;
+    GraphFingerprint pattern_fp;
+    if (opts->pattern_path) {
+        if (load_graph_g(opts->pattern_path, &pattern) != 0) return 1;
+        run.pattern = &pattern;
+        if (engine == AAC_ISO_EXACT || engine == AAC_ISO_APPROX) {
+            if (graph_fingerprint(pattern.n_g, pattern.adj_g, &pattern_fp) != 0) {
+                fprintf(stderr, "Error: out of memory\n");
+                free_graph_pair(&pattern);
+                return 1;
+            }
+            run.pattern_fp = &pattern_fp;
+            run.screen_loops = engine == AAC_ISO_APPROX;
+        }
+    }
+
+    AacOptions engine_opts = aac_default_options(engine);
+    engine_opts.n = opts->n;
+    engine_opts.joint_budget = opts->joint_budget;
+    engine_opts.approx = opts->approx_opts;
+    engine_opts.share_target = opts->target_path != NULL;
+    engine_opts.cache_dir = opts->cache_dir;
+    run.ctx = aac_create(&engine_opts);
+    if (!run.ctx) {
+        release_pattern(&run);
+        return 1;
+    }
+
+    GraphPair target;
+    if (opts->target_path) {
+        if (load_graph_pair(NULL, opts->target_path, &target) != 0) {
+            aac_destroy(run.ctx);
+            release_pattern(&run);
+            return 1;
+        }
+        if (aac_set_target(run.ctx, target.n_h, target.adj_h, target.sparse_h, target.h_index) != 0) {
+            aac_destroy(run.ctx);
+            free_graph_pair(&target);
+            release_pattern(&run);
+            return 1;
+        }
+        run.shared_target = true;
+        run.target_n_h = target.n_h;
+    }
+
+    GraphStream stream;
+    if (open_graph_stream(opts->input_path, &stream) != 0) {
+        aac_destroy(run.ctx);
+        if (run.shared_target) free_graph_pair(&target);
+        release_pattern(&run);
+        return 1;
+    }
+
+    ThreadPool *pool = NULL;
+    int jobs = opts->jobs > 0 ? opts->jobs : cpu_count();
+    if (jobs > 1) {
+        pool = thread_pool_create(jobs);
+        if (pool) jobs = thread_pool_size(pool);
+        else jobs = 1;
+    }
+    int window_size = jobs * WINDOW_PER_JOB;
+    run.window = (BatchInstance *) calloc((size_t) window_size, sizeof(BatchInstance));
+    if (!run.window) {
+        fprintf(stderr, "Error: out of memory\n");
+        thread_pool_destroy(pool);
+        close_graph_stream(&stream);
+        aac_destroy(run.ctx);
+        if (run.shared_target) free_graph_pair(&target);
+        release_pattern(&run);
+        return 1;
+    }
+
+    OutWriter out;
+    out_init(&out, stdout);
+    if (opts->format == OUTPUT_CSV) write_csv_header(&out);
+
+    int rc = 0;
+    int number = 1;
+    int screened = 0;
+    int rejections[FINGERPRINT_CHECKS] = {0};
+    bool done = false;
+    while (!done) {
+        // Read the next window of instances
+        int count = 0;
+        trace_begin("read_window");
+        while (count < window_size) {
+            int got = read_stream_pair(&stream, !run.shared_target && !run.pattern, &run.window[count].pair);
+            if (got == 0) {
+                done = true;
+                break;
+            }
+            if (got < 0) {
+                fprintf(stderr, "Batch input: instance %d is invalid (line %d), stopping\n",
+                        number + count, stream.line);
+                rc = 1;
+                done = true;
+                break;
+            }
+            count++;
+        }
+        trace_end("read_window");
+
+        run.first_number = number;
+        if (pool && count > 1) {
+            thread_pool_run(pool, count, solve_task, &run);
+        } else {
+            for (int k = 0; k < count; k++) solve_task(&run, k, 0);
+        }
+
+        for (int k = 0; k < count; k++) {
+            BatchInstance *inst = &run.window[k];
+            if (run.pattern_fp) {
+                screened++;
+                rejections[inst->screened]++;
+            }
+            out_write(&out, inst->record.buf, inst->record.len);
+            out_free(&inst->record);
+            free_graph_pair(&inst->pair);
+            memset(inst, 0, sizeof(*inst));
+        }
+        out_flush(&out);
+        number += count;
+    }
+
+    out_free(&out);
+    free(run.window);
+    thread_pool_destroy(pool);
+    close_graph_stream(&stream);
+    aac_destroy(run.ctx);
+    if (run.shared_target) free_graph_pair(&target);
+
+    if (run.pattern_fp) {
+        int rejected = screened - rejections[FINGERPRINT_FITS];
+        fprintf(stderr, "Screening: %d of %d target(s) rejected without search (%.1f%%)", rejected, screened,
+                screened > 0 ? 100.0 * rejected / screened : 0.0);
+        for (int c = FINGERPRINT_FITS + 1; c < FINGERPRINT_CHECKS; c++) {
+            fprintf(stderr, ", %s %d", fingerprint_check_name((FingerprintCheck) c), rejections[c]);
+        }
+        fprintf(stderr, "\n");
+    }
+    release_pattern(&run);
+    return rc;
+}
@@ -0,0 +1,37 @@
+#ifndef AAC_BATCH_H
+#define AAC_BATCH_H
+
+#include <stdbool.h>
+#include "algorithms.h"
+#include "output.h"
+
+/**
+ * Settings for running one engine over many instances in a single process
+ */
+typedef struct {
+    const char *command;        // iso_exact, iso_approx, ext_exact, ext_approx or ext_joint
+    const char *input_path;     // Text graph stream, "-" = standard input
+    const char *target_path;    // Shared H for every G of the stream, or NULL for (G, H) pairs
+    const char *pattern_path;   // Shared G for every H of the stream (excludes target_path), or NULL
+    int n;                      // Isomorphisms / mappings per instance
+    int jobs;                   // Instances solved concurrently (<= 0 = one per CPU)
+    OutputFormat format;        // text = key=value lines, json = JSON Lines, csv = rows per mapping
+    JointBudget joint_budget;
+    ExtApproxOptions approx_opts;
+    const char *cache_dir;      // Result cache for iso_exact / ext_exact, or NULL
+} BatchOptions;
+
+/**
+ * Run the engine on every instance of the stream and print its result to
+ * stdout in the chosen format, in input order. Engines run non-interactively
+ * and without progress output.
+ *
+ * With a pattern, isomorphism commands first compare fingerprints (see
+ * fingerprint.h) and only search targets that pass; how many each check
+ * rejected is printed to stderr at the end.
+ *
+ * @return 0 if every instance was read, 1 on unreadable input or an unknown command
+ */
+int run_batch(const BatchOptions *opts);
+
+#endif //AAC_BATCH_H
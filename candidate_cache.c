@@ -0,0 +1,129 @@
+#include "candidate_cache.h"
+#include "sparse_graph.h"
+#include <pthread.h>
+#include <stdlib.h>
+
+typedef struct {
+    int out_deg, in_deg;
+    VertexSignature sig;
+} CandidateKey;
+
+typedef struct {
+    uint64_t hash; // Of the key, 0 = empty slot
+    CandidateKey key;
+    int *ids;
+    int count;
+} CandidateSet;
+
+struct CandidateCache {
+    const HIndex *idx;
+    pthread_mutex_t lock;
+    CandidateSet *slots; // Open addressing, at most half full
+    size_t mask;
+    size_t used;
+};
+
+CandidateCache *candidate_cache_create(const HIndex *idx) {
+    CandidateCache *cache = (CandidateCache *) calloc(1, sizeof(CandidateCache));
+    if (!cache) return NULL;
+    cache->idx = idx;
+    cache->mask = 63;
+    cache->slots = (CandidateSet *) calloc(cache->mask + 1, sizeof(CandidateSet));
+    if (!cache->slots) {
+        free(cache);
+        return NULL;
+    }
+    pthread_mutex_init(&cache->lock, NULL);
+    return cache;
+}
+
+void candidate_cache_destroy(CandidateCache *cache) {
+    if (!cache) return;
+    for (size_t s = 0; s <= cache->mask; s++) {
+        free(cache->slots[s].ids);
+    }
+    free(cache->slots);
+    pthread_mutex_destroy(&cache->lock);
+    free(cache);
+}
+
+static bool same_key(const CandidateKey *a, const CandidateKey *b) {
+    return a->out_deg == b->out_deg && a->in_deg == b->in_deg && a->sig.out_nbrs == b->sig.out_nbrs &&
+           a->sig.in_nbrs == b->sig.in_nbrs && a->sig.max_mult == b->sig.max_mult;
+}
+
+// Nonzero hash of a key (FNV-1a over its fields)
+static uint64_t hash_key(const CandidateKey *key) {
+    const int fields[5] = {key->out_deg, key->in_deg, key->sig.out_nbrs, key->sig.in_nbrs, key->sig.max_mult};
+    uint64_t h = 0xCBF29CE484222325ull;
+    for (int f = 0; f < 5; f++) {
+        h ^= (uint32_t) fields[f];
+        h *= 0x100000001B3ull;
+    }
+    return h ? h : 1;
+}
+
+static CandidateSet *find_slot(CandidateSet *slots, size_t mask, uint64_t hash, const CandidateKey *key) {
+    size_t s = sparse_graph_slot(hash, mask);
+    while (slots[s].hash != 0 && (slots[s].hash != hash || !same_key(&slots[s].key, key))) s = (s + 1) & mask;
+    return &slots[s];
+}
+
+// Double the table; returns false (table unchanged) if out of memory
+static bool grow(CandidateCache *cache) {
+    size_t mask = cache->mask * 2 + 1;
+    CandidateSet *slots = (CandidateSet *) calloc(mask + 1, sizeof(CandidateSet));
+    if (!slots) return false;
+    for (size_t s = 0; s <= cache->mask; s++) {
+        const CandidateSet *set = &cache->slots[s];
+        if (set->hash != 0) *find_slot(slots, mask, set->hash, &set->key) = *set;
+    }
+    free(cache->slots);
+    cache->slots = slots;
+    cache->mask = mask;
+    return true;
+}
+
+static int *compute_candidates(const HIndex *idx, const CandidateKey *key, int *count) {
+    int *ids = (int *) malloc((idx->n > 0 ? (size_t) idx->n : 1) * sizeof(int));
+    if (!ids) return NULL;
+    int num = 0;
+    for (int u = 0; u < idx->n; u++) {
+        if (key->out_deg <= idx->out_deg[u] && key->in_deg <= idx->in_deg[u] &&
+            signature_fits(&key->sig, &idx->signature[u])) {
+            ids[num++] = u;
+        }
+    }
+    *count = num;
+    return ids;
+}
+
+const int *candidate_cache_get(CandidateCache *cache, int out_deg, int in_deg, const VertexSignature *sig,
+                               int *count) {
+    CandidateKey key = {.out_deg = out_deg, .in_deg = in_deg, .sig = *sig};
+    uint64_t hash = hash_key(&key);
+
+    pthread_mutex_lock(&cache->lock);
+    CandidateSet *set = find_slot(cache->slots, cache->mask, hash, &key);
+    if (set->hash == 0) {
+        if (2 * (cache->used + 1) > cache->mask + 1) {
+            if (!grow(cache)) {
+                pthread_mutex_unlock(&cache->lock);
+                return NULL;
+            }
+            set = find_slot(cache->slots, cache->mask, hash, &key);
+        }
+        int num = 0;
+        int *ids = compute_candidates(cache->idx, &key, &num);
+        if (!ids) {
+            pthread_mutex_unlock(&cache->lock);
+            return NULL;
+        }
+        *set = (CandidateSet) {.hash = hash, .key = key, .ids = ids, .count = num};
+        cache->used++;
+    }
+    const int *ids = set->ids;
+    *count = set->count;
+    pthread_mutex_unlock(&cache->lock);
+    return ids;
+}
@@ -0,0 +1,37 @@
+#ifndef AAC_CANDIDATE_CACHE_H
+#define AAC_CANDIDATE_CACHE_H
+
+#include "h_index.h"
+
+/**
+ * H-side candidate sets shared by many patterns matched against one H.
+ *
+ * A G vertex with out-degree o, in-degree i and signature s can only map to H
+ * vertices whose degrees and signature fields are at least as large. Motif
+ * libraries repeat the same few (o, i, s) keys over and over, so each set is
+ * computed once, on first use, and then served to every pattern (from any
+ * thread) until the cache is destroyed.
+ */
+typedef struct CandidateCache CandidateCache;
+
+/**
+ * Cache over the degree and signature tables of idx, which must outlive the cache
+ *
+ * @return New cache, or NULL on allocation failure
+ */
+CandidateCache *candidate_cache_create(const HIndex *idx);
+
+void candidate_cache_destroy(CandidateCache *cache);
+
+/**
+ * H vertices u (ascending) with out_deg[u] >= out_deg, in_deg[u] >= in_deg
+ * and signature_fits(sig, &signature[u]). The array stays valid until the
+ * cache is destroyed. Thread-safe.
+ *
+ * @param count Receives the number of candidates
+ * @return Candidate ids, or NULL on allocation failure
+ */
+const int *candidate_cache_get(CandidateCache *cache, int out_deg, int in_deg, const VertexSignature *sig,
+                               int *count);
+
+#endif //AAC_CANDIDATE_CACHE_H
@@ -0,0 +1,427 @@
+#include "canonical.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Search nodes (refinements) allowed per graph before giving up
+#define CANON_MAX_NODES 4096
+
+// Automorphisms remembered for pruning
+#define CANON_MAX_AUTOMORPHISMS 64
+
+// ============================================================================
+// Types
+// ============================================================================
+
+// One entry of a vertex's refinement signature: an incident edge as seen from the vertex
+typedef struct {
+    int key;  // 2 * colour of the other end, + 1 for an in-edge
+    int mult;
+} SigEntry;
+
+typedef struct {
+    int n;
+    const int *adj;
+    int num_edges;                // Off-diagonal cells with multiplicity > 0
+    int *loop;                    // Loop multiplicity per vertex
+    int *edge_start;              // Per vertex: its out- and in-edges (loops excluded), CSR
+    int *edge_other;
+    int *edge_mult;
+    bool *edge_in;
+
+    // Refinement scratch
+    SigEntry *sig;                // Same layout as the edge lists
+    int *order;
+    int *tmp;
+    int *new_col;
+
+    // Best leaf so far
+    int *best_edges;
+    int *best_label;
+    int *leaf_edges;
+    int total_edges;              // Cells with multiplicity > 0, loops included
+    bool have_best;
+
+    // Automorphisms found as pairs of leaves with equal edge lists (perm[v] = image of v)
+    int *automorphisms;
+    int num_automorphisms;
+    int *fixed;                   // Vertices individualized on the path to the current node
+    int num_fixed;
+    int nodes;
+    bool failed;
+} Canon;
+
+static inline int cell(const int *adj, int n, int i, int j) {
+    return adj[(size_t) i * n + j];
+}
+
+// ============================================================================
+// Colour Refinement
+// ============================================================================
+
+static int compare_entries(const void *a, const void *b) {
+    const SigEntry *x = (const SigEntry *) a;
+    const SigEntry *y = (const SigEntry *) b;
+    if (x->key != y->key) return x->key < y->key ? -1 : 1;
+    return (x->mult > y->mult) - (x->mult < y->mult);
+}
+
+// Order of two vertices by colour, then signature
+static int compare_vertices(const Canon *c, const int *col, int v, int w) {
+    if (col[v] != col[w]) return col[v] < col[w] ? -1 : 1;
+    int len_v = c->edge_start[v + 1] - c->edge_start[v];
+    int len_w = c->edge_start[w + 1] - c->edge_start[w];
+    const SigEntry *sv = c->sig + c->edge_start[v];
+    const SigEntry *sw = c->sig + c->edge_start[w];
+    for (int k = 0; k < len_v && k < len_w; k++) {
+        int r = compare_entries(&sv[k], &sw[k]);
+        if (r != 0) return r;
+    }
+    return (len_v > len_w) - (len_v < len_w);
+}
+
+// Stable merge sort of vertex ids (qsort cannot pass the colouring)
+static void sort_vertices(const Canon *c, const int *col, int *items, int *tmp, int count) {
+    if (count < 2) return;
+    int half = count / 2;
+    sort_vertices(c, col, items, tmp, half);
+    sort_vertices(c, col, items + half, tmp, count - half);
+    int i = 0, j = half, k = 0;
+    while (i < half && j < count) {
+        tmp[k++] = compare_vertices(c, col, items[j], items[i]) < 0 ? items[j++] : items[i++];
+    }
+    while (i < half) tmp[k++] = items[i++];
+    while (j < count) tmp[k++] = items[j++];
+    memcpy(items, tmp, (size_t) count * sizeof(int));
+}
+
+// Split colour classes by the colours and multiplicities around each vertex until
+// nothing changes. Colours are ranks 0..k-1 that depend only on the structure.
+// Returns k.
+static int refine(Canon *c, int *col) {
+    int n = c->n;
+    int colours = -1;
+    for (;;) {
+        for (int v = 0; v < n; v++) {
+            for (int e = c->edge_start[v]; e < c->edge_start[v + 1]; e++) {
+                c->sig[e].key = 2 * col[c->edge_other[e]] + (c->edge_in[e] ? 1 : 0);
+                c->sig[e].mult = c->edge_mult[e];
+            }
+            qsort(c->sig + c->edge_start[v], (size_t) (c->edge_start[v + 1] - c->edge_start[v]),
+                  sizeof(SigEntry), compare_entries);
+            c->order[v] = v;
+        }
+        sort_vertices(c, col, c->order, c->tmp, n);
+
+        int k = 0;
+        for (int i = 0; i < n; i++) {
+            if (i > 0 && compare_vertices(c, col, c->order[i - 1], c->order[i]) != 0) k++;
+            c->new_col[c->order[i]] = k;
+        }
+        k = n > 0 ? k + 1 : 0;
+        memcpy(col, c->new_col, (size_t) n * sizeof(int));
+        if (k == colours) return k;
+        colours = k;
+    }
+}
+
+// ============================================================================
+// Individualization Search
+// ============================================================================
+
+// True if swapping u and v maps the graph onto itself
+static bool interchangeable(const Canon *c, int u, int v) {
+    int n = c->n;
+    if (c->loop[u] != c->loop[v] || cell(c->adj, n, u, v) != cell(c->adj, n, v, u)) return false;
+    for (int w = 0; w < n; w++) {
+        if (w == u || w == v) continue;
+        if (cell(c->adj, n, u, w) != cell(c->adj, n, v, w) || cell(c->adj, n, w, u) != cell(c->adj, n, w, v)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static int compare_triples(const void *a, const void *b) {
+    const int *x = (const int *) a;
+    const int *y = (const int *) b;
+    if (x[0] != y[0]) return x[0] < y[0] ? -1 : 1;
+    return (x[1] > y[1]) - (x[1] < y[1]);
+}
+
+// A discrete colouring numbers the vertices: keep it if its edge list is the smallest
+static void visit_leaf(Canon *c, const int *col) {
+    int n = c->n, m = 0;
+    for (int i = 0; i < n; i++) {
+        for (int j = 0; j < n; j++) {
+            int mult = cell(c->adj, n, i, j);
+            if (mult == 0) continue;
+            c->leaf_edges[3 * m] = col[i];
+            c->leaf_edges[3 * m + 1] = col[j];
+            c->leaf_edges[3 * m + 2] = mult;
+            m++;
+        }
+    }
+    qsort(c->leaf_edges, (size_t) m, 3 * sizeof(int), compare_triples);
+
+    if (c->have_best) {
+        int k = 0;
+        while (k < 3 * m && c->leaf_edges[k] == c->best_edges[k]) k++;
+        if (k == 3 * m && c->num_automorphisms < CANON_MAX_AUTOMORPHISMS) {
+            // Same graph from two numberings: best^-1 after col maps the graph onto itself
+            int *perm = c->automorphisms + (size_t) c->num_automorphisms++ * n;
+            for (int v = 0; v < n; v++) c->tmp[c->best_label[v]] = v;
+            for (int v = 0; v < n; v++) perm[v] = c->tmp[col[v]];
+        }
+        if (k == 3 * m || c->leaf_edges[k] > c->best_edges[k]) return;
+    }
+    memcpy(c->best_edges, c->leaf_edges, (size_t) m * 3 * sizeof(int));
+    memcpy(c->best_label, col, (size_t) n * sizeof(int));
+    c->have_best = true;
+}
+
+static int find_root(int *parent, int v) {
+    while (parent[v] != v) v = parent[v] = parent[parent[v]];
+    return v;
+}
+
+// Orbits of the known automorphisms that fix every individualized vertex
+static void fixed_orbits(const Canon *c, int *parent) {
+    int n = c->n;
+    for (int v = 0; v < n; v++) parent[v] = v;
+    for (int a = 0; a < c->num_automorphisms; a++) {
+        const int *perm = c->automorphisms + (size_t) a * n;
+        bool fixes = true;
+        for (int f = 0; f < c->num_fixed && fixes; f++) fixes = perm[c->fixed[f]] == c->fixed[f];
+        if (!fixes) continue;
+        for (int v = 0; v < n; v++) {
+            int x = find_root(parent, v), y = find_root(parent, perm[v]);
+            if (x != y) parent[x < y ? y : x] = x < y ? x : y;
+        }
+    }
+}
+
+static void search(Canon *c, int *col) {
+    if (c->failed) return;
+    if (++c->nodes > CANON_MAX_NODES) {
+        c->failed = true;
+        return;
+    }
+    int n = c->n;
+    int k = refine(c, col);
+    if (k == n) {
+        visit_leaf(c, col);
+        return;
+    }
+
+    // First colour class with more than one vertex (colours are ranks, so count them)
+    int *size = (int *) calloc((size_t) k, sizeof(int));
+    int *members = (int *) malloc((size_t) n * sizeof(int));
+    int *child = (int *) malloc((size_t) n * sizeof(int));
+    int *tried = (int *) malloc((size_t) n * sizeof(int));
+    int *orbit = (int *) malloc((size_t) n * sizeof(int));
+    if (!size || !members || !child || !tried || !orbit) {
+        c->failed = true;
+        free(size);
+        free(members);
+        free(child);
+        free(tried);
+        free(orbit);
+        return;
+    }
+    for (int v = 0; v < n; v++) size[col[v]]++;
+    int target = 0;
+    while (size[target] < 2) target++;
+    int count = 0;
+    for (int v = 0; v < n; v++) {
+        if (col[v] == target) members[count++] = v;
+    }
+
+    // A class of mutually interchangeable vertices: every numbering of it gives the same edge list
+    bool all_alike = true;
+    for (int i = 1; i < count && all_alike; i++) all_alike = interchangeable(c, members[0], members[i]);
+    if (all_alike) {
+        for (int v = 0; v < n; v++) child[v] = col[v] > target ? col[v] + count - 1 : col[v];
+        for (int i = 0; i < count; i++) {
+            child[members[i]] = target + i;
+            c->fixed[c->num_fixed + i] = members[i];
+        }
+        c->num_fixed += count;
+        search(c, child);
+        c->num_fixed -= count;
+    } else {
+        // Skip vertices that an automorphism fixing this node maps onto one already tried:
+        // their subtrees hold the same edge lists
+        int num_tried = 0, orbits_for = -1;
+        for (int i = 0; i < count && !c->failed; i++) {
+            int v = members[i];
+            if (orbits_for != c->num_automorphisms) {
+                fixed_orbits(c, orbit);
+                orbits_for = c->num_automorphisms;
+            }
+            bool repeat = false;
+            for (int t = 0; t < num_tried && !repeat; t++) {
+                repeat = find_root(orbit, tried[t]) == find_root(orbit, v) || interchangeable(c, tried[t], v);
+            }
+            if (repeat) continue;
+            tried[num_tried++] = v;
+
+            // v first in its class, the rest of the class after it
+            for (int w = 0; w < n; w++) child[w] = col[w] > target || (col[w] == target && w != v) ? col[w] + 1 : col[w];
+            c->fixed[c->num_fixed++] = v;
+            search(c, child);
+            c->num_fixed--;
+        }
+    }
+    free(size);
+    free(members);
+    free(child);
+    free(tried);
+    free(orbit);
+}
+
+// ============================================================================
+// Public API
+// ============================================================================
+
+static void free_canon(Canon *c) {
+    free(c->loop);
+    free(c->edge_start);
+    free(c->edge_other);
+    free(c->edge_mult);
+    free(c->edge_in);
+    free(c->sig);
+    free(c->order);
+    free(c->tmp);
+    free(c->new_col);
+    free(c->best_edges);
+    free(c->best_label);
+    free(c->leaf_edges);
+    free(c->automorphisms);
+    free(c->fixed);
+}
+
+static uint64_t hash_form(const CanonicalForm *form) {
+    uint64_t h = 1469598103934665603ull; // FNV-1a
+    h = (h ^ (uint64_t) form->n) * 1099511628211ull;
+    for (int k = 0; k < 3 * form->num_edges; k++) {
+        h = (h ^ (uint32_t) form->edges[k]) * 1099511628211ull;
+    }
+    return h;
+}
+
+// Edge lists and the starting colouring (by loop multiplicity) of a dense graph.
+// Returns 0, or -1 if out of memory (c then holds nothing).
+static int init_canon(Canon *c, int n, const int *adj, int *col) {
+    memset(c, 0, sizeof(*c));
+    c->n = n;
+    c->adj = adj;
+
+    size_t count = n > 0 ? (size_t) n : 1;
+    c->loop = (int *) malloc(count * sizeof(int));
+    c->edge_start = (int *) calloc(count + 1, sizeof(int));
+    c->order = (int *) malloc(count * sizeof(int));
+    c->tmp = (int *) malloc(count * sizeof(int));
+    c->new_col = (int *) malloc(count * sizeof(int));
+    c->best_label = (int *) malloc(count * sizeof(int));
+    c->automorphisms = (int *) malloc(CANON_MAX_AUTOMORPHISMS * count * sizeof(int));
+    c->fixed = (int *) malloc(count * sizeof(int));
+    if (!c->loop || !c->edge_start || !c->order || !c->tmp || !c->new_col || !c->best_label || !c->automorphisms ||
+        !c->fixed) {
+        free_canon(c);
+        return -1;
+    }
+
+    for (int i = 0; i < n; i++) {
+        c->loop[i] = cell(adj, n, i, i);
+        for (int j = 0; j < n; j++) {
+            if (i == j || cell(adj, n, i, j) == 0) continue;
+            c->num_edges++;
+            c->edge_start[i + 1]++;
+            c->edge_start[j + 1]++;
+        }
+    }
+    for (int v = 0; v < n; v++) c->edge_start[v + 1] += c->edge_start[v];
+    c->total_edges = c->num_edges;
+    for (int v = 0; v < n; v++) c->total_edges += c->loop[v] > 0;
+
+    size_t slots = c->num_edges > 0 ? 2 * (size_t) c->num_edges : 1;
+    size_t triples = c->total_edges > 0 ? 3 * (size_t) c->total_edges : 1;
+    c->edge_other = (int *) malloc(slots * sizeof(int));
+    c->edge_mult = (int *) malloc(slots * sizeof(int));
+    c->edge_in = (bool *) malloc(slots * sizeof(bool));
+    c->sig = (SigEntry *) malloc(slots * sizeof(SigEntry));
+    c->best_edges = (int *) malloc(triples * sizeof(int));
+    c->leaf_edges = (int *) malloc(triples * sizeof(int));
+    if (!c->edge_other || !c->edge_mult || !c->edge_in || !c->sig || !c->best_edges || !c->leaf_edges) {
+        free_canon(c);
+        return -1;
+    }
+    int *fill = c->order; // Borrowed as insertion cursors
+    memcpy(fill, c->edge_start, (size_t) n * sizeof(int));
+    for (int i = 0; i < n; i++) {
+        for (int j = 0; j < n; j++) {
+            int mult = cell(adj, n, i, j);
+            if (i == j || mult == 0) continue;
+            c->edge_other[fill[i]] = j;
+            c->edge_mult[fill[i]] = mult;
+            c->edge_in[fill[i]++] = false;
+            c->edge_other[fill[j]] = i;
+            c->edge_mult[fill[j]] = mult;
+            c->edge_in[fill[j]++] = true;
+        }
+    }
+
+    // Start from loop multiplicities: colour = number of vertices with a smaller loop
+    // (refinement turns these into ranks)
+    for (int v = 0; v < n; v++) {
+        col[v] = 0;
+        for (int w = 0; w < n; w++) col[v] += c->loop[w] < c->loop[v];
+    }
+    return 0;
+}
+
+int canonical_form(int n, const int *adj, CanonicalForm *form) {
+    memset(form, 0, sizeof(*form));
+    Canon c;
+    int *col = (int *) malloc((n > 0 ? (size_t) n : 1) * sizeof(int));
+    if (!col || init_canon(&c, n, adj, col) != 0) {
+        free(col);
+        return -1;
+    }
+
+    search(&c, col);
+    free(col);
+    if (c.failed || (!c.have_best && n > 0)) {
+        free_canon(&c);
+        return -1;
+    }
+
+    form->n = n;
+    form->num_edges = c.total_edges;
+    form->edges = c.best_edges;
+    form->label = c.best_label;
+    c.best_edges = NULL;
+    c.best_label = NULL;
+    form->hash = hash_form(form);
+    free_canon(&c);
+    return 0;
+}
+
+void free_canonical_form(CanonicalForm *form) {
+    free(form->edges);
+    free(form->label);
+    memset(form, 0, sizeof(*form));
+}
+
+int canonical_colour_classes(int n, const int *adj, int *col) {
+    Canon c;
+    if (init_canon(&c, n, adj, col) != 0) return -1;
+    int k = refine(&c, col);
+    free_canon(&c);
+    return k;
+}
+
+bool canonical_forms_equal(const CanonicalForm *a, const CanonicalForm *b) {
+    return a->n == b->n && a->num_edges == b->num_edges && a->hash == b->hash &&
+           memcmp(a->edges, b->edges, (size_t) a->num_edges * 3 * sizeof(int)) == 0;
+}
@@ -0,0 +1,50 @@
+#ifndef AAC_CANONICAL_H
+#define AAC_CANONICAL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * Canonical numbering of a directed multigraph: two graphs get equal forms
+ * exactly when they are isomorphic (same multiplicities, loops included).
+ *
+ * Found by colour refinement on in- and out-multiplicities, then by
+ * individualizing each vertex of the first non-singleton colour class in
+ * turn and keeping the smallest relabelled edge list. Vertices that are
+ * interchangeable (same row and column) are branched on once, so isolated
+ * vertices and cliques stay cheap; graphs with other large symmetries can run
+ * out of search budget and get no form.
+ */
+typedef struct {
+    int n;
+    int num_edges;
+    int *edges;    // num_edges (src, dst, mult) triples in canonical numbers, sorted by (src, dst); loops included
+    int *label;    // label[v] = canonical number of vertex v
+    uint64_t hash; // Of n and edges
+} CanonicalForm;
+
+/**
+ * Canonical form of a dense graph
+ *
+ * @return 0 on success; -1 if the search budget ran out or memory did (form left empty)
+ */
+int canonical_form(int n, const int *adj, CanonicalForm *form);
+
+void free_canonical_form(CanonicalForm *form);
+
+/**
+ * Colour refinement alone: col[v] receives the class of v (0..k-1), where
+ * vertices of one class have the same multiplicities to every class. Every
+ * automorphism maps each class onto itself, so the classes bound the symmetry
+ * of the graph from above.
+ *
+ * @return k, or -1 if out of memory
+ */
+int canonical_colour_classes(int n, const int *adj, int *col);
+
+/**
+ * True if both forms describe the same graph (hence the graphs are isomorphic)
+ */
+bool canonical_forms_equal(const CanonicalForm *a, const CanonicalForm *b);
+
+#endif //AAC_CANONICAL_H
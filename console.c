@@ -26,6 +26,25 @@ void set_color_bold(void) { printf("\033[1m"); }
 void set_color_reset(void) { printf("\033[0m"); }
 void set_color_red(void) { printf("\033[31m"); }
 
+void print_adj_matrix(const char *name, int n, const int *adj) {
+    printf("Graph name='%s' n=%d\n", name, n);
+    printf("    ");
+    for (int c = 0; c < n; ++c) printf("%4d", c + 1);
+    printf("\n");
+    for (int r = 0; r < n; ++r) {
+        printf("%4d", r + 1);
+        for (int c = 0; c < n; ++c) {
+            printf("%4d", adj[r * n + c]);
+        }
+        printf("\n");
+    }
+    printf("\n");
+}
+
+void print_sparse_summary(const char *name, const SparseGraph *g) {
+    printf("Graph name='%s' n=%d edges=%d (sparse, matrix not shown)\n\n", name, g->n, g->num_edges);
+}
+
 bool prompt_continue(const char *msg) {
     printf("\n%s [Y/n]: ", msg);
     fflush(stdout);
@@ -34,6 +53,30 @@ bool prompt_continue(const char *msg) {
     return (buf[0] != 'N' && buf[0] != 'n');
 }
 
+void print_product_graph(const ProductGraph *pg) {
+    printf("Product Graph: %d vertices\n", pg->num_vertices);
+    printf("Vertices (v_G, u_H):\n");
+    for (int i = 0; i < pg->num_vertices; i++) {
+        printf("  [%d]: (G_%d, H_%d) degree=%d\n",
+               i, pg->vertices[i].v + 1, pg->vertices[i].u + 1, pg->degree[i]);
+    }
+
+    printf("Edges:\n");
+    int edge_count = 0;
+    for (int i = 0; i < pg->num_vertices; i++) {
+        for (int j = i + 1; j < pg->num_vertices; j++) {
+            if (product_graph_adjacent(pg, i, j)) {
+                printf("  [%d]-[%d]: (G_%d,H_%d)-(G_%d,H_%d)\n",
+                       i, j,
+                       pg->vertices[i].v + 1, pg->vertices[i].u + 1,
+                       pg->vertices[j].v + 1, pg->vertices[j].u + 1);
+                edge_count++;
+            }
+        }
+    }
+    printf("Total edges: %d\n", edge_count);
+}
+
 void print_matrix_highlighted(int n, const int *current, const int *previous) {
     printf("    ");
     for (int c = 0; c < n; c++) printf("%4d", c + 1);
@@ -97,3 +140,155 @@ void print_matrix_with_mapping(int n_h, const int *adj_h, const int *previous,
     }
     free(is_mapped);
 }
+
+void print_sparse_changes(const SparseGraph *current, const SparseGraph *previous) {
+    int changed = 0;
+    for (int u = 0; u < current->n; u++) {
+        for (int k = current->out_start[u]; k < current->out_start[u + 1]; k++) {
+            int v = current->out_dst[k];
+            int prev = sparse_graph_mult(previous, u, v);
+            if (current->out_mult[k] == prev) continue;
+            printf("    H_%d -> H_%d: ", u + 1, v + 1);
+            set_color_bold();
+            set_color_green();
+            printf("%d -> %d", prev, current->out_mult[k]);
+            set_color_reset();
+            printf("\n");
+            changed++;
+        }
+    }
+    if (changed == 0) printf("    None.\n");
+}
+
+// ============================================================================
+// Text Reporter
+// ============================================================================
+
+static void print_mapping_inline(const int *mapping, int n_g) {
+    printf("  Mapping: ");
+    for (int v = 0; v < n_g; v++)
+        printf("G_%d->H_%d ", v + 1, mapping[v] + 1);
+    printf("\n");
+}
+
+static void print_extension_round(const MappingReport *m) {
+    if (!m->adj_h) {
+        // Sparse H': list the raised cells instead of the matrix
+        printf("\nMapping %d: deficit = %d\n", m->index, m->deficit);
+        print_mapping_inline(m->mapping, m->n_g);
+        if (m->num_raised > 0) printf("\nEdges added to H':\n");
+        for (int k = 0; k < m->num_raised; k++) {
+            printf("    H_%d -> H_%d: %d -> %d\n", m->raised[k].src + 1, m->raised[k].dst + 1,
+                   m->raised_old[k], m->raised[k].mult);
+        }
+        printf("Edges added this round: %d\n", m->edges_added);
+        return;
+    }
+
+    printf("\nMapping %d: deficit = %d, edges added = %d\n", m->index, m->deficit, m->edges_added);
+    print_mapping_inline(m->mapping, m->n_g);
+    if (m->strategy) printf("  Strategy: %s\n", m->strategy);
+
+    if (m->edges_added > 0) {
+        printf("\nUpdated H' (new edges highlighted in green):\n");
+        print_matrix_highlighted(m->n_h, m->adj_h, m->prev_adj_h);
+    }
+
+    printf("\nUpdated H' (mapping edges highlighted in red):\n");
+    print_matrix_with_mapping(m->n_h, m->adj_h, m->prev_adj_h, m->n_g, m->adj_g, m->mapping);
+}
+
+static void console_mapping(void *ctx, const MappingReport *m) {
+    (void) ctx;
+    switch (m->kind) {
+        case REPORT_ISOMORPHISM:
+            printf("\nMapping %d:\n", m->index);
+            for (int v = 0; v < m->n_g; v++) {
+                printf("    G_%d -> H_%d\n", v + 1, m->mapping[v] + 1);
+            }
+            if (m->adj_h) {
+                printf("\nH with mapped edges highlighted:\n");
+                print_matrix_with_mapping(m->n_h, m->adj_h, NULL, m->n_g, m->adj_g, m->mapping);
+            }
+            break;
+        case REPORT_EXTENSION:
+            print_extension_round(m);
+            break;
+        case REPORT_JOINT:
+            printf("\nMapping %d:\n", m->index);
+            print_mapping_inline(m->mapping, m->n_g);
+            printf("\nH' (mapping %d edges highlighted in red, new edges in green):\n", m->index);
+            print_matrix_with_mapping(m->n_h, m->adj_h, m->prev_adj_h, m->n_g, m->adj_g, m->mapping);
+            break;
+    }
+}
+
+static void console_note(void *ctx, const char *fmt, va_list ap) {
+    (void) ctx;
+    vprintf(fmt, ap);
+}
+
+static bool console_confirm(void *ctx, const char *question) {
+    (void) ctx;
+    return prompt_continue(question);
+}
+
+const Reporter *console_reporter(void) {
+    static const Reporter reporter = {
+        .ctx = NULL,
+        .mapping = console_mapping,
+        .note = console_note,
+        .confirm = console_confirm
+    };
+    return &reporter;
+}
+
+// ============================================================================
+// Result Summaries
+// ============================================================================
+
+void print_isomorphism_result(const IsomorphismResult *result) {
+    printf("\n--- Isomorphism Result ---\n");
+    printf("Subgraph isomorphism exists: %s\n", result->is_subgraph ? "YES" : "NO");
+    printf("Number of isomorphisms found: %d\n", result->num_found);
+
+
+    for (int i = 0; i < result->num_found; i++) {
+        printf("\nMapping %d:\n", i + 1);
+        for (int v = 0; v < result->n_g; v++) {
+            printf("    G_%d -> H_%d\n", v + 1, result->mappings[i][v] + 1);
+        }
+    }
+}
+
+void print_extension_result(const ExtensionResult *result, const int *adj_g) {
+    printf("\n--- Minimal Extension Result ---\n");
+    printf("Total edges added: %d\n", result->total_edges_added);
+    printf("Mappings found: %d\n", result->num_mappings);
+
+    for (int k = 0; k < result->num_mappings; k++) {
+        printf("\nMapping %d (G -> H):\n", k + 1);
+        for (int v = 0; v < result->n_g; v++) {
+            printf("    G_%d -> H_%d\n", v + 1, result->mappings[k][v] + 1);
+        }
+    }
+
+    printf("\nEdges added to H:\n");
+    if (result->total_edges_added == 0) {
+        printf("    None. G is already embeddable in H.\n");
+    } else {
+        printf("    (See extended adjacency matrix)\n");
+    }
+
+    printf("\nExtended H' adjacency matrix:\n");
+    printf("    ");
+    for (int c = 0; c < result->n_h; c++) printf("%4d", c + 1);
+    printf("\n");
+    for (int r = 0; r < result->n_h; r++) {
+        printf("%4d", r + 1);
+        for (int c = 0; c < result->n_h; c++) {
+            printf("%4d", result->extended_adj_h[r * result->n_h + c]);
+        }
+        printf("\n");
+    }
+}
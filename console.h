@@ -2,6 +2,9 @@
 #define AAC_CONSOLE_H
 
 #include <stdbool.h>
+#include "sparse_graph.h"
+#include "report.h"
+#include "algorithms.h"
 
 void console_init(void);
 
@@ -15,9 +18,42 @@ void set_color_reset(void);
 
 bool prompt_continue(const char *msg);
 
+void print_adj_matrix(const char *name, int n, const int *adj);
+
+/**
+ * One-line description of a sparse graph (its matrix is too large to print)
+ */
+void print_sparse_summary(const char *name, const SparseGraph *g);
+
+/**
+ * Print product graph info (for debugging)
+ */
+void print_product_graph(const ProductGraph *pg);
+
 void print_matrix_highlighted(int n, const int *current, const int *previous);
 
 void print_matrix_with_mapping(int n_h, const int *adj_h, const int *previous,
                                int n_g, const int *adj_g, const int *mapping);
 
+/**
+ * List the edges whose multiplicity differs between two sparse graphs on the same vertices
+ */
+void print_sparse_changes(const SparseGraph *current, const SparseGraph *previous);
+
+/**
+ * Reporter that prints engine progress as colored text on stdout and asks on
+ * stdin whether to continue
+ */
+const Reporter *console_reporter(void);
+
+/**
+ * Print isomorphism results
+ */
+void print_isomorphism_result(const IsomorphismResult *result);
+
+/**
+ * Print extension results
+ */
+void print_extension_result(const ExtensionResult *result, const int *adj_g);
+
 #endif //AAC_CONSOLE_H
@@ -0,0 +1,96 @@
+#include "fingerprint.h"
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+static int compare_desc(const void *a, const void *b) {
+    int x = *(const int *) a;
+    int y = *(const int *) b;
+    return (y > x) - (y < x);
+}
+
+// True if each of the first count entries of h is at least the same entry of g
+static bool dominates(const int *h, const int *g, int count) {
+    for (int k = 0; k < count; k++) {
+        if (g[k] > h[k]) return false;
+    }
+    return true;
+}
+
+int graph_fingerprint(int n, const int *adj, GraphFingerprint *fp) {
+    memset(fp, 0, sizeof(*fp));
+    fp->n = n;
+    size_t count = n > 0 ? (size_t) n : 1;
+    fp->out_deg = (int *) calloc(count, sizeof(int));
+    fp->in_deg = (int *) calloc(count, sizeof(int));
+    fp->loop_mult = (int *) malloc(count * sizeof(int));
+    if (!fp->out_deg || !fp->in_deg || !fp->loop_mult) {
+        free_graph_fingerprint(fp);
+        return -1;
+    }
+
+    for (int i = 0; i < n; i++) {
+        for (int j = 0; j < n; j++) {
+            int m = adj[(size_t) i * n + j];
+            if (m == 0) continue;
+            fp->out_deg[i] += m;
+            fp->in_deg[j] += m;
+            if (i == j) {
+                fp->loop_mult[fp->num_loops++] = m;
+            } else {
+                fp->num_edges++;
+            }
+        }
+    }
+
+    fp->edge_mult = (int *) malloc((fp->num_edges > 0 ? (size_t) fp->num_edges : 1) * sizeof(int));
+    if (!fp->edge_mult) {
+        free_graph_fingerprint(fp);
+        return -1;
+    }
+    int e = 0;
+    for (int i = 0; i < n; i++) {
+        for (int j = 0; j < n; j++) {
+            int m = adj[(size_t) i * n + j];
+            if (m != 0 && i != j) fp->edge_mult[e++] = m;
+        }
+    }
+
+    qsort(fp->out_deg, (size_t) n, sizeof(int), compare_desc);
+    qsort(fp->in_deg, (size_t) n, sizeof(int), compare_desc);
+    qsort(fp->edge_mult, (size_t) fp->num_edges, sizeof(int), compare_desc);
+    qsort(fp->loop_mult, (size_t) fp->num_loops, sizeof(int), compare_desc);
+    return 0;
+}
+
+void free_graph_fingerprint(GraphFingerprint *fp) {
+    free(fp->out_deg);
+    free(fp->in_deg);
+    free(fp->edge_mult);
+    free(fp->loop_mult);
+    memset(fp, 0, sizeof(*fp));
+}
+
+FingerprintCheck fingerprint_check(const GraphFingerprint *g, const GraphFingerprint *h, bool loops) {
+    if (g->n > h->n) return FINGERPRINT_VERTICES;
+    if (g->num_edges > h->num_edges || (loops && g->num_loops > h->num_loops)) return FINGERPRINT_EDGES;
+    if (!dominates(h->out_deg, g->out_deg, g->n) || !dominates(h->in_deg, g->in_deg, g->n)) {
+        return FINGERPRINT_DEGREES;
+    }
+    if (!dominates(h->edge_mult, g->edge_mult, g->num_edges) ||
+        (loops && !dominates(h->loop_mult, g->loop_mult, g->num_loops))) {
+        return FINGERPRINT_MULTIPLICITIES;
+    }
+    return FINGERPRINT_FITS;
+}
+
+const char *fingerprint_check_name(FingerprintCheck check) {
+    static const char *names[FINGERPRINT_CHECKS] = {
+        [FINGERPRINT_FITS] = "fits",
+        [FINGERPRINT_VERTICES] = "vertices",
+        [FINGERPRINT_EDGES] = "edges",
+        [FINGERPRINT_DEGREES] = "degrees",
+        [FINGERPRINT_MULTIPLICITIES] = "multiplicities",
+    };
+    return (int) check >= 0 && check < FINGERPRINT_CHECKS ? names[check] : "unknown";
+}
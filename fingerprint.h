@@ -0,0 +1,62 @@
+#ifndef AAC_FINGERPRINT_H
+#define AAC_FINGERPRINT_H
+
+#include <stdbool.h>
+
+/**
+ * Invariants that a subgraph isomorphism G -> H must respect, cheap enough to
+ * reject most impossible targets before any search.
+ *
+ * A mapping is injective and every G edge lands on an H cell with at least its
+ * multiplicity, so H needs at least as many edges as G, its sorted degree
+ * sequences must dominate G's entry by entry, and so must its sorted edge
+ * multiplicities. Loops are compared the same way only for engines that map
+ * them: iso_exact's product graph ignores loops beyond their share of the
+ * degrees.
+ */
+typedef struct {
+    int n;
+    int num_edges;  // Cells u -> v (u != v) with multiplicity > 0
+    int num_loops;  // Vertices with a self-loop
+    int *out_deg;   // Out-degrees (multiplicity sums), descending
+    int *in_deg;    // In-degrees (multiplicity sums), descending
+    int *edge_mult; // Multiplicities of the num_edges edges, descending
+    int *loop_mult; // Multiplicities of the num_loops loops, descending
+} GraphFingerprint;
+
+/**
+ * Outcome of fingerprint_check: the first invariant that rules H out
+ */
+typedef enum {
+    FINGERPRINT_FITS,          // No invariant rules H out; a search is needed
+    FINGERPRINT_VERTICES,      // H has fewer vertices than G
+    FINGERPRINT_EDGES,         // H has fewer edges (or loops) than G
+    FINGERPRINT_DEGREES,       // H's degree sequence does not dominate G's
+    FINGERPRINT_MULTIPLICITIES // H's multiplicities do not cover G's
+} FingerprintCheck;
+
+#define FINGERPRINT_CHECKS (FINGERPRINT_MULTIPLICITIES + 1)
+
+/**
+ * Fingerprint of a dense graph, in O(n^2 + m log m)
+ *
+ * @return 0 on success, -1 on allocation failure
+ */
+int graph_fingerprint(int n, const int *adj, GraphFingerprint *fp);
+
+void free_graph_fingerprint(GraphFingerprint *fp);
+
+/**
+ * Test whether G may be a subgraph of H, in O(n_g + m_g)
+ *
+ * @param loops Also require H's loop count and multiplicities to cover G's
+ *              (iso_approx, which maps loops onto loops)
+ */
+FingerprintCheck fingerprint_check(const GraphFingerprint *g, const GraphFingerprint *h, bool loops);
+
+/**
+ * Short name of a check ("fits", "vertices", "edges", "degrees", "multiplicities")
+ */
+const char *fingerprint_check_name(FingerprintCheck check);
+
+#endif //AAC_FINGERPRINT_H
@@ -1,132 +1,744 @@
 #include "graph.h"
 #include "utils.h"
+#include "graph_binary.h"
+#include "sparse_graph.h"
+#include "mem_track.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <ctype.h>
+#include <stdbool.h>
+#include <limits.h>
+#include <stdint.h>
 
 // --- Private Helper Functions ---
 
-static int read_adjacency_matrix(FILE *f, int n, int *adj) {
-    char buffer[4096];
+// Cursor over a memory-mapped text file; rows are lines, values are separated by spaces/tabs
+typedef struct {
+    const char *p;
+    const char *end;
+    int line; // 1-based, for error messages
+} Scanner;
+
+static inline bool is_blank(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\f' || c == '\v';
+}
+
+static void skip_blanks(Scanner *sc) {
+    while (sc->p < sc->end && is_blank(*sc->p)) sc->p++;
+}
+
+// Move to the first non-empty line; returns false at end of file
+static bool skip_empty_lines(Scanner *sc) {
+    while (sc->p < sc->end) {
+        skip_blanks(sc);
+        if (sc->p < sc->end && *sc->p == '\n') {
+            sc->p++;
+            sc->line++;
+            continue;
+        }
+        return sc->p < sc->end;
+    }
+    return false;
+}
+
+// Parse one non-negative integer on the current line. Returns 0, or -1 if the
+// line ends first, or -2 on a malformed/out-of-range value.
+static int scan_int(Scanner *sc, int *out) {
+    skip_blanks(sc);
+    if (sc->p >= sc->end || *sc->p == '\n') return -1;
+
+    const char *p = sc->p;
+    if (*p == '+') p++;
+    if (p >= sc->end || *p < '0' || *p > '9') return -2;
+
+    long long value = 0;
+    while (p < sc->end && *p >= '0' && *p <= '9') {
+        value = value * 10 + (*p - '0');
+        if (value > INT_MAX) return -2;
+        p++;
+    }
+    if (p < sc->end && !is_blank(*p) && *p != '\n') return -2;
+
+    sc->p = p;
+    *out = (int) value;
+    return 0;
+}
+
+// Require the rest of the current line to be blank and step past it
+static bool end_line(Scanner *sc) {
+    skip_blanks(sc);
+    if (sc->p >= sc->end) return true;
+    if (*sc->p != '\n') return false;
+    sc->p++;
+    sc->line++;
+    return true;
+}
+
+static int read_adjacency_matrix(Scanner *sc, const char *name, int n, int *adj) {
     for (int i = 0; i < n; ++i) {
-        if (!fgets(buffer, sizeof(buffer), f)) {
+        if (!skip_empty_lines(sc)) {
+            fprintf(stderr, "Graph %s: expected %d rows, file ends after %d\n", name, n, i);
             return -1;
         }
-        
-        trim_inplace(buffer);
-        if (buffer[0] == '\0') {
-            // Skip empty lines
-            i--;
-            continue;
+
+        int *row = adj + (size_t) i * n;
+        for (int j = 0; j < n; ++j) {
+            int rc = scan_int(sc, &row[j]);
+            if (rc == -1) {
+                fprintf(stderr, "Graph %s, line %d: row %d has only %d elements, expected %d\n",
+                        name, sc->line, i + 1, j, n);
+                return -1;
+            }
+            if (rc == -2) {
+                fprintf(stderr, "Graph %s, line %d: invalid multiplicity in row %d, column %d\n",
+                        name, sc->line, i + 1, j + 1);
+                return -1;
+            }
+        }
+        if (!end_line(sc)) {
+            fprintf(stderr, "Graph %s, line %d: row %d has more than %d elements\n",
+                    name, sc->line, i + 1, n);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static int read_vertex_count(Scanner *sc, const char *name, int *n) {
+    if (!skip_empty_lines(sc)) {
+        fprintf(stderr, "Failed to read number of vertices for graph %s\n", name);
+        return -1;
+    }
+    if (scan_int(sc, n) != 0 || !end_line(sc) || *n <= 0) {
+        fprintf(stderr, "Invalid number of vertices for graph %s (line %d)\n", name, sc->line);
+        return -1;
+    }
+    return 0;
+}
+
+// Read "<n>" followed by an n x n matrix into a freshly allocated *adj
+static int read_graph(Scanner *sc, const char *name, int *n, int **adj) {
+    if (read_vertex_count(sc, name, n) != 0) return -1;
+
+    *adj = mem_calloc(MEM_GRAPH, (size_t) (*n) * (size_t) (*n), sizeof(int));
+    if (!*adj) {
+        fprintf(stderr, "Memory allocation failed for graph %s\n", name);
+        return -1;
+    }
+
+    if (read_adjacency_matrix(sc, name, *n, *adj) != 0) {
+        fprintf(stderr, "Failed to read adjacency matrix for graph %s\n", name);
+        mem_free(*adj);
+        *adj = NULL;
+        return -1;
+    }
+    return 0;
+}
+
+// Read "edges <n>" followed by "src dst [multiplicity]" lines (0-based ids).
+// The list ends at end of file, at the next "edges" header, or at a line holding
+// a single number (the vertex count of a following dense graph).
+static int read_edge_list(Scanner *sc, const char *name, int *n, SparseGraph **out) {
+    sc->p += 5; // "edges"
+    if (scan_int(sc, n) != 0 || !end_line(sc) || *n <= 0) {
+        fprintf(stderr, "Invalid number of vertices for graph %s (line %d)\n", name, sc->line);
+        return -1;
+    }
+
+    size_t count = 0, capacity = 1024;
+    SparseEdge *edges = (SparseEdge *) mem_alloc(MEM_GRAPH, capacity * sizeof(SparseEdge));
+    if (!edges) {
+        fprintf(stderr, "Memory allocation failed for graph %s\n", name);
+        return -1;
+    }
+
+    while (true) {
+        Scanner saved = *sc;
+        if (!skip_empty_lines(sc) || *sc->p == 'e') {
+            *sc = saved;
+            break;
         }
-        
-        // Parse space-separated values
-        char *token = strtok(buffer, " \t");
-        int j = 0;
-        while (token != NULL && j < n) {
-            adj[i * n + j] = (int) strtol(token, NULL, 10);
-            token = strtok(NULL, " \t");
-            j++;
+
+        int src, dst, mult = 1;
+        Scanner line_start = *sc;
+        int rc = scan_int(sc, &src);
+        if (rc == 0) rc = scan_int(sc, &dst);
+        if (rc == -1) {
+            *sc = line_start; // Single number: next graph starts here
+            break;
         }
-        
-        if (j < n) {
-            fprintf(stderr, "Warning: Row %d has only %d elements, expected %d\n", i + 1, j, n);
+        if (rc == 0 && scan_int(sc, &mult) == -2) rc = -2;
+        if (rc != 0 || !end_line(sc)) {
+            fprintf(stderr, "Graph %s, line %d: expected \"src dst [multiplicity]\"\n", name, line_start.line);
+            mem_free(edges);
+            return -1;
         }
+        if (src >= *n || dst >= *n) {
+            fprintf(stderr, "Graph %s, line %d: vertex out of range (n = %d)\n", name, line_start.line, *n);
+            mem_free(edges);
+            return -1;
+        }
+
+        if (count == capacity) {
+            capacity *= 2;
+            SparseEdge *grown = (SparseEdge *) mem_realloc(MEM_GRAPH, edges, capacity * sizeof(SparseEdge));
+            if (!grown) {
+                fprintf(stderr, "Memory allocation failed for graph %s\n", name);
+                mem_free(edges);
+                return -1;
+            }
+            edges = grown;
+        }
+        edges[count++] = (SparseEdge) {src, dst, mult};
+    }
+
+    *out = sparse_graph_from_edges(*n, edges, count);
+    mem_free(edges);
+    if (!*out) {
+        // Vertices and multiplicities were checked above
+        fprintf(stderr, "Graph %s: repeated edges add up past %d, or out of memory\n", name, INT_MAX);
+        return -1;
     }
     return 0;
 }
 
-// --- Public Functions ---
+// One graph as read from a file: a dense matrix (owned, or inside a mapping) or a CSR graph
+typedef struct {
+    int n;
+    const int *adj;
+    int *owned;
+    SparseGraph *sparse;
+} LoadedGraph;
+
+static void release_loaded(LoadedGraph *lg) {
+    mem_free(lg->owned);
+    free_sparse_graph(lg->sparse);
+    memset(lg, 0, sizeof(*lg));
+}
+
+// Read the next graph in either text form
+static int read_text_graph(Scanner *sc, const char *name, LoadedGraph *lg) {
+    memset(lg, 0, sizeof(*lg));
+    if (skip_empty_lines(sc) && sc->end - sc->p >= 5 && memcmp(sc->p, "edges", 5) == 0) {
+        return read_edge_list(sc, name, &lg->n, &lg->sparse);
+    }
+    if (read_graph(sc, name, &lg->n, &lg->owned) != 0) return -1;
+    lg->adj = lg->owned;
+    return 0;
+}
+
+// --- Binary Container ---
+
+static bool is_binary(const MappedFile *mf) {
+    return mf->size >= sizeof(AacgHeader) && memcmp(mf->data, AACG_MAGIC, 8) == 0;
+}
+
+// Payload size of graph k, or 0 if it cannot be determined within the file
+static uint64_t payload_size(const MappedFile *mf, const AacgHeader *hdr, uint32_t k) {
+    if (!(hdr->flags & AACG_FLAG_SPARSE)) return aacg_dense_size(hdr->n[k], hdr->elem_width);
+    if (mf->size - hdr->offset[k] < sizeof(uint64_t)) return 0;
+
+    uint64_t m;
+    memcpy(&m, mf->data + hdr->offset[k], sizeof(m));
+    if (m > INT_MAX) return 0;
+    return aacg_sparse_size(m, hdr->elem_width);
+}
 
-void print_adj_matrix(const char *name, int n, const int *adj) {
-    printf("Graph name='%s' n=%d\n", name, n);
-    printf("    ");
-    for (int c = 0; c < n; ++c) printf("%4d", c + 1);
-    printf("\n");
-    for (int r = 0; r < n; ++r) {
-        printf("%4d", r + 1);
-        for (int c = 0; c < n; ++c) {
-            printf("%4d", adj[r * n + c]);
+// Validate the header and payload bounds; returns the header or NULL
+static const AacgHeader *check_binary_header(const MappedFile *mf, const char *path) {
+    const AacgHeader *hdr = (const AacgHeader *) mf->data;
+
+    if (hdr->endian_tag != AACG_ENDIAN_TAG) {
+        fprintf(stderr, "%s: binary graph written with a different byte order\n", path);
+        return NULL;
+    }
+    if (hdr->version != AACG_VERSION) {
+        fprintf(stderr, "%s: unsupported binary graph version %u\n", path, hdr->version);
+        return NULL;
+    }
+    if (hdr->num_graphs < 1 || hdr->num_graphs > AACG_MAX_GRAPHS) {
+        fprintf(stderr, "%s: invalid graph count %u\n", path, hdr->num_graphs);
+        return NULL;
+    }
+    if (hdr->elem_width != 1 && hdr->elem_width != 2 && hdr->elem_width != 4) {
+        fprintf(stderr, "%s: invalid element width %u\n", path, hdr->elem_width);
+        return NULL;
+    }
+    if (hdr->flags & ~(AACG_FLAG_SPARSE | AACG_FLAG_INDEX)) {
+        fprintf(stderr, "%s: unknown flags 0x%x\n", path, hdr->flags);
+        return NULL;
+    }
+
+    bool sparse = hdr->flags & AACG_FLAG_SPARSE;
+    for (uint32_t k = 0; k < hdr->num_graphs; ++k) {
+        uint64_t size;
+        if (hdr->n[k] == 0 || (!sparse && hdr->n[k] > INT_MAX / hdr->n[k]) || hdr->n[k] > INT_MAX ||
+            hdr->offset[k] % AACG_ALIGN != 0 || hdr->offset[k] < AACG_DATA_START ||
+            hdr->offset[k] > mf->size || (size = payload_size(mf, hdr, k)) == 0 ||
+            size > mf->size - hdr->offset[k]) {
+            fprintf(stderr, "%s: graph %u has an invalid size or offset\n", path, k + 1);
+            return NULL;
         }
-        printf("\n");
     }
-    printf("\n");
+    return hdr;
 }
 
-int load_graphs(const char *path, int *n_g, int **adj_g, int *n_h, int **adj_h) {
-    FILE *f = fopen(path, "r");
-    if (!f) {
-        fprintf(stderr, "Failed to open file: %s\n", path);
-        return 1;
+static inline int read_value(const unsigned char *p, size_t idx, uint32_t width) {
+    if (width == 1) return p[idx];
+    if (width == 2) return ((const uint16_t *) p)[idx];
+    return ((const int *) p)[idx];
+}
+
+// Resolve graph `index` of a validated container. Width-4 dense payloads are
+// used in place; narrower ones are widened into a heap matrix, and sparse
+// payloads become a CSR graph.
+static int binary_graph(const MappedFile *mf, const AacgHeader *hdr, uint32_t index,
+                        const char *name, LoadedGraph *lg) {
+    const unsigned char *payload = (const unsigned char *) mf->data + hdr->offset[index];
+    memset(lg, 0, sizeof(*lg));
+    lg->n = (int) hdr->n[index];
+
+    if (hdr->flags & AACG_FLAG_SPARSE) {
+        uint64_t m;
+        memcpy(&m, payload, sizeof(m));
+        const uint32_t *src = (const uint32_t *) (payload + sizeof(uint64_t));
+        const uint32_t *dst = src + m;
+        const unsigned char *mult = (const unsigned char *) (dst + m);
+
+        SparseEdge *edges = (SparseEdge *) mem_alloc(MEM_GRAPH, (m > 0 ? m : 1) * sizeof(SparseEdge));
+        if (!edges) {
+            fprintf(stderr, "Memory allocation failed for graph %s\n", name);
+            return -1;
+        }
+        for (uint64_t e = 0; e < m; ++e) {
+            if (src[e] >= hdr->n[index] || dst[e] >= hdr->n[index]) {
+                fprintf(stderr, "Graph %s: vertex out of range in binary payload\n", name);
+                mem_free(edges);
+                return -1;
+            }
+            edges[e] = (SparseEdge) {(int) src[e], (int) dst[e], read_value(mult, e, hdr->elem_width)};
+        }
+        lg->sparse = sparse_graph_from_edges(lg->n, edges, (size_t) m);
+        mem_free(edges);
+        if (!lg->sparse) {
+            fprintf(stderr, "Graph %s: invalid edge list in binary payload\n", name);
+            return -1;
+        }
+        return 0;
     }
 
-    char buffer[4096];
-    
-    // Read first graph (G)
-    // Read number of vertices
-    if (!fgets(buffer, sizeof(buffer), f)) {
-        fprintf(stderr, "Failed to read number of vertices for graph G\n");
-        fclose(f);
-        return 2;
+    size_t cells = (size_t) hdr->n[index] * hdr->n[index];
+    if (hdr->elem_width == 4) {
+        const int *m = (const int *) payload;
+        for (size_t c = 0; c < cells; ++c) {
+            if (m[c] < 0) {
+                fprintf(stderr, "Graph %s: negative multiplicity in binary payload\n", name);
+                return -1;
+            }
+        }
+        lg->adj = m;
+        return 0;
     }
-    trim_inplace(buffer);
-    *n_g = (int) strtol(buffer, NULL, 10);
-    if (*n_g <= 0) {
-        fprintf(stderr, "Invalid number of vertices for graph G: %d\n", *n_g);
-        fclose(f);
-        return 2;
+
+    int *m = mem_alloc(MEM_GRAPH, cells * sizeof(int));
+    if (!m) {
+        fprintf(stderr, "Memory allocation failed for graph %s\n", name);
+        return -1;
     }
-    
-    // Allocate and read adjacency matrix for G
-    *adj_g = calloc((size_t) (*n_g) * (size_t) (*n_g), sizeof(int));
-    if (!*adj_g) {
-        fprintf(stderr, "Memory allocation failed for graph G\n");
-        fclose(f);
-        return 3;
+    for (size_t c = 0; c < cells; ++c) m[c] = read_value(payload, c, hdr->elem_width);
+    lg->adj = m;
+    lg->owned = m;
+    return 0;
+}
+
+// Index section of a validated container that has one, or NULL. It describes
+// the last graph and starts at the first aligned offset after its payload.
+static HIndex *binary_index(const MappedFile *mf, const AacgHeader *hdr, const char *path) {
+    if (!(hdr->flags & AACG_FLAG_INDEX)) return NULL;
+
+    uint32_t last = hdr->num_graphs - 1;
+    uint64_t offset = aacg_align(hdr->offset[last] + payload_size(mf, hdr, last));
+    HIndex *idx = (HIndex *) malloc(sizeof(HIndex));
+    if (!idx || h_index_view(mf->data, mf->size, offset, (int) hdr->n[last], idx) != 0) {
+        fprintf(stderr, "%s: ignoring a malformed H index\n", path);
+        free(idx);
+        return NULL;
     }
-    
-    if (read_adjacency_matrix(f, *n_g, *adj_g) != 0) {
-        fprintf(stderr, "Failed to read adjacency matrix for graph G\n");
-        free(*adj_g);
-        fclose(f);
-        return 3;
-    }
-    
-    // Read second graph (H)
-    // Read number of vertices
-    if (!fgets(buffer, sizeof(buffer), f)) {
-        fprintf(stderr, "Failed to read number of vertices for graph H\n");
-        free(*adj_g);
-        fclose(f);
-        return 4;
+    return idx;
+}
+
+// Load G (the first graph) and/or H from an open file. H is the second graph
+// when both are wanted, otherwise the last graph in the file. An index for H
+// is returned through h_index (which needs the file to stay mapped).
+static int read_graphs_from(const MappedFile *mf, const char *path, LoadedGraph *g, LoadedGraph *h,
+                            HIndex **h_index, bool *zero_copy) {
+    *zero_copy = false;
+    if (h_index) *h_index = NULL;
+
+    if (is_binary(mf)) {
+        const AacgHeader *hdr = check_binary_header(mf, path);
+        if (!hdr) return g ? 2 : 4;
+
+        if (g && binary_graph(mf, hdr, 0, "G", g) != 0) return 2;
+        if (h) {
+            uint32_t index = g ? 1 : hdr->num_graphs - 1;
+            if (index >= hdr->num_graphs) {
+                fprintf(stderr, "%s: file holds only one graph, H is missing\n", path);
+                return 4;
+            }
+            if (binary_graph(mf, hdr, index, "H", h) != 0) return 4;
+            if (h_index && index == hdr->num_graphs - 1) *h_index = binary_index(mf, hdr, path);
+        }
+        *zero_copy = (hdr->elem_width == 4 && !(hdr->flags & AACG_FLAG_SPARSE)) || (h_index && *h_index);
+        return 0;
     }
-    trim_inplace(buffer);
-    *n_h = (int) strtol(buffer, NULL, 10);
-    if (*n_h <= 0) {
-        fprintf(stderr, "Invalid number of vertices for graph H: %d\n", *n_h);
-        free(*adj_g);
-        fclose(f);
-        return 4;
-    }
-    
-    // Allocate and read adjacency matrix for H
-    *adj_h = calloc((size_t) (*n_h) * (size_t) (*n_h), sizeof(int));
-    if (!*adj_h) {
-        fprintf(stderr, "Memory allocation failed for graph H\n");
-        free(*adj_g);
-        fclose(f);
-        return 5;
+
+    Scanner sc = {mf->data, mf->data + mf->size, 1};
+
+    if (g && read_text_graph(&sc, "G", g) != 0) return 2;
+    if (h) {
+        // A stand-alone H file may hold a G/H pair; take its last graph
+        if (read_text_graph(&sc, "H", h) != 0) return 4;
+        if (!g && skip_empty_lines(&sc)) {
+            release_loaded(h);
+            if (read_text_graph(&sc, "H", h) != 0) return 4;
+        }
+    }
+    return 0;
+}
+
+// Move a loaded graph into slot k (0 = G, 1 = H) of the pair. G is always kept
+// dense; H stays sparse if it was given as an edge list.
+static int store_graph(GraphPair *gp, int k, LoadedGraph *lg) {
+    if (lg->sparse && k == 0) {
+        lg->owned = sparse_graph_to_dense(lg->sparse);
+        if (!lg->owned) {
+            fprintf(stderr, "Graph G (%d vertices) is too large for a dense matrix\n", lg->n);
+            release_loaded(lg);
+            return -1;
+        }
+        lg->adj = lg->owned;
+        free_sparse_graph(lg->sparse);
+        lg->sparse = NULL;
+    }
+
+    if (k == 0) {
+        gp->n_g = lg->n;
+        gp->adj_g = lg->adj;
+    } else {
+        gp->n_h = lg->n;
+        gp->adj_h = lg->adj;
+        gp->sparse_h = lg->sparse;
+    }
+    gp->owned[k] = lg->owned;
+    return 0;
+}
+
+// --- Binary Writer ---
+
+// Write count values narrowed to width bytes
+static bool write_values(FILE *f, const int *values, size_t count, int width) {
+    if (width == 4) return fwrite(values, sizeof(int), count, f) == count;
+
+    unsigned char buf[4096 * 2];
+    size_t chunk = sizeof(buf) / (size_t) width;
+    for (size_t c = 0; c < count; c += chunk) {
+        size_t len = count - c < chunk ? count - c : chunk;
+        for (size_t t = 0; t < len; ++t) {
+            if (width == 1) buf[t] = (unsigned char) values[c + t];
+            else ((uint16_t *) buf)[t] = (uint16_t) values[c + t];
+        }
+        if (fwrite(buf, (size_t) width, len, f) != len) return false;
+    }
+    return true;
+}
+
+static bool fits_width(const int *values, size_t count, int width) {
+    int max_value = width == 1 ? UINT8_MAX : width == 2 ? UINT16_MAX : INT_MAX;
+    for (size_t c = 0; c < count; ++c) {
+        if (values[c] < 0 || values[c] > max_value) {
+            fprintf(stderr, "Multiplicity %d does not fit in %d byte(s)\n", values[c], width);
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool check_write_params(int num_graphs, int elem_width) {
+    if (num_graphs < 1 || num_graphs > AACG_MAX_GRAPHS ||
+        (elem_width != 1 && elem_width != 2 && elem_width != 4)) {
+        fprintf(stderr, "Invalid binary graph parameters\n");
+        return false;
+    }
+    return true;
+}
+
+static void init_header(AacgHeader *hdr, int num_graphs, int elem_width, uint32_t flags) {
+    memset(hdr, 0, sizeof(*hdr));
+    memcpy(hdr->magic, AACG_MAGIC, 8);
+    hdr->version = AACG_VERSION;
+    hdr->endian_tag = AACG_ENDIAN_TAG;
+    hdr->num_graphs = (uint32_t) num_graphs;
+    hdr->elem_width = (uint32_t) elem_width;
+    hdr->flags = flags;
+}
+
+// Write the header and pad up to the first payload
+static FILE *begin_container(const char *path, const AacgHeader *hdr) {
+    static const unsigned char zeros[AACG_ALIGN];
+    FILE *f = fopen(path, "wb");
+    if (!f) {
+        fprintf(stderr, "Failed to open file for writing: %s\n", path);
+        return NULL;
     }
-    
-    if (read_adjacency_matrix(f, *n_h, *adj_h) != 0) {
-        fprintf(stderr, "Failed to read adjacency matrix for graph H\n");
-        free(*adj_g);
-        free(*adj_h);
+    if (fwrite(hdr, sizeof(*hdr), 1, f) != 1 ||
+        fwrite(zeros, 1, AACG_DATA_START - sizeof(*hdr), f) != AACG_DATA_START - sizeof(*hdr)) {
         fclose(f);
-        return 5;
+        fprintf(stderr, "Failed to write binary graph file: %s\n", path);
+        return NULL;
+    }
+    return f;
+}
+
+// Pad the payload that ended at `end` up to the next alignment boundary
+static bool pad_payload(FILE *f, uint64_t end) {
+    static const unsigned char zeros[AACG_ALIGN];
+    size_t pad = (size_t) (aacg_align(end) - end);
+    return pad == 0 || fwrite(zeros, 1, pad, f) == pad;
+}
+
+static int end_container(FILE *f, const char *path, bool ok) {
+    if (fclose(f) != 0) ok = false;
+    if (!ok) {
+        fprintf(stderr, "Failed to write binary graph file: %s\n", path);
+        return -1;
     }
-    
-    fclose(f);
     return 0;
 }
+
+// --- Public Functions ---
+
+// load_graph_pair, or load_graph_g without load_h
+static int load_graphs(const char *path, const char *target_path, bool load_h, GraphPair *gp) {
+    memset(gp, 0, sizeof(*gp));
+
+    LoadedGraph g, h;
+    memset(&g, 0, sizeof(g));
+    memset(&h, 0, sizeof(h));
+
+    int rc = 0;
+    bool zero_copy;
+    if (path) {
+        if (map_file(path, &gp->files[0]) != 0) {
+            fprintf(stderr, "Failed to open file: %s\n", path);
+            return 1;
+        }
+        bool h_here = load_h && !target_path;
+        rc = read_graphs_from(&gp->files[0], path, &g, h_here ? &h : NULL, h_here ? &gp->h_index : NULL,
+                              &zero_copy);
+        if (!zero_copy) unmap_file(&gp->files[0]);
+    }
+
+    if (rc == 0 && load_h && target_path) {
+        if (map_file(target_path, &gp->files[1]) != 0) {
+            fprintf(stderr, "Failed to open file: %s\n", target_path);
+            rc = 1;
+        } else {
+            rc = read_graphs_from(&gp->files[1], target_path, NULL, &h, &gp->h_index, &zero_copy);
+            if (!zero_copy) unmap_file(&gp->files[1]);
+        }
+    }
+
+    if (rc == 0 && path && store_graph(gp, 0, &g) != 0) rc = 2;
+    if (rc == 0 && load_h) store_graph(gp, 1, &h);
+    if (rc != 0) {
+        release_loaded(&g);
+        release_loaded(&h);
+        free_graph_pair(gp);
+    }
+    return rc;
+}
+
+int load_graph_pair(const char *path, const char *target_path, GraphPair *gp) {
+    return load_graphs(path, target_path, true, gp);
+}
+
+int load_graph_g(const char *path, GraphPair *gp) {
+    return load_graphs(path, NULL, false, gp);
+}
+
+int open_graph_stream(const char *path, GraphStream *gs) {
+    memset(gs, 0, sizeof(*gs));
+    if (map_file(path, &gs->file) != 0) {
+        fprintf(stderr, "Failed to open file: %s\n", path);
+        return -1;
+    }
+    if (is_binary(&gs->file)) {
+        fprintf(stderr, "%s: a graph stream must be text (binary containers hold a single pair)\n", path);
+        unmap_file(&gs->file);
+        return -1;
+    }
+    gs->pos = gs->file.data;
+    gs->end = gs->file.data + gs->file.size;
+    gs->line = 1;
+    return 0;
+}
+
+void open_graph_stream_buffer(const char *data, size_t size, GraphStream *gs) {
+    memset(gs, 0, sizeof(*gs));
+    gs->pos = data;
+    gs->end = data + size;
+    gs->line = 1;
+}
+
+int read_stream_pair(GraphStream *gs, bool with_h, GraphPair *gp) {
+    memset(gp, 0, sizeof(*gp));
+    Scanner sc = {gs->pos, gs->end, gs->line};
+    if (!skip_empty_lines(&sc)) return 0;
+
+    LoadedGraph g, h;
+    memset(&h, 0, sizeof(h));
+    int rc = read_text_graph(&sc, "G", &g) == 0 ? 0 : -1;
+    if (rc == 0 && with_h) {
+        if (!skip_empty_lines(&sc)) {
+            fprintf(stderr, "Graph stream ends before the H of its last instance\n");
+            release_loaded(&g);
+            rc = -1;
+        } else if (read_text_graph(&sc, "H", &h) != 0) {
+            release_loaded(&g);
+            rc = -1;
+        }
+    }
+    if (rc == 0 && store_graph(gp, 0, &g) != 0) {
+        release_loaded(&h);
+        rc = -1;
+    }
+    if (rc == 0 && with_h) store_graph(gp, 1, &h);
+
+    gs->pos = sc.p;
+    gs->line = sc.line;
+    return rc == 0 ? 1 : -1;
+}
+
+void close_graph_stream(GraphStream *gs) {
+    unmap_file(&gs->file);
+    gs->pos = gs->end = NULL;
+}
+
+int graph_pair_densify_h(GraphPair *gp) {
+    if (!gp->sparse_h) return 0;
+
+    int *adj = sparse_graph_to_dense(gp->sparse_h);
+    if (!adj) {
+        fprintf(stderr, "Graph H (%d vertices) is too large for a dense matrix\n", gp->n_h);
+        return -1;
+    }
+    mem_free(gp->owned[1]);
+    gp->owned[1] = adj;
+    gp->adj_h = adj;
+    free_sparse_graph(gp->sparse_h);
+    gp->sparse_h = NULL;
+    return 0;
+}
+
+void free_graph_pair(GraphPair *gp) {
+    for (int k = 0; k < 2; ++k) {
+        mem_free(gp->owned[k]);
+        gp->owned[k] = NULL;
+        unmap_file(&gp->files[k]);
+    }
+    free_sparse_graph(gp->sparse_h);
+    gp->sparse_h = NULL;
+    free_h_index(gp->h_index);
+    gp->h_index = NULL;
+    gp->adj_g = gp->adj_h = NULL;
+}
+
+// Append the index section after the last payload, which ended at `end`
+static bool write_index_section(FILE *f, uint64_t end, const HIndex *idx) {
+    return pad_payload(f, end) && h_index_write(f, aacg_align(end), idx);
+}
+
+static int save_dense(const char *path, int num_graphs, const int *n, const int *const *adj, int elem_width,
+                      const HIndex *idx) {
+    if (!check_write_params(num_graphs, elem_width)) return -1;
+
+    AacgHeader hdr;
+    init_header(&hdr, num_graphs, elem_width, idx ? AACG_FLAG_INDEX : 0);
+
+    uint64_t pos = AACG_DATA_START;
+    for (int k = 0; k < num_graphs; ++k) {
+        if (!fits_width(adj[k], (size_t) n[k] * n[k], elem_width)) return -1;
+        hdr.n[k] = (uint32_t) n[k];
+        hdr.offset[k] = pos;
+        pos = aacg_align(pos + aacg_dense_size(hdr.n[k], hdr.elem_width));
+    }
+
+    FILE *f = begin_container(path, &hdr);
+    if (!f) return -1;
+
+    bool ok = true;
+    for (int k = 0; ok && k < num_graphs; ++k) {
+        ok = write_values(f, adj[k], (size_t) n[k] * n[k], elem_width);
+        if (ok && k + 1 < num_graphs) ok = pad_payload(f, hdr.offset[k] + aacg_dense_size(hdr.n[k], hdr.elem_width));
+    }
+    int last = num_graphs - 1;
+    if (ok && idx) ok = write_index_section(f, hdr.offset[last] + aacg_dense_size(hdr.n[last], hdr.elem_width), idx);
+    return end_container(f, path, ok);
+}
+
+static int save_sparse(const char *path, int num_graphs, const SparseGraph *const *graphs, int elem_width,
+                       const HIndex *idx) {
+    if (!check_write_params(num_graphs, elem_width)) return -1;
+
+    AacgHeader hdr;
+    init_header(&hdr, num_graphs, elem_width, AACG_FLAG_SPARSE | (idx ? AACG_FLAG_INDEX : 0));
+
+    uint64_t pos = AACG_DATA_START;
+    for (int k = 0; k < num_graphs; ++k) {
+        if (!fits_width(graphs[k]->out_mult, (size_t) graphs[k]->num_edges, elem_width)) return -1;
+        hdr.n[k] = (uint32_t) graphs[k]->n;
+        hdr.offset[k] = pos;
+        pos = aacg_align(pos + aacg_sparse_size((uint64_t) graphs[k]->num_edges, hdr.elem_width));
+    }
+
+    FILE *f = begin_container(path, &hdr);
+    if (!f) return -1;
+
+    bool ok = true;
+    for (int k = 0; ok && k < num_graphs; ++k) {
+        const SparseGraph *g = graphs[k];
+        uint64_t m = (uint64_t) g->num_edges;
+        int *src = (int *) malloc((m > 0 ? m : 1) * sizeof(int));
+        if (!src) {
+            fprintf(stderr, "Memory allocation failed\n");
+            ok = false;
+            break;
+        }
+        for (int u = 0; u < g->n; ++u) {
+            for (int e = g->out_start[u]; e < g->out_start[u + 1]; ++e) src[e] = u;
+        }
+
+        ok = fwrite(&m, sizeof(m), 1, f) == 1 &&
+             write_values(f, src, m, 4) &&
+             write_values(f, g->out_dst, m, 4) &&
+             write_values(f, g->out_mult, m, elem_width);
+        free(src);
+        if (ok && k + 1 < num_graphs) ok = pad_payload(f, hdr.offset[k] + aacg_sparse_size(m, hdr.elem_width));
+        if (ok && idx && k + 1 == num_graphs) ok = write_index_section(f, hdr.offset[k] + aacg_sparse_size(m, hdr.elem_width), idx);
+    }
+    return end_container(f, path, ok);
+}
+
+int save_graphs_binary(const char *path, int num_graphs, const int *n, const int *const *adj, int elem_width) {
+    return save_dense(path, num_graphs, n, adj, elem_width, NULL);
+}
+
+int save_graphs_binary_sparse(const char *path, int num_graphs, const SparseGraph *const *graphs, int elem_width) {
+    return save_sparse(path, num_graphs, graphs, elem_width, NULL);
+}
+
+int save_indexed_h(const char *path, int n_h, const int *adj_h, const SparseGraph *sparse_h, const HIndex *idx) {
+    if (sparse_h) return save_sparse(path, 1, &sparse_h, 4, idx);
+    return save_dense(path, 1, &n_h, &adj_h, 4, idx);
+}
@@ -1,8 +1,119 @@
 #ifndef AAC_GRAPH_H
 #define AAC_GRAPH_H
 
-void print_adj_matrix(const char *name, int n, const int *adj);
+#include "utils.h"
+#include "sparse_graph.h"
+#include "h_index.h"
 
-int load_graphs(const char *path, int *n_g, int **adj_g, int *n_h, int **adj_h);
+/**
+ * Graphs G and H loaded for one run.
+ *
+ * adj_g/adj_h may point straight into a memory-mapped binary file (zero-copy),
+ * so they are read-only; release everything with free_graph_pair.
+ *
+ * G is always a dense matrix. H given as an edge list is kept in CSR form in
+ * sparse_h (adj_h is NULL then); graph_pair_densify_h expands it on demand.
+ */
+typedef struct {
+    int n_g, n_h;
+    const int *adj_g;      // n_g x n_g, row-major
+    const int *adj_h;      // n_h x n_h, row-major
+    SparseGraph *sparse_h; // H as CSR when loaded from an edge list, else NULL
+    HIndex *h_index;       // Precomputed H tables when H comes from an index file, else NULL
+    int *owned[2];         // Heap matrices owned by the pair
+    MappedFile files[2];   // Mappings kept alive for zero-copy matrices
+} GraphPair;
 
-#endif //AAC_GRAPH_H
\ No newline at end of file
+/**
+ * Load G and H from a text or binary (.aacg) file, detected by content.
+ * Each text graph is either a dense matrix or an "edges <n>" edge list.
+ *
+ * Without target_path, path must hold both graphs (G first). With target_path,
+ * G is the first graph of path and H is the last graph of target_path, so one
+ * prepared H file can be reused against many G files.
+ *
+ * path may be NULL to load only H (n_g = 0, adj_g = NULL).
+ *
+ * @return 0 on success, 1 if a file cannot be opened, 2 if G is invalid, 4 if H is invalid
+ */
+int load_graph_pair(const char *path, const char *target_path, GraphPair *gp);
+
+/**
+ * Load only G, the first graph of path (n_h = 0, adj_h = NULL), e.g. a shared
+ * batch pattern. The file may hold G alone or a G/H pair.
+ *
+ * @return 0 on success, 1 if the file cannot be opened, 2 if G is invalid
+ */
+int load_graph_g(const char *path, GraphPair *gp);
+
+/**
+ * Sequence of text graphs in one file or standard input ("-"), read one
+ * instance at a time by read_stream_pair
+ */
+typedef struct {
+    MappedFile file;
+    const char *pos; // Start of the unread part
+    const char *end;
+    int line;        // Line number at pos, for error messages
+} GraphStream;
+
+/**
+ * @return 0 on success, -1 if the input cannot be read or is not text (message printed to stderr)
+ */
+int open_graph_stream(const char *path, GraphStream *gs);
+
+/**
+ * Read instances from text in memory (borrowed; must outlive the stream)
+ */
+void open_graph_stream_buffer(const char *data, size_t size, GraphStream *gs);
+
+/**
+ * Read the next instance: a G, followed by its H when with_h is set. Graphs
+ * use the same text forms as load_graph_pair and follow each other directly.
+ *
+ * @return 1 if an instance was read into gp, 0 at the end of the stream, -1 on invalid input
+ */
+int read_stream_pair(GraphStream *gs, bool with_h, GraphPair *gp);
+
+void close_graph_stream(GraphStream *gs);
+
+/**
+ * Replace a sparse H by its dense matrix, for engines that need one
+ *
+ * @return 0 on success (or if H is already dense), -1 if the matrix does not fit
+ */
+int graph_pair_densify_h(GraphPair *gp);
+
+/**
+ * Release the matrices and mappings held by a GraphPair
+ */
+void free_graph_pair(GraphPair *gp);
+
+/**
+ * Write graphs to a binary (.aacg) file with dense payloads.
+ *
+ * @param num_graphs 1 or 2
+ * @param n Vertex count of each graph
+ * @param adj Adjacency matrix of each graph (flattened)
+ * @param elem_width Bytes per multiplicity: 1, 2 or 4 (only 4 loads without copying)
+ * @return 0 on success, -1 on error (message printed to stderr)
+ */
+int save_graphs_binary(const char *path, int num_graphs, const int *n, const int *const *adj, int elem_width);
+
+/**
+ * Write graphs to a binary (.aacg) file with sparse (edge list) payloads
+ *
+ * @return 0 on success, -1 on error (message printed to stderr)
+ */
+int save_graphs_binary_sparse(const char *path, int num_graphs, const SparseGraph *const *graphs, int elem_width);
+
+/**
+ * Write H and its index to a binary file (.aacg with an index section). H is
+ * stored with 4-byte multiplicities (dense H loads without copying) or as an
+ * edge list if sparse_h is given; loading the file gives GraphPair.h_index.
+ *
+ * @return 0 on success, -1 on error (message printed to stderr)
+ */
+int save_indexed_h(const char *path, int n_h, const int *adj_h, const SparseGraph *sparse_h, const HIndex *idx);
+
+#endif //AAC_GRAPH_H
@@ -0,0 +1,106 @@
+#ifndef AAC_GRAPH_BINARY_H
+#define AAC_GRAPH_BINARY_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * Binary graph container (.aacg)
+ *
+ * A fixed 64-byte header followed by one or two adjacency matrices (G, then H).
+ * All fields use the byte order of the machine that wrote the file; the
+ * endian_tag lets readers reject files from a machine with the other order.
+ *
+ * Dense payload: n x n row-major multiplicities, elem_width bytes each
+ * (unsigned for widths 1 and 2, int32 for width 4). Each payload starts at a
+ * 64-byte aligned offset, so a width-4 dense matrix can be used in place from
+ * a memory-mapped file as a const int* without copying.
+ *
+ * Sparse payload (AACG_FLAG_SPARSE, applies to every graph in the file):
+ * uint64 edge count m, then m uint32 sources, m uint32 destinations and m
+ * multiplicities of elem_width bytes each (0-based vertex ids).
+ *
+ * Index section (AACG_FLAG_INDEX, written by "aac index" for a single H): an
+ * AacgIndexHeader at the first aligned offset after the last payload, then
+ * precomputed H tables (h_index.h), each at a 64-byte aligned offset.
+ *
+ * This header only describes the layout, so standalone tools (test/graph_gen.c)
+ * can include it without linking the rest of the project.
+ */
+
+#define AACG_MAGIC "AACGRAPH"
+#define AACG_VERSION 1u
+#define AACG_ENDIAN_TAG 0x01020304u
+#define AACG_ALIGN 64u
+#define AACG_MAX_GRAPHS 2
+
+#define AACG_FLAG_SPARSE 0x1u // Payloads are edge lists instead of dense matrices
+#define AACG_FLAG_INDEX 0x2u  // An index section follows the last payload
+
+typedef struct {
+    char magic[8];                       // AACG_MAGIC, not NUL-terminated
+    uint32_t version;                    // AACG_VERSION
+    uint32_t endian_tag;                 // AACG_ENDIAN_TAG as written by the producer
+    uint32_t num_graphs;                 // 1 or 2
+    uint32_t elem_width;                 // Bytes per multiplicity: 1, 2 or 4
+    uint32_t flags;                      // AACG_FLAG_*
+    uint32_t reserved;
+    uint32_t n[AACG_MAX_GRAPHS];         // Vertex count of each graph
+    uint64_t offset[AACG_MAX_GRAPHS];    // Byte offset of each payload from the file start
+} AacgHeader;
+
+_Static_assert(sizeof(AacgHeader) == 56, "AacgHeader layout changed");
+
+// Second index layout (loop-free signatures, no edge bitmap); files with the
+// first are ignored as malformed and the tables rebuilt per query
+#define AACG_INDEX_MAGIC "AACINDX2"
+
+/**
+ * Tables of the index section, in file order
+ */
+enum {
+    AACG_INDEX_OUT_DEG,   // int32 per vertex: sum of out-edge multiplicities
+    AACG_INDEX_IN_DEG,    // int32 per vertex: sum of in-edge multiplicities
+    AACG_INDEX_ORDER,     // int32 per vertex: vertex ids by total degree (descending), then id
+    AACG_INDEX_SIGNATURE, // 3 x int32 per vertex: distinct out/in neighbours, max edge multiplicity (loops excluded)
+    AACG_INDEX_CELLS,     // Dense H only: n x n multiplicities of cell_width bytes
+    AACG_INDEX_TABLES
+};
+
+typedef struct {
+    char magic[8];                       // AACG_INDEX_MAGIC, not NUL-terminated
+    uint32_t n;                          // Vertex count of H
+    uint32_t cell_width;                 // Bytes per AACG_INDEX_CELLS entry (0 = no cells table)
+    uint32_t reserved[2];
+    uint64_t offset[AACG_INDEX_TABLES];  // Byte offset of each table from the file start (0 = absent)
+} AacgIndexHeader;
+
+_Static_assert(sizeof(AacgIndexHeader) == 64, "AacgIndexHeader layout changed");
+
+/**
+ * Offset of the first payload (header rounded up to the alignment)
+ */
+#define AACG_DATA_START 64u
+
+/**
+ * Round x up to the payload alignment
+ */
+static inline uint64_t aacg_align(uint64_t x) {
+    return (x + AACG_ALIGN - 1) / AACG_ALIGN * AACG_ALIGN;
+}
+
+/**
+ * Size in bytes of a dense payload
+ */
+static inline uint64_t aacg_dense_size(uint32_t n, uint32_t elem_width) {
+    return (uint64_t) n * n * elem_width;
+}
+
+/**
+ * Size in bytes of a sparse payload with m edges
+ */
+static inline uint64_t aacg_sparse_size(uint64_t m, uint32_t elem_width) {
+    return sizeof(uint64_t) + m * (2 * sizeof(uint32_t) + elem_width);
+}
+
+#endif //AAC_GRAPH_BINARY_H
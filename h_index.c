@@ -0,0 +1,236 @@
+#include "h_index.h"
+#include "graph_binary.h"
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+    int id;
+    int total_degree;
+} RankedVertex;
+
+static int compare_by_degree_desc(const void *a, const void *b) {
+    const RankedVertex *va = (const RankedVertex *) a;
+    const RankedVertex *vb = (const RankedVertex *) b;
+    if (vb->total_degree != va->total_degree) {
+        return vb->total_degree - va->total_degree;
+    }
+    return va->id - vb->id;
+}
+
+// Byte size of each table for an index over n vertices
+static void table_sizes(int n, int cell_width, uint64_t *size) {
+    size[AACG_INDEX_OUT_DEG] = (uint64_t) n * sizeof(int32_t);
+    size[AACG_INDEX_IN_DEG] = (uint64_t) n * sizeof(int32_t);
+    size[AACG_INDEX_ORDER] = (uint64_t) n * sizeof(int32_t);
+    size[AACG_INDEX_SIGNATURE] = (uint64_t) n * sizeof(VertexSignature);
+    size[AACG_INDEX_CELLS] = (uint64_t) n * (uint64_t) n * (uint64_t) cell_width;
+}
+
+_Static_assert(sizeof(VertexSignature) == 3 * sizeof(int32_t), "VertexSignature layout changed");
+
+// ============================================================================
+// Building
+// ============================================================================
+
+void vertex_signatures(int n, const int *adj, VertexSignature *sig) {
+    memset(sig, 0, (size_t) n * sizeof(VertexSignature));
+    for (int i = 0; i < n; i++) {
+        for (int j = 0; j < n; j++) {
+            int m = adj[(size_t) i * n + j];
+            if (m == 0 || i == j) continue;
+            sig[i].out_nbrs++;
+            sig[j].in_nbrs++;
+            if (m > sig[i].max_mult) sig[i].max_mult = m;
+            if (m > sig[j].max_mult) sig[j].max_mult = m;
+        }
+    }
+}
+
+void vertex_signatures_sparse(const SparseGraph *g, VertexSignature *sig) {
+    memset(sig, 0, (size_t) g->n * sizeof(VertexSignature));
+    for (int u = 0; u < g->n; u++) {
+        for (int k = g->out_start[u]; k < g->out_start[u + 1]; k++) {
+            int v = g->out_dst[k];
+            int m = g->out_mult[k];
+            if (u == v) continue;
+            sig[u].out_nbrs++;
+            sig[v].in_nbrs++;
+            if (m > sig[u].max_mult) sig[u].max_mult = m;
+            if (m > sig[v].max_mult) sig[v].max_mult = m;
+        }
+    }
+}
+
+// Allocate the tables every index has; out_deg and in_deg must be filled in by the caller
+static HIndex *alloc_index(int n) {
+    HIndex *idx = (HIndex *) calloc(1, sizeof(HIndex));
+    if (!idx) return NULL;
+    idx->n = n;
+    idx->owned = true;
+    size_t count = n > 0 ? (size_t) n : 1;
+    idx->out_deg = (int *) calloc(count, sizeof(int));
+    idx->in_deg = (int *) calloc(count, sizeof(int));
+    idx->order = (int *) malloc(count * sizeof(int));
+    idx->signature = (VertexSignature *) calloc(count, sizeof(VertexSignature));
+    if (!idx->out_deg || !idx->in_deg || !idx->order || !idx->signature) {
+        free_h_index(idx);
+        return NULL;
+    }
+    return idx;
+}
+
+static int fill_order(HIndex *idx) {
+    RankedVertex *ranked = (RankedVertex *) malloc((idx->n > 0 ? (size_t) idx->n : 1) * sizeof(RankedVertex));
+    if (!ranked) return -1;
+    for (int u = 0; u < idx->n; u++) {
+        ranked[u].id = u;
+        ranked[u].total_degree = h_index_total_degree(idx, u);
+    }
+    qsort(ranked, (size_t) idx->n, sizeof(RankedVertex), compare_by_degree_desc);
+    int *order = (int *) idx->order;
+    for (int k = 0; k < idx->n; k++) order[k] = ranked[k].id;
+    free(ranked);
+    return 0;
+}
+
+HIndex *h_index_build(int n, const int *adj) {
+    HIndex *idx = alloc_index(n);
+    if (!idx) return NULL;
+    int *out_deg = (int *) idx->out_deg;
+    int *in_deg = (int *) idx->in_deg;
+
+    if (mult_matrix_init(&idx->cells, n, adj, 0) != 0) {
+        free_h_index(idx);
+        return NULL;
+    }
+
+    for (int i = 0; i < n; i++) {
+        for (int j = 0; j < n; j++) {
+            int m = adj[(size_t) i * n + j];
+            if (m == 0) continue;
+            out_deg[i] += m;
+            in_deg[j] += m;
+        }
+    }
+    vertex_signatures(n, adj, (VertexSignature *) idx->signature);
+
+    if (fill_order(idx) != 0) {
+        free_h_index(idx);
+        return NULL;
+    }
+    return idx;
+}
+
+HIndex *h_index_build_sparse(const SparseGraph *h) {
+    HIndex *idx = alloc_index(h->n);
+    if (!idx) return NULL;
+    int *out_deg = (int *) idx->out_deg;
+    int *in_deg = (int *) idx->in_deg;
+
+    for (int u = 0; u < h->n; u++) {
+        for (int k = h->out_start[u]; k < h->out_start[u + 1]; k++) {
+            out_deg[u] += h->out_mult[k];
+            in_deg[h->out_dst[k]] += h->out_mult[k];
+        }
+    }
+    vertex_signatures_sparse(h, (VertexSignature *) idx->signature);
+
+    if (fill_order(idx) != 0) {
+        free_h_index(idx);
+        return NULL;
+    }
+    return idx;
+}
+
+void free_h_index(HIndex *idx) {
+    if (!idx) return;
+    if (idx->owned) {
+        free((void *) idx->out_deg);
+        free((void *) idx->in_deg);
+        free((void *) idx->order);
+        free((void *) idx->signature);
+        mult_matrix_free(&idx->cells);
+    }
+    free(idx);
+}
+
+// ============================================================================
+// File Section
+// ============================================================================
+
+static bool write_padded(FILE *f, const void *data, uint64_t size, uint64_t *pos) {
+    static const unsigned char zeros[AACG_ALIGN];
+    if (size > 0 && fwrite(data, 1, (size_t) size, f) != size) return false;
+    uint64_t end = *pos + size;
+    size_t pad = (size_t) (aacg_align(end) - end);
+    if (pad > 0 && fwrite(zeros, 1, pad, f) != pad) return false;
+    *pos = aacg_align(end);
+    return true;
+}
+
+bool h_index_write(FILE *f, uint64_t offset, const HIndex *idx) {
+    int cell_width = idx->cells.cells ? (int) idx->cells.width : 0;
+    uint64_t size[AACG_INDEX_TABLES];
+    table_sizes(idx->n, cell_width, size);
+
+    AacgIndexHeader hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, AACG_INDEX_MAGIC, 8);
+    hdr.n = (uint32_t) idx->n;
+    hdr.cell_width = (uint32_t) cell_width;
+
+    uint64_t pos = aacg_align(offset + sizeof(hdr));
+    for (int t = 0; t < AACG_INDEX_TABLES; t++) {
+        if (size[t] == 0) continue;
+        hdr.offset[t] = pos;
+        pos = aacg_align(pos + size[t]);
+    }
+
+    const void *tables[AACG_INDEX_TABLES] = {
+        idx->out_deg, idx->in_deg, idx->order, idx->signature, idx->cells.cells
+    };
+    pos = offset;
+    if (!write_padded(f, &hdr, sizeof(hdr), &pos)) return false;
+    for (int t = 0; t < AACG_INDEX_TABLES; t++) {
+        if (size[t] > 0 && !write_padded(f, tables[t], size[t], &pos)) return false;
+    }
+    return true;
+}
+
+int h_index_view(const void *data, size_t size, uint64_t offset, int n, HIndex *out) {
+    const unsigned char *base = (const unsigned char *) data;
+    if (offset % AACG_ALIGN != 0 || offset > size || size - offset < sizeof(AacgIndexHeader)) return -1;
+
+    const AacgIndexHeader *hdr = (const AacgIndexHeader *) (base + offset);
+    if (memcmp(hdr->magic, AACG_INDEX_MAGIC, 8) != 0 || hdr->n != (uint32_t) n) return -1;
+    if (hdr->cell_width != 0 && hdr->cell_width != 1 && hdr->cell_width != 2 && hdr->cell_width != 4) return -1;
+
+    uint64_t table_size[AACG_INDEX_TABLES];
+    table_sizes(n, (int) hdr->cell_width, table_size);
+    for (int t = 0; t < AACG_INDEX_TABLES; t++) {
+        bool wanted = table_size[t] > 0;
+        if (!wanted) continue;
+        if (hdr->offset[t] == 0 || hdr->offset[t] % AACG_ALIGN != 0 || hdr->offset[t] > size ||
+            table_size[t] > size - hdr->offset[t]) {
+            return -1;
+        }
+    }
+
+    memset(out, 0, sizeof(*out));
+    out->n = n;
+    out->out_deg = (const int *) (base + hdr->offset[AACG_INDEX_OUT_DEG]);
+    out->in_deg = (const int *) (base + hdr->offset[AACG_INDEX_IN_DEG]);
+    out->order = (const int *) (base + hdr->offset[AACG_INDEX_ORDER]);
+    out->signature = (const VertexSignature *) (base + hdr->offset[AACG_INDEX_SIGNATURE]);
+    if (hdr->cell_width > 0) {
+        out->cells.n = n;
+        out->cells.width = (MultWidth) hdr->cell_width;
+        out->cells.cells = (void *) (base + hdr->offset[AACG_INDEX_CELLS]);
+    }
+
+    // The engines index arrays with these ids
+    for (int k = 0; k < n; k++) {
+        if (out->order[k] < 0 || out->order[k] >= n) return -1;
+    }
+    return 0;
+}
@@ -0,0 +1,89 @@
+#ifndef AAC_H_INDEX_H
+#define AAC_H_INDEX_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "sparse_graph.h"
+#include "multiplicity.h"
+
+/**
+ * Per-vertex neighbourhood summary. For every vertex v of G that can map to
+ * u in H, each field of v is at most the same field of u. Loops are left out,
+ * as iso_exact only counts them in the degrees.
+ */
+typedef struct {
+    int out_nbrs; // Distinct out-neighbours (self excluded)
+    int in_nbrs;  // Distinct in-neighbours (self excluded)
+    int max_mult; // Largest multiplicity of an incident edge (loops excluded)
+} VertexSignature;
+
+/**
+ * Signatures of every vertex of a dense graph
+ */
+void vertex_signatures(int n, const int *adj, VertexSignature *sig);
+
+/**
+ * Signatures of every vertex of a sparse graph
+ */
+void vertex_signatures_sparse(const SparseGraph *g, VertexSignature *sig);
+
+/**
+ * H-side tables that the engines would otherwise recompute for every query.
+ *
+ * Built in memory with h_index_build / h_index_build_sparse, or used in place
+ * from a memory-mapped index file (see graph_binary.h) through
+ * GraphPair.h_index. All tables are read-only.
+ */
+typedef struct {
+    int n;
+    const int *out_deg;                 // Sum of out-edge multiplicities per vertex
+    const int *in_deg;                  // Sum of in-edge multiplicities per vertex
+    const int *order;                   // Vertex ids by total degree (descending), then id
+    const VertexSignature *signature;   // Checked with signature_fits in product graph phase 1
+    MultMatrix cells;                   // Dense H only: H at its narrowest width (cells NULL otherwise)
+    bool owned;                         // Tables are heap blocks (built in memory), else borrowed
+} HIndex;
+
+/**
+ * Index a dense H
+ *
+ * @return New index (free with free_h_index), or NULL on allocation failure
+ */
+HIndex *h_index_build(int n, const int *adj);
+
+/**
+ * Index a sparse H (degrees, order and signatures; no cells)
+ */
+HIndex *h_index_build_sparse(const SparseGraph *h);
+
+/**
+ * Point an index at the tables of an index section inside a file image.
+ * The image must stay mapped while the index is used.
+ *
+ * @return 0 on success, -1 if the section is malformed or does not describe n vertices
+ */
+int h_index_view(const void *data, size_t size, uint64_t offset, int n, HIndex *out);
+
+/**
+ * Write the index section for idx at offset (already aligned) of f
+ *
+ * @return true on success
+ */
+bool h_index_write(FILE *f, uint64_t offset, const HIndex *idx);
+
+void free_h_index(HIndex *idx);
+
+static inline int h_index_total_degree(const HIndex *idx, int u) {
+    return idx->out_deg[u] + idx->in_deg[u];
+}
+
+/**
+ * True if every field of g is at most the same field of h
+ */
+static inline bool signature_fits(const VertexSignature *g, const VertexSignature *h) {
+    return g->out_nbrs <= h->out_nbrs && g->in_nbrs <= h->in_nbrs && g->max_mult <= h->max_mult;
+}
+
+#endif //AAC_H_INDEX_H
@@ -1,9 +1,17 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <limits.h>
 #include "graph.h"
-#include "algorithms.h"
+#include "aac.h"
 #include "console.h"
+#include "batch.h"
+#include "server.h"
+#include "output.h"
+#include "utils.h"
+#include "mem_track.h"
+#include "trace.h"
+#include "auto_plan.h"
 
 static void print_usage(const char *prog_name) {
     fprintf(stderr, "Usage: %s <command> <graph_file> [n] [--batch|-b]\n\n", prog_name);
@@ -12,11 +20,330 @@ static void print_usage(const char *prog_name) {
     fprintf(stderr, "  iso_approx <file> <n>      Find n subgraph isomorphisms (heuristic)\n");
     fprintf(stderr, "  ext_exact <file> <n>       Find minimal extension for n isomorphisms (exact)\n");
     fprintf(stderr, "  ext_approx <file> <n>      Find minimal extension for n isomorphisms (heuristic)\n");
+    fprintf(stderr, "  ext_joint <file> <n>       Find jointly minimal extension for n isomorphisms (branch-and-bound)\n");
+    fprintf(stderr, "  auto <file> <n>            Choose the engine from estimates of the search, print the plan and run it\n");
+    fprintf(stderr, "  convert <file> <out>       Write the graphs to a binary (.aacg) file\n");
+    fprintf(stderr, "  index <file> <out>         Precompute the tables of H (the file's last graph) into an index file\n");
+    fprintf(stderr, "  iso_update <file> <updates> Apply each line of edge changes to H, listing embeddings gained and lost\n");
+    fprintf(stderr, "  batch <command> <file> <n> Run a command on every instance of a graph stream (- = stdin)\n");
+    fprintf(stderr, "  serve <socket>             Answer queries against the --target graphs on a Unix socket\n");
     fprintf(stderr, "\nOptions:\n");
     fprintf(stderr, "  --batch, -b                Disable interactive mode (stop at n results)\n");
+    fprintf(stderr, "  --target <file>            Take H from this file (its last graph); <file> then supplies only G\n");
+    fprintf(stderr, "  --pattern <file>           batch: take G from this file; every stream graph is an H, screened first\n");
+    fprintf(stderr, "  --format <text|json|csv|none> Output format (default text; others skip the matrices)\n");
+    fprintf(stderr, "  --cache <dir>              iso_exact, ext_exact: reuse answers to queries equal up to relabelling\n");
+    fprintf(stderr, "                             (runs that cannot prompt: --batch, a non-text format, batch, serve)\n");
+    fprintf(stderr, "  --stats                    Print search counters at the end (builds with -DAAC_STATS=ON)\n");
+    fprintf(stderr, "  --mem-limit <MB>           Fail allocations of graphs, results and engines beyond this total\n");
+    fprintf(stderr, "  --mem-report               Print current and peak memory per subsystem at the end\n");
+    fprintf(stderr, "  --trace <file>             Write a timeline of the run's phases (Chrome trace-event JSON)\n");
+    fprintf(stderr, "  --jobs <count>             batch: instances solved in parallel (default 1, 0 = one per CPU);\n");
+    fprintf(stderr, "                             serve: clients served in parallel (default one per CPU)\n");
+    fprintf(stderr, "  --extend                   auto: plan a minimal extension (default: isomorphisms)\n");
+    fprintf(stderr, "  --budget <ms>              auto: run the exact engine if estimated within this time (default %.0f)\n",
+            AUTO_DEFAULT_BUDGET_MS);
+    fprintf(stderr, "  --width <1|2|4>            convert: bytes per multiplicity (default 4, loads without copying)\n");
+    fprintf(stderr, "  --only <G|H>               convert: write just one of the graphs\n");
+    fprintf(stderr, "  --sparse                   convert, index: store edge lists instead of matrices\n");
+    fprintf(stderr, "  --max-nodes <count>        ext_joint: stop after expanding this many search nodes\n");
+    fprintf(stderr, "  --time-limit <ms>          ext_joint: stop after this many milliseconds\n");
+    fprintf(stderr, "  --refine                   ext_approx: improve each mapping by local search\n");
+    fprintf(stderr, "  --refine-passes <count>    ext_approx: local search pass limit per round (0 = no limit)\n");
+    fprintf(stderr, "  --portfolio                ext_approx: run several greedy strategies in parallel per round\n");
+    fprintf(stderr, "  --threads <count>          ext_approx: portfolio worker threads (default: one per CPU)\n");
+    fprintf(stderr, "  --anchors <count>          ext_approx: highest-degree G vertices tried as anchor (default 3)\n");
+    fprintf(stderr, "  --random-strategies <count> ext_approx: extra randomized tie-break strategies (default 0)\n");
+    fprintf(stderr, "  --seed <value>             ext_approx: seed for the randomized strategies\n");
     fprintf(stderr, "\nExample:\n");
     fprintf(stderr, "  %s iso_exact data/graph.txt 3\n", prog_name);
     fprintf(stderr, "  %s ext_approx data/graph.txt 2 --batch\n", prog_name);
+    fprintf(stderr, "  %s convert data/graph.txt data/h.aacg --only H\n", prog_name);
+    fprintf(stderr, "  %s iso_approx data/g.txt 1 --target data/h.aacg\n", prog_name);
+    fprintf(stderr, "  %s index data/h.txt data/h.aaci\n", prog_name);
+    fprintf(stderr, "  %s iso_update data/graph.txt data/updates.txt\n", prog_name);
+    fprintf(stderr, "  %s batch ext_approx - 2 --target data/h.aacg --jobs 0\n", prog_name);
+    fprintf(stderr, "  %s ext_approx data/graph.txt 2 --format json\n", prog_name);
+    fprintf(stderr, "  %s auto data/graph.txt 2 --extend --batch\n", prog_name);
+    fprintf(stderr, "  %s serve /tmp/aac.sock --target data/h.aaci --target data/h2.aacg\n", prog_name);
+}
+
+static const char *trace_path = NULL;
+
+// Registered with atexit, so every way out of main saves the trace
+static void write_trace(void) {
+    trace_write(trace_path);
+}
+
+// Machine-readable result of a single run
+static void write_summary(OutputFormat format, const RunSummary *summary) {
+    OutWriter w;
+    out_init(&w, stdout);
+    if (format == OUTPUT_JSON) {
+        write_summary_json(&w, summary);
+    } else {
+        write_csv_header(&w);
+        write_summary_csv(&w, summary);
+    }
+    out_free(&w);
+}
+
+// Counters of a single run; only the lines the engine fills in
+static void print_search_stats(FILE *f, const AacResult *result) {
+    const SearchStats *s = &result->stats;
+    fprintf(f, "\n--- Search Statistics ---\n");
+    if (result->engine == AAC_ISO_EXACT) {
+        long long v = s->product_vertices;
+        double pairs = (double) v * (double) (v - 1) / 2;
+        fprintf(f, "Product graph: %lld vertices, %lld edges (density %.4f)\n", v, s->product_edges,
+                pairs > 0 ? (double) s->product_edges / pairs : 0.0);
+    }
+    if (result->engine == AAC_ISO_EXACT || result->engine == AAC_EXT_EXACT || result->engine == AAC_EXT_JOINT) {
+        fprintf(f, "Nodes expanded: %lld\n", s->nodes);
+    }
+    if (result->engine == AAC_ISO_EXACT) fprintf(f, "Branches pruned: %lld\n", s->pruned);
+    if (result->engine == AAC_ISO_EXACT || result->engine == AAC_EXT_EXACT) {
+        fprintf(f, "Complete mappings reached: %lld\n", s->leaves);
+    }
+    if (result->engine == AAC_ISO_APPROX || result->engine == AAC_EXT_APPROX) {
+        fprintf(f, "Greedy starts: %lld (%lld failed)\n", s->starts, s->failed_starts);
+    }
+    if (result->engine != AAC_EXT_JOINT) fprintf(f, "Duplicates rejected: %lld\n", s->duplicates);
+}
+
+static int run_convert(const GraphPair *gp, const char *out_path, const char *only, int width, bool sparse) {
+    int ns[2] = {gp->n_g, gp->n_h};
+    const int *adjs[2] = {gp->adj_g, gp->adj_h};
+    int first = 0, count = 2;
+    sparse = sparse || gp->sparse_h != NULL;
+
+    if (only) {
+        if (strcmp(only, "G") == 0) {
+            count = 1;
+        } else if (strcmp(only, "H") == 0) {
+            first = 1;
+            count = 1;
+        } else {
+            fprintf(stderr, "Error: --only expects G or H\n");
+            return 1;
+        }
+    }
+
+    int rc = 0;
+    if (sparse) {
+        SparseGraph *g = sparse_graph_from_dense(gp->n_g, gp->adj_g);
+        SparseGraph *h = gp->sparse_h ? gp->sparse_h : sparse_graph_from_dense(gp->n_h, gp->adj_h);
+        const SparseGraph *graphs[2] = {g, h};
+        if (!g || !h) {
+            fprintf(stderr, "Error: out of memory building edge lists\n");
+            rc = 1;
+        } else if (save_graphs_binary_sparse(out_path, count, graphs + first, width) != 0) {
+            rc = 1;
+        }
+        free_sparse_graph(g);
+        if (h != gp->sparse_h) free_sparse_graph(h);
+    } else if (save_graphs_binary(out_path, count, ns + first, adjs + first, width) != 0) {
+        rc = 1;
+    }
+    if (rc != 0) return rc;
+
+    printf("Wrote %s (%d graph(s), %s, %d byte(s) per multiplicity)\n",
+           out_path, count, sparse ? "edge lists" : "matrices", width);
+    return 0;
+}
+
+static int run_index(const GraphPair *gp, const char *out_path, bool sparse) {
+    SparseGraph *h = gp->sparse_h;
+    if (!h && sparse) {
+        h = sparse_graph_from_dense(gp->n_h, gp->adj_h);
+        if (!h) {
+            fprintf(stderr, "Error: out of memory building edge lists\n");
+            return 1;
+        }
+    }
+
+    // A sparse H gets no cells: that is an n_h^2 table
+    double start = now_ms();
+    HIndex *idx = h ? h_index_build_sparse(h) : h_index_build(gp->n_h, gp->adj_h);
+    int rc = 0;
+    if (!idx) {
+        fprintf(stderr, "Error: out of memory indexing H\n");
+        rc = 1;
+    } else if (save_indexed_h(out_path, gp->n_h, gp->adj_h, h, idx) != 0) {
+        rc = 1;
+    } else {
+        printf("Wrote %s (H with %d vertices, %s, indexed in %.3f ms)\n",
+               out_path, gp->n_h, h ? "edge lists" : "matrix", now_ms() - start);
+    }
+    free_h_index(idx);
+    if (h != gp->sparse_h) free_sparse_graph(h);
+    return rc;
+}
+
+// One line of an updates file: "src dst delta" triples (0-based H vertices, signed delta)
+static int parse_update_line(char *line, int line_no, EdgeUpdate **updates, int *count, int *cap) {
+    char *hash = strchr(line, '#');
+    if (hash) *hash = '\0';
+    *count = 0;
+    char *p = line;
+    for (;;) {
+        long values[3];
+        int got = 0;
+        for (; got < 3; got++) {
+            char *end;
+            values[got] = strtol(p, &end, 10);
+            if (end == p) break;
+            p = end;
+        }
+        if (got == 0) break;
+        if (got < 3 || values[0] < 0 || values[0] > INT_MAX || values[1] < 0 || values[1] > INT_MAX ||
+            values[2] < INT_MIN || values[2] > INT_MAX) {
+            fprintf(stderr, "Error: updates line %d: expected src dst delta triples\n", line_no);
+            return -1;
+        }
+        if (*count == *cap) {
+            int grown_cap = *cap ? *cap * 2 : 8;
+            EdgeUpdate *grown = (EdgeUpdate *) realloc(*updates, (size_t) grown_cap * sizeof(EdgeUpdate));
+            if (!grown) {
+                fprintf(stderr, "Error: out of memory reading updates\n");
+                return -1;
+            }
+            *updates = grown;
+            *cap = grown_cap;
+        }
+        (*updates)[(*count)++] = (EdgeUpdate) {(int) values[0], (int) values[1], (int) values[2]};
+    }
+    while (*p == ' ' || *p == '\t' || *p == '\r') p++;
+    if (*p != '\0') {
+        fprintf(stderr, "Error: updates line %d: unexpected '%s'\n", line_no, p);
+        return -1;
+    }
+    return 0;
+}
+
+static void print_embeddings(char sign, const EmbeddingSet *set) {
+    for (int k = 0; k < set->count; k++) {
+        printf("  %c ", sign);
+        for (int v = 0; v < set->n_g; v++) printf("G_%d->H_%d ", v + 1, set->mappings[k][v] + 1);
+        printf("\n");
+    }
+}
+
+static void write_embeddings_json(OutWriter *w, const char *key, const EmbeddingSet *set) {
+    out_str(w, ",\"");
+    out_str(w, key);
+    out_str(w, "\":[");
+    for (int k = 0; k < set->count; k++) {
+        out_str(w, k ? ",[" : "[");
+        for (int v = 0; v < set->n_g; v++) {
+            if (v) out_char(w, ',');
+            out_int(w, set->mappings[k][v] + 1);
+        }
+        out_char(w, ']');
+    }
+    out_char(w, ']');
+}
+
+// Register G against H, then apply the updates file one line (one step) at a time
+static int run_iso_update(const GraphPair *gp, const char *updates_path, OutputFormat format) {
+    if (format == OUTPUT_CSV) {
+        fprintf(stderr, "Error: iso_update writes text or json\n");
+        return 1;
+    }
+    MappedFile mf;
+    if (map_file(updates_path, &mf) != 0) return 1;
+
+    double start = now_ms();
+    IncrementalIso *inc = incremental_iso_create(gp->n_g, gp->adj_g, gp->n_h, gp->adj_h);
+    EmbeddingSet initial = {0};
+    if (!inc || incremental_iso_embeddings(inc, &initial) != 0) {
+        fprintf(stderr, "Error: out of memory registering G against H\n");
+        incremental_iso_destroy(inc);
+        unmap_file(&mf);
+        return 1;
+    }
+    double elapsed = now_ms() - start;
+
+    OutWriter w;
+    out_init(&w, stdout);
+    if (format == OUTPUT_TEXT) {
+        printf("Loaded G: %d vertices, H: %d vertices\n", gp->n_g, gp->n_h);
+        printf("Registered: %d embedding(s) (%.3f ms)\n", initial.count, elapsed);
+    } else if (format == OUTPUT_JSON) {
+        out_str(&w, "{\"update\":0,\"embeddings\":");
+        out_int(&w, initial.count);
+        out_str(&w, ",\"time_ms\":");
+        out_ms(&w, elapsed);
+        out_str(&w, "}\n");
+    }
+    free_embedding_set(&initial);
+
+    EdgeUpdate *updates = NULL;
+    int cap = 0, step = 0, rc = 0;
+    const char *p = mf.data, *end = mf.data + mf.size;
+    char *line = NULL;
+    size_t line_cap = 0;
+    for (int line_no = 1; p < end && rc == 0; line_no++) {
+        const char *nl = memchr(p, '\n', (size_t) (end - p));
+        size_t len = (size_t) ((nl ? nl : end) - p);
+        if (len + 1 > line_cap) {
+            char *grown = (char *) realloc(line, len + 1);
+            if (!grown) {
+                fprintf(stderr, "Error: out of memory reading updates\n");
+                rc = 1;
+                break;
+            }
+            line = grown;
+            line_cap = len + 1;
+        }
+        memcpy(line, p, len);
+        line[len] = '\0';
+        p = nl ? nl + 1 : end;
+
+        int count;
+        if (parse_update_line(line, line_no, &updates, &count, &cap) != 0) {
+            rc = 1;
+            break;
+        }
+        if (count == 0) continue;
+
+        EmbeddingDelta delta;
+        start = now_ms();
+        if (incremental_iso_update(inc, updates, count, &delta) != 0) {
+            fprintf(stderr, "Error: updates line %d not applied\n", line_no);
+            rc = 1;
+            break;
+        }
+        elapsed = now_ms() - start;
+        step++;
+
+        if (format == OUTPUT_TEXT) {
+            printf("\nUpdate %d (%d change(s)): %d gained, %d lost, %lld node(s) searched (%.3f ms)\n",
+                   step, count, delta.gained.count, delta.lost.count, delta.nodes, elapsed);
+            print_embeddings('+', &delta.gained);
+            print_embeddings('-', &delta.lost);
+        } else if (format == OUTPUT_JSON) {
+            out_str(&w, "{\"update\":");
+            out_int(&w, step);
+            out_str(&w, ",\"changes\":");
+            out_int(&w, count);
+            write_embeddings_json(&w, "gained", &delta.gained);
+            write_embeddings_json(&w, "lost", &delta.lost);
+            out_str(&w, ",\"nodes\":");
+            out_int(&w, delta.nodes);
+            out_str(&w, ",\"time_ms\":");
+            out_ms(&w, elapsed);
+            out_str(&w, "}\n");
+        }
+        free_embedding_delta(&delta);
+    }
+
+    out_free(&w);
+    free(line);
+    free(updates);
+    incremental_iso_destroy(inc);
+    unmap_file(&mf);
+    return rc;
 }
 
 int main(const int argc, char *argv[]) {
@@ -29,74 +356,348 @@ int main(const int argc, char *argv[]) {
 
     const char *command = argv[1];
     const char *file_path = argv[2];
+    const char *target_path = NULL;
+    const char *pattern_path = NULL;
+    const char *convert_out = NULL;
+    const char *convert_only = NULL;
+    int convert_width = 4;
+    bool convert_sparse = false;
+    const char *batch_command = NULL;
+    const char *updates_path = NULL;
+    const char *cache_dir = NULL;
+    bool serve = strcmp(command, "serve") == 0;
+    int batch_jobs = serve ? 0 : 1;
+    OutputFormat format = OUTPUT_TEXT;
     int n = 1;
     bool interactive = true;
+    bool print_stats = false;
+    bool mem_report = false;
+    bool auto_engine = strcmp(command, "auto") == 0;
+    bool auto_extend = false;
+    double auto_budget_ms = AUTO_DEFAULT_BUDGET_MS;
+    JointBudget joint_budget = {0, 0};
+    ExtApproxOptions approx_opts = ext_approx_default_options();
 
-    for (int i = 3; i < argc; i++) {
+    int first_opt = 3;
+    if (strcmp(command, "convert") == 0 || strcmp(command, "index") == 0) {
+        if (argc < 4) {
+            print_usage(argv[0]);
+            return 1;
+        }
+        convert_out = argv[3];
+        first_opt = 4;
+    } else if (strcmp(command, "iso_update") == 0) {
+        if (argc < 4) {
+            print_usage(argv[0]);
+            return 1;
+        }
+        updates_path = argv[3];
+        first_opt = 4;
+    } else if (strcmp(command, "batch") == 0) {
+        if (argc < 4) {
+            print_usage(argv[0]);
+            return 1;
+        }
+        batch_command = argv[2];
+        file_path = argv[3];
+        first_opt = 4;
+    }
+
+    for (int i = first_opt; i < argc; i++) {
         if (strcmp(argv[i], "--batch") == 0 || strcmp(argv[i], "-b") == 0) {
             interactive = false;
+        } else if (strcmp(argv[i], "--target") == 0 && i + 1 < argc) {
+            target_path = argv[++i];
+        } else if (strcmp(argv[i], "--pattern") == 0 && i + 1 < argc) {
+            pattern_path = argv[++i];
+        } else if (strcmp(argv[i], "--format") == 0 && i + 1 < argc) {
+            if (!parse_output_format(argv[++i], &format)) {
+                fprintf(stderr, "Error: --format expects text, json, csv or none\n");
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--stats") == 0) {
+            print_stats = true;
+        } else if (strcmp(argv[i], "--mem-limit") == 0 && i + 1 < argc) {
+            double mb = atof(argv[++i]);
+            if (mb <= 0) {
+                fprintf(stderr, "Error: --mem-limit expects a positive number of megabytes\n");
+                return 1;
+            }
+            mem_set_limit((size_t) (mb * 1024.0 * 1024.0));
+        } else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+            trace_path = argv[++i];
+        } else if (strcmp(argv[i], "--mem-report") == 0) {
+            mem_report = true;
+        } else if (strcmp(argv[i], "--extend") == 0) {
+            auto_extend = true;
+        } else if (strcmp(argv[i], "--budget") == 0 && i + 1 < argc) {
+            auto_budget_ms = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--cache") == 0 && i + 1 < argc) {
+            cache_dir = argv[++i];
+        } else if (strcmp(argv[i], "--jobs") == 0 && i + 1 < argc) {
+            batch_jobs = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--width") == 0 && i + 1 < argc) {
+            convert_width = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--only") == 0 && i + 1 < argc) {
+            convert_only = argv[++i];
+        } else if (strcmp(argv[i], "--sparse") == 0) {
+            convert_sparse = true;
+        } else if (strcmp(argv[i], "--max-nodes") == 0 && i + 1 < argc) {
+            joint_budget.max_nodes = atoll(argv[++i]);
+        } else if (strcmp(argv[i], "--time-limit") == 0 && i + 1 < argc) {
+            joint_budget.time_limit_ms = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--refine") == 0) {
+            approx_opts.refine = true;
+        } else if (strcmp(argv[i], "--refine-passes") == 0 && i + 1 < argc) {
+            approx_opts.refine_max_passes = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--portfolio") == 0) {
+            approx_opts.portfolio = true;
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            approx_opts.threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--anchors") == 0 && i + 1 < argc) {
+            approx_opts.portfolio_anchors = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--random-strategies") == 0 && i + 1 < argc) {
+            approx_opts.portfolio_random = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            approx_opts.seed = (unsigned int) strtoul(argv[++i], NULL, 10);
         } else if (argv[i][0] != '-') {
             n = atoi(argv[i]);
             if (n < 1) n = 1;
         }
     }
 
-    int *adj_g = NULL, *adj_h = NULL;
-    int n_g = 0, n_h = 0;
-
-    if (load_graphs(file_path, &n_g, &adj_g, &n_h, &adj_h) != 0) {
+    if (print_stats && !search_stats_enabled()) {
+        fprintf(stderr, "Error: --stats needs a build configured with -DAAC_STATS=ON\n");
         return 1;
     }
+    if (print_stats && (batch_command || serve)) {
+        fprintf(stderr, "Error: --stats applies to single runs only\n");
+        return 1;
+    }
+    if (mem_report && serve) {
+        fprintf(stderr, "Error: --mem-report does not apply to serve\n");
+        return 1;
+    }
+    if (trace_path) {
+        trace_enable();
+        atexit(write_trace);
+    }
 
-    printf("Loaded G: %d vertices, H: %d vertices\n", n_g, n_h);
-    print_adj_matrix("G", n_g, adj_g);
-    print_adj_matrix("H", n_h, adj_h);
+    if (batch_command) {
+        BatchOptions batch = {
+            .command = batch_command,
+            .input_path = file_path,
+            .target_path = target_path,
+            .pattern_path = pattern_path,
+            .n = n,
+            .jobs = batch_jobs,
+            .format = format,
+            .joint_budget = joint_budget,
+            .approx_opts = approx_opts,
+            .cache_dir = cache_dir,
+        };
+        int rc = run_batch(&batch);
+        // After the instance lines, which own stdout
+        if (mem_report) mem_print_report(stderr);
+        return rc;
+    }
 
-    if (strcmp(command, "iso_exact") == 0) {
-        printf("\n=== Finding %d isomorphism(s) [EXACT]%s ===\n", n, interactive ? "" : " [BATCH]");
-        IsomorphismResult *result = find_isomorphisms_exact(n_g, adj_g, n_h, adj_h, n, interactive);
-        printf("\n--- Summary ---\n");
-        printf("Total isomorphisms found: %d\n", result->num_found);
-        printf("G is subgraph of H: %s\n", result->is_subgraph ? "YES" : "NO");
-        free_isomorphism_result(result);
+    // serve takes every --target, in order (file_path is the socket)
+    if (serve) {
+        const char **targets = (const char **) malloc((size_t) argc * sizeof(char *));
+        if (!targets) return 1;
+        int num_targets = 0;
+        for (int i = first_opt; i + 1 < argc; i++) {
+            if (strcmp(argv[i], "--target") == 0) targets[num_targets++] = argv[++i];
+        }
+        ServerOptions server = {
+            .socket_path = file_path,
+            .target_paths = targets,
+            .num_targets = num_targets,
+            .jobs = batch_jobs,
+            .joint_budget = joint_budget,
+            .approx_opts = approx_opts,
+            .cache_dir = cache_dir,
+        };
+        int rc = run_server(&server);
+        free(targets);
+        return rc;
+    }
 
-    } else if (strcmp(command, "iso_approx") == 0) {
-        printf("\n=== Finding %d isomorphism(s) [HEURISTIC]%s ===\n", n, interactive ? "" : " [BATCH]");
-        IsomorphismResult *result = find_isomorphisms_greedy(n_g, adj_g, n_h, adj_h, n, interactive);
-        printf("\n--- Summary ---\n");
-        printf("Total isomorphisms found: %d\n", result->num_found);
-        printf("G is subgraph of H: %s\n", result->is_subgraph ? "YES" : "NO");
-        free_isomorphism_result(result);
+    // A single graph can be converted from a file that holds only that graph
+    if (convert_out && convert_only && !target_path) target_path = file_path;
 
-    } else if (strcmp(command, "ext_exact") == 0) {
-        printf("\n=== Finding minimal extension for %d isomorphism(s) [EXACT]%s ===\n", n, interactive ? "" : " [BATCH]");
-        ExtensionResult *result = find_minimal_extension_exact(n_g, adj_g, n_h, adj_h, n, interactive);
-        printf("\n--- Summary ---\n");
-        printf("Total mappings found: %d\n", result->num_mappings);
-        printf("Total edges added: %d\n", result->total_edges_added);
-        printf("\nFinal H' adjacency matrix:\n");
-        print_matrix_highlighted(n_h, result->extended_adj_h, adj_h);
-        free_extension_result(result);
-
-    } else if (strcmp(command, "ext_approx") == 0) {
-        printf("\n=== Finding minimal extension for %d isomorphism(s) [HEURISTIC]%s ===\n", n, interactive ? "" : " [BATCH]");
-        ExtensionResult *result = find_minimal_extension_greedy(n_g, adj_g, n_h, adj_h, n, interactive);
-        printf("\n--- Summary ---\n");
-        printf("Total mappings found: %d\n", result->num_mappings);
-        printf("Total edges added: %d\n", result->total_edges_added);
-        printf("\nFinal H' adjacency matrix:\n");
-        print_matrix_highlighted(n_h, result->extended_adj_h, adj_h);
-        free_extension_result(result);
+    // Indexing needs only H: the file's last graph
+    bool index_h = strcmp(command, "index") == 0;
+    if (index_h) {
+        GraphPair target;
+        if (load_graph_pair(NULL, file_path, &target) != 0) {
+            return 1;
+        }
+        int rc = run_index(&target, convert_out, convert_sparse);
+        free_graph_pair(&target);
+        return rc;
+    }
 
-    } else {
+    GraphPair graphs;
+    trace_begin("load");
+    int loaded = load_graph_pair(file_path, target_path, &graphs);
+    trace_end("load");
+    if (loaded != 0) {
+        return 1;
+    }
+
+    if (updates_path) {
+        // Updates change individual cells, so H is kept as a matrix
+        int rc = graphs.sparse_h ? graph_pair_densify_h(&graphs) : 0;
+        if (rc == 0) rc = run_iso_update(&graphs, updates_path, format);
+        // JSON lines keep stdout to themselves
+        if (mem_report) mem_print_report(format == OUTPUT_TEXT ? stdout : stderr);
+        free_graph_pair(&graphs);
+        return rc != 0;
+    }
+
+    if (convert_out) {
+        int rc = run_convert(&graphs, convert_out, convert_only, convert_width, convert_sparse);
+        free_graph_pair(&graphs);
+        return rc;
+    }
+
+    // auto: the plan goes before everything else the run prints (stderr beside machine-readable output)
+    AacEngine engine;
+    AutoPlan plan;
+    if (auto_engine) {
+        AacInstance probe = {graphs.n_g, graphs.adj_g, graphs.n_h, graphs.adj_h, graphs.sparse_h, graphs.h_index, n};
+        AutoCalibration calibration = auto_default_calibration();
+        if (auto_plan(&probe, auto_extend, auto_budget_ms, approx_opts.threads, &calibration, &plan) != 0) {
+            free_graph_pair(&graphs);
+            return 1;
+        }
+        auto_plan_print(format == OUTPUT_TEXT ? stdout : stderr, &plan);
+        if (format == OUTPUT_TEXT) printf("\n");
+        engine = plan.engine;
+        command = aac_engine_name(engine);
+    } else if (!aac_parse_engine(command, &engine)) {
         fprintf(stderr, "Error: Unknown command '%s'\n\n", command);
         print_usage(argv[0]);
-        free(adj_g);
-        free(adj_h);
+        free_graph_pair(&graphs);
+        return 1;
+    }
+
+    // Only the heuristics run on a sparse H; the other engines get a dense copy
+    // (expanded here rather than in the context so the summary can highlight against it)
+    if (graphs.sparse_h && !aac_engine_runs_on_sparse(engine) && graph_pair_densify_h(&graphs) != 0) {
+        free_graph_pair(&graphs);
+        return 1;
+    }
+
+    const int n_g = graphs.n_g, n_h = graphs.n_h;
+    const int *adj_g = graphs.adj_g, *adj_h = graphs.adj_h;
+    const SparseGraph *sparse_h = graphs.sparse_h;
+    const HIndex *h_index = graphs.h_index;
+
+    // Text output renders matrices and progress; the other formats only collect
+    // per-mapping figures, and "none" not even those
+    bool text = format == OUTPUT_TEXT;
+    StatsCollector collector;
+    stats_collector_init(&collector);
+
+    AacOptions opts = aac_default_options(engine);
+    opts.n = n;
+    opts.interactive = interactive;
+    opts.joint_budget = joint_budget;
+    opts.approx = approx_opts;
+    opts.cache_dir = cache_dir;
+    if (auto_engine) auto_plan_apply(&plan, &opts);
+    if (text) opts.reporter = *console_reporter();
+    else if (format != OUTPUT_NONE) opts.reporter = collector.reporter;
+
+    AacContext *ctx = aac_create(&opts);
+    if (!ctx || aac_set_target(ctx, n_h, adj_h, sparse_h, h_index) != 0) {
+        aac_destroy(ctx);
+        stats_collector_free(&collector);
+        free_graph_pair(&graphs);
+        return 1;
+    }
+
+    if (text) {
+        trace_begin("print_graphs");
+        printf("Loaded G: %d vertices, H: %d vertices\n", n_g, n_h);
+        print_adj_matrix("G", n_g, adj_g);
+        if (sparse_h) {
+            print_sparse_summary("H", sparse_h);
+        } else {
+            print_adj_matrix("H", n_h, adj_h);
+        }
+
+        static const char *const titles[] = {
+            [AAC_ISO_EXACT] = "%d isomorphism(s) [EXACT]",
+            [AAC_ISO_APPROX] = "%d isomorphism(s) [HEURISTIC]",
+            [AAC_EXT_EXACT] = "minimal extension for %d isomorphism(s) [EXACT]",
+            [AAC_EXT_APPROX] = "minimal extension for %d isomorphism(s) [HEURISTIC]",
+            [AAC_EXT_JOINT] = "jointly minimal extension for %d isomorphism(s) [JOINT]",
+        };
+        printf("\n=== Finding ");
+        printf(titles[engine], n);
+        // ext_joint never prompts, so it carries no [BATCH] tag
+        printf("%s ===\n", interactive || engine == AAC_EXT_JOINT ? "" : " [BATCH]");
+        trace_end("print_graphs");
+    }
+
+    AacInstance instance = {.n_g = n_g, .adj_g = adj_g};
+    collector.start_ms = now_ms();
+    AacResult *result = aac_solve(ctx, &instance);
+    if (!result) {
+        aac_destroy(ctx);
+        stats_collector_free(&collector);
+        free_graph_pair(&graphs);
         return 1;
     }
 
-    free(adj_g);
-    free(adj_h);
+    trace_begin("print_summary");
+    if (text) {
+        printf("\n--- Summary ---\n");
+        if (result->iso) {
+            printf("Total isomorphisms found: %d\n", result->iso->num_found);
+            printf("G is subgraph of H: %s\n", result->iso->is_subgraph ? "YES" : "NO");
+        } else {
+            printf("Total mappings found: %d\n", result->ext->num_mappings);
+            printf("Total edges added: %d\n", result->ext->total_edges_added);
+            if (engine == AAC_EXT_JOINT) printf("Proven optimal: %s\n", result->joint.optimal ? "YES" : "NO");
+            if (result->ext->extended_sparse_h) {
+                printf("\nEdges added to H':\n");
+                print_sparse_changes(result->ext->extended_sparse_h, sparse_h);
+            } else {
+                printf("\nFinal H' adjacency matrix:\n");
+                print_matrix_highlighted(n_h, result->ext->extended_adj_h, adj_h);
+            }
+        }
+    } else if (format != OUTPUT_NONE) {
+        RunSummary summary = {
+            .command = command,
+            .n_g = n_g,
+            .n_h = n_h,
+            .extension = result->ext != NULL,
+            .is_subgraph = result->iso && result->iso->is_subgraph,
+            .edges_added = result->ext ? result->ext->total_edges_added : 0,
+            .optimal = engine == AAC_EXT_JOINT ? result->joint.optimal : -1,
+            .time_ms = result->time_ms,
+            .mappings = result->mappings,
+            .num_mappings = result->num_mappings,
+            .stats = collector.stats,
+            .num_stats = collector.count
+        };
+        write_summary(format, &summary);
+    }
+    trace_end("print_summary");
+
+    // Machine-readable formats keep stdout to themselves
+    if (print_stats) print_search_stats(text ? stdout : stderr, result);
+    if (mem_report) mem_print_report(text ? stdout : stderr);
+
+    aac_free_result(result);
+    aac_destroy(ctx);
+    stats_collector_free(&collector);
+    free_graph_pair(&graphs);
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,140 @@
+#include "mem_track.h"
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Size and owner of a block, in front of the bytes handed out (keeps their alignment)
+typedef union {
+    struct {
+        size_t size;
+        MemSubsystem subsystem;
+    } info;
+    max_align_t align;
+} BlockHeader;
+
+static atomic_size_t current[MEM_NUM_SUBSYSTEMS];
+static atomic_size_t peak[MEM_NUM_SUBSYSTEMS];
+static atomic_size_t total_current = 0;
+static atomic_size_t total_peak = 0;
+static atomic_size_t limit = 0;
+
+static const char *const subsystem_names[MEM_NUM_SUBSYSTEMS] = {
+    [MEM_GRAPH] = "graphs",
+    [MEM_PRODUCT] = "product graph",
+    [MEM_RESULTS] = "results",
+    [MEM_EXTENSION] = "extension engines",
+};
+
+static void raise_peak(atomic_size_t *p, size_t value) {
+    size_t seen = atomic_load(p);
+    while (value > seen && !atomic_compare_exchange_weak(p, &seen, value)) {
+    }
+}
+
+// Count size more bytes for subsystem, or refuse if they would pass the limit
+static bool reserve(MemSubsystem subsystem, size_t size) {
+    size_t before = atomic_fetch_add(&total_current, size);
+    size_t cap = atomic_load(&limit);
+    if (cap > 0 && (before + size < before || before + size > cap)) {
+        atomic_fetch_sub(&total_current, size);
+        return false;
+    }
+    raise_peak(&total_peak, before + size);
+    size_t now = atomic_fetch_add(&current[subsystem], size) + size;
+    raise_peak(&peak[subsystem], now);
+    return true;
+}
+
+static void release(MemSubsystem subsystem, size_t size) {
+    atomic_fetch_sub(&current[subsystem], size);
+    atomic_fetch_sub(&total_current, size);
+}
+
+void *mem_alloc(MemSubsystem subsystem, size_t size) {
+    if (size > SIZE_MAX - sizeof(BlockHeader) || !reserve(subsystem, size)) return NULL;
+    BlockHeader *h = (BlockHeader *) malloc(sizeof(BlockHeader) + size);
+    if (!h) {
+        release(subsystem, size);
+        return NULL;
+    }
+    h->info.size = size;
+    h->info.subsystem = subsystem;
+    return h + 1;
+}
+
+void *mem_calloc(MemSubsystem subsystem, size_t count, size_t size) {
+    if (size > 0 && count > SIZE_MAX / size) return NULL;
+    void *p = mem_alloc(subsystem, count * size);
+    if (p) memset(p, 0, count * size);
+    return p;
+}
+
+void *mem_realloc(MemSubsystem subsystem, void *ptr, size_t size) {
+    if (!ptr) return mem_alloc(subsystem, size);
+    BlockHeader *h = (BlockHeader *) ptr - 1;
+    size_t old_size = h->info.size;
+    MemSubsystem owner = h->info.subsystem;
+    if (size > SIZE_MAX - sizeof(BlockHeader)) return NULL;
+
+    // Count a growth before making it, a shrink after
+    if (size > old_size && !reserve(owner, size - old_size)) return NULL;
+    BlockHeader *grown = (BlockHeader *) realloc(h, sizeof(BlockHeader) + size);
+    if (!grown) {
+        if (size > old_size) release(owner, size - old_size);
+        return NULL;
+    }
+    if (size < old_size) release(owner, old_size - size);
+    grown->info.size = size;
+    return grown + 1;
+}
+
+void mem_free(void *ptr) {
+    if (!ptr) return;
+    BlockHeader *h = (BlockHeader *) ptr - 1;
+    release(h->info.subsystem, h->info.size);
+    free(h);
+}
+
+void mem_set_limit(size_t bytes) {
+    atomic_store(&limit, bytes);
+}
+
+size_t mem_get_limit(void) {
+    return atomic_load(&limit);
+}
+
+bool mem_fits(size_t size) {
+    size_t cap = atomic_load(&limit);
+    size_t used = atomic_load(&total_current);
+    return cap == 0 || (used <= cap && size <= cap - used);
+}
+
+MemUsage mem_usage(MemSubsystem subsystem) {
+    return (MemUsage) {atomic_load(&current[subsystem]), atomic_load(&peak[subsystem])};
+}
+
+MemUsage mem_usage_total(void) {
+    return (MemUsage) {atomic_load(&total_current), atomic_load(&total_peak)};
+}
+
+const char *mem_subsystem_name(MemSubsystem subsystem) {
+    return (int) subsystem >= 0 && subsystem < MEM_NUM_SUBSYSTEMS ? subsystem_names[subsystem] : "unknown";
+}
+
+static double to_mb(size_t bytes) {
+    return (double) bytes / (1024.0 * 1024.0);
+}
+
+void mem_print_report(FILE *f) {
+    fprintf(f, "\n--- Memory Usage ---\n");
+    fprintf(f, "%-18s %12s %12s\n", "subsystem", "current MB", "peak MB");
+    for (int s = 0; s < MEM_NUM_SUBSYSTEMS; s++) {
+        MemUsage u = mem_usage((MemSubsystem) s);
+        fprintf(f, "%-18s %12.3f %12.3f\n", subsystem_names[s], to_mb(u.current), to_mb(u.peak));
+    }
+    MemUsage total = mem_usage_total();
+    fprintf(f, "%-18s %12.3f %12.3f\n", "total", to_mb(total.current), to_mb(total.peak));
+    size_t cap = mem_get_limit();
+    if (cap > 0) fprintf(f, "Limit: %.3f MB\n", to_mb(cap));
+}
@@ -0,0 +1,75 @@
+#ifndef AAC_MEM_TRACK_H
+#define AAC_MEM_TRACK_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+/**
+ * Tracked allocation for the large buffers of libaac.
+ *
+ * Every block records its size and the subsystem that asked for it, so the
+ * current and peak bytes of each subsystem can be reported, and an optional
+ * process-wide limit makes allocations beyond it fail (return NULL) instead of
+ * exhausting the machine. Blocks from mem_alloc / mem_calloc / mem_realloc
+ * must be released with mem_free, never with free (and the other way round).
+ * The counters are atomic: allocating threads need no locking.
+ */
+
+typedef enum {
+    MEM_GRAPH,     // Loaded graphs: matrices, edge lists, CSR copies
+    MEM_PRODUCT,   // iso_exact product graph
+    MEM_RESULTS,   // Result containers and the mappings they hold
+    MEM_EXTENSION, // Working storage of the extension engines
+    MEM_NUM_SUBSYSTEMS
+} MemSubsystem;
+
+typedef struct {
+    size_t current; // Bytes allocated now
+    size_t peak;    // Most bytes allocated at once
+} MemUsage;
+
+void *mem_alloc(MemSubsystem subsystem, size_t size);
+
+/**
+ * Zeroed array of count elements (NULL if count * size overflows)
+ */
+void *mem_calloc(MemSubsystem subsystem, size_t count, size_t size);
+
+/**
+ * Resize a block from mem_alloc (ptr NULL = allocate). On failure the old
+ * block is left untouched and NULL is returned.
+ */
+void *mem_realloc(MemSubsystem subsystem, void *ptr, size_t size);
+
+void mem_free(void *ptr);
+
+/**
+ * Cap the bytes allocated by all subsystems together (0 = no limit, the default)
+ */
+void mem_set_limit(size_t bytes);
+
+size_t mem_get_limit(void);
+
+/**
+ * True if size more bytes could be allocated now without passing the limit.
+ * For choosing a smaller representation up front; the allocation itself can
+ * still fail if other threads allocate in between.
+ */
+bool mem_fits(size_t size);
+
+MemUsage mem_usage(MemSubsystem subsystem);
+
+/**
+ * All subsystems together (the peak is that of the total, not a sum of peaks)
+ */
+MemUsage mem_usage_total(void);
+
+const char *mem_subsystem_name(MemSubsystem subsystem);
+
+/**
+ * Print current and peak bytes per subsystem, and the limit if one is set
+ */
+void mem_print_report(FILE *f);
+
+#endif //AAC_MEM_TRACK_H
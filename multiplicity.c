@@ -0,0 +1,44 @@
+#include "multiplicity.h"
+#include <stdlib.h>
+#include <stdint.h>
+
+MultWidth mult_width_for(int max_value) {
+    if (max_value <= UINT8_MAX) return MULT_WIDTH_8;
+    if (max_value <= UINT16_MAX) return MULT_WIDTH_16;
+    return MULT_WIDTH_32;
+}
+
+int mult_max_value(const int *adj, size_t cells) {
+    int max_value = 0, min_value = 0;
+    for (size_t c = 0; c < cells; c++) {
+        if (adj[c] > max_value) max_value = adj[c];
+        if (adj[c] < min_value) min_value = adj[c];
+    }
+    return min_value < 0 ? -1 : max_value;
+}
+
+int mult_matrix_init(MultMatrix *m, int n, const int *adj, int max_extra) {
+    size_t cells = (size_t) n * n;
+    int max_value = mult_max_value(adj, cells);
+    if (max_value < 0) {
+        m->cells = NULL;
+        return MULT_NEGATIVE;
+    }
+    if (max_extra > max_value) max_value = max_extra;
+
+    m->n = n;
+    m->width = mult_width_for(max_value);
+    m->cells = malloc((cells > 0 ? cells : 1) * (size_t) m->width);
+    if (!m->cells) return -1;
+
+    MULT_DISPATCH(m, cell_t,
+        cell_t *dst = (cell_t *) m->cells;
+        for (size_t c = 0; c < cells; c++) dst[c] = (cell_t) adj[c];
+    )
+    return 0;
+}
+
+void mult_matrix_free(MultMatrix *m) {
+    free(m->cells);
+    m->cells = NULL;
+}
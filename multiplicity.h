@@ -0,0 +1,88 @@
+#ifndef AAC_MULTIPLICITY_H
+#define AAC_MULTIPLICITY_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Bytes per cell of a MultMatrix
+ */
+typedef enum {
+    MULT_WIDTH_8 = 1,
+    MULT_WIDTH_16 = 2,
+    MULT_WIDTH_32 = 4
+} MultWidth;
+
+/**
+ * Square multiplicity matrix stored with the narrowest cell type that holds
+ * every value it will ever contain (uint8_t for almost all inputs), so hot
+ * loops over H move a quarter of the bytes of an int matrix.
+ */
+typedef struct {
+    int n;
+    MultWidth width;
+    void *cells; // n x n, row-major
+} MultMatrix;
+
+/**
+ * Narrowest width that can store values in [0, max_value]
+ */
+MultWidth mult_width_for(int max_value);
+
+// mult_matrix_init result for a matrix with a negative cell
+#define MULT_NEGATIVE (-2)
+
+/**
+ * Largest value in a flattened int matrix (0 if empty), or -1 if any value is
+ * negative
+ */
+int mult_max_value(const int *adj, size_t cells);
+
+/**
+ * Copy an int matrix into m, using the narrowest width that holds both its
+ * values and max_extra (the largest value that will be written later).
+ * Negative cells are refused rather than wrapped into the unsigned widths.
+ *
+ * @return 0 on success, -1 on allocation failure, MULT_NEGATIVE if a cell is negative
+ */
+int mult_matrix_init(MultMatrix *m, int n, const int *adj, int max_extra);
+
+void mult_matrix_free(MultMatrix *m);
+
+/**
+ * Run the statement list with T defined as the cell type of m. Lets a hot loop
+ * be written once and compiled for each width, with the width switch outside
+ * the loop.
+ */
+#define MULT_DISPATCH(m, T, ...)                                         \
+    switch ((m)->width) {                                                \
+        case MULT_WIDTH_8: { typedef uint8_t T; __VA_ARGS__ } break;     \
+        case MULT_WIDTH_16: { typedef uint16_t T; __VA_ARGS__ } break;   \
+        default: { typedef int32_t T; __VA_ARGS__ } break;               \
+    }
+
+/**
+ * Cell (i, j); for code outside the hot loops
+ */
+static inline int mult_at(const MultMatrix *m, int i, int j) {
+    size_t idx = (size_t) i * m->n + j;
+    switch (m->width) {
+        case MULT_WIDTH_8: return ((const uint8_t *) m->cells)[idx];
+        case MULT_WIDTH_16: return ((const uint16_t *) m->cells)[idx];
+        default: return ((const int32_t *) m->cells)[idx];
+    }
+}
+
+/**
+ * Set cell (i, j); value must fit the width chosen at init
+ */
+static inline void mult_set(MultMatrix *m, int i, int j, int value) {
+    size_t idx = (size_t) i * m->n + j;
+    switch (m->width) {
+        case MULT_WIDTH_8: ((uint8_t *) m->cells)[idx] = (uint8_t) value; break;
+        case MULT_WIDTH_16: ((uint16_t *) m->cells)[idx] = (uint16_t) value; break;
+        default: ((int32_t *) m->cells)[idx] = value; break;
+    }
+}
+
+#endif //AAC_MULTIPLICITY_H
@@ -0,0 +1,269 @@
+#include "output.h"
+#include "utils.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Bytes buffered before a file writer writes them out
+#define OUT_FILE_BUFFER (64 * 1024)
+
+bool parse_output_format(const char *name, OutputFormat *format) {
+    static const struct {
+        const char *name;
+        OutputFormat format;
+    } formats[] = {
+        {"text", OUTPUT_TEXT},
+        {"json", OUTPUT_JSON},
+        {"csv", OUTPUT_CSV},
+        {"none", OUTPUT_NONE},
+    };
+    for (size_t k = 0; k < sizeof(formats) / sizeof(formats[0]); k++) {
+        if (strcmp(name, formats[k].name) == 0) {
+            *format = formats[k].format;
+            return true;
+        }
+    }
+    return false;
+}
+
+// ============================================================================
+// Buffered Writer
+// ============================================================================
+
+void out_init(OutWriter *w, FILE *file) {
+    w->file = file;
+    w->len = 0;
+    w->cap = file ? OUT_FILE_BUFFER : 0;
+    w->buf = file ? (char *) malloc(w->cap) : NULL;
+    if (!w->buf) w->cap = 0;
+}
+
+void out_flush(OutWriter *w) {
+    if (!w->file) return;
+    if (w->len > 0) fwrite(w->buf, 1, w->len, w->file);
+    w->len = 0;
+    fflush(w->file);
+}
+
+void out_free(OutWriter *w) {
+    out_flush(w);
+    free(w->buf);
+    w->buf = NULL;
+    w->len = w->cap = 0;
+}
+
+void out_write(OutWriter *w, const char *data, size_t len) {
+    if (len == 0) return;
+    if (w->len + len <= w->cap) {
+        memcpy(w->buf + w->len, data, len);
+        w->len += len;
+        return;
+    }
+
+    if (w->file) {
+        // Unbuffered fallback if the buffer could not be allocated or the data is larger
+        if (w->len > 0) fwrite(w->buf, 1, w->len, w->file);
+        w->len = 0;
+        if (len <= w->cap) {
+            memcpy(w->buf, data, len);
+            w->len = len;
+        } else {
+            fwrite(data, 1, len, w->file);
+        }
+        return;
+    }
+
+    size_t cap = w->cap ? w->cap : 128;
+    while (w->len + len > cap) cap *= 2;
+    char *grown = (char *) realloc(w->buf, cap);
+    if (!grown) return;
+    w->buf = grown;
+    w->cap = cap;
+    memcpy(w->buf + w->len, data, len);
+    w->len += len;
+}
+
+void out_str(OutWriter *w, const char *s) {
+    out_write(w, s, strlen(s));
+}
+
+void out_char(OutWriter *w, char c) {
+    out_write(w, &c, 1);
+}
+
+void out_int(OutWriter *w, long long value) {
+    char digits[24];
+    int pos = (int) sizeof(digits);
+    unsigned long long magnitude = value < 0 ? 0ULL - (unsigned long long) value : (unsigned long long) value;
+    do {
+        digits[--pos] = (char) ('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude > 0);
+    if (value < 0) digits[--pos] = '-';
+    out_write(w, digits + pos, sizeof(digits) - (size_t) pos);
+}
+
+void out_ms(OutWriter *w, double ms) {
+    if (ms < 0) ms = 0;
+    long long thousandths = (long long) (ms * 1000.0 + 0.5);
+    out_int(w, thousandths / 1000);
+    char frac[4] = {
+        '.',
+        (char) ('0' + thousandths / 100 % 10),
+        (char) ('0' + thousandths / 10 % 10),
+        (char) ('0' + thousandths % 10)
+    };
+    out_write(w, frac, sizeof(frac));
+}
+
+// ============================================================================
+// Statistics Collector
+// ============================================================================
+
+static void collect_mapping(void *ctx, const MappingReport *m) {
+    StatsCollector *c = (StatsCollector *) ctx;
+    if (c->count == c->cap) {
+        int cap = c->cap ? c->cap * 2 : 16;
+        MappingStats *grown = (MappingStats *) realloc(c->stats, (size_t) cap * sizeof(MappingStats));
+        if (!grown) return;
+        c->stats = grown;
+        c->cap = cap;
+    }
+    c->stats[c->count++] = (MappingStats) {
+        .deficit = m->deficit,
+        .edges_added = m->edges_added,
+        .time_ms = now_ms() - c->start_ms
+    };
+}
+
+void stats_collector_init(StatsCollector *c) {
+    memset(c, 0, sizeof(*c));
+    c->reporter.ctx = c;
+    c->reporter.mapping = collect_mapping;
+    c->start_ms = now_ms();
+}
+
+void stats_collector_free(StatsCollector *c) {
+    free(c->stats);
+    c->stats = NULL;
+    c->count = c->cap = 0;
+}
+
+// ============================================================================
+// Summary Writers
+// ============================================================================
+
+static void out_bool_json(OutWriter *w, bool value) {
+    out_str(w, value ? "true" : "false");
+}
+
+void write_summary_json(OutWriter *w, const RunSummary *s) {
+    out_char(w, '{');
+    if (s->instance > 0) {
+        out_str(w, "\"instance\":");
+        out_int(w, s->instance);
+        out_char(w, ',');
+    }
+    out_str(w, "\"command\":\"");
+    out_str(w, s->command);
+    out_str(w, "\",\"n_g\":");
+    out_int(w, s->n_g);
+    out_str(w, ",\"n_h\":");
+    out_int(w, s->n_h);
+    out_str(w, ",\"found\":");
+    out_int(w, s->num_mappings);
+    if (s->extension) {
+        out_str(w, ",\"edges_added\":");
+        out_int(w, s->edges_added);
+    } else {
+        out_str(w, ",\"subgraph\":");
+        out_bool_json(w, s->is_subgraph);
+    }
+    if (s->screened) {
+        out_str(w, ",\"screened\":\"");
+        out_str(w, s->screened);
+        out_char(w, '"');
+    }
+    if (s->optimal >= 0) {
+        out_str(w, ",\"optimal\":");
+        out_bool_json(w, s->optimal != 0);
+    }
+    out_str(w, ",\"time_ms\":");
+    out_ms(w, s->time_ms);
+
+    out_str(w, ",\"mappings\":[");
+    for (int k = 0; k < s->num_mappings; k++) {
+        if (k > 0) out_char(w, ',');
+        out_str(w, "{\"index\":");
+        out_int(w, k + 1);
+        if (s->stats && k < s->num_stats) {
+            if (s->extension) {
+                out_str(w, ",\"deficit\":");
+                out_int(w, s->stats[k].deficit);
+                out_str(w, ",\"edges_added\":");
+                out_int(w, s->stats[k].edges_added);
+            }
+            out_str(w, ",\"time_ms\":");
+            out_ms(w, s->stats[k].time_ms);
+        }
+        out_str(w, ",\"mapping\":[");
+        for (int v = 0; v < s->n_g; v++) {
+            if (v > 0) out_char(w, ',');
+            out_int(w, s->mappings[k][v] + 1);
+        }
+        out_str(w, "]}");
+    }
+    out_str(w, "]}\n");
+}
+
+void write_csv_header(OutWriter *w) {
+    out_str(w, "instance,command,n_g,n_h,found,subgraph,edges_added,optimal,time_ms,"
+               "index,deficit,mapping_edges_added,mapping_time_ms,mapping\n");
+}
+
+// Run columns, shared by every row of the run
+static void write_csv_run(OutWriter *w, const RunSummary *s) {
+    out_int(w, s->instance);
+    out_char(w, ',');
+    out_str(w, s->command);
+    out_char(w, ',');
+    out_int(w, s->n_g);
+    out_char(w, ',');
+    out_int(w, s->n_h);
+    out_char(w, ',');
+    out_int(w, s->num_mappings);
+    out_char(w, ',');
+    if (!s->extension) out_str(w, s->is_subgraph ? "YES" : "NO");
+    out_char(w, ',');
+    if (s->extension) out_int(w, s->edges_added);
+    out_char(w, ',');
+    if (s->optimal >= 0) out_str(w, s->optimal ? "YES" : "NO");
+    out_char(w, ',');
+    out_ms(w, s->time_ms);
+    out_char(w, ',');
+}
+
+void write_summary_csv(OutWriter *w, const RunSummary *s) {
+    if (s->num_mappings == 0) {
+        write_csv_run(w, s);
+        out_str(w, ",,,,\n");
+        return;
+    }
+    for (int k = 0; k < s->num_mappings; k++) {
+        write_csv_run(w, s);
+        out_int(w, k + 1);
+        out_char(w, ',');
+        bool has_stats = s->stats && k < s->num_stats;
+        if (has_stats && s->extension) out_int(w, s->stats[k].deficit);
+        out_char(w, ',');
+        if (has_stats && s->extension) out_int(w, s->stats[k].edges_added);
+        out_char(w, ',');
+        if (has_stats) out_ms(w, s->stats[k].time_ms);
+        out_char(w, ',');
+        // H vertex (1-based) of each G vertex, space-separated to stay one field
+        for (int v = 0; v < s->n_g; v++) {
+            if (v > 0) out_char(w, ' ');
+            out_int(w, s->mappings[k][v] + 1);
+        }
+        out_char(w, '\n');
+    }
+}
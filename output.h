@@ -0,0 +1,132 @@
+#ifndef AAC_OUTPUT_H
+#define AAC_OUTPUT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include "report.h"
+
+/**
+ * How results are written
+ */
+typedef enum {
+    OUTPUT_TEXT, // Human-readable progress with matrices (single runs) or key=value lines (batch)
+    OUTPUT_JSON, // One JSON object per run (JSON Lines in batch mode)
+    OUTPUT_CSV,  // One row per mapping, header first
+    OUTPUT_NONE  // Nothing; only the exit code
+} OutputFormat;
+
+/**
+ * Parse "text", "json", "csv" or "none". Returns false for anything else.
+ */
+bool parse_output_format(const char *name, OutputFormat *format);
+
+// ============================================================================
+// Buffered Writer
+// ============================================================================
+
+/**
+ * Append-only output buffer. With a file it is written out whenever it fills
+ * up and on out_flush; without one it grows and keeps everything in memory
+ * (used to build batch records on worker threads).
+ */
+typedef struct {
+    FILE *file;
+    char *buf;
+    size_t len, cap;
+} OutWriter;
+
+/**
+ * Start a writer on file, or an in-memory writer if file is NULL
+ */
+void out_init(OutWriter *w, FILE *file);
+
+void out_write(OutWriter *w, const char *data, size_t len);
+
+void out_str(OutWriter *w, const char *s);
+
+void out_char(OutWriter *w, char c);
+
+void out_int(OutWriter *w, long long value);
+
+/**
+ * Milliseconds with three decimals
+ */
+void out_ms(OutWriter *w, double ms);
+
+/**
+ * Write buffered bytes to the file (no-op for in-memory writers)
+ */
+void out_flush(OutWriter *w);
+
+/**
+ * Flush and release the buffer
+ */
+void out_free(OutWriter *w);
+
+// ============================================================================
+// Run Summaries
+// ============================================================================
+
+/**
+ * Per-mapping figures gathered from engine reports
+ */
+typedef struct {
+    int deficit;
+    int edges_added;
+    double time_ms; // Time since the run started when the mapping was reported
+} MappingStats;
+
+/**
+ * Reporter that records MappingStats for each reported mapping and formats
+ * nothing. Notes and prompts are dropped, so interactive searches stop at n.
+ */
+typedef struct {
+    Reporter reporter;
+    double start_ms;
+    MappingStats *stats;
+    int count, cap;
+} StatsCollector;
+
+/**
+ * Start collecting; the clock for MappingStats.time_ms starts now
+ */
+void stats_collector_init(StatsCollector *c);
+
+void stats_collector_free(StatsCollector *c);
+
+/**
+ * Everything the machine-readable formats print for one run
+ */
+typedef struct {
+    int instance;              // Batch instance number, 0 for a single run
+    const char *command;
+    int n_g, n_h;
+    bool extension;            // Extension commands report edges_added instead of subgraph
+    bool is_subgraph;
+    int edges_added;
+    int optimal;               // ext_joint: 1 or 0; -1 = not applicable
+    double time_ms;
+    int *const *mappings;
+    int num_mappings;
+    const MappingStats *stats; // Per-mapping figures, or NULL
+    int num_stats;
+    const char *screened;      // Fingerprint check that ruled H out without a search, or NULL
+} RunSummary;
+
+/**
+ * Write the run as one JSON object followed by a newline
+ */
+void write_summary_json(OutWriter *w, const RunSummary *s);
+
+/**
+ * Write the CSV header line
+ */
+void write_csv_header(OutWriter *w);
+
+/**
+ * Write one CSV row per mapping (one row with empty mapping columns if there are none)
+ */
+void write_summary_csv(OutWriter *w, const RunSummary *s);
+
+#endif //AAC_OUTPUT_H
@@ -0,0 +1,13 @@
+#include "report.h"
+
+void report_note(const Reporter *rep, const char *fmt, ...) {
+    if (!rep || !rep->note) return;
+    va_list ap;
+    va_start(ap, fmt);
+    rep->note(rep->ctx, fmt, ap);
+    va_end(ap);
+}
+
+bool report_confirm(const Reporter *rep, const char *question) {
+    return rep && rep->confirm && rep->confirm(rep->ctx, question);
+}
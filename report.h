@@ -0,0 +1,74 @@
+#ifndef AAC_REPORT_H
+#define AAC_REPORT_H
+
+#include <stdarg.h>
+#include <stdbool.h>
+#include "sparse_graph.h"
+#include "trace.h"
+
+/**
+ * What a reported mapping is
+ */
+typedef enum {
+    REPORT_ISOMORPHISM, // A new subgraph isomorphism
+    REPORT_EXTENSION,   // One round of an iterative extension and the edges it added
+    REPORT_JOINT        // One mapping of a jointly minimal set (reported after the search)
+} ReportKind;
+
+/**
+ * One mapping found by an engine, with what a renderer needs to show it.
+ * Pointers are only valid during the callback.
+ */
+typedef struct {
+    ReportKind kind;
+    int index;                // 1-based number of the mapping
+    const int *mapping;       // mapping[v] = u, n_g entries
+    int n_g, n_h;
+    const int *adj_g;
+    const int *adj_h;         // H (isomorphism) or H' after this mapping; NULL for a sparse H
+    const int *prev_adj_h;    // H' before this round (extension), H (joint), else NULL
+    int deficit;              // Extension: multiplicity the mapping was missing (joint: from H)
+    int edges_added;          // Extension: edges added for this mapping (joint: not already
+                              // added for an earlier mapping of the set)
+    const SparseEdge *raised; // Sparse H': cells raised this round, with their new multiplicity
+    const int *raised_old;    // Sparse H': multiplicity of those cells before the round
+    int num_raised;
+    const char *strategy;     // Portfolio strategy that produced the mapping, or NULL
+} MappingReport;
+
+/**
+ * Receiver for engine progress. Engines do no output of their own: every
+ * mapping, progress note and continue prompt goes through these callbacks.
+ * Any callback may be NULL, and a NULL Reporter is silent. Notes are only
+ * formatted when a note callback is present.
+ */
+typedef struct {
+    void *ctx;
+    void (*mapping)(void *ctx, const MappingReport *m);
+    void (*note)(void *ctx, const char *fmt, va_list ap);
+    bool (*confirm)(void *ctx, const char *question); // true = keep searching
+} Reporter;
+
+static inline bool report_wants_mappings(const Reporter *rep) {
+    return rep && rep->mapping;
+}
+
+static inline void report_mapping(const Reporter *rep, const MappingReport *m) {
+    if (rep && rep->mapping) {
+        trace_begin("report_mapping");
+        rep->mapping(rep->ctx, m);
+        trace_end("report_mapping");
+    }
+}
+
+/**
+ * Pass a printf-style progress line to the reporter
+ */
+void report_note(const Reporter *rep, const char *fmt, ...);
+
+/**
+ * Ask whether to continue after the requested results were found (false without a confirm callback)
+ */
+bool report_confirm(const Reporter *rep, const char *question);
+
+#endif //AAC_REPORT_H
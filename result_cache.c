@@ -0,0 +1,147 @@
+#include "result_cache.h"
+#include "mem_track.h"
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <process.h>
+#define process_id() _getpid()
+#else
+#include <unistd.h>
+#define process_id() getpid()
+#endif
+
+#define RESULT_CACHE_MAGIC "aac-result 1"
+
+// Distinguishes temporary files of concurrent stores within one process
+static atomic_uint store_counter = 0;
+
+// ============================================================================
+// Entry Files
+// ============================================================================
+
+static void entry_path(char *path, size_t size, const char *dir, const char *command, int n,
+                       const CanonicalForm *g, const CanonicalForm *h) {
+    uint64_t key = 1469598103934665603ull; // FNV-1a over the whole key
+    const uint64_t parts[3] = {g->hash, h->hash, (uint64_t) n};
+    for (int k = 0; k < 3; k++) key = (key ^ parts[k]) * 1099511628211ull;
+    for (const char *p = command; *p; p++) key = (key ^ (unsigned char) *p) * 1099511628211ull;
+    snprintf(path, size, "%s/%016llx.aacr", dir, (unsigned long long) key);
+}
+
+static void write_form(FILE *f, char name, const CanonicalForm *form) {
+    fprintf(f, "%c %d %d\n", name, form->n, form->num_edges);
+    for (int e = 0; e < form->num_edges; e++) {
+        fprintf(f, "%d %d %d\n", form->edges[3 * e], form->edges[3 * e + 1], form->edges[3 * e + 2]);
+    }
+}
+
+// True if the file holds exactly this form next
+static bool read_form_matches(FILE *f, char name, const CanonicalForm *form) {
+    char got;
+    int n, num_edges;
+    if (fscanf(f, " %c %d %d", &got, &n, &num_edges) != 3) return false;
+    if (got != name || n != form->n || num_edges != form->num_edges) return false;
+    for (int k = 0; k < 3 * num_edges; k++) {
+        int value;
+        if (fscanf(f, "%d", &value) != 1 || value != form->edges[k]) return false;
+    }
+    return true;
+}
+
+// ============================================================================
+// Public API
+// ============================================================================
+
+int result_cache_lookup(const char *dir, const char *command, int n,
+                        const CanonicalForm *g, const CanonicalForm *h, int ***mappings, int *count) {
+    *mappings = NULL;
+    *count = 0;
+    char path[4096];
+    entry_path(path, sizeof(path), dir, command, n, g, h);
+    FILE *f = fopen(path, "r");
+    if (!f) return 0;
+
+    // The key is a hash: the entry only counts if it was stored for this very query
+    char magic[sizeof(RESULT_CACHE_MAGIC)];
+    char stored_command[32];
+    int stored_n, num_mappings;
+    bool match = fgets(magic, sizeof(magic), f) && strcmp(magic, RESULT_CACHE_MAGIC) == 0 &&
+                 fscanf(f, " %31s %d", stored_command, &stored_n) == 2 &&
+                 strcmp(stored_command, command) == 0 && stored_n == n &&
+                 read_form_matches(f, 'G', g) && read_form_matches(f, 'H', h) &&
+                 fscanf(f, " mappings %d", &num_mappings) == 1 && num_mappings >= 0;
+    if (!match) {
+        fclose(f);
+        return 0;
+    }
+
+    // Canonical numbers back to this query's: G_v is canonical g->label[v], and
+    // canonical H vertex c is the u with h->label[u] == c
+    int n_g = g->n, n_h = h->n;
+    int **out = (int **) mem_calloc(MEM_RESULTS, num_mappings > 0 ? (size_t) num_mappings : 1, sizeof(int *));
+    int *h_vertex = (int *) malloc((n_h > 0 ? (size_t) n_h : 1) * sizeof(int));
+    int *row = (int *) malloc((n_g > 0 ? (size_t) n_g : 1) * sizeof(int));
+    bool ok = out && h_vertex && row;
+    for (int u = 0; ok && u < n_h; u++) h_vertex[h->label[u]] = u;
+    int k = 0;
+    for (; ok && k < num_mappings; k++) {
+        for (int c = 0; c < n_g && ok; c++) ok = fscanf(f, "%d", &row[c]) == 1 && row[c] >= 0 && row[c] < n_h;
+        out[k] = ok ? (int *) mem_alloc(MEM_RESULTS, (n_g > 0 ? (size_t) n_g : 1) * sizeof(int)) : NULL;
+        if (!out[k]) {
+            ok = false;
+            break;
+        }
+        for (int v = 0; v < n_g; v++) out[k][v] = h_vertex[row[g->label[v]]];
+    }
+    fclose(f);
+    free(h_vertex);
+    free(row);
+    if (!ok) {
+        for (int j = 0; out && j < k; j++) mem_free(out[j]);
+        mem_free(out);
+        return 0;
+    }
+    *mappings = out;
+    *count = num_mappings;
+    return 1;
+}
+
+int result_cache_store(const char *dir, const char *command, int n,
+                       const CanonicalForm *g, const CanonicalForm *h, int *const *mappings, int count) {
+    char path[4096], tmp_path[4200];
+    entry_path(path, sizeof(path), dir, command, n, g, h);
+    snprintf(tmp_path, sizeof(tmp_path), "%s.%d.%u.tmp", path, (int) process_id(), atomic_fetch_add(&store_counter, 1));
+
+    FILE *f = fopen(tmp_path, "w");
+    if (!f) {
+        fprintf(stderr, "Error: cannot write result cache entry %s\n", tmp_path);
+        return -1;
+    }
+    fprintf(f, "%s\n%s %d\n", RESULT_CACHE_MAGIC, command, n);
+    write_form(f, 'G', g);
+    write_form(f, 'H', h);
+    fprintf(f, "mappings %d\n", count);
+    int *row = (int *) malloc((g->n > 0 ? (size_t) g->n : 1) * sizeof(int));
+    for (int k = 0; row && k < count; k++) {
+        // Position c of the row is canonical G vertex c
+        for (int v = 0; v < g->n; v++) row[g->label[v]] = h->label[mappings[k][v]];
+        for (int c = 0; c < g->n; c++) fprintf(f, c ? " %d" : "%d", row[c]);
+        fprintf(f, "\n");
+    }
+    bool ok = row != NULL;
+    free(row);
+    ok = fclose(f) == 0 && ok;
+
+#ifdef _WIN32
+    if (ok) remove(path);
+#endif
+    if (!ok || rename(tmp_path, path) != 0) {
+        remove(tmp_path);
+        fprintf(stderr, "Error: cannot write result cache entry %s\n", path);
+        return -1;
+    }
+    return 0;
+}
@@ -0,0 +1,35 @@
+#ifndef AAC_RESULT_CACHE_H
+#define AAC_RESULT_CACHE_H
+
+#include "canonical.h"
+
+/**
+ * On-disk store of solved queries, one file per (command, n, canonical G,
+ * canonical H) in a directory. Mappings are kept in canonical numbers, so a
+ * query that repeats an earlier one up to relabelling of G and H gets the
+ * earlier answer translated into its own vertex numbers.
+ *
+ * Files are written to a temporary name and renamed into place, so several
+ * processes and threads can share a directory.
+ */
+
+/**
+ * Look up a query
+ *
+ * @param g, h Canonical forms of the query's G and H
+ * @param mappings Receives count mappings (mappings[k][v] = H vertex of G_v) on a hit;
+ *                 the caller frees each and the array with mem_free (see mem_track.h)
+ * @return 1 on a hit, 0 on a miss (including an unreadable or colliding entry)
+ */
+int result_cache_lookup(const char *dir, const char *command, int n,
+                        const CanonicalForm *g, const CanonicalForm *h, int ***mappings, int *count);
+
+/**
+ * Store the answer to a query, replacing any entry for it
+ *
+ * @return 0 on success, -1 if the entry could not be written (described on stderr)
+ */
+int result_cache_store(const char *dir, const char *command, int n,
+                       const CanonicalForm *g, const CanonicalForm *h, int *const *mappings, int count);
+
+#endif //AAC_RESULT_CACHE_H
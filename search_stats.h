@@ -0,0 +1,56 @@
+#ifndef AAC_SEARCH_STATS_H
+#define AAC_SEARCH_STATS_H
+
+#include <stdbool.h>
+
+/**
+ * Counters describing how an engine spent its search, for choosing engines
+ * and tuning instances. The engines only count when libaac is built with
+ * AAC_STATS (CMake option AAC_STATS); otherwise the counting macros expand to
+ * nothing and every field stays zero.
+ */
+typedef struct {
+    long long product_vertices; // iso_exact: vertices of the product graph
+    long long product_edges;    // iso_exact: edges of the product graph
+    long long nodes;            // Search nodes expanded (iso_exact, ext_exact, ext_joint)
+    long long pruned;           // iso_exact: branches cut by the size bound or an incompatible candidate
+    long long leaves;           // Complete mappings reached by the exact searches
+    long long duplicates;       // Complete mappings rejected as already found
+    long long starts;           // Greedy start pairs tried (iso_approx, ext_approx)
+    long long failed_starts;    // Greedy starts that got stuck or did not verify
+} SearchStats;
+
+#ifdef AAC_STATS
+#define STATS_ADD(stats, field, amount) ((stats)->field += (amount))
+#else
+#define STATS_ADD(stats, field, amount) ((void) 0)
+#endif
+
+#define STATS_INC(stats, field) STATS_ADD(stats, field, 1)
+
+/**
+ * True if this build counts
+ */
+static inline bool search_stats_enabled(void) {
+#ifdef AAC_STATS
+    return true;
+#else
+    return false;
+#endif
+}
+
+/**
+ * Add the counters of from to into (merging per-thread counters)
+ */
+static inline void search_stats_merge(SearchStats *into, const SearchStats *from) {
+    into->product_vertices += from->product_vertices;
+    into->product_edges += from->product_edges;
+    into->nodes += from->nodes;
+    into->pruned += from->pruned;
+    into->leaves += from->leaves;
+    into->duplicates += from->duplicates;
+    into->starts += from->starts;
+    into->failed_starts += from->failed_starts;
+}
+
+#endif //AAC_SEARCH_STATS_H
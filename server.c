@@ -0,0 +1,346 @@
+#include "server.h"
+#include "aac.h"
+#include "graph.h"
+#include "output.h"
+#include "thread_pool.h"
+#include "mem_track.h"
+#include "trace.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+
+int run_server(const ServerOptions *opts) {
+    (void) opts;
+    fprintf(stderr, "Error: serve needs Unix domain sockets, which this platform does not provide\n");
+    return 1;
+}
+
+#else
+
+#include <errno.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#define NUM_ENGINES (AAC_EXT_JOINT + 1)
+
+// Largest request accepted (header plus G)
+#define MAX_REQUEST_BYTES (64u << 20)
+
+// A client that stops sending for this long is dropped
+#define CLIENT_TIMEOUT_S 30
+
+// ============================================================================
+// Types
+// ============================================================================
+
+typedef struct {
+    GraphPair graphs;
+    HIndex *owned_index;             // Built at startup when the file had none
+    int *dense_h;                    // Matrix of a sparse H, for the dense engines (NULL if too large)
+    AacContext *ctx[NUM_ENGINES];    // One per engine, all sharing this H and its index
+} ServedTarget;
+
+typedef struct {
+    ServedTarget *targets;
+    int num_targets;
+    int listen_fd;
+} Server;
+
+// Set by the signal handler, read by every worker (lock-free, so signal-safe)
+static atomic_int stopping = 0;
+static atomic_int signal_fd = -1;
+
+static void handle_stop(int sig) {
+    (void) sig;
+    stopping = 1;
+    // Wakes the workers blocked in accept
+    if (signal_fd >= 0) shutdown(signal_fd, SHUT_RDWR);
+}
+
+// ============================================================================
+// Targets
+// ============================================================================
+
+static void free_target(ServedTarget *t) {
+    for (int e = 0; e < NUM_ENGINES; e++) aac_destroy(t->ctx[e]);
+    free_h_index(t->owned_index);
+    mem_free(t->dense_h);
+    free_graph_pair(&t->graphs);
+}
+
+static int load_target(const ServerOptions *opts, const char *path, ServedTarget *t) {
+    memset(t, 0, sizeof(*t));
+    if (load_graph_pair(NULL, path, &t->graphs) != 0) return -1;
+
+    GraphPair *gp = &t->graphs;
+    const HIndex *idx = gp->h_index;
+    if (!idx) {
+        t->owned_index = gp->adj_h ? h_index_build(gp->n_h, gp->adj_h) : h_index_build_sparse(gp->sparse_h);
+        idx = t->owned_index;
+        if (!idx) {
+            fprintf(stderr, "Error: out of memory indexing %s\n", path);
+            return -1;
+        }
+    }
+    if (gp->sparse_h) t->dense_h = sparse_graph_to_dense(gp->sparse_h);
+
+    for (int e = 0; e < NUM_ENGINES; e++) {
+        AacEngine engine = (AacEngine) e;
+        const int *adj_h = gp->adj_h ? gp->adj_h : t->dense_h;
+        const SparseGraph *sparse_h = NULL;
+        if (aac_engine_runs_on_sparse(engine) && gp->sparse_h) {
+            adj_h = NULL;
+            sparse_h = gp->sparse_h;
+        }
+        if (!adj_h && !sparse_h) continue; // H too large for this engine's matrix
+
+        AacOptions engine_opts = aac_default_options(engine);
+        engine_opts.joint_budget = opts->joint_budget;
+        engine_opts.approx = opts->approx_opts;
+        engine_opts.share_target = true;
+        engine_opts.cache_dir = opts->cache_dir;
+        t->ctx[e] = aac_create(&engine_opts);
+        if (!t->ctx[e] || aac_set_target(t->ctx[e], gp->n_h, adj_h, sparse_h, idx) != 0) return -1;
+    }
+    return 0;
+}
+
+// ============================================================================
+// Requests
+// ============================================================================
+
+// Read until the client shuts down its side; NULL if it sends too much or fails
+static char *read_request(int fd, size_t *size) {
+    size_t len = 0, cap = 4096;
+    char *buf = (char *) malloc(cap);
+    while (buf) {
+        if (len == cap) {
+            if (cap >= MAX_REQUEST_BYTES) break;
+            char *grown = (char *) realloc(buf, cap * 2);
+            if (!grown) break;
+            buf = grown;
+            cap *= 2;
+        }
+        ssize_t got = recv(fd, buf + len, cap - len, 0);
+        if (got < 0 && errno == EINTR) continue;
+        if (got < 0) break;
+        if (got == 0) {
+            *size = len;
+            return buf;
+        }
+        len += (size_t) got;
+    }
+    free(buf);
+    return NULL;
+}
+
+static void send_all(int fd, const char *data, size_t len) {
+    while (len > 0) {
+        ssize_t sent = send(fd, data, len, 0);
+        if (sent < 0 && errno == EINTR) continue;
+        if (sent <= 0) return;
+        data += sent;
+        len -= (size_t) sent;
+    }
+}
+
+static void send_error(int fd, const char *message) {
+    OutWriter w;
+    out_init(&w, NULL);
+    out_str(&w, "{\"error\":\"");
+    out_str(&w, message);
+    out_str(&w, "\"}\n");
+    send_all(fd, w.buf, w.len);
+    out_free(&w);
+}
+
+static void answer(const Server *server, int fd, const char *request, size_t size) {
+    // Header line: <command> [n] [target]
+    const char *body = memchr(request, '\n', size);
+    body = body ? body + 1 : request + size;
+    char header[128];
+    size_t header_len = (size_t) (body - request);
+    if (header_len >= sizeof(header)) {
+        send_error(fd, "header line too long");
+        return;
+    }
+    memcpy(header, request, header_len);
+    header[header_len] = '\0';
+
+    char command[32];
+    int n = 1, target = 1;
+    AacEngine engine;
+    if (sscanf(header, "%31s %d %d", command, &n, &target) < 1 || !aac_parse_engine(command, &engine)) {
+        send_error(fd, "unknown command");
+        return;
+    }
+    if (target < 1 || target > server->num_targets) {
+        send_error(fd, "no such target");
+        return;
+    }
+    const AacContext *ctx = server->targets[target - 1].ctx[engine];
+    if (!ctx) {
+        send_error(fd, "target too large for this command");
+        return;
+    }
+
+    GraphStream stream;
+    GraphPair g;
+    open_graph_stream_buffer(body, size - header_len, &stream);
+    if (read_stream_pair(&stream, false, &g) != 1) {
+        send_error(fd, "invalid graph G");
+        return;
+    }
+
+    StatsCollector collector;
+    stats_collector_init(&collector);
+    AacInstance instance = {.n_g = g.n_g, .adj_g = g.adj_g, .n = n > 0 ? n : 1};
+    AacResult *result = aac_solve_reported(ctx, &instance, &collector.reporter);
+    if (!result) {
+        send_error(fd, "solve failed");
+    } else {
+        RunSummary summary = {
+            .command = command,
+            .n_g = g.n_g,
+            .n_h = server->targets[target - 1].graphs.n_h,
+            .extension = result->ext != NULL,
+            .is_subgraph = result->iso && result->iso->is_subgraph,
+            .edges_added = result->ext ? result->ext->total_edges_added : 0,
+            .optimal = result->engine == AAC_EXT_JOINT ? result->joint.optimal : -1,
+            .time_ms = result->time_ms,
+            .mappings = result->mappings,
+            .num_mappings = result->num_mappings,
+            .stats = collector.stats,
+            .num_stats = collector.count
+        };
+        OutWriter w;
+        out_init(&w, NULL);
+        write_summary_json(&w, &summary);
+        send_all(fd, w.buf, w.len);
+        out_free(&w);
+    }
+    aac_free_result(result);
+    stats_collector_free(&collector);
+    free_graph_pair(&g);
+}
+
+// Worker: take connections one at a time until the server stops
+static void serve_task(void *arg, int task, int worker) {
+    (void) task;
+    (void) worker;
+    const Server *server = (const Server *) arg;
+    while (!stopping) {
+        int fd = accept(server->listen_fd, NULL, NULL);
+        if (fd < 0) {
+            if (stopping || (errno != EINTR && errno != ECONNABORTED)) break;
+            continue;
+        }
+        struct timeval timeout = {CLIENT_TIMEOUT_S, 0};
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+        size_t size = 0;
+        char *request = read_request(fd, &size);
+        if (request) {
+            trace_begin("query");
+            answer(server, fd, request, size);
+            trace_end("query");
+        } else {
+            send_error(fd, "request unreadable or too large");
+        }
+        free(request);
+        close(fd);
+    }
+}
+
+// ============================================================================
+// Main Loop
+// ============================================================================
+
+static int open_socket(const char *path) {
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "Error: socket path too long: %s\n", path);
+        return -1;
+    }
+    strcpy(addr.sun_path, path);
+
+    // Replace a stale socket from an earlier run, but never another kind of file
+    struct stat st;
+    if (lstat(path, &st) == 0 && S_ISSOCK(st.st_mode)) unlink(path);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || bind(fd, (struct sockaddr *) &addr, sizeof(addr)) != 0 || listen(fd, SOMAXCONN) != 0) {
+        fprintf(stderr, "Error: cannot listen on %s: %s\n", path, strerror(errno));
+        if (fd >= 0) close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+int run_server(const ServerOptions *opts) {
+    if (opts->num_targets < 1) {
+        fprintf(stderr, "Error: serve needs at least one --target\n");
+        return 1;
+    }
+
+    Server server = {.num_targets = opts->num_targets, .listen_fd = -1};
+    server.targets = (ServedTarget *) calloc((size_t) opts->num_targets, sizeof(ServedTarget));
+    if (!server.targets) {
+        fprintf(stderr, "Error: out of memory\n");
+        return 1;
+    }
+    int rc = 0;
+    int loaded = 0;
+    for (; loaded < opts->num_targets && rc == 0; loaded++) {
+        if (load_target(opts, opts->target_paths[loaded], &server.targets[loaded]) != 0) rc = 1;
+    }
+
+    if (rc == 0) server.listen_fd = open_socket(opts->socket_path);
+    if (server.listen_fd < 0) rc = 1;
+
+    if (rc == 0) {
+        struct sigaction sa;
+        memset(&sa, 0, sizeof(sa));
+        sa.sa_handler = SIG_IGN;
+        sigaction(SIGPIPE, &sa, NULL); // A client that hangs up early must not stop the server
+        sa.sa_handler = handle_stop;
+        signal_fd = server.listen_fd;
+        sigaction(SIGINT, &sa, NULL);
+        sigaction(SIGTERM, &sa, NULL);
+
+        ThreadPool *pool = NULL;
+        int jobs = opts->jobs > 0 ? opts->jobs : cpu_count();
+        if (jobs > 1) {
+            pool = thread_pool_create(jobs);
+            jobs = pool ? thread_pool_size(pool) : 1;
+        }
+        printf("Serving %d target(s) on %s with %d worker(s)\n", opts->num_targets, opts->socket_path, jobs);
+        fflush(stdout);
+
+        if (pool) {
+            thread_pool_run(pool, jobs, serve_task, &server);
+        } else {
+            serve_task(&server, 0, 0);
+        }
+        thread_pool_destroy(pool);
+
+        signal_fd = -1;
+        close(server.listen_fd);
+        unlink(opts->socket_path);
+    }
+
+    for (int k = 0; k < loaded; k++) free_target(&server.targets[k]);
+    free(server.targets);
+    return rc;
+}
+
+#endif
@@ -0,0 +1,32 @@
+#ifndef AAC_SERVER_H
+#define AAC_SERVER_H
+
+#include "algorithms.h"
+
+/**
+ * Settings for answering queries against preloaded targets over a Unix socket
+ */
+typedef struct {
+    const char *socket_path;
+    const char *const *target_paths; // H files (their last graph), addressed 1..num_targets by requests
+    int num_targets;
+    int jobs;                        // Clients served concurrently (<= 0 = one per CPU)
+    JointBudget joint_budget;
+    ExtApproxOptions approx_opts;
+    const char *cache_dir;           // Result cache for iso_exact / ext_exact, or NULL
+} ServerOptions;
+
+/**
+ * Load and index every target once, then serve requests on the socket until
+ * SIGINT or SIGTERM.
+ *
+ * A request is one connection: a header line "<command> [n] [target]"
+ * (command as on the command line, n defaults to 1, target to 1) followed by
+ * G in any text form, then end of input (shut down the write side). The reply
+ * is one JSON object as printed by --format json, or {"error": "..."}.
+ *
+ * @return 0 after a clean shutdown, 1 if a target or the socket could not be set up
+ */
+int run_server(const ServerOptions *opts);
+
+#endif //AAC_SERVER_H
@@ -0,0 +1,252 @@
+#include "sparse_graph.h"
+#include "mem_track.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+
+// --- Private Helper Functions ---
+
+static int compare_edges(const void *a, const void *b) {
+    const SparseEdge *ea = (const SparseEdge *) a;
+    const SparseEdge *eb = (const SparseEdge *) b;
+    if (ea->src != eb->src) return (ea->src < eb->src) ? -1 : 1;
+    if (ea->dst != eb->dst) return (ea->dst < eb->dst) ? -1 : 1;
+    return 0;
+}
+
+static void release_arrays(SparseGraph *g) {
+    mem_free(g->out_start);
+    mem_free(g->out_dst);
+    mem_free(g->out_mult);
+    mem_free(g->in_start);
+    mem_free(g->in_src);
+    mem_free(g->in_mult);
+    mem_free(g->slot_key);
+    mem_free(g->slot_pos);
+}
+
+// Fill g's arrays from edges sorted by (src, dst) without duplicates or zeros
+static int build_arrays(SparseGraph *g, int n, const SparseEdge *edges, size_t count) {
+    memset(g, 0, sizeof(*g));
+    if (count > INT_MAX) return -1;
+
+    size_t slots = 16;
+    while (slots < 2 * count) slots *= 2;
+
+    g->n = n;
+    g->num_edges = (int) count;
+    g->out_start = (int *) mem_calloc(MEM_GRAPH, (size_t) n + 1, sizeof(int));
+    g->in_start = (int *) mem_calloc(MEM_GRAPH, (size_t) n + 1, sizeof(int));
+    g->out_dst = (int *) mem_alloc(MEM_GRAPH, (count > 0 ? count : 1) * sizeof(int));
+    g->out_mult = (int *) mem_alloc(MEM_GRAPH, (count > 0 ? count : 1) * sizeof(int));
+    g->in_src = (int *) mem_alloc(MEM_GRAPH, (count > 0 ? count : 1) * sizeof(int));
+    g->in_mult = (int *) mem_alloc(MEM_GRAPH, (count > 0 ? count : 1) * sizeof(int));
+    g->slot_key = (uint64_t *) mem_calloc(MEM_GRAPH, slots, sizeof(uint64_t));
+    g->slot_pos = (int *) mem_alloc(MEM_GRAPH, slots * sizeof(int));
+    g->slot_mask = slots - 1;
+    if (!g->out_start || !g->in_start || !g->out_dst || !g->out_mult ||
+        !g->in_src || !g->in_mult || !g->slot_key || !g->slot_pos) {
+        release_arrays(g);
+        return -1;
+    }
+
+    // Out-edges: the input order already is CSR order
+    for (size_t e = 0; e < count; e++) {
+        g->out_start[edges[e].src + 1]++;
+        g->in_start[edges[e].dst + 1]++;
+        g->out_dst[e] = edges[e].dst;
+        g->out_mult[e] = edges[e].mult;
+
+        uint64_t key = (uint64_t) edges[e].src * (uint64_t) n + (uint64_t) edges[e].dst + 1;
+        size_t s = sparse_graph_slot(key, g->slot_mask);
+        while (g->slot_key[s] != 0) s = (s + 1) & g->slot_mask;
+        g->slot_key[s] = key;
+        g->slot_pos[s] = (int) e;
+    }
+    for (int v = 0; v < n; v++) {
+        g->out_start[v + 1] += g->out_start[v];
+        g->in_start[v + 1] += g->in_start[v];
+    }
+
+    // In-edges: counting sort by dst keeps src ascending within each row
+    int *fill = (int *) mem_alloc(MEM_GRAPH, (size_t) n * sizeof(int));
+    if (!fill) {
+        release_arrays(g);
+        return -1;
+    }
+    memcpy(fill, g->in_start, (size_t) n * sizeof(int));
+    for (size_t e = 0; e < count; e++) {
+        int pos = fill[edges[e].dst]++;
+        g->in_src[pos] = edges[e].src;
+        g->in_mult[pos] = edges[e].mult;
+    }
+    mem_free(fill);
+    return 0;
+}
+
+// Sort by (src, dst), then sum duplicates and drop zero multiplicities into
+// the new *count; returns false if a sum would pass INT_MAX
+static bool normalize_edges(SparseEdge *edges, size_t *count) {
+    qsort(edges, *count, sizeof(SparseEdge), compare_edges);
+
+    size_t out = 0;
+    for (size_t e = 0; e < *count; e++) {
+        if (out > 0 && compare_edges(&edges[out - 1], &edges[e]) == 0) {
+            if (edges[e].mult > INT_MAX - edges[out - 1].mult) return false;
+            edges[out - 1].mult += edges[e].mult;
+        } else {
+            edges[out++] = edges[e];
+        }
+    }
+
+    size_t kept = 0;
+    for (size_t e = 0; e < out; e++) {
+        if (edges[e].mult > 0) edges[kept++] = edges[e];
+    }
+    *count = kept;
+    return true;
+}
+
+// --- Public Functions ---
+
+SparseGraph *sparse_graph_from_edges(int n, SparseEdge *edges, size_t count) {
+    for (size_t e = 0; e < count; e++) {
+        if (edges[e].src < 0 || edges[e].src >= n || edges[e].dst < 0 || edges[e].dst >= n ||
+            edges[e].mult < 0) {
+            return NULL;
+        }
+    }
+
+    if (!normalize_edges(edges, &count)) return NULL;
+
+    SparseGraph *g = (SparseGraph *) mem_alloc(MEM_GRAPH, sizeof(SparseGraph));
+    if (!g) return NULL;
+    if (build_arrays(g, n, edges, count) != 0) {
+        mem_free(g);
+        return NULL;
+    }
+    return g;
+}
+
+SparseGraph *sparse_graph_from_dense(int n, const int *adj) {
+    size_t count = 0;
+    for (size_t c = 0; c < (size_t) n * n; c++) {
+        if (adj[c] > 0) count++;
+    }
+
+    SparseEdge *edges = (SparseEdge *) mem_alloc(MEM_GRAPH, (count > 0 ? count : 1) * sizeof(SparseEdge));
+    if (!edges) return NULL;
+    count = 0;
+    for (int i = 0; i < n; i++) {
+        for (int j = 0; j < n; j++) {
+            int m = adj[(size_t) i * n + j];
+            if (m > 0) edges[count++] = (SparseEdge) {i, j, m};
+        }
+    }
+
+    SparseGraph *g = sparse_graph_from_edges(n, edges, count);
+    mem_free(edges);
+    return g;
+}
+
+int *sparse_graph_to_dense(const SparseGraph *g) {
+    if (g->n > 46340) return NULL; // n * n must stay within int indexing
+
+    int *adj = (int *) mem_calloc(MEM_GRAPH, (size_t) g->n * g->n, sizeof(int));
+    if (!adj) return NULL;
+    for (int u = 0; u < g->n; u++) {
+        for (int k = g->out_start[u]; k < g->out_start[u + 1]; k++) {
+            adj[(size_t) u * g->n + g->out_dst[k]] = g->out_mult[k];
+        }
+    }
+    return adj;
+}
+
+SparseGraph *sparse_graph_copy(const SparseGraph *g) {
+    size_t num_edges = g->num_edges > 0 ? (size_t) g->num_edges : 1;
+    SparseEdge *edges = (SparseEdge *) mem_alloc(MEM_GRAPH, num_edges * sizeof(SparseEdge));
+    if (!edges) return NULL;
+    for (int u = 0; u < g->n; u++) {
+        for (int k = g->out_start[u]; k < g->out_start[u + 1]; k++) {
+            edges[k] = (SparseEdge) {u, g->out_dst[k], g->out_mult[k]};
+        }
+    }
+
+    SparseGraph *copy = (SparseGraph *) mem_alloc(MEM_GRAPH, sizeof(SparseGraph));
+    if (copy && build_arrays(copy, g->n, edges, (size_t) g->num_edges) != 0) {
+        mem_free(copy);
+        copy = NULL;
+    }
+    mem_free(edges);
+    return copy;
+}
+
+int sparse_graph_raise(SparseGraph *g, const SparseEdge *cells, size_t count) {
+    // Cells that already exist are raised in place (in_mult is found by binary search)
+    size_t num_new = 0;
+    for (size_t c = 0; c < count; c++) {
+        if (sparse_graph_mult(g, cells[c].src, cells[c].dst) == 0 && cells[c].mult > 0) num_new++;
+    }
+
+    if (num_new == 0) {
+        for (size_t c = 0; c < count; c++) {
+            const SparseEdge *cell = &cells[c];
+            if (sparse_graph_mult(g, cell->src, cell->dst) >= cell->mult) continue;
+
+            uint64_t key = (uint64_t) cell->src * (uint64_t) g->n + (uint64_t) cell->dst + 1;
+            size_t s = sparse_graph_slot(key, g->slot_mask);
+            while (g->slot_key[s] != key) s = (s + 1) & g->slot_mask;
+            g->out_mult[g->slot_pos[s]] = cell->mult;
+
+            int lo = g->in_start[cell->dst], hi = g->in_start[cell->dst + 1] - 1;
+            while (lo < hi) {
+                int mid = (lo + hi) / 2;
+                if (g->in_src[mid] < cell->src) lo = mid + 1;
+                else hi = mid;
+            }
+            g->in_mult[lo] = cell->mult;
+        }
+        return 0;
+    }
+
+    // New edges change the CSR layout: rebuild from the merged edge list
+    size_t total = (size_t) g->num_edges + count;
+    SparseEdge *edges = (SparseEdge *) mem_alloc(MEM_GRAPH, total * sizeof(SparseEdge));
+    if (!edges) return -1;
+    size_t m = 0;
+    for (int u = 0; u < g->n; u++) {
+        for (int k = g->out_start[u]; k < g->out_start[u + 1]; k++) {
+            edges[m++] = (SparseEdge) {u, g->out_dst[k], g->out_mult[k]};
+        }
+    }
+    for (size_t c = 0; c < count; c++) edges[m++] = cells[c];
+
+    // Merge by maximum rather than sum
+    qsort(edges, m, sizeof(SparseEdge), compare_edges);
+    size_t out = 0;
+    for (size_t e = 0; e < m; e++) {
+        if (out > 0 && compare_edges(&edges[out - 1], &edges[e]) == 0) {
+            if (edges[e].mult > edges[out - 1].mult) edges[out - 1].mult = edges[e].mult;
+        } else {
+            edges[out++] = edges[e];
+        }
+    }
+
+    SparseGraph rebuilt;
+    if (build_arrays(&rebuilt, g->n, edges, out) != 0) {
+        mem_free(edges);
+        return -1;
+    }
+    mem_free(edges);
+    release_arrays(g);
+    *g = rebuilt;
+    return 0;
+}
+
+void free_sparse_graph(SparseGraph *g) {
+    if (g) {
+        release_arrays(g);
+        mem_free(g);
+    }
+}
@@ -0,0 +1,82 @@
+#ifndef AAC_SPARSE_GRAPH_H
+#define AAC_SPARSE_GRAPH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * One directed edge with its multiplicity
+ */
+typedef struct {
+    int src;
+    int dst;
+    int mult;
+} SparseEdge;
+
+/**
+ * Directed multigraph in CSR form, for large sparse graphs where an n x n
+ * matrix does not fit in memory.
+ *
+ * Out- and in-edges are both stored (sorted by neighbour id), and a hash index
+ * over (src, dst) gives expected O(1) multiplicity lookups.
+ */
+typedef struct SparseGraph {
+    int n;
+    int num_edges;      // Distinct (src, dst) pairs with multiplicity > 0
+    int *out_start;     // Out-edges of u: out_dst/out_mult[out_start[u] .. out_start[u+1])
+    int *out_dst;
+    int *out_mult;
+    int *in_start;      // In-edges of v: in_src/in_mult[in_start[v] .. in_start[v+1])
+    int *in_src;
+    int *in_mult;
+    uint64_t *slot_key; // Hash index: src * n + dst + 1 (0 = empty slot)
+    int *slot_pos;      // Position of the edge in out_dst/out_mult
+    size_t slot_mask;
+} SparseGraph;
+
+/**
+ * Build a graph from an edge list. Duplicate (src, dst) pairs add up, zero
+ * multiplicities are dropped. Sorts edges in place.
+ *
+ * @return New graph, or NULL on allocation failure, an out-of-range vertex,
+ *         a negative multiplicity or duplicates whose sum exceeds INT_MAX
+ */
+SparseGraph *sparse_graph_from_edges(int n, SparseEdge *edges, size_t count);
+
+/**
+ * Build a graph from a flattened n x n adjacency matrix
+ */
+SparseGraph *sparse_graph_from_dense(int n, const int *adj);
+
+/**
+ * Expand to a freshly allocated n x n matrix (NULL if it does not fit)
+ */
+int *sparse_graph_to_dense(const SparseGraph *g);
+
+SparseGraph *sparse_graph_copy(const SparseGraph *g);
+
+/**
+ * Raise each listed cell to at least its multiplicity (new edges are inserted).
+ *
+ * @return 0 on success, -1 on allocation failure (graph unchanged)
+ */
+int sparse_graph_raise(SparseGraph *g, const SparseEdge *cells, size_t count);
+
+void free_sparse_graph(SparseGraph *g);
+
+static inline size_t sparse_graph_slot(uint64_t key, size_t mask) {
+    return (size_t) ((key * 0x9E3779B97F4A7C15ull) >> 17) & mask;
+}
+
+/**
+ * Multiplicity of the edge src -> dst (0 if absent)
+ */
+static inline int sparse_graph_mult(const SparseGraph *g, int src, int dst) {
+    uint64_t key = (uint64_t) src * (uint64_t) g->n + (uint64_t) dst + 1;
+    for (size_t s = sparse_graph_slot(key, g->slot_mask);; s = (s + 1) & g->slot_mask) {
+        if (g->slot_key[s] == key) return g->out_mult[g->slot_pos[s]];
+        if (g->slot_key[s] == 0) return 0;
+    }
+}
+
+#endif //AAC_SPARSE_GRAPH_H
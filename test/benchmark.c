@@ -0,0 +1,468 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "aac.h"
+#include "auto_plan.h"
+#include "graph.h"
+#include "output.h"
+#include "utils.h"
+
+/**
+ * In-process benchmark: generates the instances of benchmark_linear.sh
+ * (G cut from a random H; for extensions one G edge made heavier than any
+ * in H) and runs each engine on them without process startup or console
+ * printing in the way. Every repetition is split into phases:
+ *
+ *   load        parsing the instance text (read_stream_pair)
+ *   preprocess  H index: degrees, degree order, signatures (h_index_build),
+ *               plus build_product_graph for iso_exact
+ *   search      the engine given that index (aac_solve); iso_exact builds its
+ *               product graph again inside, so that build is subtracted
+ *   output      the JSON summary into memory (write_summary_json)
+ *
+ * The first CSV has the columns test/plot_benchmark.py reads, with the search
+ * time of each engine; the optional second one has every phase.
+ *
+ * With --calibrate, each timing is also paired with the work auto_plan counts
+ * for that engine on the instance, and the cost per work unit is fitted by
+ * least squares (product pairs against the product graph build, everything
+ * else against the search; iso_exact is timed again on the extension instance,
+ * where it must search to the end). The fit is printed for
+ * auto_default_calibration.
+ */
+
+static const AacEngine engines[] = {AAC_ISO_EXACT, AAC_ISO_APPROX, AAC_EXT_EXACT, AAC_EXT_APPROX};
+#define NUM_ENGINES ((int) (sizeof(engines) / sizeof(engines[0])))
+
+typedef struct {
+    int min_size, max_size, step, h_offset;
+    int iso_limit, ext_limit; // Largest G for the exact engines
+    int reps, warmup;
+    unsigned seed;
+    const char *output;       // Plot CSV, NULL = stdout
+    const char *phases;       // Per-phase CSV, or NULL
+    bool calibrate;           // Fit the planner's per-unit costs
+} BenchOptions;
+
+typedef struct {
+    double load, preprocess, search, output;
+    double product;           // iso_exact: the product graph build inside preprocess
+} PhaseTimes;
+
+// Least-squares fit of time = cost * work through the origin, for one AutoCalibration field
+typedef struct {
+    const char *name;
+    double sum_wt, sum_ww;    // Sums of work * ns and work^2
+    double min_cost, max_cost; // Per-sample ns per unit, to show the spread around the fit
+    int samples;
+} CostFit;
+
+enum { FIT_PAIR, FIT_CLIQUE_NODE, FIT_EXT_NODE, FIT_ISO_STEP, FIT_EXT_STEP, NUM_FITS };
+
+// ============================================================================
+// Instance Generation (as test/graph_gen.c)
+// ============================================================================
+
+static void shuffle(int *p, int n) {
+    for (int i = n - 1; i > 0; i--) {
+        int j = rand() % (i + 1);
+        int temp = p[i];
+        p[i] = p[j];
+        p[j] = temp;
+    }
+}
+
+static void write_matrix(OutWriter *w, int n, const int *adj) {
+    out_int(w, n);
+    out_char(w, '\n');
+    for (int i = 0; i < n; i++) {
+        for (int j = 0; j < n; j++) {
+            if (j > 0) out_char(w, ' ');
+            out_int(w, adj[i * n + j]);
+        }
+        out_char(w, '\n');
+    }
+}
+
+/**
+ * Text of one (G, H) instance in w; G is a subgraph of H unless not_subgraph
+ */
+static bool generate_instance(OutWriter *w, int g_size, int h_size, bool not_subgraph) {
+    int *h_base = (int *) calloc((size_t) h_size * h_size, sizeof(int));
+    int *h_final = (int *) malloc((size_t) h_size * h_size * sizeof(int));
+    int *g = (int *) malloc((size_t) g_size * g_size * sizeof(int));
+    int *p = (int *) malloc((size_t) h_size * sizeof(int));
+    if (!h_base || !h_final || !g || !p) {
+        free(h_base);
+        free(h_final);
+        free(g);
+        free(p);
+        return false;
+    }
+
+    int max_weight = 0;
+    for (int i = 0; i < h_size * h_size; i++) {
+        if ((double) rand() / (double) RAND_MAX < 0.3) h_base[i] = rand() % 4 + 1;
+        if (h_base[i] > max_weight) max_weight = h_base[i];
+    }
+
+    // G: the rows and columns of g_size random H vertices, in H order
+    for (int i = 0; i < h_size; i++) p[i] = i;
+    shuffle(p, h_size);
+    for (int i = 1; i < g_size; i++) {
+        for (int j = i; j > 0 && p[j - 1] > p[j]; j--) {
+            int temp = p[j];
+            p[j] = p[j - 1];
+            p[j - 1] = temp;
+        }
+    }
+    for (int i = 0; i < g_size; i++) {
+        for (int j = 0; j < g_size; j++) g[i * g_size + j] = h_base[p[i] * h_size + p[j]];
+    }
+
+    if (not_subgraph && g_size > 0) {
+        int r = rand() % g_size, c = rand() % g_size;
+        for (int attempts = 0; attempts < 100 && g[r * g_size + c] == 0; attempts++) {
+            r = rand() % g_size;
+            c = rand() % g_size;
+        }
+        g[r * g_size + c] = max_weight + 1;
+    }
+
+    // H: relabelled so that G does not sit on its first vertices
+    for (int i = 0; i < h_size; i++) p[i] = i;
+    shuffle(p, h_size);
+    for (int i = 0; i < h_size; i++) {
+        for (int j = 0; j < h_size; j++) h_final[i * h_size + j] = h_base[p[i] * h_size + p[j]];
+    }
+
+    write_matrix(w, g_size, g);
+    write_matrix(w, h_size, h_final);
+    free(h_base);
+    free(h_final);
+    free(g);
+    free(p);
+    return true;
+}
+
+// ============================================================================
+// Timed Runs
+// ============================================================================
+
+/**
+ * One repetition of engine on the instance text
+ *
+ * @return Mappings found, or -1 on failure (described on stderr)
+ */
+static int run_once(AacEngine engine, const OutWriter *instance, PhaseTimes *t, AutoPlan *plan) {
+    double start = now_ms();
+    GraphStream gs;
+    GraphPair gp;
+    open_graph_stream_buffer(instance->buf, instance->len, &gs);
+    int rc = read_stream_pair(&gs, true, &gp);
+    close_graph_stream(&gs);
+    if (rc != 1) {
+        fprintf(stderr, "Error: generated instance does not parse\n");
+        return -1;
+    }
+    t->load = now_ms() - start;
+
+    start = now_ms();
+    HIndex *idx = h_index_build(gp.n_h, gp.adj_h);
+    double product_ms = 0;
+    if (idx && engine == AAC_ISO_EXACT) {
+        double product_start = now_ms();
+        ProductGraph *pg = build_product_graph(gp.n_g, gp.adj_g, gp.n_h, gp.adj_h, idx, NULL);
+        product_ms = now_ms() - product_start;
+        free_product_graph(pg);
+    }
+    t->preprocess = now_ms() - start;
+    t->product = product_ms;
+
+    AacOptions opts = aac_default_options(engine);
+    AacContext *ctx = idx ? aac_create(&opts) : NULL;
+    AacInstance inst = {gp.n_g, gp.adj_g, gp.n_h, gp.adj_h, NULL, idx, 0};
+    if (ctx && plan) {
+        AutoCalibration calibration = auto_default_calibration();
+        bool extension = engine == AAC_EXT_EXACT || engine == AAC_EXT_APPROX;
+        if (auto_plan(&inst, extension, 0, 1, &calibration, plan) != 0) {
+            aac_destroy(ctx);
+            ctx = NULL;
+        }
+    }
+    AacResult *result = ctx ? aac_solve(ctx, &inst) : NULL;
+    if (!result) {
+        aac_destroy(ctx);
+        free_h_index(idx);
+        free_graph_pair(&gp);
+        fprintf(stderr, "Error: %s failed\n", aac_engine_name(engine));
+        return -1;
+    }
+    t->search = result->time_ms - product_ms;
+    if (t->search < 0) t->search = 0;
+
+    start = now_ms();
+    RunSummary summary = {
+        .command = aac_engine_name(engine),
+        .n_g = gp.n_g,
+        .n_h = gp.n_h,
+        .extension = result->ext != NULL,
+        .is_subgraph = result->iso && result->iso->is_subgraph,
+        .edges_added = result->ext ? result->ext->total_edges_added : 0,
+        .optimal = -1,
+        .time_ms = result->time_ms,
+        .mappings = result->mappings,
+        .num_mappings = result->num_mappings
+    };
+    OutWriter w;
+    out_init(&w, NULL);
+    write_summary_json(&w, &summary);
+    out_free(&w);
+    t->output = now_ms() - start;
+
+    int found = result->num_mappings;
+    aac_free_result(result);
+    aac_destroy(ctx);
+    free_h_index(idx);
+    free_graph_pair(&gp);
+    return found;
+}
+
+static int compare_doubles(const void *a, const void *b) {
+    double x = *(const double *) a, y = *(const double *) b;
+    return (x > y) - (x < y);
+}
+
+static double median(double *values, int count) {
+    qsort(values, (size_t) count, sizeof(double), compare_doubles);
+    return count % 2 ? values[count / 2] : (values[count / 2 - 1] + values[count / 2]) / 2;
+}
+
+/**
+ * Warm up, then time opts->reps repetitions; each phase is the median over them
+ */
+static int run_engine(const BenchOptions *opts, AacEngine engine, const OutWriter *instance, PhaseTimes *out,
+                      AutoPlan *plan) {
+    PhaseTimes t;
+    int found = 0;
+    for (int k = 0; k < opts->warmup; k++) {
+        if (run_once(engine, instance, &t, NULL) < 0) return -1;
+    }
+    double *samples = (double *) malloc((size_t) opts->reps * 5 * sizeof(double));
+    if (!samples) {
+        fprintf(stderr, "Error: out of memory\n");
+        return -1;
+    }
+    for (int k = 0; k < opts->reps; k++) {
+        found = run_once(engine, instance, &t, k == 0 ? plan : NULL);
+        if (found < 0) {
+            free(samples);
+            return -1;
+        }
+        samples[k] = t.load;
+        samples[opts->reps + k] = t.preprocess;
+        samples[2 * opts->reps + k] = t.search;
+        samples[3 * opts->reps + k] = t.output;
+        samples[4 * opts->reps + k] = t.product;
+    }
+    out->load = median(samples, opts->reps);
+    out->preprocess = median(samples + opts->reps, opts->reps);
+    out->search = median(samples + 2 * opts->reps, opts->reps);
+    out->output = median(samples + 3 * opts->reps, opts->reps);
+    out->product = median(samples + 4 * opts->reps, opts->reps);
+    free(samples);
+    return found;
+}
+
+// ============================================================================
+// Calibration
+// ============================================================================
+
+static void add_sample(CostFit *fit, double work, double ms) {
+    if (work <= 0) return;
+    double ns = ms * 1e6, cost = ns / work;
+    fit->sum_wt += work * ns;
+    fit->sum_ww += work * work;
+    if (fit->samples == 0 || cost < fit->min_cost) fit->min_cost = cost;
+    if (fit->samples == 0 || cost > fit->max_cost) fit->max_cost = cost;
+    fit->samples++;
+}
+
+// The work auto_plan counted for the engine, against the time it took
+static void add_engine_samples(CostFit *fits, AacEngine engine, const AutoPlan *plan, const PhaseTimes *t) {
+    switch (engine) {
+        case AAC_ISO_EXACT:
+            add_sample(&fits[FIT_PAIR], plan->product_pairs, t->product);
+            add_sample(&fits[FIT_CLIQUE_NODE], plan->clique_nodes, t->search);
+            break;
+        case AAC_ISO_APPROX:
+            add_sample(&fits[FIT_ISO_STEP], plan->iso_steps, t->search);
+            break;
+        case AAC_EXT_EXACT:
+            add_sample(&fits[FIT_EXT_NODE], plan->ext_nodes, t->search);
+            break;
+        default:
+            add_sample(&fits[FIT_EXT_STEP], plan->ext_steps, t->search);
+            break;
+    }
+}
+
+static void print_calibration(FILE *f, const CostFit *fits) {
+    fprintf(f, "\nCalibration (ns per unit; per-sample range in brackets):\n");
+    for (int k = 0; k < NUM_FITS; k++) {
+        const CostFit *fit = &fits[k];
+        if (fit->samples == 0) {
+            fprintf(f, "    .%s = (no samples),\n", fit->name);
+            continue;
+        }
+        fprintf(f, "    .%s = %.3g, // [%.3g, %.3g] over %d size(s)\n", fit->name, fit->sum_wt / fit->sum_ww,
+                fit->min_cost, fit->max_cost, fit->samples);
+    }
+}
+
+// ============================================================================
+// Main
+// ============================================================================
+
+static void print_usage(const char *prog_name) {
+    fprintf(stderr, "Usage: %s [options]\n\n", prog_name);
+    fprintf(stderr, "Options:\n");
+    fprintf(stderr, "  --min <n>          Smallest G (default 5)\n");
+    fprintf(stderr, "  --max <n>          Largest G (default 10)\n");
+    fprintf(stderr, "  --step <n>         G size increment (default 5)\n");
+    fprintf(stderr, "  --h-offset <n>     H has this many more vertices than G (default 5)\n");
+    fprintf(stderr, "  --iso-limit <n>    Largest G for iso_exact (default 25)\n");
+    fprintf(stderr, "  --ext-limit <n>    Largest G for ext_exact (default 12)\n");
+    fprintf(stderr, "  --reps <n>         Timed repetitions per engine and size (default 5)\n");
+    fprintf(stderr, "  --warmup <n>       Untimed repetitions before them (default 1)\n");
+    fprintf(stderr, "  --seed <n>         Random seed (default: time)\n");
+    fprintf(stderr, "  --output <file>    CSV for plot_benchmark.py (default stdout)\n");
+    fprintf(stderr, "  --phases <file>    CSV with every phase per engine and size\n");
+    fprintf(stderr, "  --calibrate        Fit the per-unit costs of the auto planner and print them\n");
+}
+
+static bool parse_count(const char *s, int min, int *out) {
+    char *end;
+    long value = strtol(s, &end, 10);
+    if (*s == '\0' || *end != '\0' || value < min || value > 100000) return false;
+    *out = (int) value;
+    return true;
+}
+
+int main(int argc, char *argv[]) {
+    BenchOptions opts = {5, 10, 5, 5, 25, 12, 5, 1, (unsigned) time(NULL), NULL, NULL, false};
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        if (strcmp(arg, "--calibrate") == 0) {
+            opts.calibrate = true;
+            continue;
+        }
+        const char *value = i + 1 < argc ? argv[i + 1] : NULL;
+        int seed;
+        bool ok = value != NULL;
+        if (strcmp(arg, "--min") == 0) ok = ok && parse_count(value, 1, &opts.min_size);
+        else if (strcmp(arg, "--max") == 0) ok = ok && parse_count(value, 1, &opts.max_size);
+        else if (strcmp(arg, "--step") == 0) ok = ok && parse_count(value, 1, &opts.step);
+        else if (strcmp(arg, "--h-offset") == 0) ok = ok && parse_count(value, 0, &opts.h_offset);
+        else if (strcmp(arg, "--iso-limit") == 0) ok = ok && parse_count(value, 0, &opts.iso_limit);
+        else if (strcmp(arg, "--ext-limit") == 0) ok = ok && parse_count(value, 0, &opts.ext_limit);
+        else if (strcmp(arg, "--reps") == 0) ok = ok && parse_count(value, 1, &opts.reps);
+        else if (strcmp(arg, "--warmup") == 0) ok = ok && parse_count(value, 0, &opts.warmup);
+        else if (strcmp(arg, "--seed") == 0) {
+            ok = ok && parse_count(value, 0, &seed);
+            if (ok) opts.seed = (unsigned) seed;
+        } else if (strcmp(arg, "--output") == 0) opts.output = value;
+        else if (strcmp(arg, "--phases") == 0) opts.phases = value;
+        else ok = false;
+        if (!ok) {
+            fprintf(stderr, "Error: bad option %s\n", arg);
+            print_usage(argv[0]);
+            return 1;
+        }
+        i++;
+    }
+    if (opts.min_size > opts.max_size) {
+        fprintf(stderr, "Error: --min is larger than --max\n");
+        return 1;
+    }
+
+    FILE *out = opts.output ? fopen(opts.output, "w") : stdout;
+    FILE *phases = opts.phases ? fopen(opts.phases, "w") : NULL;
+    if (!out || (opts.phases && !phases)) {
+        fprintf(stderr, "Error: cannot open %s\n", !out ? opts.output : opts.phases);
+        if (out && out != stdout) fclose(out);
+        return 1;
+    }
+    fprintf(out, "g_size,h_size,iso_exact_ms,iso_approx_ms,ext_exact_ms,ext_approx_ms\n");
+    if (phases) fprintf(phases, "engine,g_size,h_size,found,load_ms,preprocess_ms,search_ms,output_ms\n");
+
+    srand(opts.seed);
+    fprintf(stderr, "Seed %u, %d repetitions after %d warmup\n", opts.seed, opts.reps, opts.warmup);
+    CostFit fits[NUM_FITS] = {
+        [FIT_PAIR] = {.name = "pair_ns"},
+        [FIT_CLIQUE_NODE] = {.name = "clique_node_ns"},
+        [FIT_EXT_NODE] = {.name = "ext_node_ns"},
+        [FIT_ISO_STEP] = {.name = "iso_step_ns"},
+        [FIT_EXT_STEP] = {.name = "ext_step_ns"},
+    };
+    int status = 0;
+    for (int g_size = opts.min_size; g_size <= opts.max_size && status == 0; g_size += opts.step) {
+        int h_size = g_size + opts.h_offset;
+        OutWriter iso_instance, ext_instance;
+        out_init(&iso_instance, NULL);
+        out_init(&ext_instance, NULL);
+        if (!generate_instance(&iso_instance, g_size, h_size, false) ||
+            !generate_instance(&ext_instance, g_size, h_size, true)) {
+            fprintf(stderr, "Error: out of memory\n");
+            status = 1;
+        }
+
+        fprintf(stderr, "G=%d, H=%d:", g_size, h_size);
+        fprintf(out, "%d,%d", g_size, h_size);
+        for (int e = 0; e < NUM_ENGINES && status == 0; e++) {
+            AacEngine engine = engines[e];
+            int limit = engine == AAC_ISO_EXACT ? opts.iso_limit : engine == AAC_EXT_EXACT ? opts.ext_limit : g_size;
+            if (g_size > limit) {
+                fprintf(out, ",-");
+                continue;
+            }
+            fprintf(stderr, " %s", aac_engine_name(engine));
+            bool extension = engine == AAC_EXT_EXACT || engine == AAC_EXT_APPROX;
+            PhaseTimes t;
+            AutoPlan plan;
+            int found = run_engine(&opts, engine, extension ? &ext_instance : &iso_instance, &t,
+                                   opts.calibrate ? &plan : NULL);
+            if (found < 0) {
+                status = 1;
+                break;
+            }
+            if (opts.calibrate && engine == AAC_ISO_EXACT) {
+                // Calibrated where G is not a subgraph: a search that has to finish,
+                // as auto must assume (a planted G can be found at any point)
+                PhaseTimes full;
+                if (run_engine(&opts, engine, &ext_instance, &full, &plan) < 0) {
+                    status = 1;
+                    break;
+                }
+                add_engine_samples(fits, engine, &plan, &full);
+            } else if (opts.calibrate) {
+                add_engine_samples(fits, engine, &plan, &t);
+            }
+            fprintf(out, ",%.3f", t.search);
+            if (phases) {
+                fprintf(phases, "%s,%d,%d,%d,%.3f,%.3f,%.3f,%.3f\n", aac_engine_name(engine), g_size, h_size, found,
+                        t.load, t.preprocess, t.search, t.output);
+            }
+        }
+        fprintf(out, "\n");
+        fprintf(stderr, "\n");
+        out_free(&iso_instance);
+        out_free(&ext_instance);
+    }
+
+    if (opts.calibrate && status == 0) print_calibration(stderr, fits);
+    if (out != stdout) fclose(out);
+    if (phases) fclose(phases);
+    return status;
+}
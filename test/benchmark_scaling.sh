@@ -0,0 +1,71 @@
+#!/bin/bash
+
+# ============================================================================
+# Benchmark Script: Structured Graph Families at Growing Sizes
+# Times the heuristics on large sparse targets of every graph_gen family, with
+# a G planted in H (iso_approx) or planted and made unembeddable (ext_approx)
+# ============================================================================
+
+# Configuration
+C_SCRIPT="./graph_gen"
+EXECUTABLE="../build/aac"
+DIR_BENCHMARK="benchmark_scaling"
+RESULTS_DIR="results"
+RESULTS_FILE="$RESULTS_DIR/benchmark_scaling_results.csv"
+
+FAMILIES="uniform scalefree grid regular symmetric core"
+G_SIZE=20
+MIN_H=1000
+MAX_H=64000           # H doubles from MIN_H up to this
+AVG_DEGREE=8          # uniform: density chosen for this many edges per vertex
+SEED=1
+TIMEOUT_S=300         # Runs over this are recorded as '-'
+
+echo "=============================================="
+echo "Benchmark: Graph Family Scaling"
+echo "=============================================="
+echo "Families: $FAMILIES"
+echo "G = $G_SIZE (planted), H from $MIN_H to $MAX_H (doubling)"
+echo "=============================================="
+
+mkdir -p "$DIR_BENCHMARK"
+mkdir -p "$RESULTS_DIR"
+
+# Engine time from the JSON summary ('-' on failure or timeout)
+run_time() {
+    local output
+    output=$(timeout "$TIMEOUT_S" "$EXECUTABLE" "$1" "$2" 1 --batch --format json 2>/dev/null)
+    local t
+    t=$(echo "$output" | sed -n 's/.*"time_ms":\([0-9.]*\),"mappings".*/\1/p' | tail -1)
+    echo "${t:--}"
+}
+
+echo "family,g_size,h_size,iso_approx_ms,ext_approx_ms" > "$RESULTS_FILE"
+
+for family in $FAMILIES; do
+    for (( h_size=MIN_H; h_size<=MAX_H; h_size*=2 )); do
+        density=$(awk -v d="$AVG_DEGREE" -v n="$h_size" 'BEGIN { printf "%.8f", d / n }')
+        iso_file="$DIR_BENCHMARK/${family}_iso_H${h_size}.el"
+        ext_file="$DIR_BENCHMARK/${family}_ext_H${h_size}.el"
+
+        # Edge lists: H stays sparse in the engines that support it
+        "$C_SCRIPT" "$G_SIZE" "$h_size" --family "$family" --density "$density" --plant \
+            --format edges --seed "$SEED" --output "$iso_file" || exit 1
+        "$C_SCRIPT" "$G_SIZE" "$h_size" --family "$family" --density "$density" --plant --not-subgraph \
+            --format edges --seed "$SEED" --output "$ext_file" || exit 1
+
+        echo -n "Testing $family H=$h_size: "
+        iso_time=$(run_time iso_approx "$iso_file")
+        ext_time=$(run_time ext_approx "$ext_file")
+        echo "iso_approx $iso_time ms, ext_approx $ext_time ms"
+
+        echo "$family,$G_SIZE,$h_size,$iso_time,$ext_time" >> "$RESULTS_FILE"
+    done
+done
+
+echo ""
+echo "=============================================="
+echo "Benchmark Complete!"
+echo "=============================================="
+echo "Results saved to: $RESULTS_FILE"
+echo "Note: '-' indicates the run failed or exceeded ${TIMEOUT_S}s"
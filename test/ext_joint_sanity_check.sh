@@ -0,0 +1,146 @@
+#!/bin/bash
+
+# ============================================================================
+# Sanity Check: Jointly Optimal Extension (ext_joint)
+# ext_joint starts from the iterative solution and only keeps improvements, so
+# its total must never exceed ext_exact's. A search cut short by --max-nodes
+# must report optimal:false (unless it finished within the budget) and still
+# return n valid, distinct mappings.
+# ============================================================================
+
+# --- CONFIGURATION ---
+GENERATOR="./graph_gen"
+SOLVER="../build/aac"
+OUTPUT_DIR="./debug_data"
+NUM_TRIALS=10
+
+# Colors
+GREEN='\033[0;32m'
+RED='\033[0;31m'
+NC='\033[0m'
+
+mkdir -p "$OUTPUT_DIR"
+
+# Counters
+total_tests=0
+total_failures=0
+
+# Top-level edges_added of a JSON result
+total_added() {
+    sed -n 's/^{[^[]*"edges_added":\([0-9]*\).*/\1/p'
+}
+
+# Top-level optimal flag of an ext_joint JSON result
+optimal_flag() {
+    sed -n 's/^{[^[]*"optimal":\([a-z]*\).*/\1/p'
+}
+
+# Succeeds if the JSON result holds exactly n distinct injective mappings of
+# n_g vertices into H (1-based vertex ids)
+valid_mappings() {
+    local json=$1 n=$2
+    local n_g n_h
+    n_g=$(echo "$json" | sed -n 's/^{[^[]*"n_g":\([0-9]*\).*/\1/p')
+    n_h=$(echo "$json" | sed -n 's/^{[^[]*"n_h":\([0-9]*\).*/\1/p')
+    echo "$json" | grep -o '"mapping":\[[0-9,]*\]' | sed 's/.*\[\(.*\)\]/\1/' | awk -F, -v n="$n" -v ng="$n_g" -v nh="$n_h" '
+        {
+            if (NF != ng || seen[$0]++) bad = 1
+            delete used
+            for (i = 1; i <= NF; i++) {
+                if ($i < 1 || $i > nh || used[$i]++) bad = 1
+            }
+        }
+        END { exit (bad || NR != n) }
+    '
+}
+
+run_batch() {
+    local g_size=$1 # Pattern G
+    local h_size=$2 # Host H
+    local n=$3      # Mappings to extend for
+
+    echo "----------------------------------------------------"
+    echo "Testing ext_joint: G=$g_size, H=$h_size, n=$n ($NUM_TRIALS trials)"
+
+    local batch_failures=0
+
+    for ((i=1; i<=NUM_TRIALS; i++)); do
+        local test_name="joint_G${g_size}_H${h_size}_n${n}_id${i}"
+        local input_file="${OUTPUT_DIR}/${test_name}.txt"
+        local seed=$((i * 7919 + g_size * 101 + h_size * 7 + n))
+
+        # 1. Generate a pair that needs edges added
+        $GENERATOR "$g_size" "$h_size" --not-subgraph --seed "$seed" --output "$input_file" > /dev/null 2>&1
+        if [ ! -f "$input_file" ]; then
+            echo -e "  Trial $i: ${RED}GENERATION FAILED${NC}"
+            exit 1
+        fi
+
+        # 2. Solve iteratively, jointly, and jointly with a one-node budget
+        local exact_json joint_json capped_json
+        exact_json=$($SOLVER ext_exact "$input_file" "$n" --format json 2>/dev/null)
+        joint_json=$($SOLVER ext_joint "$input_file" "$n" --format json 2>/dev/null)
+        capped_json=$($SOLVER ext_joint "$input_file" "$n" --format json --max-nodes 1 2>/dev/null)
+
+        local exact_total joint_total capped_total capped_optimal capped_note=""
+        exact_total=$(echo "$exact_json" | total_added)
+        joint_total=$(echo "$joint_json" | total_added)
+        capped_total=$(echo "$capped_json" | total_added)
+        capped_optimal=$(echo "$capped_json" | optimal_flag)
+
+        # 3. Check the totals and the capped incumbent
+        local failure=""
+        if [ -z "$exact_total" ] || [ -z "$joint_total" ] || [ -z "$capped_total" ]; then
+            failure="NO RESULT"
+        elif [ "$joint_total" -gt "$exact_total" ]; then
+            failure="JOINT WORSE ($joint_total > $exact_total)"
+        elif [ "$(echo "$joint_json" | optimal_flag)" != "true" ]; then
+            failure="UNCAPPED NOT OPTIMAL"
+        elif [ "$capped_optimal" != "false" ] && [ "$capped_total" != "$joint_total" ]; then
+            failure="CAPPED CLAIMS OPTIMAL ($capped_total)"
+        elif [ "$capped_total" -gt "$exact_total" ] || [ "$capped_total" -lt "$joint_total" ]; then
+            failure="BAD INCUMBENT ($capped_total)"
+        elif ! valid_mappings "$capped_json" "$n" || ! valid_mappings "$joint_json" "$n"; then
+            failure="INVALID MAPPINGS"
+        fi
+
+        if [ -z "$failure" ]; then
+            [ "$capped_optimal" == "false" ] && capped_note=", capped $capped_total"
+            echo -e "  Trial $i: ${GREEN}SUCCESS${NC} (ext_exact $exact_total, ext_joint $joint_total$capped_note)"
+            rm "$input_file"
+        else
+            echo -e "  Trial $i: ${RED}${failure}${NC}"
+            ((batch_failures++))
+            ((total_failures++))
+            # Keep the pair for debugging
+            mv "$input_file" "${OUTPUT_DIR}/FAIL_${test_name}.txt"
+        fi
+
+        ((total_tests++))
+    done
+
+    # Batch summary
+    if [ $batch_failures -gt 0 ]; then
+        echo -e "Batch Result: ${RED}$batch_failures / $NUM_TRIALS failed${NC}"
+    else
+        echo -e "Batch Result: ${GREEN}100% Success${NC}"
+    fi
+}
+
+# --- TEST PLAN ---
+
+# Small pairs: the joint search finishes quickly
+run_batch 3 6 2
+run_batch 3 6 3
+run_batch 4 8 2
+run_batch 4 8 3
+
+# The sizes of run_tests.sh's extension data
+run_batch 5 9 2
+run_batch 5 9 3
+
+# --- FINAL REPORT ---
+echo "========================================"
+echo "Total Tests: $total_tests"
+echo -e "Failures: ${RED}$total_failures${NC}"
+[ $total_failures -eq 0 ]
@@ -1,130 +1,588 @@
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
+#include "../graph_binary.h"
+
+// Test instance generator: a pattern G and a target H, from one of several
+// graph families. Graphs are built as edge lists in one contiguous array and
+// written out row by row, so memory grows with the edges, not with n^2.
+
+// --- Random numbers: xoshiro256**, seeded through splitmix64 ---
+// (own generator, so a seed gives the same graphs with every C library)
+typedef struct {
+    uint64_t s[4];
+} Rng;
+
+static uint64_t splitmix64(uint64_t *x) {
+    uint64_t z = (*x += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
 
-// --- Helper: Memory Management ---
-int** create_matrix(int size) {
-    int** matrix = (int**)malloc(size * sizeof(int*));
-    for (int i = 0; i < size; i++) {
-        matrix[i] = (int*)calloc(size, sizeof(int)); // calloc initializes to 0
-    }
-    return matrix;
+static void rng_seed(Rng *rng, uint64_t seed) {
+    for (int k = 0; k < 4; k++) rng->s[k] = splitmix64(&seed);
 }
 
-void free_matrix(int** matrix, int size) {
-    for (int i = 0; i < size; i++) {
-        free(matrix[i]);
-    }
-    free(matrix);
+static inline uint64_t rotl(uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
 }
 
-// --- Helper: Sorting for indices ---
-int compare_ints(const void* a, const void* b) {
-    return (*(int*)a - *(int*)b);
+static uint64_t rng_next(Rng *rng) {
+    uint64_t *s = rng->s;
+    uint64_t result = rotl(s[1] * 5, 7) * 9;
+    uint64_t t = s[1] << 17;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rotl(s[3], 45);
+    return result;
 }
 
-// --- Logic: Random Generation ---
-int** generate_random_multigraph(int size, double density, int max_multiedges) {
-    int** matrix = create_matrix(size);
-    for (int i = 0; i < size; i++) {
-        for (int j = 0; j < size; j++) {
-            // Random float between 0.0 and 1.0
-            double r = (double)rand() / (double)RAND_MAX;
-            if (r < density) {
-                matrix[i][j] = (rand() % max_multiedges) + 1;
-            }
-        }
-    }
-    return matrix;
+// Uniform in [0, n)
+static uint32_t rng_below(Rng *rng, uint32_t n) {
+    return (uint32_t) (((rng_next(rng) >> 32) * n) >> 32);
 }
 
-// --- Logic: Permutation ---
-int** permute_matrix(int** matrix, int n) {
-    int* p = (int*)malloc(n * sizeof(int));
-    for (int i = 0; i < n; i++) p[i] = i;
+// Uniform in [0, 1)
+static double rng_double(Rng *rng) {
+    return (double) (rng_next(rng) >> 11) * 0x1.0p-53;
+}
 
-    // Fisher-Yates Shuffle
+static void shuffle(Rng *rng, int *p, int n) {
     for (int i = n - 1; i > 0; i--) {
-        int j = rand() % (i + 1);
+        int j = (int) rng_below(rng, (uint32_t) i + 1);
         int temp = p[i];
         p[i] = p[j];
         p[j] = temp;
     }
+}
+
+static void *xmalloc(size_t size) {
+    void *p = malloc(size > 0 ? size : 1);
+    if (!p) {
+        fprintf(stderr, "Error: out of memory\n");
+        exit(1);
+    }
+    return p;
+}
+
+// Identity permutation of n vertices, shuffled
+static int *random_permutation(Rng *rng, int n) {
+    int *p = (int *) xmalloc((size_t) n * sizeof(int));
+    for (int i = 0; i < n; i++) p[i] = i;
+    shuffle(rng, p, n);
+    return p;
+}
+
+// --- Edge lists ---
+typedef struct {
+    int src, dst, mult;
+} Edge;
+
+typedef struct {
+    int n;
+    Edge *edges;
+    size_t count, cap;
+} EdgeList;
+
+static void edges_init(EdgeList *g, int n) {
+    g->n = n;
+    g->count = 0;
+    g->cap = 1024;
+    g->edges = (Edge *) xmalloc(g->cap * sizeof(Edge));
+}
+
+static void edges_free(EdgeList *g) {
+    free(g->edges);
+    g->edges = NULL;
+    g->count = g->cap = 0;
+}
+
+static void edges_add(EdgeList *g, int src, int dst, int mult) {
+    if (g->count == g->cap) {
+        g->cap *= 2;
+        Edge *grown = (Edge *) realloc(g->edges, g->cap * sizeof(Edge));
+        if (!grown) {
+            fprintf(stderr, "Error: out of memory\n");
+            exit(1);
+        }
+        g->edges = grown;
+    }
+    g->edges[g->count++] = (Edge) {src, dst, mult};
+}
+
+static int compare_edges(const void *a, const void *b) {
+    const Edge *x = (const Edge *) a, *y = (const Edge *) b;
+    if (x->src != y->src) return x->src < y->src ? -1 : 1;
+    if (x->dst != y->dst) return x->dst < y->dst ? -1 : 1;
+    return 0;
+}
+
+// Sort by (src, dst) and merge repeated pairs: multiplicities add up, or the
+// larger one is kept (overlaying one graph on another)
+static void edges_normalize(EdgeList *g, bool take_max) {
+    qsort(g->edges, g->count, sizeof(Edge), compare_edges);
+    size_t out = 0;
+    for (size_t k = 0; k < g->count; k++) {
+        Edge e = g->edges[k];
+        if (out > 0 && g->edges[out - 1].src == e.src && g->edges[out - 1].dst == e.dst) {
+            Edge *last = &g->edges[out - 1];
+            last->mult = take_max ? (e.mult > last->mult ? e.mult : last->mult) : last->mult + e.mult;
+        } else if (e.mult > 0) {
+            g->edges[out++] = e;
+        }
+    }
+    g->count = out;
+}
 
-    int** new_matrix = create_matrix(n);
+static int edges_max_mult(const EdgeList *g) {
+    int max_val = 0;
+    for (size_t k = 0; k < g->count; k++) {
+        if (g->edges[k].mult > max_val) max_val = g->edges[k].mult;
+    }
+    return max_val;
+}
+
+// New id of vertex v is perm_inv[v]
+static void edges_relabel(EdgeList *g, const int *perm_inv) {
+    for (size_t k = 0; k < g->count; k++) {
+        g->edges[k].src = perm_inv[g->edges[k].src];
+        g->edges[k].dst = perm_inv[g->edges[k].dst];
+    }
+    qsort(g->edges, g->count, sizeof(Edge), compare_edges);
+}
+
+// --- Graph families ---
+typedef enum {
+    FAMILY_UNIFORM,   // Every cell an edge with probability density
+    FAMILY_SCALEFREE, // Preferential attachment, degree edges per vertex
+    FAMILY_GRID,      // 2D lattice, both directions
+    FAMILY_REGULAR,   // Union of degree random permutations: every in- and out-degree equal
+    FAMILY_SYMMETRIC, // Circulant (vertex-transitive) plus a few random edges
+    FAMILY_CORE,      // Dense core (density) with a sparse periphery attached to it
+} Family;
+
+static const char *const family_names[] = {
+    [FAMILY_UNIFORM] = "uniform",
+    [FAMILY_SCALEFREE] = "scalefree",
+    [FAMILY_GRID] = "grid",
+    [FAMILY_REGULAR] = "regular",
+    [FAMILY_SYMMETRIC] = "symmetric",
+    [FAMILY_CORE] = "core",
+};
+#define NUM_FAMILIES ((int) (sizeof(family_names) / sizeof(family_names[0])))
+
+typedef struct {
+    Family family;
+    double density;  // uniform, and the core of core
+    int degree;      // scalefree, regular, symmetric, core periphery
+    int max_mult;    // Largest random multiplicity
+    double core;     // core: fraction of vertices in the core
+    int perturb;     // symmetric: extra random edges (-1 = n / 100, at least 1)
+} GenParams;
+
+static int random_mult(Rng *rng, int max_mult) {
+    return 1 + (int) rng_below(rng, (uint32_t) max_mult);
+}
+
+// Each cell of the rows x cols block at (row0, col0) becomes an edge with
+// probability p. Geometric skips between edges: the cost is the number of
+// edges, not of cells.
+static void uniform_block(EdgeList *g, Rng *rng, int row0, int col0, uint64_t rows, uint64_t cols,
+                          double p, int max_mult) {
+    uint64_t cells = rows * cols;
+    if (p <= 0 || cells == 0) return;
+    if (p >= 1) {
+        for (uint64_t c = 0; c < cells; c++) {
+            edges_add(g, row0 + (int) (c / cols), col0 + (int) (c % cols), random_mult(rng, max_mult));
+        }
+        return;
+    }
+    double log_q = log1p(-p);
+    uint64_t c = 0;
+    while (c < cells) {
+        double skip = floor(log1p(-rng_double(rng)) / log_q);
+        if (skip >= (double) (cells - c)) break;
+        c += (uint64_t) skip;
+        edges_add(g, row0 + (int) (c / cols), col0 + (int) (c % cols), random_mult(rng, max_mult));
+        c++;
+    }
+}
+
+static void gen_scalefree(EdgeList *g, Rng *rng, int n, int m, int max_mult) {
+    if (n < 2) return;
+    if (m < 1) m = 1;
+    int seed_size = m + 1 < n ? m + 1 : n;
+
+    // Every edge puts both endpoints here, so a uniform pick is degree-proportional
+    int *ends = (int *) xmalloc((2 * (size_t) seed_size + 2 * (size_t) n * m) * sizeof(int));
+    int *picked = (int *) xmalloc((size_t) m * sizeof(int));
+    size_t num_ends = 0;
+    for (int i = 0; i < seed_size; i++) {
+        int j = (i + 1) % seed_size;
+        edges_add(g, i, j, random_mult(rng, max_mult));
+        ends[num_ends++] = i;
+        ends[num_ends++] = j;
+    }
+    for (int v = seed_size; v < n; v++) {
+        for (int k = 0; k < m; k++) {
+            int t = ends[rng_below(rng, (uint32_t) num_ends)];
+            picked[k] = t;
+            if (rng_next(rng) & 1) {
+                edges_add(g, v, t, random_mult(rng, max_mult));
+            } else {
+                edges_add(g, t, v, random_mult(rng, max_mult));
+            }
+        }
+        // Only now, so v does not link to itself
+        for (int k = 0; k < m; k++) {
+            ends[num_ends++] = v;
+            ends[num_ends++] = picked[k];
+        }
+    }
+    free(picked);
+    free(ends);
+}
+
+static void gen_grid(EdgeList *g, int n) {
+    int w = (int) ceil(sqrt((double) n));
     for (int i = 0; i < n; i++) {
-        for (int j = 0; j < n; j++) {
-            new_matrix[i][j] = matrix[p[i]][p[j]];
+        if ((i % w) + 1 < w && i + 1 < n) {
+            edges_add(g, i, i + 1, 1);
+            edges_add(g, i + 1, i, 1);
+        }
+        if (i + w < n) {
+            edges_add(g, i, i + w, 1);
+            edges_add(g, i + w, i, 1);
+        }
+    }
+}
+
+static void gen_regular(EdgeList *g, Rng *rng, int n, int d) {
+    for (int k = 0; k < d; k++) {
+        int *p = random_permutation(rng, n);
+        for (int i = 0; i < n; i++) edges_add(g, i, p[i], 1);
+        free(p);
+    }
+}
+
+static void gen_symmetric(EdgeList *g, Rng *rng, int n, int d, int perturb, int max_mult) {
+    if (n < 2) return;
+    if (d > n - 1) d = n - 1;
+    int *offsets = random_permutation(rng, n - 1); // Offsets 1..n-1, in random order
+    for (int k = 0; k < d; k++) {
+        int s = offsets[k] + 1;
+        int mult = (s % max_mult) + 1; // Same for every edge of an offset: rotations stay automorphisms
+        for (int i = 0; i < n; i++) edges_add(g, i, (i + s) % n, mult);
+    }
+    free(offsets);
+
+    if (perturb < 0) perturb = n / 100 > 1 ? n / 100 : 1;
+    for (int k = 0; k < perturb; k++) {
+        edges_add(g, (int) rng_below(rng, (uint32_t) n), (int) rng_below(rng, (uint32_t) n), 1);
+    }
+}
+
+static void gen_core(EdgeList *g, Rng *rng, int n, const GenParams *params) {
+    int c = (int) lround(params->core * n);
+    if (c < 1) c = 1;
+    if (c > n) c = n;
+    uniform_block(g, rng, 0, 0, (uint64_t) c, (uint64_t) c, params->density, params->max_mult);
+
+    // Periphery vertices mostly link into the core
+    for (int v = c; v < n; v++) {
+        for (int k = 0; k < params->degree; k++) {
+            int t = rng_double(rng) < 0.8 ? (int) rng_below(rng, (uint32_t) c) : (int) rng_below(rng, (uint32_t) n);
+            if (rng_next(rng) & 1) {
+                edges_add(g, v, t, random_mult(rng, params->max_mult));
+            } else {
+                edges_add(g, t, v, random_mult(rng, params->max_mult));
+            }
         }
     }
-    free(p);
-    return new_matrix;
+}
+
+static void generate(EdgeList *g, Rng *rng, int n, const GenParams *params) {
+    edges_init(g, n);
+    switch (params->family) {
+        case FAMILY_UNIFORM:
+            uniform_block(g, rng, 0, 0, (uint64_t) n, (uint64_t) n, params->density, params->max_mult);
+            break;
+        case FAMILY_SCALEFREE:
+            gen_scalefree(g, rng, n, params->degree, params->max_mult);
+            break;
+        case FAMILY_GRID:
+            gen_grid(g, n);
+            break;
+        case FAMILY_REGULAR:
+            gen_regular(g, rng, n, params->degree);
+            break;
+        case FAMILY_SYMMETRIC:
+            gen_symmetric(g, rng, n, params->degree, params->perturb, params->max_mult);
+            break;
+        case FAMILY_CORE:
+            gen_core(g, rng, n, params);
+            break;
+    }
+    edges_normalize(g, false);
 }
 
 // --- Logic: Subgraph Extraction ---
-int** extract_subgraph(int** H_matrix, int H_size, int sub_size) {
-    if (sub_size > H_size) {
-        fprintf(stderr, "Error: Subgraph size cannot be larger than original graph.\n");
-        exit(1);
+// G: the subgraph of H induced by g_size random vertices, kept in H order
+static void extract_subgraph(const EdgeList *h, int g_size, Rng *rng, EdgeList *g) {
+    int *picked = random_permutation(rng, h->n);
+    int *new_id = (int *) xmalloc((size_t) h->n * sizeof(int));
+    for (int i = 0; i < h->n; i++) new_id[i] = -1;
+    for (int i = 0; i < g_size; i++) new_id[picked[i]] = 0;
+    for (int i = 0, next = 0; i < h->n; i++) {
+        if (new_id[i] == 0) new_id[i] = next++;
+    }
+
+    edges_init(g, g_size);
+    for (size_t k = 0; k < h->count; k++) {
+        const Edge *e = &h->edges[k];
+        if (new_id[e->src] >= 0 && new_id[e->dst] >= 0) edges_add(g, new_id[e->src], new_id[e->dst], e->mult);
     }
+    free(new_id);
+    free(picked);
+}
 
-    // select random unique indices
-    int* all_indices = (int*)malloc(H_size * sizeof(int));
-    for (int i = 0; i < H_size; i++) all_indices[i] = i;
+// --- Logic: Planting ---
+// Overlay G on g_size random H vertices, raising H cells to at least G's.
+// With short_edge >= 0, G's edge number short_edge is planted one unit lower and its H
+// cell set to exactly that, whatever H had there: the copy then just misses.
+static void plant_subgraph(EdgeList *h, const EdgeList *g, long short_edge, Rng *rng) {
+    int *target = random_permutation(rng, h->n);
+    for (size_t k = 0; k < g->count; k++) {
+        const Edge *e = &g->edges[k];
+        edges_add(h, target[e->src], target[e->dst], (long) k == short_edge ? e->mult - 1 : e->mult);
+    }
+    edges_normalize(h, true);
+
+    if (short_edge >= 0) {
+        const Edge *e = &g->edges[short_edge];
+        Edge key = {target[e->src], target[e->dst], 0};
+        Edge *cell = (Edge *) bsearch(&key, h->edges, h->count, sizeof(Edge), compare_edges);
+        if (cell) {
+            cell->mult = e->mult - 1;
+            edges_normalize(h, false); // Drops the cell if it is now empty
+        }
+    }
+    free(target);
+}
 
-    // Shuffle and pick first sub_size elements (mimics random.sample)
-    for (int i = H_size - 1; i > 0; i--) {
-        int j = rand() % (i + 1);
-        int temp = all_indices[i];
-        all_indices[i] = all_indices[j];
-        all_indices[j] = temp;
+// Make one G edge heavier than any H edge, or add one if G has none
+static void break_subgraph(EdgeList *g, int max_in_h, Rng *rng) {
+    if (g->count > 0) {
+        g->edges[rng_below(rng, (uint32_t) g->count)].mult = max_in_h + 1;
+    } else {
+        edges_add(g, (int) rng_below(rng, (uint32_t) g->n), (int) rng_below(rng, (uint32_t) g->n), max_in_h + 1);
+        edges_normalize(g, false);
     }
+}
+
+// --- Output ---
+typedef enum {
+    FORMAT_TEXT,   // Adjacency matrices
+    FORMAT_EDGES,  // Edge-list sections ("edges <n>")
+    FORMAT_BINARY, // .aacg container with both matrices
+} Format;
+
+typedef struct {
+    FILE *f;
+    size_t len;
+    char buf[1 << 16];
+} Writer;
+
+static void put_flush(Writer *w) {
+    if (w->len > 0) fwrite(w->buf, 1, w->len, w->f);
+    w->len = 0;
+}
+
+static inline void put_char(Writer *w, char c) {
+    if (w->len == sizeof(w->buf)) put_flush(w);
+    w->buf[w->len++] = c;
+}
+
+static void put_str(Writer *w, const char *s) {
+    while (*s) put_char(w, *s++);
+}
 
-    // Sort the chosen indices to maintain relative order (optional, but matches Python sort)
-    qsort(all_indices, sub_size, sizeof(int), compare_ints);
+static void put_int(Writer *w, long long value) {
+    char digits[24];
+    int k = 0;
+    unsigned long long v = value < 0 ? 0ull - (unsigned long long) value : (unsigned long long) value;
+    do {
+        digits[k++] = (char) ('0' + v % 10);
+        v /= 10;
+    } while (v > 0);
+    if (value < 0) put_char(w, '-');
+    while (k > 0) put_char(w, digits[--k]);
+}
 
-    int** G_matrix = create_matrix(sub_size);
-    for (int i = 0; i < sub_size; i++) {
-        for (int j = 0; j < sub_size; j++) {
-            G_matrix[i][j] = H_matrix[all_indices[i]][all_indices[j]];
+static void write_matrix_text(Writer *w, const EdgeList *g) {
+    put_int(w, g->n);
+    put_char(w, '\n');
+    size_t k = 0;
+    for (int i = 0; i < g->n; i++) {
+        for (int j = 0; j < g->n; j++) {
+            int val = 0;
+            if (k < g->count && g->edges[k].src == i && g->edges[k].dst == j) val = g->edges[k++].mult;
+            put_int(w, val);
+            put_char(w, j == g->n - 1 ? '\n' : ' ');
         }
     }
+}
 
-    free(all_indices);
-    return G_matrix;
+static void write_edges_text(Writer *w, const EdgeList *g) {
+    put_str(w, "edges ");
+    put_int(w, g->n);
+    put_char(w, '\n');
+    for (size_t k = 0; k < g->count; k++) {
+        const Edge *e = &g->edges[k];
+        put_int(w, e->src);
+        put_char(w, ' ');
+        put_int(w, e->dst);
+        if (e->mult != 1) {
+            put_char(w, ' ');
+            put_int(w, e->mult);
+        }
+        put_char(w, '\n');
+    }
 }
 
-int get_max_weight(int** matrix, int size) {
-    int max_val = 0;
-    for (int i = 0; i < size; i++) {
-        for (int j = 0; j < size; j++) {
-            if (matrix[i][j] > max_val) max_val = matrix[i][j];
+// Dense rows, one buffer of n ints at a time
+static void write_matrix_rows(FILE *f, const EdgeList *g) {
+    int *row = (int *) xmalloc((size_t) g->n * sizeof(int));
+    size_t k = 0;
+    for (int i = 0; i < g->n; i++) {
+        memset(row, 0, (size_t) g->n * sizeof(int));
+        while (k < g->count && g->edges[k].src == i) {
+            row[g->edges[k].dst] = g->edges[k].mult;
+            k++;
         }
+        fwrite(row, sizeof(int), (size_t) g->n, f);
     }
-    return max_val;
+    free(row);
+}
+
+// --- Output: Binary container (see graph_binary.h) ---
+static void write_binary(FILE *f, const EdgeList *g, const EdgeList *h) {
+    AacgHeader hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, AACG_MAGIC, 8);
+    hdr.version = AACG_VERSION;
+    hdr.endian_tag = AACG_ENDIAN_TAG;
+    hdr.num_graphs = 2;
+    hdr.elem_width = 4;
+    hdr.n[0] = g->n;
+    hdr.n[1] = h->n;
+    hdr.offset[0] = AACG_DATA_START;
+    hdr.offset[1] = aacg_align(AACG_DATA_START + aacg_dense_size(g->n, 4));
+
+    static const char zeros[AACG_ALIGN];
+    fwrite(&hdr, sizeof(hdr), 1, f);
+    fwrite(zeros, 1, AACG_DATA_START - sizeof(hdr), f);
+    write_matrix_rows(f, g);
+    fwrite(zeros, 1, hdr.offset[1] - AACG_DATA_START - aacg_dense_size(g->n, 4), f);
+    write_matrix_rows(f, h);
 }
 
 // --- Main ---
-int main(int argc, char* argv[]) {
-    srand(time(NULL)); // Seed RNG
+typedef enum {
+    PATTERN_INDUCED, // G cut from H (the default)
+    PATTERN_PLANT,   // G from the family, hidden in H
+} PatternMode;
+
+static void print_usage(const char *prog_name) {
+    printf("Usage: %s <g_size> <h_size> [options] --output <file>\n\n", prog_name);
+    printf("Options:\n");
+    printf("  --family <name>       uniform (default), scalefree, grid, regular, symmetric or core\n");
+    printf("  --density <p>         Edge probability of uniform graphs and of the core (default 0.3)\n");
+    printf("  --degree <d>          Edges per vertex: scalefree, regular, symmetric, core periphery (default 3)\n");
+    printf("  --core <fraction>     core: share of the vertices in the dense core (default 0.1)\n");
+    printf("  --perturb <count>     symmetric: random extra edges (default n/100, at least 1)\n");
+    printf("  --max-mult <m>        Largest random multiplicity (default 4)\n");
+    printf("  --plant               Generate G from the family too and hide it in H (default: cut G from H)\n");
+    printf("  --near-miss           With --plant: hide G with one edge one lower, so that copy barely misses\n");
+    printf("                        (G may still embed elsewhere in H)\n");
+    printf("  --not-subgraph        Make one G edge heavier than any H edge\n");
+    printf("  --format <f>          text (matrices, default), edges (edge lists) or binary (.aacg)\n");
+    printf("  --binary              Same as --format binary\n");
+    printf("  --count <k>           Write k instances back to back (text and edges; for batch)\n");
+    printf("  --seed <n>            Seed (default: the current time)\n");
+    printf("  --output <file>       Output file, - for stdout\n");
+}
 
-    // Quick and dirty arg parsing
-    // Usage: ./graph_gen <g_size> <h_size> [--not-subgraph] --output <file>
+int main(int argc, char* argv[]) {
     if (argc < 5) {
-        printf("Usage: %s <g_size> <h_size> [--not-subgraph] --output <file>\n", argv[0]);
+        print_usage(argv[0]);
         return 1;
     }
 
     int g_size = atoi(argv[1]);
     int h_size = atoi(argv[2]);
+    GenParams params = {FAMILY_UNIFORM, 0.3, 3, 4, 0.1, -1};
+    PatternMode pattern = PATTERN_INDUCED;
+    bool near_miss = false;
     int is_subgraph = 1; // Default True
+    Format format = FORMAT_TEXT;
+    int count = 1;
+    uint64_t seed = (uint64_t) time(NULL);
     char* output_file = NULL;
 
     // Loop through remaining args
     for (int i = 3; i < argc; i++) {
         if (strcmp(argv[i], "--not-subgraph") == 0) {
             is_subgraph = 0;
+        } else if (strcmp(argv[i], "--binary") == 0) {
+            format = FORMAT_BINARY;
+        } else if (strcmp(argv[i], "--plant") == 0) {
+            pattern = PATTERN_PLANT;
+        } else if (strcmp(argv[i], "--near-miss") == 0) {
+            near_miss = true;
+        } else if (strcmp(argv[i], "--family") == 0 && i + 1 < argc) {
+            const char *name = argv[++i];
+            int f = 0;
+            while (f < NUM_FAMILIES && strcmp(name, family_names[f]) != 0) f++;
+            if (f == NUM_FAMILIES) {
+                fprintf(stderr, "Error: unknown family '%s'\n", name);
+                return 1;
+            }
+            params.family = (Family) f;
+        } else if (strcmp(argv[i], "--format") == 0 && i + 1 < argc) {
+            const char *name = argv[++i];
+            if (strcmp(name, "text") == 0) {
+                format = FORMAT_TEXT;
+            } else if (strcmp(name, "edges") == 0) {
+                format = FORMAT_EDGES;
+            } else if (strcmp(name, "binary") == 0) {
+                format = FORMAT_BINARY;
+            } else {
+                fprintf(stderr, "Error: --format expects text, edges or binary\n");
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--density") == 0 && i + 1 < argc) {
+            params.density = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--degree") == 0 && i + 1 < argc) {
+            params.degree = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--core") == 0 && i + 1 < argc) {
+            params.core = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--perturb") == 0 && i + 1 < argc) {
+            params.perturb = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--max-mult") == 0 && i + 1 < argc) {
+            params.max_mult = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--count") == 0 && i + 1 < argc) {
+            count = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = strtoull(argv[++i], NULL, 10); // Same seed, same graphs
         } else if (strcmp(argv[i], "--output") == 0) {
             if (i + 1 < argc) {
                 output_file = argv[i + 1];
@@ -137,78 +595,83 @@ int main(int argc, char* argv[]) {
         fprintf(stderr, "Error: --output filename required.\n");
         return 1;
     }
-
-    // 1. Generate H
-    int** H_base = generate_random_multigraph(h_size, 0.3, 4);
-
-    // 2. Extract G
-    int** G = extract_subgraph(H_base, h_size, g_size);
-    int** H_final;
-
-    // 3. Apply Logic
-    if (is_subgraph) {
-        H_final = permute_matrix(H_base, h_size);
-    } else {
-        int max_weight_in_H = get_max_weight(H_base, h_size);
-
-        // Find existing edges
-        int r = -1, c = -1;
-        // Simple search for first non-zero edge, or random if empty
-        int found = 0;
-        int attempts = 0;
-
-        // Try to find an existing edge to boost (up to 100 tries to keep it fast)
-        while (attempts < 100 && !found) {
-            int tr = rand() % g_size;
-            int tc = rand() % g_size;
-            if (G[tr][tc] > 0) {
-                r = tr; c = tc;
-                found = 1;
-            }
-            attempts++;
-        }
-
-        // Fallback if graph is empty or search failed
-        if (!found) {
-            r = rand() % g_size;
-            c = rand() % g_size;
-        }
-
-        G[r][c] = max_weight_in_H + 1;
-        H_final = permute_matrix(H_base, h_size);
+    if (g_size < 1 || h_size < 1) {
+        fprintf(stderr, "Error: graph sizes must be positive.\n");
+        return 1;
+    }
+    if (g_size > h_size) {
+        fprintf(stderr, "Error: Subgraph size cannot be larger than original graph.\n");
+        return 1;
+    }
+    if (params.degree < 1 || params.max_mult < 1 || count < 1) {
+        fprintf(stderr, "Error: --degree, --max-mult and --count must be at least 1.\n");
+        return 1;
+    }
+    if (near_miss && pattern != PATTERN_PLANT) {
+        fprintf(stderr, "Error: --near-miss needs --plant.\n");
+        return 1;
+    }
+    if (format == FORMAT_BINARY && count > 1) {
+        fprintf(stderr, "Error: a binary file holds one instance; use text or edges with --count.\n");
+        return 1;
     }
 
-    // 4. Write Output
-    FILE* f = fopen(output_file, "w");
+    bool to_stdout = strcmp(output_file, "-") == 0;
+    FILE* f = to_stdout ? stdout : fopen(output_file, format == FORMAT_BINARY ? "wb" : "w");
     if (!f) {
         perror("Error opening file");
         return 1;
     }
-
-    // Write G
-    fprintf(f, "%d\n", g_size);
-    for (int i = 0; i < g_size; i++) {
-        for (int j = 0; j < g_size; j++) {
-            fprintf(f, "%d%s", G[i][j], (j == g_size - 1) ? "" : " ");
+    Writer *w = (Writer *) xmalloc(sizeof(Writer));
+    w->f = f;
+    w->len = 0;
+
+    Rng rng;
+    rng_seed(&rng, seed);
+    for (int instance = 0; instance < count; instance++) {
+        // 1. Generate H and G
+        EdgeList h, g;
+        generate(&h, &rng, h_size, &params);
+        if (pattern == PATTERN_PLANT) {
+            generate(&g, &rng, g_size, &params);
+            // Near miss: hide a copy one unit short on one edge, so that edge keeps the copy out
+            long short_edge = near_miss && g.count > 0 ? (long) rng_below(&rng, (uint32_t) g.count) : -1;
+            plant_subgraph(&h, &g, short_edge, &rng);
+        } else {
+            extract_subgraph(&h, g_size, &rng, &g);
         }
-        fprintf(f, "\n");
-    }
 
-    // Write H
-    fprintf(f, "%d\n", h_size);
-    for (int i = 0; i < h_size; i++) {
-        for (int j = 0; j < h_size; j++) {
-            fprintf(f, "%d%s", H_final[i][j], (j == h_size - 1) ? "" : " ");
+        // 2. Apply Logic
+        if (!is_subgraph) break_subgraph(&g, edges_max_mult(&h), &rng);
+
+        // 3. Hide where G came from
+        int *p = random_permutation(&rng, h_size);
+        int *p_inv = (int *) xmalloc((size_t) h_size * sizeof(int));
+        for (int i = 0; i < h_size; i++) p_inv[p[i]] = i;
+        edges_relabel(&h, p_inv);
+        free(p_inv);
+        free(p);
+
+        // 4. Write Output
+        if (format == FORMAT_BINARY) {
+            write_binary(f, &g, &h);
+        } else if (format == FORMAT_EDGES) {
+            write_edges_text(w, &g);
+            write_edges_text(w, &h);
+        } else {
+            write_matrix_text(w, &g);
+            write_matrix_text(w, &h);
         }
-        fprintf(f, "\n");
+        edges_free(&g);
+        edges_free(&h);
     }
+    put_flush(w);
+    free(w);
 
-    fclose(f);
-
-    // Cleanup memory
-    free_matrix(H_base, h_size);
-    free_matrix(H_final, h_size);
-    free_matrix(G, g_size);
-
-    return 0;
-}
\ No newline at end of file
+    int rc = 0;
+    if (to_stdout ? fflush(f) != 0 : fclose(f) != 0) {
+        perror("Error writing file");
+        rc = 1;
+    }
+    return rc;
+}
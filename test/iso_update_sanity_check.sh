@@ -0,0 +1,195 @@
+#!/bin/bash
+
+# ============================================================================
+# Sanity Check: Incremental Embeddings (iso_update)
+# Applies random lines of "src dst delta" changes to H through iso_update and
+# keeps a running set of embeddings from the gained and lost lists. After
+# every line the set must equal a fresh iso_exact enumeration of the updated H.
+# G is stripped of loops, since iso_update also fits G loops under H loops and
+# iso_exact does not.
+# ============================================================================
+
+# --- CONFIGURATION ---
+GENERATOR="./graph_gen"
+SOLVER="../build/aac"
+OUTPUT_DIR="./debug_data"
+NUM_TRIALS=10
+NUM_UPDATES=20
+MAX_EMBEDDINGS=1000 # iso_exact's limit on the mappings it returns
+
+# Colors
+GREEN='\033[0;32m'
+RED='\033[0;31m'
+NC='\033[0m'
+
+mkdir -p "$OUTPUT_DIR"
+export LC_ALL=C # sort and comm must agree on the order
+
+# Counters
+total_tests=0
+total_failures=0
+
+# Sorted "a,b,c" lines of every mapping in an iso_exact JSON result
+exact_embeddings() {
+    grep -o '"mapping":\[[0-9,]*\]' | sed 's/.*\[\(.*\)\]/\1/' | sort
+}
+
+# Sorted "a,b,c" lines of the list under key in one iso_update JSON line
+# (next = the key that follows it)
+update_embeddings() {
+    local key=$1 next=$2
+    sed -n "s/.*\"$key\":\[\(.*\)\],\"$next\".*/\1/p" | grep -o '\[[0-9,]*\]' | tr -d '[]' | sort
+}
+
+# Sorted "a,b,c" lines of every embedding of a pair text
+fresh_embeddings() {
+    echo "$1" > "$pair_file"
+    $SOLVER iso_exact "$pair_file" "$MAX_EMBEDDINGS" --format json < /dev/null 2>/dev/null | exact_embeddings
+}
+
+# Write G (loops cleared) and the current H matrix as a text pair
+write_pair() {
+    local file=$1
+    echo "$g_block" > "$file"
+    echo "$h_size" >> "$file"
+    for ((r=0; r<h_size; r++)); do
+        local row=""
+        for ((c=0; c<h_size; c++)); do row+="${h[r * h_size + c]} "; done
+        echo "${row% }" >> "$file"
+    done
+}
+
+run_batch() {
+    local g_size=$1  # Pattern G
+    local h_size=$2  # Host H
+    local density=$3 # Density of H
+
+    echo "----------------------------------------------------"
+    echo "Testing iso_update: G=$g_size, H=$h_size, density $density ($NUM_TRIALS trials of $NUM_UPDATES lines)"
+
+    local batch_failures=0
+
+    for ((i=1; i<=NUM_TRIALS; i++)); do
+        local test_name="update_G${g_size}_H${h_size}_id${i}"
+        local source_file="${OUTPUT_DIR}/${test_name}_source.txt"
+        local start_file="${OUTPUT_DIR}/${test_name}_start.txt"
+        pair_file="${OUTPUT_DIR}/${test_name}_pair.txt"
+        local updates_file="${OUTPUT_DIR}/${test_name}_updates.txt"
+        local seed=$((i * 7919 + g_size * 101 + h_size))
+        RANDOM=$seed
+
+        # 1. Generate a pair with G planted, clear G's loops and load H
+        $GENERATOR "$g_size" "$h_size" --plant --density "$density" --seed "$seed" --output "$source_file" > /dev/null 2>&1
+        if [ ! -f "$source_file" ]; then
+            echo -e "  Trial $i: ${RED}GENERATION FAILED${NC}"
+            exit 1
+        fi
+        g_block=$(awk -v n="$g_size" 'NR == 1 { print; next } NR <= n + 1 { $(NR - 1) = 0; print }' "$source_file")
+        h=($(awk -v n="$g_size" 'NR > n + 2' "$source_file"))
+
+        # 2. Random update lines of one to three changes on distinct cells;
+        #    a negative delta never takes a cell below zero
+        local snapshots=()
+        write_pair "$start_file"
+        snapshots+=("$(cat "$start_file")")
+        : > "$updates_file"
+        for ((k=1; k<=NUM_UPDATES; k++)); do
+            local line="" changes=$((RANDOM % 3 + 1)) cells=" "
+            for ((c=0; c<changes; c++)); do
+                local src=$((RANDOM % h_size)) dst=$((RANDOM % h_size))
+                local idx=$((src * h_size + dst))
+                [[ "$cells" == *" $idx "* ]] && continue
+                cells+="$idx "
+                local delta=$((RANDOM % (h[idx] + 3) - h[idx]))
+                [ "$delta" -eq 0 ] && delta=1
+                h[idx]=$((h[idx] + delta))
+                line+="$src $dst $delta "
+            done
+            echo "${line% }" >> "$updates_file"
+            write_pair "$pair_file"
+            snapshots+=("$(cat "$pair_file")")
+        done
+
+        # 3. Replay the lines and check the running set after each one
+        local failure="" running step=0
+        running=$(fresh_embeddings "${snapshots[0]}")
+        while IFS= read -r json; do
+            if [ "$step" -eq 0 ]; then
+                local registered
+                registered=$(echo "$json" | sed -n 's/.*"embeddings":\([0-9]*\).*/\1/p')
+                if [ "$registered" != "$(echo -n "$running" | grep -c .)" ]; then
+                    failure="REGISTERED $registered"
+                    break
+                fi
+                step=1
+                continue
+            fi
+
+            local gained lost
+            gained=$(echo "$json" | update_embeddings gained lost)
+            lost=$(echo "$json" | update_embeddings lost nodes)
+            if [ -n "$lost" ] && [ -n "$(comm -13 <(echo "$running") <(echo "$lost"))" ]; then
+                failure="LINE $step LOST AN UNKNOWN EMBEDDING"
+                break
+            fi
+            if [ -n "$gained" ] && [ -n "$(comm -12 <(echo "$running") <(echo "$gained"))" ]; then
+                failure="LINE $step GAINED A KNOWN EMBEDDING"
+                break
+            fi
+            running=$(comm -23 <(echo "$running") <(echo "$lost") | cat - <(echo "$gained") | grep . | sort)
+
+            local fresh
+            fresh=$(fresh_embeddings "${snapshots[$step]}")
+            if [ "$(echo -n "$fresh" | grep -c .)" -ge "$MAX_EMBEDDINGS" ]; then
+                failure="LINE $step HAS TOO MANY EMBEDDINGS"
+                break
+            fi
+            if [ "$running" != "$fresh" ]; then
+                failure="LINE $step DIFFERS"
+                break
+            fi
+            ((step++))
+        done < <($SOLVER iso_update "$start_file" "$updates_file" --format json 2>/dev/null)
+        if [ -z "$failure" ] && [ "$step" -ne $((NUM_UPDATES + 1)) ]; then
+            failure="ONLY $((step - 1)) LINES APPLIED"
+        fi
+
+        if [ -z "$failure" ]; then
+            echo -e "  Trial $i: ${GREEN}SUCCESS${NC} ($(echo -n "$running" | grep -c .) embeddings at the end)"
+            rm "$source_file" "$start_file" "$pair_file" "$updates_file"
+        else
+            echo -e "  Trial $i: ${RED}${failure}${NC}"
+            ((batch_failures++))
+            ((total_failures++))
+            # Keep the starting pair and the updates for debugging
+            rm "$source_file" "$pair_file"
+            mv "$start_file" "${OUTPUT_DIR}/FAIL_${test_name}_pair.txt"
+            mv "$updates_file" "${OUTPUT_DIR}/FAIL_${test_name}_updates.txt"
+        fi
+
+        ((total_tests++))
+    done
+
+    # Batch summary
+    if [ $batch_failures -gt 0 ]; then
+        echo -e "Batch Result: ${RED}$batch_failures / $NUM_TRIALS failed${NC}"
+    else
+        echo -e "Batch Result: ${GREEN}100% Success${NC}"
+    fi
+}
+
+# --- TEST PLAN ---
+
+# Dense hosts: many embeddings gained and lost per line
+run_batch 3 6 0.5
+run_batch 3 8 0.4
+
+# Larger patterns on sparser hosts
+run_batch 4 10 0.3
+run_batch 5 12 0.3
+
+# --- FINAL REPORT ---
+echo "========================================"
+echo "Total Tests: $total_tests"
+echo -e "Mismatches: ${RED}$total_failures${NC}"
+[ $total_failures -eq 0 ]
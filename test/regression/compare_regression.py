@@ -0,0 +1,102 @@
+#!/usr/bin/env python3
+"""
+Performance Regression Comparison
+Compares a run of run_regression.py against a baseline CSV. A case is flagged
+SLOWER when its median grew by more than the threshold and a one-sided
+Mann-Whitney U test on the samples says the shift is significant; a case whose
+answer (mappings found, edges added) changed is flagged CHANGED. Either makes
+the exit code 1.
+"""
+
+import argparse
+import csv
+import math
+import sys
+
+
+def load_results(path):
+    """Rows of a results CSV by case name, with the samples as floats."""
+    results = {}
+    with open(path, "r") as f:
+        for row in csv.DictReader(f):
+            row["samples"] = [float(s) for s in row["samples_ms"].split()]
+            row["median"] = float(row["median_ms"])
+            results[row["name"]] = row
+    return results
+
+
+def mann_whitney_greater(current, baseline):
+    """One-sided p-value that current samples tend to be larger than baseline
+    ones (normal approximation with tie and continuity correction)."""
+    n1, n2 = len(current), len(baseline)
+    pooled = sorted([(v, 0) for v in current] + [(v, 1) for v in baseline])
+
+    # Average ranks over ties
+    ranks = [0.0] * len(pooled)
+    tie_term = 0.0
+    i = 0
+    while i < len(pooled):
+        j = i
+        while j + 1 < len(pooled) and pooled[j + 1][0] == pooled[i][0]:
+            j += 1
+        for k in range(i, j + 1):
+            ranks[k] = (i + j) / 2 + 1
+        t = j - i + 1
+        tie_term += t ** 3 - t
+        i = j + 1
+
+    rank_sum = sum(r for r, (_, group) in zip(ranks, pooled) if group == 0)
+    u = rank_sum - n1 * (n1 + 1) / 2
+    n = n1 + n2
+    variance = n1 * n2 / 12 * ((n + 1) - tie_term / (n * (n - 1)))
+    if variance <= 0:
+        return 1.0
+    z = (u - n1 * n2 / 2 - 0.5) / math.sqrt(variance)
+    return 0.5 * math.erfc(z / math.sqrt(2))
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Flag slowdowns against a baseline.")
+    parser.add_argument("baseline", help="baseline CSV (from run_regression.py)")
+    parser.add_argument("current", help="CSV of the build under test")
+    parser.add_argument("--threshold", type=float, default=0.05,
+                        help="smallest median slowdown that counts, as a fraction (default 0.05)")
+    parser.add_argument("--alpha", type=float, default=0.01, help="significance level (default 0.01)")
+    args = parser.parse_args()
+
+    baseline = load_results(args.baseline)
+    current = load_results(args.current)
+
+    print(f"{'case':<28} {'baseline':>10} {'current':>10} {'change':>8} {'p':>8}  verdict")
+    failed = False
+    for name, cur in current.items():
+        base = baseline.get(name)
+        if base is None:
+            print(f"{name:<28} {'-':>10} {cur['median']:>10.3f} {'':>8} {'':>8}  NEW")
+            continue
+
+        change = cur["median"] / base["median"] - 1 if base["median"] > 0 else 0.0
+        p_slower = mann_whitney_greater(cur["samples"], base["samples"])
+        p_faster = mann_whitney_greater(base["samples"], cur["samples"])
+        if (cur["found"], cur["edges_added"]) != (base["found"], base["edges_added"]):
+            verdict, p = "CHANGED (answer differs)", p_slower
+            failed = True
+        elif change > args.threshold and p_slower < args.alpha:
+            verdict, p = "SLOWER", p_slower
+            failed = True
+        elif -change > args.threshold and p_faster < args.alpha:
+            verdict, p = "faster", p_faster
+        else:
+            verdict, p = "ok", min(p_slower, p_faster)
+        print(f"{name:<28} {base['median']:>10.3f} {cur['median']:>10.3f} {change:>+8.1%} {p:>8.4f}  {verdict}")
+
+    for name in baseline:
+        if name not in current:
+            print(f"{name:<28} {baseline[name]['median']:>10.3f} {'-':>10} {'':>8} {'':>8}  MISSING")
+
+    print("\nRegression detected." if failed else "\nNo regressions.")
+    return 1 if failed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,45 @@
+#!/bin/bash
+
+# ============================================================================
+# Regenerate the pinned regression instances
+#
+# The instances are committed: they were made by the earlier rand()-based
+# graph_gen, and the current generator (its own PRNG, the same graphs on every
+# platform) gives different graphs for the same seeds. Run this only to add
+# instances or to rebuild them deliberately; changed instances invalidate
+# every stored baseline.
+# ============================================================================
+
+cd "$(dirname "$0")" || exit 1
+GENERATOR="../graph_gen"
+DIR="instances"
+
+mkdir -p "$DIR"
+
+# name g_size h_size density seed [--not-subgraph]
+while read -r name g_size h_size density seed flag; do
+    [ -z "$name" ] && continue
+    case "$name" in \#*) continue ;; esac
+    "$GENERATOR" "$g_size" "$h_size" $flag --density "$density" --seed "$seed" --output "$DIR/$name.txt" || exit 1
+    echo "Generated: $name"
+done <<'LIST'
+# G is a subgraph of H (isomorphism engines)
+iso_8_14_d30    8   14  0.3   101
+iso_10_18_d15   10  18  0.15  104
+iso_12_20_d30   12  20  0.3   105
+iso_12_20_d60   12  20  0.6   103
+iso_30_60_d30   30  60  0.3   111
+iso_40_80_d60   40  80  0.6   113
+iso_50_100_d10  50  100 0.1   114
+iso_50_100_d30  50  100 0.3   112
+# One G edge heavier than any in H (extension engines)
+ext_5_8_d30     5   8   0.3   123  --not-subgraph
+ext_6_9_d30     6   9   0.3   123  --not-subgraph
+ext_6_9_d60     6   9   0.6   122  --not-subgraph
+ext_7_10_d30    7   10  0.3   124  --not-subgraph
+ext_8_14_d30    8   14  0.3   142  --not-subgraph
+ext_8_14_d60    8   14  0.6   143  --not-subgraph
+ext_30_60_d30   30  60  0.3   131  --not-subgraph
+ext_40_80_d60   40  80  0.6   133  --not-subgraph
+ext_50_100_d30  50  100 0.3   132  --not-subgraph
+LIST
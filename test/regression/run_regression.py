@@ -0,0 +1,156 @@
+#!/usr/bin/env python3
+"""
+Performance Regression Runner
+Runs every case of suite.txt on its pinned instance several times and writes
+one CSV row per case with the median, mean, variance and every sample of the
+engine time (time_ms of --format json, so process startup and loading are
+left out). Compare two such files with compare_regression.py.
+
+With --baseline-aac, the old build is timed in the same session, alternating
+runs with the new one, so that drift in machine load hits both files alike.
+"""
+
+import argparse
+import csv
+import json
+import os
+import statistics
+import subprocess
+import sys
+
+SCRIPT_DIR = os.path.dirname(os.path.abspath(__file__))
+DEFAULT_AAC = os.path.join(SCRIPT_DIR, "..", "..", "build", "aac")
+DEFAULT_SUITE = os.path.join(SCRIPT_DIR, "suite.txt")
+INSTANCE_DIR = os.path.join(SCRIPT_DIR, "instances")
+RUN_TIMEOUT_S = 600
+
+FIELDS = ["name", "command", "n_g", "n_h", "found", "edges_added", "reps",
+          "median_ms", "mean_ms", "variance_ms2", "min_ms", "max_ms", "samples_ms"]
+
+
+def load_suite(path):
+    """Cases as dicts: name, command, instance, n, options."""
+    cases = []
+    with open(path, "r") as f:
+        for line_no, line in enumerate(f, 1):
+            line = line.split("#", 1)[0].split()
+            if not line:
+                continue
+            if len(line) < 4:
+                raise ValueError(f"{path}:{line_no}: expected name, command, instance and n")
+            cases.append({
+                "name": line[0],
+                "command": line[1],
+                "instance": os.path.join(INSTANCE_DIR, line[2]),
+                "n": line[3],
+                "options": line[4:],
+            })
+    return cases
+
+
+def run_once(aac, case):
+    """One run of a case; returns its JSON summary."""
+    argv = [aac, case["command"], case["instance"], case["n"], *case["options"], "--batch", "--format", "json"]
+    proc = subprocess.run(argv, capture_output=True, text=True, timeout=RUN_TIMEOUT_S)
+    if proc.returncode != 0:
+        raise RuntimeError(f"{case['name']}: exit code {proc.returncode}: {proc.stderr.strip()}")
+    return json.loads(proc.stdout)
+
+
+def summarize(case, runs):
+    """CSV row for the summaries of one build. The engines are deterministic,
+    so every run must find the same answer; a difference is reported as an error."""
+    first = runs[0]
+    for summary in runs:
+        if (summary["found"], summary.get("edges_added")) != (first["found"], first.get("edges_added")):
+            raise RuntimeError(f"{case['name']}: answer changed between repetitions")
+    samples = [summary["time_ms"] for summary in runs]
+    reps = len(samples)
+
+    return {
+        "name": case["name"],
+        "command": case["command"],
+        "n_g": first["n_g"],
+        "n_h": first["n_h"],
+        "found": first["found"],
+        "edges_added": first.get("edges_added", ""),
+        "reps": reps,
+        "median_ms": f"{statistics.median(samples):.3f}",
+        "mean_ms": f"{statistics.mean(samples):.3f}",
+        "variance_ms2": f"{statistics.variance(samples):.6f}" if reps > 1 else "0",
+        "min_ms": f"{min(samples):.3f}",
+        "max_ms": f"{max(samples):.3f}",
+        "samples_ms": " ".join(f"{s:.3f}" for s in samples),
+    }
+
+
+def measure(aacs, case, reps, warmup):
+    """Warm up, then time reps runs of each build; rows in the order of aacs.
+    The builds take turns, and the first to run changes every repetition."""
+    for _ in range(warmup):
+        for aac in aacs:
+            run_once(aac, case)
+
+    runs = [[] for _ in aacs]
+    for rep in range(reps):
+        order = range(len(aacs)) if rep % 2 == 0 else reversed(range(len(aacs)))
+        for k in order:
+            runs[k].append(run_once(aacs[k], case))
+    return [summarize(case, r) for r in runs]
+
+
+def write_results(path, rows):
+    with open(path, "w", newline="") as f:
+        writer = csv.DictWriter(f, fieldnames=FIELDS)
+        writer.writeheader()
+        writer.writerows(rows)
+    print(f"Results saved to: {path}")
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Run the performance regression suite.")
+    parser.add_argument("--aac", default=DEFAULT_AAC, help="aac executable (default: build/aac)")
+    parser.add_argument("--suite", default=DEFAULT_SUITE, help="suite file (default: suite.txt)")
+    parser.add_argument("--output", default="regression_results.csv", help="CSV to write")
+    parser.add_argument("--reps", type=int, default=10, help="timed runs per case (default 10)")
+    parser.add_argument("--warmup", type=int, default=1, help="untimed runs before them (default 1)")
+    parser.add_argument("--filter", default="", help="only cases whose name contains this")
+    parser.add_argument("--baseline-aac", help="old build to time alongside, interleaved")
+    parser.add_argument("--baseline-output", default="regression_baseline.csv",
+                        help="CSV for the old build (default regression_baseline.csv)")
+    args = parser.parse_args()
+
+    if args.reps < 2:
+        print("Error: --reps must be at least 2 to estimate the variance")
+        return 1
+    aacs = [args.aac] + ([args.baseline_aac] if args.baseline_aac else [])
+    for aac in aacs:
+        if not os.path.isfile(aac):
+            print(f"Error: Executable not found: {aac}")
+            return 1
+
+    cases = [c for c in load_suite(args.suite) if args.filter in c["name"]]
+    print(f"Running {len(cases)} cases, {args.reps} repetitions after {args.warmup} warmup")
+
+    rows = [[] for _ in aacs]
+    for case in cases:
+        print(f"  {case['name']:<28}", end="", flush=True)
+        try:
+            case_rows = measure(aacs, case, args.reps, args.warmup)
+        except (RuntimeError, subprocess.TimeoutExpired, ValueError, KeyError) as e:
+            print(f"\nError: {e}")
+            return 1
+        row = case_rows[0]
+        print(f"median {row['median_ms']:>10} ms  (min {row['min_ms']}, max {row['max_ms']})"
+              + (f"  old {case_rows[1]['median_ms']} ms" if len(case_rows) > 1 else ""))
+        for k, r in enumerate(case_rows):
+            rows[k].append(r)
+
+    write_results(args.output, rows[0])
+    if args.baseline_aac:
+        write_results(args.baseline_output, rows[1])
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -13,6 +13,7 @@ N_VAL_ISO_EXACT=${1:-1}  # Number of solutions to find
 N_VAL_ISO_APPROX=${2:-1}  # Number of solutions to find
 N_VAL_EXT_EXACT=${3:-1}  # Number of solutions to find
 N_VAL_EXT_APPROX=${4:-1}  # Number of solutions to find
+N_VAL_EXT_JOINT=${5:-2}  # Number of mappings extended for jointly
 
 # Check if binary exists
 if [ ! -f "$EXECUTABLE" ]; then
@@ -34,7 +35,7 @@ echo "Approx Data:     $DIR_APPROX"
 echo "Exact Ext Data:  $DIR_EXACT_EXT"
 echo "Approx Ext Data: $DIR_APPROX_EXT"
 echo "Results Dir:     $RESULTS_DIR"
-echo "N Values:        $N_VAL_ISO_EXACT, $N_VAL_ISO_APPROX, $N_VAL_EXT_EXACT, $N_VAL_EXT_APPROX"
+echo "N Values:        $N_VAL_ISO_EXACT, $N_VAL_ISO_APPROX, $N_VAL_EXT_EXACT, $N_VAL_EXT_APPROX, $N_VAL_EXT_JOINT"
 echo "Stop on Fail:    YES"
 echo "=========================================="
 echo ""
@@ -66,7 +67,7 @@ run_algo_suite() {
     echo "==========================================" >> "$result_file"
     echo "Date: $(date)" >> "$result_file"
     echo "Source Directory: $input_dir" >> "$result_file"
-    echo "N Values: $N_VAL_ISO_EXACT, $N_VAL_ISO_APPROX, $N_VAL_EXT_EXACT, $N_VAL_EXT_APPROX" >> "$result_file"
+    echo "N Values: $N_VAL_ISO_EXACT, $N_VAL_ISO_APPROX, $N_VAL_EXT_EXACT, $N_VAL_EXT_APPROX, $N_VAL_EXT_JOINT" >> "$result_file"
     echo "==========================================" >> "$result_file"
     echo "" >> "$result_file"
 
@@ -161,6 +162,9 @@ run_algo_suite "ext_exact" "$DIR_EXACT_EXT" "$N_VAL_EXT_EXACT"
 # 4. Approx Extension
 run_algo_suite "ext_approx" "$DIR_APPROX_EXT" "$N_VAL_EXT_APPROX"
 
+# 5. Joint Extension (on the exact extension data)
+run_algo_suite "ext_joint" "$DIR_EXACT_EXT" "$N_VAL_EXT_JOINT"
+
 
 # ==========================================
 # Summary
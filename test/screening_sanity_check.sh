@@ -0,0 +1,130 @@
+#!/bin/bash
+
+# ============================================================================
+# Sanity Check: Fingerprint Screening of batch --pattern
+# Every answer of a screened run must match the answer of the same instances
+# solved without screening; a mismatch means the filter rejected a target H
+# that G embeds in.
+# ============================================================================
+
+# --- CONFIGURATION ---
+GENERATOR="./graph_gen"
+SOLVER="../build/aac"
+OUTPUT_DIR="./debug_data"
+NUM_TRIALS=10
+NUM_TARGETS=50
+
+# Colors
+GREEN='\033[0;32m'
+RED='\033[0;31m'
+NC='\033[0m'
+
+mkdir -p "$OUTPUT_DIR"
+
+# Counters
+total_tests=0
+total_failures=0
+
+# Print graph k (1-based) of a stream of matrices: a line with n, then n rows
+extract_graph() {
+    awk -v want="$2" '
+        NF == 0 { next }
+        rows == 0 { count++; rows = $1; if (count == want) print; next }
+        { rows--; if (count == want) print }
+    ' "$1"
+}
+
+# subgraph=YES/NO of every instance, one per line
+answers() {
+    sed -n 's/.*subgraph=\([A-Z]*\).*/\1/p'
+}
+
+run_batch() {
+    local engine=$1 # iso_exact or iso_approx
+    local g_size=$2 # Pattern G
+    local h_size=$3 # Every target H
+
+    echo "----------------------------------------------------"
+    echo "Testing batch: $engine, G=$g_size, H=$h_size ($NUM_TRIALS trials of $NUM_TARGETS targets)"
+
+    local batch_failures=0
+
+    for ((i=1; i<=NUM_TRIALS; i++)); do
+        local test_name="screen_${engine}_G${g_size}_H${h_size}_id${i}"
+        local pattern_file="${OUTPUT_DIR}/${test_name}_pattern.txt"
+        local source_file="${OUTPUT_DIR}/${test_name}_source.txt"
+        local targets_file="${OUTPUT_DIR}/${test_name}_targets.txt"
+        local pairs_file="${OUTPUT_DIR}/${test_name}_pairs.txt"
+        local seed=$((i * 7919 + g_size * 101 + h_size))
+
+        # 1. Generate a dense G (loops included) and sparser targets of varying density
+        $GENERATOR "$g_size" "$h_size" --plant --density 0.6 --seed "$seed" --output "$source_file" > /dev/null 2>&1
+        $GENERATOR 1 "$h_size" --density 0.4 --count "$NUM_TARGETS" --seed "$seed" --output "${source_file}.h" > /dev/null 2>&1
+        if [ ! -f "$source_file" ] || [ ! -f "${source_file}.h" ]; then
+            echo -e "  Trial $i: ${RED}GENERATION FAILED${NC}"
+            exit 1
+        fi
+        extract_graph "$source_file" 1 > "$pattern_file"
+        : > "$targets_file"
+        : > "$pairs_file"
+        for ((k=1; k<=NUM_TARGETS; k++)); do
+            local target
+            target=$(extract_graph "${source_file}.h" $((2 * k)))
+            echo "$target" >> "$targets_file"
+            cat "$pattern_file" >> "$pairs_file"
+            echo "$target" >> "$pairs_file"
+        done
+        # The planted H as well, so some targets do embed G
+        extract_graph "$source_file" 2 >> "$targets_file"
+        cat "$source_file" >> "$pairs_file"
+
+        # 2. Solve with and without screening
+        local screened unscreened
+        screened=$($SOLVER batch "$engine" "$targets_file" 1 --pattern "$pattern_file" 2>/dev/null | answers)
+        unscreened=$($SOLVER batch "$engine" "$pairs_file" 1 2>/dev/null | answers)
+
+        # 3. Compare instance by instance
+        if [ -n "$unscreened" ] && [ "$screened" == "$unscreened" ]; then
+            local rejected
+            rejected=$($SOLVER batch "$engine" "$targets_file" 1 --pattern "$pattern_file" 2>/dev/null | grep -c "screened=")
+            echo -e "  Trial $i: ${GREEN}SUCCESS${NC} ($rejected screened out)"
+            rm "$pattern_file" "$source_file" "${source_file}.h" "$targets_file" "$pairs_file"
+        else
+            echo -e "  Trial $i: ${RED}ANSWERS DIFFER${NC}"
+            ((batch_failures++))
+            ((total_failures++))
+            # Keep the streams for debugging
+            rm "$source_file" "${source_file}.h"
+            mv "$pattern_file" "${OUTPUT_DIR}/FAIL_${test_name}_pattern.txt"
+            mv "$targets_file" "${OUTPUT_DIR}/FAIL_${test_name}_targets.txt"
+            mv "$pairs_file" "${OUTPUT_DIR}/FAIL_${test_name}_pairs.txt"
+        fi
+
+        ((total_tests++))
+    done
+
+    # Batch summary
+    if [ $batch_failures -gt 0 ]; then
+        echo -e "Batch Result: ${RED}$batch_failures / $NUM_TRIALS failed${NC}"
+    else
+        echo -e "Batch Result: ${GREEN}100% Success${NC}"
+    fi
+}
+
+# --- TEST PLAN ---
+
+# Exact: screening must never change an answer
+run_batch iso_exact 3 4
+run_batch iso_exact 4 6
+run_batch iso_exact 6 9
+
+# Heuristic: the same targets, with loops mapped onto loops
+run_batch iso_approx 3 4
+run_batch iso_approx 6 9
+run_batch iso_approx 10 20
+
+# --- FINAL REPORT ---
+echo "========================================"
+echo "Total Tests: $total_tests"
+echo -e "Mismatches: ${RED}$total_failures${NC}"
+[ $total_failures -eq 0 ]
@@ -0,0 +1,149 @@
+#include "thread_pool.h"
+#include "trace.h"
+#include <stdlib.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include <unistd.h>
+
+struct ThreadPool {
+    pthread_t *threads;
+    int num_threads;
+
+    pthread_mutex_t lock;
+    pthread_cond_t job_ready; // Signalled when a new job is posted or on shutdown
+    pthread_cond_t job_done;  // Signalled when the last task of a job finishes
+
+    // Current job
+    ThreadPoolTask fn;
+    void *arg;
+    int num_tasks;
+    int next_task;
+    int tasks_done;
+    unsigned long generation; // Incremented per job so idle workers notice new work
+    bool shutdown;
+};
+
+typedef struct {
+    ThreadPool *pool;
+    int worker;
+} WorkerArg;
+
+static void *worker_main(void *p) {
+    WorkerArg *wa = (WorkerArg *) p;
+    ThreadPool *pool = wa->pool;
+    int worker = wa->worker;
+    free(wa);
+
+    unsigned long seen = 0;
+    pthread_mutex_lock(&pool->lock);
+    while (1) {
+        while (!pool->shutdown && pool->generation == seen) {
+            pthread_cond_wait(&pool->job_ready, &pool->lock);
+        }
+        if (pool->shutdown) break;
+        seen = pool->generation;
+
+        // Claim tasks one at a time until the job is exhausted (one trace
+        // slice per worker and job, if the worker got any task)
+        bool traced = false;
+        while (pool->next_task < pool->num_tasks) {
+            int task = pool->next_task++;
+            ThreadPoolTask fn = pool->fn;
+            void *arg = pool->arg;
+            pthread_mutex_unlock(&pool->lock);
+
+            if (!traced) {
+                trace_begin_index("pool_tasks", worker);
+                traced = true;
+            }
+            fn(arg, task, worker);
+
+            pthread_mutex_lock(&pool->lock);
+            if (++pool->tasks_done == pool->num_tasks) {
+                pthread_cond_signal(&pool->job_done);
+            }
+        }
+        if (traced) trace_end("pool_tasks");
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+int cpu_count(void) {
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (int) n : 1;
+}
+
+ThreadPool *thread_pool_create(int num_threads) {
+    if (num_threads <= 0) num_threads = cpu_count();
+
+    ThreadPool *pool = (ThreadPool *) calloc(1, sizeof(ThreadPool));
+    if (!pool) return NULL;
+    pool->threads = (pthread_t *) malloc(num_threads * sizeof(pthread_t));
+    if (!pool->threads) {
+        free(pool);
+        return NULL;
+    }
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->job_ready, NULL);
+    pthread_cond_init(&pool->job_done, NULL);
+
+    for (int i = 0; i < num_threads; i++) {
+        WorkerArg *wa = (WorkerArg *) malloc(sizeof(WorkerArg));
+        if (!wa) break;
+        wa->pool = pool;
+        wa->worker = i;
+        if (pthread_create(&pool->threads[i], NULL, worker_main, wa) != 0) {
+            free(wa);
+            break;
+        }
+        pool->num_threads++;
+    }
+
+    if (pool->num_threads == 0) {
+        thread_pool_destroy(pool);
+        return NULL;
+    }
+    return pool;
+}
+
+int thread_pool_size(const ThreadPool *pool) {
+    return pool->num_threads;
+}
+
+void thread_pool_run(ThreadPool *pool, int num_tasks, ThreadPoolTask fn, void *arg) {
+    if (num_tasks <= 0) return;
+
+    pthread_mutex_lock(&pool->lock);
+    pool->fn = fn;
+    pool->arg = arg;
+    pool->num_tasks = num_tasks;
+    pool->next_task = 0;
+    pool->tasks_done = 0;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->job_ready);
+
+    while (pool->tasks_done < pool->num_tasks) {
+        pthread_cond_wait(&pool->job_done, &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+}
+
+void thread_pool_destroy(ThreadPool *pool) {
+    if (!pool) return;
+
+    pthread_mutex_lock(&pool->lock);
+    pool->shutdown = true;
+    pthread_cond_broadcast(&pool->job_ready);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (int i = 0; i < pool->num_threads; i++) {
+        pthread_join(pool->threads[i], NULL);
+    }
+
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->job_ready);
+    pthread_cond_destroy(&pool->job_done);
+    free(pool->threads);
+    free(pool);
+}
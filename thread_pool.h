@@ -0,0 +1,42 @@
+#ifndef AAC_THREAD_POOL_H
+#define AAC_THREAD_POOL_H
+
+/**
+ * Fixed-size pool of worker threads running parallel-for style jobs
+ */
+typedef struct ThreadPool ThreadPool;
+
+/**
+ * Task callback: task is the index in [0, num_tasks), worker is the index of
+ * the thread running it in [0, thread_pool_size) (for per-thread scratch space)
+ */
+typedef void (*ThreadPoolTask)(void *arg, int task, int worker);
+
+/**
+ * Create a pool with num_threads workers (<= 0 = one per online CPU)
+ * The pool may hold fewer workers if some cannot be started (see thread_pool_size);
+ * NULL if none can.
+ */
+ThreadPool *thread_pool_create(int num_threads);
+
+/**
+ * Number of workers in the pool
+ */
+int thread_pool_size(const ThreadPool *pool);
+
+/**
+ * Run fn for every task index on the pool's workers and wait for all of them
+ */
+void thread_pool_run(ThreadPool *pool, int num_tasks, ThreadPoolTask fn, void *arg);
+
+/**
+ * Stop and join all workers, then free the pool
+ */
+void thread_pool_destroy(ThreadPool *pool);
+
+/**
+ * Number of online CPUs (at least 1)
+ */
+int cpu_count(void);
+
+#endif //AAC_THREAD_POOL_H
@@ -0,0 +1,122 @@
+#include "trace.h"
+#include "output.h"
+#include "utils.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+typedef struct {
+    const char *name;
+    double ts_us; // Microseconds since trace_enable
+    int tid;
+    int index;    // -1 = none
+    char phase;   // 'B' or 'E'
+} TraceEvent;
+
+static atomic_bool enabled = false;
+static atomic_int next_tid = 0;
+static _Thread_local int thread_id = 0; // 0 = not assigned yet
+
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static double start_ms;
+static TraceEvent *events;
+static size_t num_events, cap_events;
+static bool dropped;
+
+static int current_tid(void) {
+    if (thread_id == 0) thread_id = atomic_fetch_add(&next_tid, 1) + 1;
+    return thread_id;
+}
+
+static void record(const char *name, char phase, int index) {
+    if (!atomic_load_explicit(&enabled, memory_order_relaxed)) return;
+    int tid = current_tid();
+    pthread_mutex_lock(&lock);
+    double ts_us = (now_ms() - start_ms) * 1000.0;
+    if (num_events == cap_events) {
+        size_t cap = cap_events ? cap_events * 2 : 1024;
+        TraceEvent *grown = (TraceEvent *) realloc(events, cap * sizeof(TraceEvent));
+        if (!grown) {
+            dropped = true;
+            pthread_mutex_unlock(&lock);
+            return;
+        }
+        events = grown;
+        cap_events = cap;
+    }
+    events[num_events++] = (TraceEvent) {name, ts_us, tid, index, phase};
+    pthread_mutex_unlock(&lock);
+}
+
+void trace_enable(void) {
+    pthread_mutex_lock(&lock);
+    start_ms = now_ms();
+    num_events = 0;
+    dropped = false;
+    pthread_mutex_unlock(&lock);
+    current_tid();
+    atomic_store(&enabled, true);
+}
+
+bool trace_enabled(void) {
+    return atomic_load(&enabled);
+}
+
+void trace_begin(const char *name) {
+    record(name, 'B', -1);
+}
+
+void trace_begin_index(const char *name, int index) {
+    record(name, 'B', index);
+}
+
+void trace_end(const char *name) {
+    record(name, 'E', -1);
+}
+
+int trace_write(const char *path) {
+    atomic_store(&enabled, false);
+    FILE *f = fopen(path, "w");
+    if (!f) {
+        fprintf(stderr, "Error: cannot write trace file %s\n", path);
+        return 1;
+    }
+
+    pthread_mutex_lock(&lock);
+    OutWriter w;
+    out_init(&w, f);
+    out_str(&w, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    out_str(&w, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"aac\"}}");
+    for (size_t k = 0; k < num_events; k++) {
+        const TraceEvent *e = &events[k];
+        // Names are literals from the source: no escaping needed
+        out_str(&w, ",\n{\"name\":\"");
+        out_str(&w, e->name);
+        out_str(&w, "\",\"ph\":\"");
+        out_char(&w, e->phase);
+        out_str(&w, "\",\"ts\":");
+        out_ms(&w, e->ts_us);
+        out_str(&w, ",\"pid\":1,\"tid\":");
+        out_int(&w, e->tid);
+        if (e->index >= 0) {
+            out_str(&w, ",\"args\":{\"index\":");
+            out_int(&w, e->index);
+            out_char(&w, '}');
+        }
+        out_char(&w, '}');
+    }
+    out_str(&w, "\n]}\n");
+    out_free(&w);
+    if (dropped) fprintf(stderr, "Warning: out of memory while tracing, the trace is incomplete\n");
+    free(events);
+    events = NULL;
+    num_events = cap_events = 0;
+    pthread_mutex_unlock(&lock);
+
+    if (fclose(f) != 0) {
+        fprintf(stderr, "Error: cannot write trace file %s\n", path);
+        return 1;
+    }
+    return 0;
+}
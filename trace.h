@@ -0,0 +1,42 @@
+#ifndef AAC_TRACE_H
+#define AAC_TRACE_H
+
+#include <stdbool.h>
+
+/**
+ * Timeline of a run for a trace viewer (chrome://tracing, Perfetto).
+ *
+ * Code marks phases with trace_begin / trace_end pairs; while tracing is
+ * enabled each call records an event with a timestamp and the id of the
+ * calling thread, and trace_write saves them as Chrome trace-event JSON.
+ * Disabled (the default), a call costs one atomic load. Events are meant for
+ * phases (loading, product graph construction, a round of an engine), not
+ * for search nodes. Names must be string literals: only the pointer is kept.
+ */
+
+/**
+ * Start recording (timestamps count from here). The calling thread becomes thread 1.
+ */
+void trace_enable(void);
+
+bool trace_enabled(void);
+
+void trace_begin(const char *name);
+
+/**
+ * Begin an event carrying an index (shown as its "index" argument), such as the round of an engine
+ */
+void trace_begin_index(const char *name, int index);
+
+/**
+ * End the innermost open event of the calling thread (name must match its begin)
+ */
+void trace_end(const char *name);
+
+/**
+ * Write the recorded events to path as Chrome trace-event JSON and stop
+ * recording. Returns 0 on success.
+ */
+int trace_write(const char *path);
+
+#endif //AAC_TRACE_H
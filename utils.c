@@ -1,7 +1,19 @@
 #include "utils.h"
+#include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
 
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
 char *trim_inplace(char *s) {
     if (!s) return s;
     size_t len = strlen(s);
@@ -13,3 +25,119 @@ char *trim_inplace(char *s) {
     if (start != s) memmove(s, start, strlen(start) + 1);
     return s;
 }
+
+double now_ms(void) {
+#ifdef _WIN32
+    LARGE_INTEGER freq, counter;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&counter);
+    return (double) counter.QuadPart * 1000.0 / (double) freq.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double) ts.tv_sec * 1000.0 + (double) ts.tv_nsec / 1e6;
+#endif
+}
+
+// Read a stream of unknown length (a pipe) into a heap buffer
+static int read_whole_stream(FILE *f, MappedFile *mf) {
+    size_t capacity = 1 << 16, size = 0;
+    char *buf = (char *) malloc(capacity);
+    if (!buf) return -1;
+
+    size_t got;
+    while ((got = fread(buf + size, 1, capacity - size, f)) > 0) {
+        size += got;
+        if (size == capacity) {
+            capacity *= 2;
+            char *grown = (char *) realloc(buf, capacity);
+            if (!grown) {
+                free(buf);
+                return -1;
+            }
+            buf = grown;
+        }
+    }
+    if (ferror(f) || size == 0) {
+        free(buf);
+        return ferror(f) ? -1 : 0;
+    }
+    mf->data = buf;
+    mf->size = size;
+    return 0;
+}
+
+#ifdef _WIN32
+int map_file(const char *path, MappedFile *mf) {
+    mf->data = NULL;
+    mf->size = 0;
+    mf->mapped = false;
+
+    if (strcmp(path, "-") == 0) return read_whole_stream(stdin, mf);
+
+    FILE *f = fopen(path, "rb");
+    if (!f) return -1;
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    if (size > 0) {
+        char *buf = (char *) malloc((size_t) size);
+        if (!buf || fread(buf, 1, (size_t) size, f) != (size_t) size) {
+            free(buf);
+            fclose(f);
+            return -1;
+        }
+        mf->data = buf;
+        mf->size = (size_t) size;
+    }
+    fclose(f);
+    return 0;
+}
+#else
+int map_file(const char *path, MappedFile *mf) {
+    mf->data = NULL;
+    mf->size = 0;
+    mf->mapped = false;
+
+    bool is_stdin = strcmp(path, "-") == 0;
+    int fd = is_stdin ? dup(STDIN_FILENO) : open(path, O_RDONLY);
+    if (fd < 0) return -1;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return -1;
+    }
+    if (is_stdin && !S_ISREG(st.st_mode)) {
+        close(fd);
+        return read_whole_stream(stdin, mf);
+    }
+    if (st.st_size > 0) {
+        void *p = mmap(NULL, (size_t) st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p == MAP_FAILED) {
+            close(fd);
+            return -1;
+        }
+        madvise(p, (size_t) st.st_size, MADV_SEQUENTIAL);
+        mf->data = (const char *) p;
+        mf->size = (size_t) st.st_size;
+        mf->mapped = true;
+    }
+    close(fd);
+    return 0;
+}
+#endif
+
+void unmap_file(MappedFile *mf) {
+    if (!mf->data) return;
+#ifndef _WIN32
+    if (mf->mapped) {
+        munmap((void *) mf->data, mf->size);
+    } else
+#endif
+    {
+        free((void *) mf->data);
+    }
+    mf->data = NULL;
+    mf->size = 0;
+}
@@ -1,6 +1,34 @@
 #ifndef AAC_UTILS_H
 #define AAC_UTILS_H
 
+#include <stdbool.h>
+#include <stddef.h>
+
 char *trim_inplace(char *s);
 
-#endif //AAC_UTILS_H
\ No newline at end of file
+/**
+ * Read-only view of a whole file (memory-mapped where supported)
+ */
+typedef struct {
+    const char *data;
+    size_t size;
+    bool mapped; // true = munmap on release, false = heap copy
+} MappedFile;
+
+/**
+ * Map path into memory. Returns 0 on success (an empty file gives data = NULL, size = 0).
+ * The path "-" reads standard input (mapped if it is a regular file, else copied).
+ */
+int map_file(const char *path, MappedFile *mf);
+
+/**
+ * Release a view obtained from map_file
+ */
+void unmap_file(MappedFile *mf);
+
+/**
+ * Monotonic wall-clock time in milliseconds (arbitrary epoch, for measuring intervals)
+ */
+double now_ms(void);
+
+#endif //AAC_UTILS_H